@@ -0,0 +1,811 @@
+// Allocator benchmarks. Runs the same repeatable workloads against every allocator and prints
+// ns/op, latency percentiles, peak RSS and per allocation overhead. The threaded workload only
+// runs against the allocators that can be shared between threads.
+//
+//   bench [--csv | --json] [--quick] [--filter <allocator name prefix>]
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+#endif
+
+#ifdef _WIN32
+#ifdef _MSC_VER
+#pragma warning( push, 0 )
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma warning( pop )
+#pragma comment( lib, "psapi.lib" )
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+#define SRALLOC_IMPLEMENTATION
+#include "../../sralloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_LIVE_COUNT 1024
+#define BENCH_MAX_DEPTH 8
+#define BENCH_MAX_CHAIN ( BENCH_MAX_DEPTH + 2 )
+#define BENCH_NUM_THREADS 4
+
+typedef enum {
+    BENCH_OUTPUT_TABLE,
+    BENCH_OUTPUT_CSV,
+    BENCH_OUTPUT_JSON,
+} bench_output_t;
+
+typedef enum {
+    BENCH_ORDER_LIFO,
+    BENCH_ORDER_FIFO,
+    BENCH_ORDER_RANDOM,
+} bench_order_t;
+
+typedef struct {
+    const char*   name;
+    bench_order_t order;
+    int           min_size;
+    int           max_size;
+    int           power_law;
+    int           max_align;
+    int           num_threads; // Each thread runs the whole workload at the same time
+} bench_workload_t;
+
+static const bench_workload_t bench_workloads[] = {
+    { "fixed", BENCH_ORDER_LIFO, 64, 64, 0, 0, 1 },
+    { "power_law", BENCH_ORDER_RANDOM, 16, 16384, 1, 0, 1 },
+    { "lifo", BENCH_ORDER_LIFO, 16, 256, 0, 0, 1 },
+    { "fifo", BENCH_ORDER_FIFO, 16, 256, 0, 0, 1 },
+    { "random", BENCH_ORDER_RANDOM, 16, 256, 0, 0, 1 },
+    { "aligned", BENCH_ORDER_RANDOM, 16, 256, 0, 256, 1 },
+    { "threaded", BENCH_ORDER_RANDOM, 16, 256, 0, 0, BENCH_NUM_THREADS },
+};
+
+#define BENCH_NUM_WORKLOADS ( sizeof( bench_workloads ) / sizeof( bench_workloads[0] ) )
+
+typedef enum {
+    BENCH_MALLOC,
+    BENCH_PROXY,
+    BENCH_HEAP,
+    BENCH_PAGE,
+    BENCH_STACK,
+    BENCH_VIRTUAL_STACK,
+    BENCH_ARENA,
+    BENCH_TLSF,
+    BENCH_BUDDY,
+    BENCH_SLOT,
+    BENCH_RING,
+    BENCH_MULTI_FRAME,
+    BENCH_MUTEX,
+    BENCH_SPINLOCK,
+    BENCH_THREAD_CACHE,
+    BENCH_CONCURRENT_FRAME,
+    BENCH_NUM_KINDS,
+} bench_kind_t;
+
+// A chain of allocators, the workload runs against the last one
+typedef struct {
+    char           name[32];
+    bench_kind_t   kind;
+    int            depth;
+    srallocator_t* chain[BENCH_MAX_CHAIN];
+    int            chain_length;
+    srallocator_t* measured; // The allocator whose stats show the memory really in use
+    int            lifo_only;
+    int            fifo_only;
+    int            thread_safe;
+    int            max_size;
+} bench_setup_t;
+
+typedef struct {
+    int    sizes[BENCH_LIVE_COUNT];
+    int    aligns[BENCH_LIVE_COUNT];
+    int    free_order[BENCH_LIVE_COUNT];
+    void*  ptrs[BENCH_LIVE_COUNT];
+    double ns_per_op;
+    double p50;
+    double p99;
+    double p999;
+    long   peak_rss_kb;
+    double overhead;
+} bench_run_t;
+
+static unsigned int bench_rng_state;
+
+static unsigned int
+bench_rand( void ) {
+    // xorshift32, good enough and the same on every platform
+    bench_rng_state ^= bench_rng_state << 13;
+    bench_rng_state ^= bench_rng_state >> 17;
+    bench_rng_state ^= bench_rng_state << 5;
+    return bench_rng_state;
+}
+
+static void
+bench_generate( const bench_workload_t* workload, bench_run_t* run, int round ) {
+    bench_rng_state = 0x9e3779b9u + (unsigned int)round * 7919u;
+    for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+        int range = workload->max_size - workload->min_size + 1;
+        if ( workload->power_law ) {
+            // Each doubling of the size is half as likely
+            int size = workload->min_size;
+            while ( size < workload->max_size && ( bench_rand() & 1 ) ) {
+                size *= 2;
+            }
+            run->sizes[i] = size / 2 + 1 + (int)( bench_rand() % (unsigned int)( size / 2 ) );
+        }
+        else {
+            run->sizes[i] = workload->min_size + (int)( bench_rand() % (unsigned int)range );
+        }
+
+        run->aligns[i] = 0;
+        if ( workload->max_align > 0 ) {
+            run->aligns[i] = 16 << ( bench_rand() % 5 );
+        }
+
+        run->free_order[i] = workload->order == BENCH_ORDER_LIFO ? BENCH_LIVE_COUNT - 1 - i : i;
+    }
+
+    if ( workload->order == BENCH_ORDER_RANDOM ) {
+        for ( int i = BENCH_LIVE_COUNT - 1; i > 0; --i ) {
+            int j              = (int)( bench_rand() % (unsigned int)( i + 1 ) );
+            int tmp            = run->free_order[i];
+            run->free_order[i] = run->free_order[j];
+            run->free_order[j] = tmp;
+        }
+    }
+}
+
+static void
+bench_reset_peak_rss( void ) {
+#ifdef __linux__
+    // Writing 5 resets VmHWM, so each run gets its own peak
+    FILE* file = fopen( "/proc/self/clear_refs", "w" );
+    if ( file != NULL ) {
+        fputs( "5", file );
+        fclose( file );
+    }
+#endif
+}
+
+static long
+bench_peak_rss_kb( void ) {
+#if defined( _WIN32 )
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) );
+    return (long)( counters.PeakWorkingSetSize / 1024 );
+#elif defined( __linux__ )
+    FILE* file = fopen( "/proc/self/status", "r" );
+    char  line[128];
+    long  peak = -1;
+    while ( file != NULL && fgets( line, sizeof( line ), file ) != NULL ) {
+        if ( strncmp( line, "VmHWM:", 6 ) == 0 ) {
+            peak = strtol( line + 6, NULL, 10 );
+        }
+    }
+    if ( file != NULL ) {
+        fclose( file );
+    }
+    return peak;
+#else
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+    return (long)( usage.ru_maxrss / 1024 );
+#else
+    return (long)usage.ru_maxrss;
+#endif
+#endif
+}
+
+static void
+bench_setup_push( bench_setup_t* setup, srallocator_t* allocator ) {
+    setup->chain[setup->chain_length++] = allocator;
+}
+
+static void
+bench_create( bench_setup_t* setup ) {
+    srallocator_t* root = sralloc_create_malloc_allocator( "root" );
+    bench_setup_push( setup, root );
+    setup->measured    = root;
+    setup->lifo_only   = 0;
+    setup->fifo_only   = 0;
+    setup->thread_safe = 0;
+    setup->max_size    = 1 << 30;
+    switch ( setup->kind ) {
+    case BENCH_MALLOC:
+        break;
+    case BENCH_PROXY:
+        for ( int i = 0; i < setup->depth; ++i ) {
+            bench_setup_push(
+              setup, sralloc_create_proxy_allocator( "proxy", setup->chain[i] ) );
+        }
+        break;
+    case BENCH_HEAP:
+        // The heap maps its own memory, root only keeps the chain uniform
+        setup->measured = sralloc_create_heap_allocator( "heap" );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_PAGE:
+        // Every allocation is its own mapping, like the heap the chain is only kept uniform
+        setup->measured = sralloc_create_page_allocator( "page", 0 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_STACK:
+        setup->measured = sralloc_create_stack_allocator( "stack", root, 1024 * 1024 );
+        setup->lifo_only = 1;
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_VIRTUAL_STACK:
+        setup->measured =
+          sralloc_create_virtual_stack_allocator( "virtual_stack", root, 64 * 1024 * 1024, 0 );
+        setup->lifo_only = 1;
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_ARENA:
+        // Only the last allocation is really freed, the arena is cleared after every round
+        setup->measured = sralloc_create_arena_allocator( "arena", root, 64 * 1024, 2 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_TLSF:
+        setup->measured = sralloc_create_tlsf_allocator( "tlsf", root, 32 * 1024 * 1024 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_BUDDY:
+        setup->measured = sralloc_create_buddy_allocator( "buddy", root, 64 * 1024 * 1024, 16 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_SLOT:
+        setup->measured = sralloc_create_growing_slot_allocator( "slot", root, 64, 4096 );
+        setup->max_size = 64;
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_RING:
+        setup->measured  = sralloc_create_ring_allocator( "ring", root, 4 * 1024 * 1024, 0 );
+        setup->fifo_only = 1;
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_MULTI_FRAME:
+        // Frees don't give memory back, the frame is advanced after every round
+        setup->measured =
+          sralloc_create_multi_frame_allocator( "multi_frame", root, 2, 32 * 1024 * 1024 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_MUTEX:
+    case BENCH_SPINLOCK:
+        setup->thread_safe = 1;
+        bench_setup_push( setup,
+                          sralloc_create_mutex_allocator( "mutex",
+                                                          root,
+                                                          setup->kind == BENCH_MUTEX
+                                                            ? SRALLOC_LOCK_MUTEX
+                                                            : SRALLOC_LOCK_SPINLOCK ) );
+        break;
+    case BENCH_THREAD_CACHE:
+        setup->thread_safe = 1;
+        setup->measured    = sralloc_create_heap_allocator( "heap" );
+        bench_setup_push( setup, setup->measured );
+        bench_setup_push(
+          setup, sralloc_create_mutex_allocator( "mutex", setup->measured, SRALLOC_LOCK_MUTEX ) );
+        bench_setup_push( setup,
+                          sralloc_create_thread_cache_allocator( "tcache", setup->chain[2] ) );
+        break;
+    case BENCH_CONCURRENT_FRAME:
+        // Frees don't give memory back, the frame is cleared after every round
+        setup->thread_safe = 1;
+        setup->measured =
+          sralloc_create_concurrent_frame_allocator( "frame", root, 64 * 1024 * 1024 );
+        bench_setup_push( setup, setup->measured );
+        break;
+    case BENCH_NUM_KINDS:
+        break;
+    }
+}
+
+static void
+bench_destroy( bench_setup_t* setup ) {
+    for ( int i = setup->chain_length - 1; i > 0; --i ) {
+        srallocator_t* allocator = setup->chain[i];
+        switch ( setup->kind ) {
+        case BENCH_MALLOC:
+            break;
+        case BENCH_PROXY:
+            sralloc_destroy_proxy_allocator( allocator );
+            break;
+        case BENCH_HEAP:
+            sralloc_destroy_heap_allocator( allocator );
+            break;
+        case BENCH_PAGE:
+            sralloc_destroy_page_allocator( allocator );
+            break;
+        case BENCH_STACK:
+        case BENCH_VIRTUAL_STACK:
+            sralloc_destroy_stack_allocator( allocator );
+            break;
+        case BENCH_ARENA:
+            sralloc_destroy_arena_allocator( allocator );
+            break;
+        case BENCH_TLSF:
+            sralloc_destroy_tlsf_allocator( allocator );
+            break;
+        case BENCH_BUDDY:
+            sralloc_destroy_buddy_allocator( allocator );
+            break;
+        case BENCH_SLOT:
+            sralloc_destroy_slot_allocator( allocator );
+            break;
+        case BENCH_RING:
+            sralloc_destroy_ring_allocator( allocator );
+            break;
+        case BENCH_MULTI_FRAME:
+            sralloc_destroy_multi_frame_allocator( allocator );
+            break;
+        case BENCH_MUTEX:
+        case BENCH_SPINLOCK:
+            sralloc_destroy_mutex_allocator( allocator );
+            break;
+        case BENCH_THREAD_CACHE:
+            if ( i == 3 ) {
+                sralloc_destroy_thread_cache_allocator( allocator );
+            }
+            else if ( i == 2 ) {
+                sralloc_destroy_mutex_allocator( allocator );
+            }
+            else {
+                sralloc_destroy_heap_allocator( allocator );
+            }
+            break;
+        case BENCH_CONCURRENT_FRAME:
+            sralloc_destroy_concurrent_frame_allocator( allocator );
+            break;
+        case BENCH_NUM_KINDS:
+            break;
+        }
+    }
+
+    sralloc_destroy_malloc_allocator( setup->chain[0] );
+    setup->chain_length = 0;
+}
+
+static void
+bench_end_round( bench_setup_t* setup ) {
+    if ( setup->kind == BENCH_CONCURRENT_FRAME ) {
+        sralloc_concurrent_frame_allocator_collect_stats( setup->measured );
+        sralloc_concurrent_frame_allocator_clear( setup->measured );
+    }
+    else if ( setup->kind == BENCH_THREAD_CACHE ) {
+        sralloc_thread_cache_allocator_flush( setup->chain[3] );
+    }
+    else if ( setup->kind == BENCH_ARENA ) {
+        sralloc_arena_allocator_clear( setup->measured );
+    }
+    else if ( setup->kind == BENCH_MULTI_FRAME ) {
+        sralloc_multi_frame_allocator_advance_frame( setup->measured );
+    }
+}
+
+// Frees the first count allocations of a round, in the round's free order
+static void
+bench_free_live( srallocator_t* allocator, bench_run_t* run, int count ) {
+    for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+        if ( run->free_order[i] < count ) {
+            sralloc_dealloc( allocator, run->ptrs[run->free_order[i]] );
+        }
+    }
+}
+
+static int
+bench_compare_latency( const void* a, const void* b ) {
+    int64_t diff = *(const int64_t*)a - *(const int64_t*)b;
+    return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+static double
+bench_percentile( int64_t* sorted, int count, double percentile ) {
+    int index = (int)( percentile * (double)( count - 1 ) );
+    return (double)sorted[index];
+}
+
+// Cost of reading the clock, taken off every single measured latency
+static int64_t
+bench_timer_overhead( void ) {
+    int64_t samples[1001];
+    for ( int i = 0; i < 1001; ++i ) {
+        int64_t start = SRALLOC_time_ns();
+        samples[i]    = SRALLOC_time_ns() - start;
+    }
+    qsort( samples, 1001, sizeof( int64_t ), bench_compare_latency );
+    return samples[500];
+}
+
+// Call with every allocation of the runs live, compares what the allocator holds to what was
+// asked for
+static double
+bench_overhead( bench_setup_t* setup, const bench_run_t* runs, int num_runs ) {
+    if ( setup->kind == BENCH_CONCURRENT_FRAME ) {
+        sralloc_concurrent_frame_allocator_collect_stats( setup->measured );
+    }
+
+    int64_t requested = 0;
+    for ( int i_run = 0; i_run < num_runs; ++i_run ) {
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            requested += runs[i_run].sizes[i];
+        }
+    }
+
+    sralloc_stats_t stats = sralloc_get_stats( setup->measured );
+    return (double)( stats.amount_allocated - requested ) / ( BENCH_LIVE_COUNT * num_runs );
+}
+
+static void
+bench_finish( bench_run_t* run, int64_t* latencies, int ops ) {
+    qsort( latencies, ops, sizeof( int64_t ), bench_compare_latency );
+    run->p50         = bench_percentile( latencies, ops, 0.5 );
+    run->p99         = bench_percentile( latencies, ops, 0.99 );
+    run->p999        = bench_percentile( latencies, ops, 0.999 );
+    run->peak_rss_kb = bench_peak_rss_kb();
+}
+
+static int
+bench_run( bench_setup_t*          setup,
+           const bench_workload_t* workload,
+           int                     rounds,
+           int64_t*                latencies,
+           bench_run_t*            run ) {
+    srallocator_t* allocator = setup->chain[setup->chain_length - 1];
+    int64_t        timer     = bench_timer_overhead();
+    int64_t        total     = 0;
+    int            ops       = 0;
+    bench_reset_peak_rss();
+
+    // Every round is run twice with the same sizes. The first run is timed as a whole for ns/op,
+    // the second times each operation for the percentiles.
+    for ( int round = 0; round < rounds; ++round ) {
+        bench_generate( workload, run, round );
+        int64_t start = SRALLOC_time_ns();
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            run->ptrs[i] = sralloc_alloc_aligned( allocator, run->sizes[i], run->aligns[i] );
+        }
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            sralloc_dealloc( allocator, run->ptrs[run->free_order[i]] );
+        }
+        total += SRALLOC_time_ns() - start;
+        bench_end_round( setup );
+
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            int64_t op_start = SRALLOC_time_ns();
+            run->ptrs[i] = sralloc_alloc_aligned( allocator, run->sizes[i], run->aligns[i] );
+            latencies[ops++] = SRALLOC_time_ns() - op_start - timer;
+            if ( run->ptrs[i] == SRALLOC_NULL ) {
+                bench_free_live( allocator, run, i );
+                bench_end_round( setup );
+                return 0;
+            }
+        }
+
+        if ( round == 0 ) {
+            run->overhead = bench_overhead( setup, run, 1 );
+        }
+
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            int64_t op_start = SRALLOC_time_ns();
+            sralloc_dealloc( allocator, run->ptrs[run->free_order[i]] );
+            latencies[ops++] = SRALLOC_time_ns() - op_start - timer;
+        }
+        bench_end_round( setup );
+    }
+
+    run->ns_per_op = (double)total / ( (double)rounds * BENCH_LIVE_COUNT * 2 );
+    bench_finish( run, latencies, ops );
+    return 1;
+}
+
+#ifdef _WIN32
+typedef HANDLE bench_thread_t;
+typedef DWORD  bench_thread_result_t;
+#define BENCH_THREAD_CALL WINAPI
+#else
+#include <pthread.h>
+typedef pthread_t bench_thread_t;
+typedef void*     bench_thread_result_t;
+#define BENCH_THREAD_CALL
+#endif
+
+// The main thread moves phase forward, in odd phases every thread allocates its round and in even
+// ones it frees it again, and bumps arrived when done. Lowering rounds stops the threads early.
+typedef struct {
+    srallocator_t*    allocator;
+    bench_run_t*      run;
+    int64_t*          latencies;
+    int64_t           timer;
+    int               ops;
+    volatile int      failed;
+    volatile srint_t* phase;
+    volatile srint_t* arrived;
+    volatile srint_t* rounds;
+} bench_thread_data_t;
+
+static void
+bench_wait_for( volatile srint_t* value, srint_t target ) {
+    while ( SRALLOC_atomic_load( value ) < target ) {
+        SRALLOC_thread_yield();
+    }
+}
+
+static bench_thread_result_t BENCH_THREAD_CALL
+bench_thread( void* arg ) {
+    bench_thread_data_t* data = (bench_thread_data_t*)arg;
+    bench_run_t*         run  = data->run;
+    for ( srint_t round = 0; round < SRALLOC_atomic_load( data->rounds ); ++round ) {
+        bench_wait_for( data->phase, 2 * round + 1 );
+        int count = 0;
+        while ( count < BENCH_LIVE_COUNT ) {
+            int64_t op_start = SRALLOC_time_ns();
+            run->ptrs[count] =
+              sralloc_alloc_aligned( data->allocator, run->sizes[count], run->aligns[count] );
+            data->latencies[data->ops++] = SRALLOC_time_ns() - op_start - data->timer;
+            if ( run->ptrs[count] == SRALLOC_NULL ) {
+                data->failed = 1;
+                break;
+            }
+            ++count;
+        }
+        SRALLOC_atomic_fetch_add( data->arrived, 1 );
+
+        bench_wait_for( data->phase, 2 * round + 2 );
+        for ( int i = 0; i < BENCH_LIVE_COUNT; ++i ) {
+            if ( run->free_order[i] < count ) {
+                int64_t op_start = SRALLOC_time_ns();
+                sralloc_dealloc( data->allocator, run->ptrs[run->free_order[i]] );
+                data->latencies[data->ops++] = SRALLOC_time_ns() - op_start - data->timer;
+            }
+        }
+        SRALLOC_atomic_fetch_add( data->arrived, 1 );
+    }
+    return 0;
+}
+
+// Every thread gets its own sizes and runs them each round, all of them at the same time. Each
+// operation is timed on its own, so ns/op is the mean latency and shows the cost of contention.
+static int
+bench_run_threaded( bench_setup_t*          setup,
+                    const bench_workload_t* workload,
+                    int                     rounds,
+                    int64_t*                latencies,
+                    bench_run_t*            run ) {
+    bench_run_t*        runs = (bench_run_t*)malloc( sizeof( bench_run_t ) * BENCH_NUM_THREADS );
+    bench_thread_data_t data[BENCH_NUM_THREADS];
+    bench_thread_t      threads[BENCH_NUM_THREADS];
+    volatile srint_t    phase       = 0;
+    volatile srint_t    arrived     = 0;
+    volatile srint_t    num_rounds  = rounds;
+    int64_t             timer       = bench_timer_overhead();
+    int                 num_threads = workload->num_threads;
+    bench_reset_peak_rss();
+
+    for ( int i = 0; i < num_threads; ++i ) {
+        bench_generate( workload, &runs[i], i );
+        data[i].allocator = setup->chain[setup->chain_length - 1];
+        data[i].run       = &runs[i];
+        data[i].latencies = latencies + (int64_t)i * rounds * BENCH_LIVE_COUNT * 2;
+        data[i].timer     = timer;
+        data[i].ops       = 0;
+        data[i].failed    = 0;
+        data[i].phase     = &phase;
+        data[i].arrived   = &arrived;
+        data[i].rounds    = &num_rounds;
+#ifdef _WIN32
+        threads[i] = CreateThread( NULL, 0, bench_thread, &data[i], 0, NULL );
+#else
+        pthread_create( &threads[i], NULL, bench_thread, &data[i] );
+#endif
+    }
+
+    int failed = 0;
+    for ( srint_t round = 0; round < rounds && !failed; ++round ) {
+        SRALLOC_atomic_store( &phase, 2 * round + 1 );
+        bench_wait_for( &arrived, num_threads * ( 2 * round + 1 ) );
+        for ( int i = 0; i < num_threads; ++i ) {
+            failed = failed || data[i].failed;
+        }
+        if ( round == 0 && !failed ) {
+            run->overhead = bench_overhead( setup, runs, num_threads );
+        }
+        if ( failed ) {
+            SRALLOC_atomic_store( &num_rounds, round + 1 );
+        }
+
+        SRALLOC_atomic_store( &phase, 2 * round + 2 );
+        bench_wait_for( &arrived, num_threads * ( 2 * round + 2 ) );
+        bench_end_round( setup );
+    }
+
+    int ops = 0;
+    for ( int i = 0; i < num_threads; ++i ) {
+#ifdef _WIN32
+        WaitForSingleObject( threads[i], INFINITE );
+        CloseHandle( threads[i] );
+#else
+        pthread_join( threads[i], NULL );
+#endif
+        memmove( latencies + ops, data[i].latencies, sizeof( int64_t ) * data[i].ops );
+        ops += data[i].ops;
+    }
+
+    free( runs );
+    if ( failed ) {
+        return 0;
+    }
+
+    double sum = 0;
+    for ( int i = 0; i < ops; ++i ) {
+        sum += (double)latencies[i];
+    }
+    run->ns_per_op = sum / ops;
+    bench_finish( run, latencies, ops );
+    return 1;
+}
+
+static void
+bench_print( bench_output_t          output,
+             int                     first,
+             const bench_setup_t*    setup,
+             const bench_workload_t* workload,
+             int                     ops,
+             const bench_run_t*      run ) {
+    switch ( output ) {
+    case BENCH_OUTPUT_TABLE:
+        if ( first ) {
+            printf( "%-16s %-10s %10s %9s %9s %9s %9s %12s %14s\n",
+                    "allocator",
+                    "workload",
+                    "ops",
+                    "ns/op",
+                    "p50",
+                    "p99",
+                    "p999",
+                    "peak_rss_kb",
+                    "overhead/alloc" );
+        }
+        printf( "%-16s %-10s %10d %9.1f %9.0f %9.0f %9.0f %12ld %14.1f\n",
+                setup->name,
+                workload->name,
+                ops,
+                run->ns_per_op,
+                run->p50,
+                run->p99,
+                run->p999,
+                run->peak_rss_kb,
+                run->overhead );
+        break;
+    case BENCH_OUTPUT_CSV:
+        if ( first ) {
+            printf( "allocator,depth,workload,ops,ns_per_op,p50_ns,p99_ns,p999_ns,peak_rss_kb,"
+                    "overhead_bytes\n" );
+        }
+        printf( "%s,%d,%s,%d,%.2f,%.0f,%.0f,%.0f,%ld,%.2f\n",
+                setup->name,
+                setup->depth,
+                workload->name,
+                ops,
+                run->ns_per_op,
+                run->p50,
+                run->p99,
+                run->p999,
+                run->peak_rss_kb,
+                run->overhead );
+        break;
+    case BENCH_OUTPUT_JSON:
+        printf( "%s\n  { \"allocator\": \"%s\", \"depth\": %d, \"workload\": \"%s\", \"ops\": %d, "
+                "\"ns_per_op\": %.2f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f, "
+                "\"peak_rss_kb\": %ld, \"overhead_bytes\": %.2f }",
+                first ? "[" : ",",
+                setup->name,
+                setup->depth,
+                workload->name,
+                ops,
+                run->ns_per_op,
+                run->p50,
+                run->p99,
+                run->p999,
+                run->peak_rss_kb,
+                run->overhead );
+        break;
+    }
+}
+
+int
+main( int argc, char** argv ) {
+    bench_output_t output = BENCH_OUTPUT_TABLE;
+    int            rounds = 200;
+    const char*    filter = NULL;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[i], "--csv" ) == 0 ) {
+            output = BENCH_OUTPUT_CSV;
+        }
+        else if ( strcmp( argv[i], "--json" ) == 0 ) {
+            output = BENCH_OUTPUT_JSON;
+        }
+        else if ( strcmp( argv[i], "--quick" ) == 0 ) {
+            rounds = 10;
+        }
+        else if ( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc ) {
+            filter = argv[++i];
+        }
+        else {
+            fprintf( stderr, "usage: %s [--csv | --json] [--quick] [--filter <name>]\n", argv[0] );
+            return 1;
+        }
+    }
+
+    // One setup per proxy depth plus one for every other kind
+    bench_setup_t setups[BENCH_MAX_DEPTH + BENCH_NUM_KINDS - 1];
+    int           num_setups = 0;
+    const char*   names[]    = { "malloc", "proxy",         "heap",         "page",
+                                 "stack",  "virtual_stack", "arena",        "tlsf",
+                                 "buddy",  "slot",          "ring",         "multi_frame",
+                                 "mutex",  "spinlock",      "thread_cache", "concurrent_frame" };
+    for ( int kind = BENCH_MALLOC; kind < BENCH_NUM_KINDS; ++kind ) {
+        int max_depth = kind == BENCH_PROXY ? BENCH_MAX_DEPTH : 1;
+        for ( int depth = 1; depth <= max_depth; ++depth ) {
+            bench_setup_t* setup = &setups[num_setups++];
+            memset( setup, 0, sizeof( *setup ) );
+            setup->kind  = (bench_kind_t)kind;
+            setup->depth = kind == BENCH_PROXY ? depth : 0;
+            if ( kind == BENCH_PROXY ) {
+                sprintf( setup->name, "%s_%d", names[kind], depth );
+            }
+            else {
+                sprintf( setup->name, "%s", names[kind] );
+            }
+        }
+    }
+
+    int64_t* latencies =
+      (int64_t*)malloc( sizeof( int64_t ) * rounds * BENCH_LIVE_COUNT * 2 * BENCH_NUM_THREADS );
+    bench_run_t* run       = (bench_run_t*)malloc( sizeof( bench_run_t ) );
+    int          first     = 1;
+    for ( int i_setup = 0; i_setup < num_setups; ++i_setup ) {
+        bench_setup_t* setup = &setups[i_setup];
+        if ( filter != NULL && strncmp( setup->name, filter, strlen( filter ) ) != 0 ) {
+            continue;
+        }
+
+        for ( unsigned int i_work = 0; i_work < BENCH_NUM_WORKLOADS; ++i_work ) {
+            const bench_workload_t* workload = &bench_workloads[i_work];
+            bench_create( setup );
+            int supported = workload->max_size <= setup->max_size &&
+                            ( !setup->lifo_only || workload->order == BENCH_ORDER_LIFO ) &&
+                            ( !setup->fifo_only || workload->order == BENCH_ORDER_FIFO ) &&
+                            ( workload->num_threads == 1 || setup->thread_safe );
+            int ops = rounds * BENCH_LIVE_COUNT * 2 * workload->num_threads;
+            int ran = 0;
+            if ( supported && workload->num_threads > 1 ) {
+                ran = bench_run_threaded( setup, workload, rounds, latencies, run );
+            }
+            else if ( supported ) {
+                ran = bench_run( setup, workload, rounds, latencies, run );
+            }
+            if ( ran ) {
+                bench_print( output, first, setup, workload, ops, run );
+                first = 0;
+            }
+            bench_destroy( setup );
+        }
+    }
+
+    if ( output == BENCH_OUTPUT_JSON ) {
+        printf( "%s\n", first ? "[]" : "\n]" );
+    }
+
+    free( run );
+    free( latencies );
+    return 0;
+}
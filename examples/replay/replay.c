@@ -0,0 +1,664 @@
+// Replays a trace written by the recording allocator against different allocator setups and
+// prints ns/op, latency percentiles, peak memory and fragmentation for each.
+//
+//   replay <trace> [--csv | --json] [--filter <setup name prefix>] [--capacity <bytes>]
+//
+// Every allocator that was recorded gets its own allocator of the setup's kind (or shares the
+// root for malloc, heap and page), all below one root whose stats are the memory in use.
+// Fragmentation is how much of the peak memory in use the live blocks never needed, counting
+// what's reserved up front like the buddy and stack capacity (--capacity, 256 MiB by default).
+
+#if !defined( _WIN32 ) && !defined( _POSIX_C_SOURCE )
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#define SRALLOC_IMPLEMENTATION
+#include "../../sralloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_ALLOCATORS 256
+
+typedef enum {
+    REPLAY_OUTPUT_TABLE,
+    REPLAY_OUTPUT_CSV,
+    REPLAY_OUTPUT_JSON,
+} replay_output_t;
+
+typedef enum {
+    REPLAY_MALLOC,
+    REPLAY_HEAP,
+    REPLAY_PAGE,
+    REPLAY_PROXY,
+    REPLAY_TLSF,
+    REPLAY_BUDDY,
+    REPLAY_ARENA,
+    REPLAY_STACK,
+} replay_kind_t;
+
+typedef struct {
+    replay_kind_t  kind;
+    srint_t        capacity;
+    srallocator_t* root;
+    srallocator_t* allocators[REPLAY_MAX_ALLOCATORS]; // Per recorded allocator id
+    int            num_allocators;
+} replay_setup_t;
+
+// A block that was live when recorded, by the allocator and address it had then. Recording
+// allocators stacked on one trace each log the blocks going through them, so the same address
+// can be live for more than one of them.
+typedef struct {
+    srint_t        id;
+    uint64_t       recorded;
+    void*          ptr;
+    srint_t        size;
+    srint_t        align;
+    srallocator_t* allocator;
+} replay_block_t;
+
+// Open addressing with linear probing, 0 marks an empty slot since null is never recorded live
+typedef struct {
+    replay_block_t* blocks;
+    int64_t         capacity;
+    int64_t         count;
+} replay_map_t;
+
+typedef struct {
+    int64_t ops;
+    int64_t failed;
+    double  ns_per_op;
+    double  p50;
+    double  p99;
+    double  p999;
+    int64_t peak_footprint;
+    int64_t peak_live;
+    double  fragmentation;
+} replay_result_t;
+
+typedef struct {
+    int64_t num_events;
+    int64_t num_allocators;
+    int64_t duration_ns;
+    int64_t unordered_frees; // Frees of anything but the newest live block of its allocator
+} replay_summary_t;
+
+static int64_t
+replay_map_slot( const replay_map_t* map, srint_t id, uint64_t recorded ) {
+    uint64_t hash = ( ( recorded >> 4 ) ^ ( (uint64_t)id << 48 ) ) * 0x9e3779b97f4a7c15ull;
+    return (int64_t)( hash >> 20 ) & ( map->capacity - 1 );
+}
+
+static replay_block_t*
+replay_map_find( const replay_map_t* map, srint_t id, uint64_t recorded ) {
+    if ( recorded == 0 ) {
+        return NULL;
+    }
+
+    for ( int64_t slot = replay_map_slot( map, id, recorded );;
+          slot          = ( slot + 1 ) & ( map->capacity - 1 ) ) {
+        if ( map->blocks[slot].recorded == recorded && map->blocks[slot].id == id ) {
+            return &map->blocks[slot];
+        }
+
+        if ( map->blocks[slot].recorded == 0 ) {
+            return NULL;
+        }
+    }
+}
+
+static void
+replay_map_insert( replay_map_t* map, const replay_block_t* block ) {
+    if ( ( map->count + 1 ) * 2 > map->capacity ) {
+        replay_map_t grown = { NULL, map->capacity * 2, 0 };
+        grown.blocks = (replay_block_t*)calloc( (size_t)grown.capacity, sizeof( replay_block_t ) );
+        for ( int64_t slot = 0; slot < map->capacity; ++slot ) {
+            if ( map->blocks[slot].recorded != 0 ) {
+                replay_map_insert( &grown, &map->blocks[slot] );
+            }
+        }
+
+        free( map->blocks );
+        *map = grown;
+    }
+
+    int64_t slot = replay_map_slot( map, block->id, block->recorded );
+    while ( map->blocks[slot].recorded != 0 && ( map->blocks[slot].recorded != block->recorded ||
+                                                 map->blocks[slot].id != block->id ) ) {
+        slot = ( slot + 1 ) & ( map->capacity - 1 );
+    }
+
+    map->count += map->blocks[slot].recorded == 0;
+    map->blocks[slot] = *block;
+}
+
+static void
+replay_map_remove( replay_map_t* map, replay_block_t* block ) {
+    // Backward shift, so lookups never need tombstones
+    int64_t hole = block - map->blocks;
+    int64_t slot = hole;
+    map->blocks[hole].recorded = 0;
+    map->count--;
+    for ( ;; ) {
+        slot = ( slot + 1 ) & ( map->capacity - 1 );
+        if ( map->blocks[slot].recorded == 0 ) {
+            return;
+        }
+
+        int64_t home = replay_map_slot( map, map->blocks[slot].id, map->blocks[slot].recorded );
+        if ( ( ( slot - home ) & ( map->capacity - 1 ) ) >=
+             ( ( slot - hole ) & ( map->capacity - 1 ) ) ) {
+            map->blocks[hole]          = map->blocks[slot];
+            map->blocks[slot].recorded = 0;
+            hole                       = slot;
+        }
+    }
+}
+
+static void
+replay_map_init( replay_map_t* map ) {
+    map->capacity = 1024;
+    map->count    = 0;
+    map->blocks   = (replay_block_t*)calloc( (size_t)map->capacity, sizeof( replay_block_t ) );
+}
+
+static srallocator_t*
+replay_create_child( replay_setup_t* setup, const char* name ) {
+    switch ( setup->kind ) {
+    case REPLAY_MALLOC:
+    case REPLAY_HEAP:
+    case REPLAY_PAGE:
+        return setup->root;
+    case REPLAY_PROXY:
+        return sralloc_create_proxy_allocator( name, setup->root );
+    case REPLAY_TLSF:
+        return sralloc_create_tlsf_allocator( name, setup->root, 4 * 1024 * 1024 );
+    case REPLAY_BUDDY:
+        return sralloc_create_buddy_allocator( name, setup->root, setup->capacity, 16 );
+    case REPLAY_ARENA:
+        return sralloc_create_arena_allocator( name, setup->root, 1024 * 1024, 2 );
+    case REPLAY_STACK:
+        return sralloc_create_stack_allocator( name, setup->root, setup->capacity );
+    }
+
+    return NULL;
+}
+
+static void
+replay_create( replay_setup_t* setup ) {
+    setup->num_allocators = 0;
+    switch ( setup->kind ) {
+    case REPLAY_MALLOC:
+        setup->root = sralloc_create_malloc_allocator( "root" );
+        break;
+    case REPLAY_HEAP:
+    case REPLAY_PROXY:
+        setup->root = sralloc_create_heap_allocator( "root" );
+        break;
+    default:
+        setup->root = sralloc_create_page_allocator( "root", 0 );
+        break;
+    }
+}
+
+static void
+replay_destroy( replay_setup_t* setup ) {
+    for ( int i = setup->num_allocators - 1; i >= 0; --i ) {
+        srallocator_t* allocator = setup->allocators[i];
+        switch ( setup->kind ) {
+        case REPLAY_MALLOC:
+        case REPLAY_HEAP:
+        case REPLAY_PAGE:
+            break;
+        case REPLAY_PROXY:
+            sralloc_destroy_proxy_allocator( allocator );
+            break;
+        case REPLAY_TLSF:
+            sralloc_destroy_tlsf_allocator( allocator );
+            break;
+        case REPLAY_BUDDY:
+            sralloc_destroy_buddy_allocator( allocator );
+            break;
+        case REPLAY_ARENA:
+            sralloc_destroy_arena_allocator( allocator );
+            break;
+        case REPLAY_STACK:
+            sralloc_destroy_stack_allocator( allocator );
+            break;
+        }
+    }
+
+    if ( setup->kind == REPLAY_MALLOC ) {
+        sralloc_destroy_malloc_allocator( setup->root );
+    }
+    else if ( setup->kind == REPLAY_HEAP || setup->kind == REPLAY_PROXY ) {
+        sralloc_destroy_heap_allocator( setup->root );
+    }
+    else {
+        sralloc_destroy_page_allocator( setup->root );
+    }
+}
+
+static int
+replay_compare_latency( const void* a, const void* b ) {
+    int64_t diff = *(const int64_t*)a - *(const int64_t*)b;
+    return diff < 0 ? -1 : diff > 0 ? 1 : 0;
+}
+
+static double
+replay_percentile( int64_t* sorted, int64_t count, double percentile ) {
+    if ( count == 0 ) {
+        return 0;
+    }
+
+    return (double)sorted[(int64_t)( percentile * (double)( count - 1 ) )];
+}
+
+// Cost of reading the clock, taken off every single measured latency
+static int64_t
+replay_timer_overhead( void ) {
+    int64_t samples[1001];
+    for ( int i = 0; i < 1001; ++i ) {
+        int64_t start = SRALLOC_time_ns();
+        samples[i]    = SRALLOC_time_ns() - start;
+    }
+    qsort( samples, 1001, sizeof( int64_t ), replay_compare_latency );
+    return samples[500];
+}
+
+// Moves a block the setup couldn't resize in place
+static void*
+replay_move( srallocator_t* allocator, replay_block_t* block, srint_t size ) {
+    void* ptr = sralloc_alloc_aligned( allocator, size, block->align );
+    if ( ptr != NULL ) {
+        memcpy( ptr, block->ptr, (size_t)( size < block->size ? size : block->size ) );
+        sralloc_dealloc_sized( allocator, block->ptr, block->size, block->align );
+    }
+    return ptr;
+}
+
+// Goes through the trace once without an allocator, for what the setups need to know up front
+static void
+replay_summarize( const unsigned char* data, int64_t size, replay_summary_t* summary ) {
+    // Live blocks per allocator id in allocation order, freed ones are dropped lazily
+    replay_map_t live;
+    uint64_t**   stacks      = (uint64_t**)calloc( REPLAY_MAX_ALLOCATORS, sizeof( uint64_t* ) );
+    int64_t      stack_sizes[REPLAY_MAX_ALLOCATORS];
+    int64_t      stack_capacities[REPLAY_MAX_ALLOCATORS];
+    memset( stack_sizes, 0, sizeof( stack_sizes ) );
+    memset( stack_capacities, 0, sizeof( stack_capacities ) );
+    memset( summary, 0, sizeof( *summary ) );
+    replay_map_init( &live );
+
+    sralloc_trace_reader_t reader = { data, size, 0, 0 };
+    sralloc_trace_event_t  event;
+    while ( sralloc_trace_read( &reader, &event ) ) {
+        summary->num_events++;
+        summary->duration_ns = event.time_ns;
+        srint_t id           = event.allocator_id;
+        if ( id < 0 || id >= REPLAY_MAX_ALLOCATORS ) {
+            continue;
+        }
+
+        if ( event.op == SRALLOC_TRACE_NAME ) {
+            summary->num_allocators++;
+        }
+        else if ( event.op == SRALLOC_TRACE_ALLOC && event.ptr != 0 ) {
+            replay_block_t block = { id, event.ptr, NULL, event.size, 0, NULL };
+            replay_map_insert( &live, &block );
+            if ( stack_sizes[id] == stack_capacities[id] ) {
+                stack_capacities[id] = stack_capacities[id] * 2 + 64;
+                stacks[id]           = (uint64_t*)realloc(
+                  stacks[id], sizeof( uint64_t ) * (size_t)stack_capacities[id] );
+            }
+            stacks[id][stack_sizes[id]++] = event.ptr;
+        }
+        else if ( event.op == SRALLOC_TRACE_FREE ) {
+            replay_block_t* block = replay_map_find( &live, id, event.ptr );
+            if ( block == NULL ) {
+                continue;
+            }
+
+            while ( stack_sizes[id] > 0 &&
+                    replay_map_find( &live, id, stacks[id][stack_sizes[id] - 1] ) == NULL ) {
+                stack_sizes[id]--;
+            }
+
+            if ( stack_sizes[id] > 0 && stacks[id][stack_sizes[id] - 1] == event.ptr ) {
+                stack_sizes[id]--;
+            }
+            else {
+                summary->unordered_frees++;
+            }
+            replay_map_remove( &live, block );
+        }
+        else if ( event.op == SRALLOC_TRACE_REALLOC && event.new_ptr != event.ptr &&
+                  event.new_ptr != 0 ) {
+            // A moved block is new as far as a stack is concerned
+            replay_block_t* block = replay_map_find( &live, id, event.ptr );
+            if ( block != NULL ) {
+                replay_map_remove( &live, block );
+                replay_block_t moved = { id, event.new_ptr, NULL, event.size, 0, NULL };
+                replay_map_insert( &live, &moved );
+                summary->unordered_frees++;
+            }
+        }
+    }
+
+    for ( int i = 0; i < REPLAY_MAX_ALLOCATORS; ++i ) {
+        free( stacks[i] );
+    }
+    free( stacks );
+    free( live.blocks );
+}
+
+static void
+replay_run( replay_setup_t*      setup,
+            const unsigned char* data,
+            int64_t              size,
+            int64_t*             latencies,
+            replay_result_t*     result ) {
+    int64_t      timer = replay_timer_overhead();
+    int64_t      total = 0;
+    int64_t      live  = 0;
+    replay_map_t blocks;
+    memset( result, 0, sizeof( *result ) );
+    replay_map_init( &blocks );
+    replay_create( setup );
+
+    sralloc_trace_reader_t reader = { data, size, 0, 0 };
+    sralloc_trace_event_t  event;
+    while ( sralloc_trace_read( &reader, &event ) ) {
+        srint_t id = event.allocator_id;
+        if ( event.op == SRALLOC_TRACE_NAME ) {
+            char name[65];
+            int  length = event.name_length < 64 ? (int)event.name_length : 64;
+            memcpy( name, event.name, (size_t)length );
+            name[length] = 0;
+            while ( setup->num_allocators <= id && id < REPLAY_MAX_ALLOCATORS ) {
+                setup->allocators[setup->num_allocators++] = replay_create_child( setup, name );
+            }
+            continue;
+        }
+
+        if ( id < 0 || id >= setup->num_allocators ) {
+            continue;
+        }
+
+        // Failed calls and blocks from before the recording started are left out
+        srallocator_t*  allocator = setup->allocators[id];
+        replay_block_t* block     = replay_map_find( &blocks, id, event.ptr );
+        int64_t         start     = 0;
+        int64_t         elapsed   = 0;
+        if ( event.op == SRALLOC_TRACE_ALLOC ) {
+            if ( event.ptr == 0 || event.size == 0 ) {
+                continue;
+            }
+
+            start     = SRALLOC_time_ns();
+            void* ptr = sralloc_alloc_aligned( allocator, event.size, event.align );
+            elapsed   = SRALLOC_time_ns() - start;
+            if ( ptr == NULL ) {
+                result->failed++;
+            }
+            else {
+                replay_block_t added = {
+                    id, event.ptr, ptr, event.size, event.align, allocator
+                };
+                replay_map_insert( &blocks, &added );
+                live += event.size;
+            }
+        }
+        else if ( block == NULL ) {
+            continue;
+        }
+        else if ( event.op == SRALLOC_TRACE_FREE ) {
+            start = SRALLOC_time_ns();
+            sralloc_dealloc_sized( block->allocator, block->ptr, block->size, block->align );
+            elapsed = SRALLOC_time_ns() - start;
+            live -= block->size;
+            replay_map_remove( &blocks, block );
+        }
+        else if ( event.op == SRALLOC_TRACE_REALLOC ) {
+            if ( event.new_ptr == 0 ) {
+                continue;
+            }
+
+            start     = SRALLOC_time_ns();
+            void* ptr = sralloc_realloc( block->allocator, block->ptr, event.size, block->align );
+            if ( ptr == NULL ) {
+                ptr = replay_move( block->allocator, block, event.size );
+            }
+            elapsed = SRALLOC_time_ns() - start;
+            if ( ptr == NULL ) {
+                result->failed++;
+                continue;
+            }
+
+            replay_block_t moved = *block;
+            moved.recorded       = event.new_ptr;
+            moved.ptr            = ptr;
+            moved.size           = event.size;
+            live += event.size - block->size;
+            replay_map_remove( &blocks, block );
+            replay_map_insert( &blocks, &moved );
+        }
+        else {
+            // A resize that worked when recorded has to work here too, even if it moves
+            start        = SRALLOC_time_ns();
+            int expanded = sralloc_try_expand( block->allocator, block->ptr, event.size );
+            void* ptr    = block->ptr;
+            if ( !expanded && event.new_ptr != 0 ) {
+                ptr = replay_move( block->allocator, block, event.size );
+            }
+            elapsed = SRALLOC_time_ns() - start;
+            if ( ptr == NULL ) {
+                result->failed++;
+                continue;
+            }
+
+            if ( expanded || event.new_ptr != 0 ) {
+                live += event.size - block->size;
+                block->ptr  = ptr;
+                block->size = event.size;
+            }
+        }
+
+        total += elapsed;
+        latencies[result->ops++] = elapsed - timer;
+        int64_t footprint        = sralloc_get_stats( setup->root ).amount_allocated;
+        if ( footprint > result->peak_footprint ) {
+            result->peak_footprint = footprint;
+        }
+        if ( live > result->peak_live ) {
+            result->peak_live = live;
+        }
+    }
+
+    // Whatever the trace never freed
+    for ( int64_t slot = 0; slot < blocks.capacity; ++slot ) {
+        replay_block_t* left = &blocks.blocks[slot];
+        if ( left->recorded != 0 ) {
+            sralloc_dealloc_sized( left->allocator, left->ptr, left->size, left->align );
+        }
+    }
+
+    free( blocks.blocks );
+    replay_destroy( setup );
+    qsort( latencies, (size_t)result->ops, sizeof( int64_t ), replay_compare_latency );
+    result->ns_per_op = result->ops > 0 ? (double)total / (double)result->ops : 0;
+    if ( result->peak_footprint > 0 ) {
+        result->fragmentation =
+          1.0 - (double)result->peak_live / (double)result->peak_footprint;
+    }
+    result->p50       = replay_percentile( latencies, result->ops, 0.5 );
+    result->p99       = replay_percentile( latencies, result->ops, 0.99 );
+    result->p999      = replay_percentile( latencies, result->ops, 0.999 );
+}
+
+// The unit tests include this file for replay_summarize and replay_run
+#ifndef REPLAY_NO_MAIN
+static const char* replay_names[] = { "malloc", "heap", "page",  "proxy",
+                                      "tlsf",   "buddy", "arena", "stack" };
+
+static void
+replay_print( replay_output_t output, int first, const char* name, const replay_result_t* result ) {
+    switch ( output ) {
+    case REPLAY_OUTPUT_TABLE:
+        if ( first ) {
+            printf( "%-8s %12s %8s %9s %9s %9s %9s %14s %14s %8s\n",
+                    "setup",
+                    "ops",
+                    "failed",
+                    "ns/op",
+                    "p50",
+                    "p99",
+                    "p999",
+                    "peak_bytes",
+                    "peak_live",
+                    "frag" );
+        }
+        printf( "%-8s %12lld %8lld %9.1f %9.0f %9.0f %9.0f %14lld %14lld %7.1f%%\n",
+                name,
+                (long long)result->ops,
+                (long long)result->failed,
+                result->ns_per_op,
+                result->p50,
+                result->p99,
+                result->p999,
+                (long long)result->peak_footprint,
+                (long long)result->peak_live,
+                result->fragmentation * 100.0 );
+        break;
+    case REPLAY_OUTPUT_CSV:
+        if ( first ) {
+            printf( "setup,ops,failed,ns_per_op,p50_ns,p99_ns,p999_ns,peak_bytes,peak_live_bytes,"
+                    "fragmentation\n" );
+        }
+        printf( "%s,%lld,%lld,%.2f,%.0f,%.0f,%.0f,%lld,%lld,%.4f\n",
+                name,
+                (long long)result->ops,
+                (long long)result->failed,
+                result->ns_per_op,
+                result->p50,
+                result->p99,
+                result->p999,
+                (long long)result->peak_footprint,
+                (long long)result->peak_live,
+                result->fragmentation );
+        break;
+    case REPLAY_OUTPUT_JSON:
+        printf( "%s\n  { \"setup\": \"%s\", \"ops\": %lld, \"failed\": %lld, \"ns_per_op\": %.2f, "
+                "\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"p999_ns\": %.0f, \"peak_bytes\": %lld, "
+                "\"peak_live_bytes\": %lld, \"fragmentation\": %.4f }",
+                first ? "[" : ",",
+                name,
+                (long long)result->ops,
+                (long long)result->failed,
+                result->ns_per_op,
+                result->p50,
+                result->p99,
+                result->p999,
+                (long long)result->peak_footprint,
+                (long long)result->peak_live,
+                result->fragmentation );
+        break;
+    }
+}
+
+int
+main( int argc, char** argv ) {
+    replay_output_t output   = REPLAY_OUTPUT_TABLE;
+    const char*     path     = NULL;
+    const char*     filter   = NULL;
+    srint_t         capacity = 256 * 1024 * 1024;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[i], "--csv" ) == 0 ) {
+            output = REPLAY_OUTPUT_CSV;
+        }
+        else if ( strcmp( argv[i], "--json" ) == 0 ) {
+            output = REPLAY_OUTPUT_JSON;
+        }
+        else if ( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc ) {
+            filter = argv[++i];
+        }
+        else if ( strcmp( argv[i], "--capacity" ) == 0 && i + 1 < argc ) {
+            capacity = (srint_t)strtoll( argv[++i], NULL, 10 );
+        }
+        else if ( path == NULL && argv[i][0] != '-' ) {
+            path = argv[i];
+        }
+        else {
+            path = NULL;
+            break;
+        }
+    }
+
+    if ( path == NULL ) {
+        fprintf( stderr,
+                 "usage: %s <trace> [--csv | --json] [--filter <name>] [--capacity <bytes>]\n",
+                 argv[0] );
+        return 1;
+    }
+
+    FILE* file = fopen( path, "rb" );
+    if ( file == NULL ) {
+        fprintf( stderr, "can't open %s\n", path );
+        return 1;
+    }
+
+    fseek( file, 0, SEEK_END );
+    int64_t size = (int64_t)ftell( file );
+    fseek( file, 0, SEEK_SET );
+    unsigned char* data = (unsigned char*)malloc( (size_t)( size > 0 ? size : 1 ) );
+    int64_t        read = (int64_t)fread( data, 1, (size_t)size, file );
+    fclose( file );
+
+    replay_summary_t summary;
+    replay_summarize( data, read, &summary );
+    if ( summary.num_events == 0 ) {
+        fprintf( stderr, "%s isn't a trace\n", path );
+        free( data );
+        return 1;
+    }
+
+    // The stack only works when every allocator freed its blocks in reverse order
+    fprintf( stderr,
+             "%lld events from %lld allocators over %.3f s, %lld frees out of stack order\n",
+             (long long)summary.num_events,
+             (long long)summary.num_allocators,
+             (double)summary.duration_ns / 1e9,
+             (long long)summary.unordered_frees );
+
+    int64_t* latencies = (int64_t*)malloc( sizeof( int64_t ) * (size_t)summary.num_events );
+    int      first     = 1;
+    for ( int kind = REPLAY_MALLOC; kind <= REPLAY_STACK; ++kind ) {
+        const char* name = replay_names[kind];
+        if ( filter != NULL && strncmp( name, filter, strlen( filter ) ) != 0 ) {
+            continue;
+        }
+
+        if ( kind == REPLAY_STACK && summary.unordered_frees > 0 ) {
+            continue;
+        }
+
+        replay_setup_t  setup;
+        replay_result_t result;
+        memset( &setup, 0, sizeof( setup ) );
+        setup.kind     = (replay_kind_t)kind;
+        setup.capacity = capacity;
+        replay_run( &setup, data, read, latencies, &result );
+        replay_print( output, first, name, &result );
+        first = 0;
+    }
+
+    if ( output == REPLAY_OUTPUT_JSON ) {
+        printf( "%s\n", first ? "[]" : "\n]" );
+    }
+
+    free( latencies );
+    free( data );
+    return 0;
+}
+#endif // REPLAY_NO_MAIN
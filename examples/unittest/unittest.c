@@ -45,8 +45,15 @@
 
 #ifdef SRALLOC_DISABLE_STATS
 #define lequal( ... )
+#elif defined( SRALLOC_64BIT_SIZES )
+// Sizes and counts are 64 bit, so print them as such
+#undef lequal
+#define lequal( a, b ) lequal_base( ( a ) == ( b ), (long long)( a ), (long long)( b ), "%lld" )
 #endif
 
+#define REPLAY_NO_MAIN
+#include "../replay/replay.c"
+
 sr_result_t
 unittest_alloc( srallocator_t* allocator, int size ) {
     sr_result_t res = sralloc_alloc_with_size( allocator, size );
@@ -65,37 +72,37 @@ unittest_dealloc( srallocator_t* allocator, sr_result_t res ) {
 
 void
 generic_allocator_tests( srallocator_t* allocator ) {
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 
     // Single
     sr_result_t pA1 = unittest_alloc( allocator, 73 );
-    lequal( allocator->stats.num_allocations, 1 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 1 );
     unittest_dealloc( allocator, pA1 );
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 
     // Multiple
     sr_result_t pB1 = unittest_alloc( allocator, 27 );
     sr_result_t pB2 = unittest_alloc( allocator, 57 );
-    lequal( allocator->stats.num_allocations, 2 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 2 );
     unittest_dealloc( allocator, pB2 );
-    lequal( allocator->stats.num_allocations, 1 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 1 );
     unittest_dealloc( allocator, pB1 );
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 
     // Aligned
     void* psC[10];
     for ( int i = 0; i < 10; i++ ) {
         psC[i] = sralloc_alloc_aligned( allocator, i * 7 + 100, 16 );
     }
-    lequal( allocator->stats.num_allocations, 10 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 10 );
     for ( int i = 0; i < 10; i++ ) {
         sralloc_dealloc( allocator, psC[i] );
     }
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 
     // Test returned size
     sr_result_t psD[10];
@@ -105,24 +112,24 @@ generic_allocator_tests( srallocator_t* allocator ) {
     for ( int i = 0; i < 10; i++ ) {
         memset( psD[i].ptr, i + 150, psD[i].size );
     }
-    lequal( allocator->stats.num_allocations, 10 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 10 );
     for ( int i = 0; i < 10; i++ ) {
         sralloc_dealloc( allocator, psD[i].ptr );
     }
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 
     // Test returned size 2
     sr_result_t psE[10];
     for ( int i = 0; i < 10; i++ ) {
         psE[i] = unittest_alloc( allocator, i * 7 + 100 );
     }
-    lequal( allocator->stats.num_allocations, 10 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 10 );
     for ( int i = 0; i < 10; i++ ) {
         unittest_dealloc( allocator, psE[i] );
     }
-    lequal( allocator->stats.num_allocations, 0 );
-    lequal( allocator->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
 }
 
 void
@@ -132,6 +139,180 @@ malloc_test( void ) {
     sralloc_destroy_malloc_allocator( mallocalloc );
 }
 
+void
+heap_test( void ) {
+    srallocator_t* heapalloc = sralloc_create_heap_allocator( "root" );
+    generic_allocator_tests( heapalloc );
+
+    // Small blocks are rounded up to their size class and have no preamble
+    sr_result_t pA1 = unittest_alloc( heapalloc, 100 );
+    sr_result_t pA2 = unittest_alloc( heapalloc, 100 );
+    lequal( pA1.size, 112 );
+    int distance = (int)( (char*)pA2.ptr - (char*)pA1.ptr );
+    lok( distance == 112 || distance == -112 );
+    unittest_dealloc( heapalloc, pA2 );
+    unittest_dealloc( heapalloc, pA1 );
+
+    // Aligned and large allocations
+    int aligns[] = { 16, 64, 256, 4096 };
+    int sizes[]  = { 8, 1000, 9000, 300000 };
+    for ( int i_align = 0; i_align < 4; ++i_align ) {
+        for ( int i_size = 0; i_size < 4; ++i_size ) {
+            sr_result_t res =
+              sralloc_alloc_aligned_with_size( heapalloc, sizes[i_size], aligns[i_align] );
+            lequal( (int)( (sruintptr_t)res.ptr & ( aligns[i_align] - 1 ) ), 0 );
+            lok( res.size >= sizes[i_size] );
+            memset( res.ptr, 0x11, res.size );
+            sralloc_dealloc( heapalloc, res.ptr );
+        }
+    }
+    lequal( sralloc_get_stats( heapalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( heapalloc ).amount_allocated, 0 );
+
+    // Mixed sizes freed in scrambled order, spanning several spans and segments
+    static sr_result_t ptrs[5000];
+    for ( int i = 0; i < 5000; ++i ) {
+        ptrs[i] = unittest_alloc( heapalloc, 1 + ( i * 7919 ) % ( i % 50 == 0 ? 20000 : 700 ) );
+    }
+    for ( int i = 0; i < 5000; ++i ) {
+        int i_ptr = ( i * 2503 ) % 5000;
+        unittest_dealloc( heapalloc, ptrs[i_ptr] );
+    }
+    lequal( sralloc_get_stats( heapalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( heapalloc ).amount_allocated, 0 );
+
+    // Alignments the span lookup can't handle fail instead of asserting
+    lok( sralloc_alloc_aligned( heapalloc, 100, 1 << 20 ) == SRALLOC_NULL );
+
+    // After a burst only a few empty spans keep their pages, the rest are reused once committed
+    srallocator_heap_t* heap = (srallocator_heap_t*)( heapalloc + 1 );
+    static void*        burst[40000];
+    for ( int round = 0; round < 2; ++round ) {
+        for ( int i = 0; i < 40000; ++i ) {
+            burst[i] = sralloc_alloc( heapalloc, 64 );
+            lok( burst[i] != SRALLOC_NULL );
+            *(int*)burst[i] = i;
+        }
+        for ( int i = 0; i < 40000; ++i ) {
+            lequal( *(int*)burst[i], i );
+            sralloc_dealloc( heapalloc, burst[i] );
+        }
+        lequal( (int)heap->num_free_spans, SRALLOC_HEAP_MAX_FREE_SPANS );
+        lok( heap->released_spans != SRALLOC_NULL );
+    }
+    lequal( sralloc_get_stats( heapalloc ).amount_allocated, 0 );
+
+    srallocator_t* proxyalloc = sralloc_create_proxy_allocator( "proxy", heapalloc );
+    generic_allocator_tests( proxyalloc );
+    srallocator_t* stackalloc = sralloc_create_stack_allocator( "stack", proxyalloc, 100000 );
+    generic_allocator_tests( stackalloc );
+    sralloc_destroy_stack_allocator( stackalloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    sralloc_destroy_heap_allocator( heapalloc );
+}
+
+void
+page_test( void ) {
+    srallocator_t* pagealloc = sralloc_create_page_allocator( "pages", 0 );
+    generic_allocator_tests( pagealloc );
+
+    // Whole pages, aligned to at least the page size
+    sr_result_t pA = unittest_alloc( pagealloc, 100 );
+    lequal( (int)pA.size, SRALLOC_PAGE_SIZE );
+    lequal( (int)( (sruintptr_t)pA.ptr & ( SRALLOC_PAGE_SIZE - 1 ) ), 0 );
+    void* pB = sralloc_alloc_aligned( pagealloc, 100, 64 * 1024 );
+    lequal( (int)( (sruintptr_t)pB & ( 64 * 1024 - 1 ) ), 0 );
+    lok( sralloc_try_expand( pagealloc, pA.ptr, SRALLOC_PAGE_SIZE ) );
+    lok( !sralloc_try_expand( pagealloc, pA.ptr, SRALLOC_PAGE_SIZE + 1 ) );
+    lequal( sralloc_page_allocator_stats( pagealloc ).mapped, SRALLOC_PAGE_SIZE * 2 );
+    lequal( sralloc_page_allocator_stats( pagealloc ).huge_page_bytes, 0 );
+
+    // Enough live mappings to make the side table grow and shift entries on removal
+    void* ptrs[600];
+    for ( int i = 0; i < 600; ++i ) {
+        ptrs[i] = sralloc_alloc( pagealloc, 1 + i * 100 );
+        lok( ptrs[i] != SRALLOC_NULL );
+    }
+    for ( int i = 0; i < 600; i += 3 ) {
+        sralloc_dealloc( pagealloc, ptrs[i] );
+    }
+    for ( int i = 1; i < 600; ++i ) {
+        if ( i % 3 != 0 ) {
+            sralloc_dealloc( pagealloc, ptrs[i] );
+        }
+    }
+    unittest_dealloc( pagealloc, pA );
+    sralloc_dealloc( pagealloc, pB );
+    lequal( sralloc_page_allocator_stats( pagealloc ).mapped, 0 );
+
+    // Huge page aligned mappings spread over the side table too
+    srallocator_page_t* page_allocator = (srallocator_page_t*)( pagealloc + 1 );
+    static char         used[4096];
+    int                 num_homes = 0;
+    lok( page_allocator->spans_capacity >= 256 && page_allocator->spans_capacity <= 4096 );
+    for ( int i = 0; i < 200; ++i ) {
+        srint_t home = sr__page_home( page_allocator, (void*)( (sruintptr_t)i << 21 ) );
+        num_homes += !used[home];
+        used[home] = 1;
+    }
+    lok( num_homes > 100 );
+    sralloc_destroy_page_allocator( pagealloc );
+
+    // Huge pages are a request, how many are granted depends on the system
+    srallocator_t* hugealloc = sralloc_create_page_allocator( "huge_pages", 1 );
+    srint_t        size      = SRALLOC_HUGE_PAGE_SIZE * 4;
+    char*          pC        = (char*)sralloc_alloc( hugealloc, size );
+    lok( pC != SRALLOC_NULL );
+    memset( pC, 1, size );
+    sralloc_page_stats_t stats = sralloc_page_allocator_stats( hugealloc );
+    lok( stats.mapped >= size );
+    lok( stats.huge_page_bytes >= 0 && stats.huge_page_bytes <= stats.mapped );
+    sralloc_dealloc( hugealloc, pC );
+    lequal( sralloc_page_allocator_stats( hugealloc ).huge_page_bytes, 0 );
+    sralloc_destroy_page_allocator( hugealloc );
+}
+
+void
+numa_test( void ) {
+    srallocator_t* numaalloc = sralloc_create_numa_allocator( "numa", 0 );
+    generic_allocator_tests( sralloc_numa_allocator_node( numaalloc, 0 ) );
+    srint_t num_nodes = sralloc_numa_allocator_num_nodes( numaalloc );
+    lok( num_nodes >= 1 );
+
+    // Every node has its own allocator and stats, the NUMA allocator sees them all
+    for ( srint_t node = 0; node < num_nodes; ++node ) {
+        srallocator_t*  nodealloc = sralloc_numa_allocator_node( numaalloc, node );
+        sralloc_stats_t before    = sralloc_get_stats( nodealloc );
+        srallocator_t*  stackalloc =
+          sralloc_create_stack_allocator( "worker_frame", nodealloc, 1024 * 1024 );
+        lequal( sralloc_get_stats( nodealloc ).num_allocations, before.num_allocations + 1 );
+        char* ptr = (char*)SRALLOC_BYTES( stackalloc, 1000 );
+        memset( ptr, 1, 1000 );
+        lok( sralloc_page_allocator_stats( nodealloc ).mapped >= 1024 * 1024 );
+        SRALLOC_DEALLOC( stackalloc, ptr );
+        sralloc_destroy_stack_allocator( stackalloc );
+        lequal( sralloc_get_stats( nodealloc ).num_allocations, before.num_allocations );
+    }
+
+    // Allocating from the NUMA allocator itself binds to the calling thread's node, its own
+    // stats start out with the list of node allocators
+    sralloc_stats_t before = sralloc_get_stats( numaalloc );
+    void*           pA     = sralloc_alloc( numaalloc, 100000 );
+    lequal( sralloc_get_stats( numaalloc ).num_allocations, before.num_allocations + 1 );
+    srint_t node_total = sralloc_get_stats( numaalloc ).amount_allocated;
+    for ( srint_t node = 0; node < num_nodes; ++node ) {
+        node_total += sralloc_get_stats( sralloc_numa_allocator_node( numaalloc, node ) )
+                        .amount_allocated;
+    }
+    lequal( sralloc_get_total_stats( numaalloc ).amount_allocated, node_total );
+    pA = sralloc_realloc( numaalloc, pA, 200000, 0 );
+    lok( pA != SRALLOC_NULL );
+    sralloc_dealloc( numaalloc, pA );
+    lequal( sralloc_get_stats( numaalloc ).num_allocations, before.num_allocations );
+    lok( sralloc_numa_allocator_local_node( numaalloc ) != SRALLOC_NULL );
+    sralloc_destroy_numa_allocator( numaalloc );
+}
+
 void
 stack_test( void ) {
     {
@@ -139,8 +320,8 @@ stack_test( void ) {
         srallocator_t* stackalloc  = sralloc_create_stack_allocator( "stack", mallocalloc, 20000 );
         generic_allocator_tests( stackalloc );
         sralloc_destroy_stack_allocator( stackalloc );
-        lequal( mallocalloc->stats.num_allocations, 0 );
-        lequal( mallocalloc->stats.amount_allocated, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
         sralloc_destroy_malloc_allocator( mallocalloc );
     }
     {
@@ -152,7 +333,7 @@ stack_test( void ) {
         void* pA2 = SRALLOC_BYTES( stackalloc, 100 );
         (void)pA2;
         sralloc_stack_allocator_pop_state( stackalloc );
-        lequal( stackalloc->stats.num_allocations, 1 );
+        lequal( sralloc_get_stats( stackalloc ).num_allocations, 1 );
         int* pA3 = SRALLOC_OBJECT( stackalloc, int );
         *pA3     = 333;
         lequal( *pA1, 111 );
@@ -160,12 +341,240 @@ stack_test( void ) {
         lequal( *pA3, 333 );
         SRALLOC_DEALLOC( stackalloc, pA3 );
         SRALLOC_DEALLOC( stackalloc, pA1 );
-        lequal( stackalloc->stats.num_allocations, 0 );
+        lequal( sralloc_get_stats( stackalloc ).num_allocations, 0 );
         sralloc_destroy_stack_allocator( stackalloc );
-        lequal( mallocalloc->stats.num_allocations, 0 );
-        lequal( mallocalloc->stats.amount_allocated, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
         sralloc_destroy_malloc_allocator( mallocalloc );
     }
+    {
+        srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+        srallocator_t* stackalloc  = sralloc_create_virtual_stack_allocator(
+          "virtual_stack", mallocalloc, 256 * 1024 * 1024, SRALLOC_STACK_COMMIT_SIZE );
+        generic_allocator_tests( stackalloc );
+        lequal( sralloc_stack_allocator_committed( stackalloc ), SRALLOC_STACK_COMMIT_SIZE );
+
+        // Pages get committed as top moves and stay where they are
+        char* pA = (char*)SRALLOC_BYTES( stackalloc, 100 );
+        pA[99]   = 1;
+        sralloc_stack_allocator_push_state( stackalloc );
+        char* pB = (char*)SRALLOC_BYTES( stackalloc, 8 * 1024 * 1024 );
+        memset( pB, 2, 8 * 1024 * 1024 );
+        lok( sralloc_stack_allocator_committed( stackalloc ) > 8 * 1024 * 1024 );
+        lok( sralloc_realloc( stackalloc, pB, 16 * 1024 * 1024, 0 ) == pB );
+        pB[16 * 1024 * 1024 - 1] = 3;
+        lequal( pA[99], 1 );
+        lok( SRALLOC_BYTES( stackalloc, 256 * 1024 * 1024 ) == SRALLOC_NULL );
+
+        // Everything past top above the high-water mark to keep is given back
+        sralloc_stack_allocator_pop_state( stackalloc );
+        lequal( sralloc_stack_allocator_committed( stackalloc ), SRALLOC_STACK_COMMIT_SIZE );
+        SRALLOC_DEALLOC( stackalloc, pA );
+        sralloc_stack_allocator_clear( stackalloc );
+        lequal( sralloc_stack_allocator_committed( stackalloc ), SRALLOC_STACK_COMMIT_SIZE );
+        sralloc_destroy_stack_allocator( stackalloc );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+        sralloc_destroy_malloc_allocator( mallocalloc );
+    }
+}
+
+void
+arena_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* arenaalloc  = sralloc_create_arena_allocator( "arena", mallocalloc, 1024, 2 );
+    generic_allocator_tests( arenaalloc );
+
+    // Earlier blocks stay put when the arena chains new ones
+    char* pA = (char*)SRALLOC_BYTES( arenaalloc, 100 );
+    pA[0]    = 1;
+    sralloc_arena_allocator_push_state( arenaalloc );
+    srint_t parent_allocations = sralloc_get_stats( mallocalloc ).num_allocations;
+    for ( int i = 0; i < 100; ++i ) {
+        char* pB = (char*)SRALLOC_BYTES( arenaalloc, 500 );
+        lok( pB != SRALLOC_NULL );
+        pB[499] = 2;
+    }
+    void* pC = SRALLOC_BYTES( arenaalloc, 100000 );
+    lok( pC != SRALLOC_NULL );
+    lok( sralloc_get_stats( mallocalloc ).num_allocations > parent_allocations );
+    lequal( pA[0], 1 );
+
+    // Popping gives back the blocks chained since the push
+    sralloc_arena_allocator_pop_state( arenaalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, parent_allocations );
+    lequal( sralloc_get_stats( arenaalloc ).num_allocations, 1 );
+    char* pD = (char*)SRALLOC_BYTES( arenaalloc, 100 );
+    lok( pD > pA );
+    SRALLOC_DEALLOC( arenaalloc, pD );
+    SRALLOC_DEALLOC( arenaalloc, pA );
+
+    // Clearing keeps only the largest block and drops the states pushed before it
+    sralloc_arena_allocator_push_state( arenaalloc );
+    for ( int i = 0; i < 100; ++i ) {
+        SRALLOC_BYTES( arenaalloc, 1000 );
+    }
+    sralloc_arena_allocator_clear( arenaalloc );
+    lequal( (int)( (srallocator_arena_t*)( arenaalloc + 1 ) )->num_states, 0 );
+    lequal( sralloc_get_stats( arenaalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 3 );
+    lok( SRALLOC_BYTES( arenaalloc, 1000 ) != SRALLOC_NULL );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 3 );
+    sralloc_arena_allocator_clear( arenaalloc );
+
+    sralloc_destroy_arena_allocator( arenaalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+buddy_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* buddyalloc  = sralloc_create_buddy_allocator( "buddy", mallocalloc, 4096, 64 );
+    generic_allocator_tests( buddyalloc );
+
+    // Sizes are rounded up to a power of two and the whole block is handed out
+    sr_result_t pA = unittest_alloc( buddyalloc, 100 );
+    sr_result_t pB = unittest_alloc( buddyalloc, 1 );
+    sr_result_t pC = sralloc_alloc_aligned_with_size( buddyalloc, 10, 256 );
+    lequal( pA.size, 128 );
+    lequal( pB.size, 64 );
+    lequal( pC.size, 256 );
+    lequal( (int)( (sruintptr_t)pC.ptr & 255 ), 0 );
+    lequal( sralloc_get_stats( buddyalloc ).amount_allocated, 128 + 64 + 256 );
+    lequal( sralloc_buddy_allocator_stats( buddyalloc ).free, 4096 - 128 - 64 - 256 );
+    lequal( sralloc_buddy_allocator_stats( buddyalloc ).largest_free_block, 2048 );
+    lok( sralloc_alloc( buddyalloc, 4096 ) == SRALLOC_NULL );
+    lok( sralloc_try_expand( buddyalloc, pA.ptr, 128 ) );
+    lok( !sralloc_try_expand( buddyalloc, pA.ptr, 129 ) );
+    unittest_dealloc( buddyalloc, pA );
+    unittest_dealloc( buddyalloc, pB );
+    sralloc_dealloc( buddyalloc, pC.ptr );
+
+    // Everything merges back into one block
+    sralloc_buddy_stats_t stats = sralloc_buddy_allocator_stats( buddyalloc );
+    lequal( stats.free, 4096 );
+    lequal( stats.largest_free_block, 4096 );
+    lequal( stats.num_free_blocks, 1 );
+
+    // Freeing every other block leaves half the memory free in blocks that can't merge
+    void* ptrs[64];
+    for ( int i = 0; i < 64; ++i ) {
+        ptrs[i] = sralloc_alloc( buddyalloc, 64 );
+        lok( ptrs[i] != SRALLOC_NULL );
+    }
+    lok( sralloc_alloc( buddyalloc, 1 ) == SRALLOC_NULL );
+    for ( int i = 0; i < 64; i += 2 ) {
+        sralloc_dealloc( buddyalloc, ptrs[i] );
+    }
+    stats = sralloc_buddy_allocator_stats( buddyalloc );
+    lequal( stats.free, 2048 );
+    lequal( stats.largest_free_block, 64 );
+    lequal( stats.num_free_blocks, 32 );
+    lok( sralloc_alloc( buddyalloc, 65 ) == SRALLOC_NULL );
+    for ( int i = 1; i < 64; i += 2 ) {
+        sralloc_dealloc( buddyalloc, ptrs[i] );
+    }
+    lequal( sralloc_buddy_allocator_stats( buddyalloc ).num_free_blocks, 1 );
+
+    // Random sizes in random order
+    sr_result_t blocks[32];
+    memset( blocks, 0, sizeof( blocks ) );
+    for ( int i = 0; i < 2000; ++i ) {
+        sr_result_t* block = &blocks[( i * 7 ) % 32];
+        if ( block->ptr != SRALLOC_NULL ) {
+            unittest_dealloc( buddyalloc, *block );
+            block->ptr = SRALLOC_NULL;
+        }
+        else {
+            *block = sralloc_alloc_with_size( buddyalloc, 1 + ( i * 37 ) % 300 );
+            if ( block->ptr != SRALLOC_NULL ) {
+                memset( block->ptr, ( ( (sruintptr_t)block->ptr ) & 0xFF0 ) >> 8, block->size );
+            }
+        }
+    }
+    for ( int i = 0; i < 32; ++i ) {
+        if ( blocks[i].ptr != SRALLOC_NULL ) {
+            unittest_dealloc( buddyalloc, blocks[i] );
+        }
+    }
+    lequal( sralloc_buddy_allocator_stats( buddyalloc ).largest_free_block, 4096 );
+
+    sralloc_destroy_buddy_allocator( buddyalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+tlsf_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* tlsfalloc   = sralloc_create_tlsf_allocator( "tlsf", mallocalloc, 64 * 1024 );
+    generic_allocator_tests( tlsfalloc );
+    srint_t parent_allocations = sralloc_get_stats( mallocalloc ).num_allocations;
+
+    // Neighbours are merged as soon as they're freed, whatever the order
+    void* pA = sralloc_alloc( tlsfalloc, 1000 );
+    void* pB = sralloc_alloc( tlsfalloc, 1000 );
+    void* pC = sralloc_alloc( tlsfalloc, 1000 );
+    sralloc_dealloc( tlsfalloc, pA );
+    sralloc_dealloc( tlsfalloc, pC );
+    sralloc_dealloc( tlsfalloc, pB );
+    void* pD = sralloc_alloc( tlsfalloc, 60 * 1024 );
+    lok( pD != SRALLOC_NULL );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, parent_allocations );
+
+    // The block after pD is free, so it can grow in place
+    lok( sralloc_try_expand( tlsfalloc, pD, 62 * 1024 ) );
+    lok( sralloc_try_expand( tlsfalloc, pD, 100 ) );
+    lok( !sralloc_try_expand( tlsfalloc, pD, 64 * 1024 ) );
+    sralloc_dealloc( tlsfalloc, pD );
+
+    // Another pool is added when none has room
+    void* pE = sralloc_alloc( tlsfalloc, 100 * 1024 );
+    lok( pE != SRALLOC_NULL );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, parent_allocations + 1 );
+    sralloc_dealloc( tlsfalloc, pE );
+
+    // Also for sizes that aren't on a free list boundary
+    void* pF = sralloc_alloc( tlsfalloc, 100 * 1024 + 1 );
+    lok( pF != SRALLOC_NULL );
+    sralloc_dealloc( tlsfalloc, pF );
+
+    for ( int align = 32; align <= 4096; align *= 2 ) {
+        sr_result_t res = sralloc_alloc_aligned_with_size( tlsfalloc, 100, align );
+        lequal( (int)( (sruintptr_t)res.ptr & ( align - 1 ) ), 0 );
+        lok( res.size >= 100 );
+        memset( res.ptr, 1, res.size );
+        sralloc_dealloc( tlsfalloc, res.ptr );
+    }
+
+    // Random sizes in random order
+    sr_result_t blocks[64];
+    memset( blocks, 0, sizeof( blocks ) );
+    for ( int i = 0; i < 5000; ++i ) {
+        sr_result_t* block = &blocks[( i * 13 ) % 64];
+        if ( block->ptr != SRALLOC_NULL ) {
+            unittest_dealloc( tlsfalloc, *block );
+            block->ptr = SRALLOC_NULL;
+        }
+        else {
+            *block = unittest_alloc( tlsfalloc, 1 + ( i * 337 ) % 5000 );
+        }
+    }
+    for ( int i = 0; i < 64; ++i ) {
+        if ( blocks[i].ptr != SRALLOC_NULL ) {
+            unittest_dealloc( tlsfalloc, blocks[i] );
+        }
+    }
+
+    lequal( sralloc_get_stats( tlsfalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( tlsfalloc ).amount_allocated, 0 );
+    sralloc_destroy_tlsf_allocator( tlsfalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
 }
 
 void
@@ -176,13 +585,15 @@ proxy_test( void ) {
     generic_allocator_tests( proxyalloc1 );
     generic_allocator_tests( proxyalloc2 );
     srallocator_t* proxyalloc3 = sralloc_create_proxy_allocator( "proxy3", proxyalloc2 );
-    lequal( proxyalloc2->stats.num_allocations, 1 );
+#ifndef SRALLOC_DISABLE_PROXY
+    lequal( sralloc_get_stats( proxyalloc2 ).num_allocations, 1 );
+#endif
     generic_allocator_tests( proxyalloc3 );
     sralloc_destroy_proxy_allocator( proxyalloc3 );
     sralloc_destroy_proxy_allocator( proxyalloc1 );
     sralloc_destroy_proxy_allocator( proxyalloc2 );
-    lequal( mallocalloc->stats.num_allocations, 0 );
-    lequal( mallocalloc->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
     sralloc_destroy_malloc_allocator( mallocalloc );
 }
 
@@ -198,11 +609,1446 @@ end_of_page_test( void ) {
     // }
     unittest_dealloc( eopalloc, pA1 );
     sralloc_destroy_end_of_page_allocator( eopalloc );
-    lequal( mallocalloc->stats.num_allocations, 0 );
-    lequal( mallocalloc->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+slot_test( void ) {
+    {
+        srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+        srallocator_t* slotalloc   = sralloc_create_slot_allocator( "slot", mallocalloc, 176, 32 );
+        generic_allocator_tests( slotalloc );
+        sralloc_destroy_slot_allocator( slotalloc );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+        sralloc_destroy_malloc_allocator( mallocalloc );
+    }
+    {
+        srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+        srallocator_t* slotalloc   = sralloc_create_slot_allocator( "slot", mallocalloc, 24, 4 );
+        void*          pA[4];
+        for ( int i = 0; i < 4; ++i ) {
+            pA[i] = SRALLOC_BYTES( slotalloc, 24 );
+            lok( pA[i] != SRALLOC_NULL );
+        }
+        lok( SRALLOC_BYTES( slotalloc, 24 ) == SRALLOC_NULL );
+        lok( SRALLOC_BYTES( slotalloc, 25 ) == SRALLOC_NULL );
+        lequal( sralloc_get_stats( slotalloc ).num_allocations, 4 );
+        lequal( sralloc_get_stats( slotalloc ).amount_allocated, 4 * 24 );
+
+        // Freed slots are handed out again, most recent first
+        SRALLOC_DEALLOC( slotalloc, pA[1] );
+        SRALLOC_DEALLOC( slotalloc, pA[2] );
+        lok( SRALLOC_BYTES( slotalloc, 8 ) == pA[2] );
+        lok( SRALLOC_BYTES( slotalloc, 8 ) == pA[1] );
+        for ( int i = 0; i < 4; ++i ) {
+            SRALLOC_DEALLOC( slotalloc, pA[i] );
+        }
+        lequal( sralloc_get_stats( slotalloc ).num_allocations, 0 );
+        sralloc_destroy_slot_allocator( slotalloc );
+        sralloc_destroy_malloc_allocator( mallocalloc );
+    }
+    {
+        srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+        srallocator_t* slotalloc =
+          sralloc_create_growing_slot_allocator( "slot", mallocalloc, 64, 8 );
+        void* pA[100];
+        for ( int i = 0; i < 100; ++i ) {
+            pA[i] = SRALLOC_ALIGNED_BYTES( slotalloc, 64, 64 );
+            lok( pA[i] != SRALLOC_NULL );
+            lequal( (int)( (sruintptr_t)pA[i] & 63 ), 0 );
+            *(int*)pA[i] = i;
+        }
+        lequal( sralloc_get_stats( slotalloc ).num_allocations, 100 );
+        for ( int i = 0; i < 100; ++i ) {
+            lequal( *(int*)pA[i], i );
+            SRALLOC_DEALLOC( slotalloc, pA[i] );
+        }
+        lequal( sralloc_get_stats( slotalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( slotalloc ).amount_allocated, 0 );
+        sralloc_destroy_slot_allocator( slotalloc );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+        sralloc_destroy_malloc_allocator( mallocalloc );
+    }
+}
+
+#ifdef _WIN32
+typedef HANDLE unittest_thread_t;
+typedef DWORD  unittest_thread_result_t;
+#define UNITTEST_THREAD_CALL WINAPI
+#else
+#include <pthread.h>
+typedef pthread_t unittest_thread_t;
+typedef void*     unittest_thread_result_t;
+#define UNITTEST_THREAD_CALL
+#endif
+
+typedef unittest_thread_result_t( UNITTEST_THREAD_CALL* unittest_thread_func_t )( void* );
+
+static unittest_thread_t
+unittest_thread_start( unittest_thread_func_t func, void* arg ) {
+#ifdef _WIN32
+    return CreateThread( NULL, 0, func, arg, 0, NULL );
+#else
+    pthread_t thread;
+    pthread_create( &thread, NULL, func, arg );
+    return thread;
+#endif
+}
+
+static int
+unittest_thread_join( unittest_thread_t thread ) {
+#ifdef _WIN32
+    DWORD result = 0;
+    WaitForSingleObject( thread, INFINITE );
+    GetExitCodeThread( thread, &result );
+    CloseHandle( thread );
+    return (int)result;
+#else
+    void* result = NULL;
+    pthread_join( thread, &result );
+    return result != NULL;
+#endif
+}
+
+#define UNITTEST_NUM_THREADS 4
+
+static unittest_thread_result_t UNITTEST_THREAD_CALL
+mutex_test_thread( void* arg ) {
+    srallocator_t* allocator = (srallocator_t*)arg;
+    void*          ptrs[64];
+    for ( int round = 0; round < 200; ++round ) {
+        for ( int i = 0; i < 64; ++i ) {
+            ptrs[i] = SRALLOC_BYTES( allocator, 16 + ( i * 13 + round ) % 200 );
+            *(int*)ptrs[i] = i;
+        }
+        for ( int i = 0; i < 64; ++i ) {
+            if ( *(int*)ptrs[i] != i ) {
+                return 0;
+            }
+            SRALLOC_DEALLOC( allocator, ptrs[i] );
+        }
+    }
+    return 0;
+}
+
+void
+mutex_test( void ) {
+    sralloc_lock_type_t lock_types[] = { SRALLOC_LOCK_MUTEX, SRALLOC_LOCK_SPINLOCK };
+    for ( int i_type = 0; i_type < 2; ++i_type ) {
+        srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+        srallocator_t* stackalloc  = sralloc_create_stack_allocator( "stack", mallocalloc, 20000 );
+        srallocator_t* mutexalloc =
+          sralloc_create_mutex_allocator( "mutex", stackalloc, lock_types[i_type] );
+        generic_allocator_tests( mutexalloc );
+        sralloc_destroy_mutex_allocator( mutexalloc );
+        sralloc_destroy_stack_allocator( stackalloc );
+
+        // Every worker gets its own proxy for tracking, all sharing one locked parent
+        mutexalloc = sralloc_create_mutex_allocator( "mutex", mallocalloc, lock_types[i_type] );
+        srallocator_t*    proxies[UNITTEST_NUM_THREADS];
+        unittest_thread_t threads[UNITTEST_NUM_THREADS];
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            proxies[i] = sralloc_create_proxy_allocator( "worker", mutexalloc );
+        }
+#ifndef SRALLOC_DISABLE_PROXY
+        lequal( sralloc_get_stats( mutexalloc ).num_allocations, UNITTEST_NUM_THREADS );
+#endif
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            threads[i] = unittest_thread_start( mutex_test_thread, proxies[i] );
+        }
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            unittest_thread_join( threads[i] );
+        }
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            lequal( sralloc_get_stats( proxies[i] ).num_allocations, 0 );
+            sralloc_destroy_proxy_allocator( proxies[i] );
+        }
+
+        sralloc_lock_stats_t lock_stats = sralloc_mutex_allocator_lock_stats( mutexalloc );
+        lok( lock_stats.num_acquisitions >= UNITTEST_NUM_THREADS * 200 * 64 * 2 );
+        lok( lock_stats.num_contended <= lock_stats.num_acquisitions );
+        lequal( sralloc_get_stats( mutexalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mutexalloc ).amount_allocated, 0 );
+        sralloc_destroy_mutex_allocator( mutexalloc );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+        sralloc_destroy_malloc_allocator( mallocalloc );
+    }
+}
+
+static unittest_thread_result_t UNITTEST_THREAD_CALL
+thread_cache_test_thread( void* arg ) {
+    void** ptrs = (void**)arg;
+
+    // Free the other thread's blocks, then allocate a new batch for the next one to free
+    for ( int i = 0; i < 256; ++i ) {
+        if ( ptrs[i] != NULL ) {
+            SRALLOC_DEALLOC( (srallocator_t*)ptrs[-1], ptrs[i] );
+        }
+        ptrs[i] = SRALLOC_BYTES( (srallocator_t*)ptrs[-1], 8 + i * 7 );
+    }
+
+    return 0;
+}
+
+static unittest_thread_result_t UNITTEST_THREAD_CALL
+thread_cache_test_exit_thread( void* arg ) {
+    srallocator_t* allocator = (srallocator_t*)arg;
+    SRALLOC_DEALLOC( allocator, SRALLOC_BYTES( allocator, 64 ) );
+    return ( unittest_thread_result_t )( sruintptr_t )( sr__thread_index() < SRALLOC_MAX_THREADS );
+}
+
+void
+thread_cache_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* mutexalloc =
+      sralloc_create_mutex_allocator( "mutex", mallocalloc, SRALLOC_LOCK_MUTEX );
+    srallocator_t* tcachealloc = sralloc_create_thread_cache_allocator( "tcache", mutexalloc );
+
+    // Freed blocks are reused by the same thread without going to the parent
+    sr_result_t pA1 = unittest_alloc( tcachealloc, 100 );
+    lequal( pA1.size, 112 );
+    sralloc_thread_cache_allocator_flush( tcachealloc );
+    lequal( sralloc_get_stats( tcachealloc ).num_allocations, 1 );
+    unittest_dealloc( tcachealloc, pA1 );
+    sralloc_lock_stats_t lock_stats = sralloc_mutex_allocator_lock_stats( mutexalloc );
+    sr_result_t          pA2        = unittest_alloc( tcachealloc, 97 );
+    lok( pA2.ptr == pA1.ptr );
+    lequal( (int)sralloc_mutex_allocator_lock_stats( mutexalloc ).num_acquisitions,
+            (int)lock_stats.num_acquisitions + 1 );
+    unittest_dealloc( tcachealloc, pA2 );
+
+    // Big and overaligned allocations go straight to the parent
+    void* pB1 = SRALLOC_BYTES( tcachealloc, 5000 );
+    void* pB2 = SRALLOC_ALIGNED_BYTES( tcachealloc, 64, 128 );
+    lequal( (int)( (sruintptr_t)pB2 & 127 ), 0 );
+    sralloc_thread_cache_allocator_flush( tcachealloc );
+    lequal( sralloc_get_stats( tcachealloc ).num_allocations, 2 );
+    SRALLOC_DEALLOC( tcachealloc, pB1 );
+    SRALLOC_DEALLOC( tcachealloc, pB2 );
+    sralloc_thread_cache_allocator_flush( tcachealloc );
+    lequal( sralloc_get_stats( tcachealloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( tcachealloc ).amount_allocated, 0 );
+
+    // Blocks allocated on one thread and freed on another
+    void* ptrs[UNITTEST_NUM_THREADS][257];
+    for ( int i_thread = 0; i_thread < UNITTEST_NUM_THREADS; ++i_thread ) {
+        ptrs[i_thread][0] = tcachealloc;
+        for ( int i = 1; i < 257; ++i ) {
+            ptrs[i_thread][i] = NULL;
+        }
+    }
+    for ( int round = 0; round < 8; ++round ) {
+        unittest_thread_t threads[UNITTEST_NUM_THREADS];
+        for ( int i_thread = 0; i_thread < UNITTEST_NUM_THREADS; ++i_thread ) {
+            int i_ptrs        = ( i_thread + round ) % UNITTEST_NUM_THREADS;
+            threads[i_thread] = unittest_thread_start( thread_cache_test_thread, &ptrs[i_ptrs][1] );
+        }
+        for ( int i_thread = 0; i_thread < UNITTEST_NUM_THREADS; ++i_thread ) {
+            unittest_thread_join( threads[i_thread] );
+        }
+    }
+    for ( int i_thread = 0; i_thread < UNITTEST_NUM_THREADS; ++i_thread ) {
+        for ( int i = 1; i < 257; ++i ) {
+            SRALLOC_DEALLOC( tcachealloc, ptrs[i_thread][i] );
+        }
+    }
+
+    // Exited threads hand their bins back to the parent and their index to the next thread
+    sralloc_thread_cache_allocator_flush( tcachealloc );
+    for ( int i = 0; i < SRALLOC_MAX_THREADS * 2; ++i ) {
+        lok( unittest_thread_join(
+          unittest_thread_start( thread_cache_test_exit_thread, tcachealloc ) ) );
+    }
+    srallocator_thread_cache_t* tcache     = (srallocator_thread_cache_t*)( tcachealloc + 1 );
+    int                         num_caches = 0;
+    for ( int i = 0; i < SRALLOC_MAX_THREADS; ++i ) {
+        num_caches += tcache->caches[i] != NULL;
+    }
+    lequal( sralloc_get_stats( tcachealloc ).num_allocations, 0 );
+    lequal( (int)sralloc_get_stats( mutexalloc ).num_allocations, num_caches + 1 );
+
+    sralloc_destroy_thread_cache_allocator( tcachealloc );
+    lequal( sralloc_get_stats( mutexalloc ).num_allocations, 0 );
+    sralloc_destroy_mutex_allocator( mutexalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
     sralloc_destroy_malloc_allocator( mallocalloc );
 }
 
+static unittest_thread_result_t UNITTEST_THREAD_CALL
+concurrent_frame_test_thread( void* arg ) {
+    srallocator_t* allocator = (srallocator_t*)arg;
+    int*           ptrs[500];
+    for ( int i = 0; i < 500; ++i ) {
+        ptrs[i] = (int*)SRALLOC_ALIGNED_BYTES( allocator, sizeof( int ) * ( 1 + i % 8 ), 4 );
+        for ( int j = 0; j < 1 + i % 8; ++j ) {
+            ptrs[i][j] = i;
+        }
+    }
+
+    // Would trip if two threads were handed overlapping memory
+    int ok = 1;
+    for ( int i = 0; i < 500; ++i ) {
+        for ( int j = 0; j < 1 + i % 8; ++j ) {
+            ok = ok && ptrs[i][j] == i;
+        }
+        SRALLOC_DEALLOC( allocator, ptrs[i] );
+    }
+    return ok ? 0 : (unittest_thread_result_t)1;
+}
+
+void
+concurrent_frame_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* framealloc =
+      sralloc_create_concurrent_frame_allocator( "frame", mallocalloc, 200000 );
+
+    // Stats live in per-thread shards until collected
+    sr_result_t psC[10];
+    for ( int i = 0; i < 10; i++ ) {
+        psC[i] = sralloc_alloc_aligned_with_size( framealloc, i * 7 + 100, 16 );
+        lequal( (int)( (sruintptr_t)psC[i].ptr & 15 ), 0 );
+        memset( psC[i].ptr, i, psC[i].size );
+    }
+    sralloc_concurrent_frame_allocator_collect_stats( framealloc );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 10 );
+    for ( int i = 0; i < 10; i++ ) {
+        lequal( *( (char*)psC[i].ptr + psC[i].size - 1 ), i );
+        sralloc_dealloc( framealloc, psC[i].ptr );
+    }
+    sralloc_concurrent_frame_allocator_collect_stats( framealloc );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( framealloc ).amount_allocated, 0 );
+
+    // Deallocating the latest allocation in a thread's sub-block rewinds it
+    void* pA1 = SRALLOC_BYTES( framealloc, 10 );
+    SRALLOC_DEALLOC( framealloc, pA1 );
+    void* pA2 = SRALLOC_BYTES( framealloc, 10 );
+    lok( pA1 == pA2 );
+    SRALLOC_DEALLOC( framealloc, pA2 );
+
+    // Requests that don't fit the remaining capacity fail
+    lok( SRALLOC_BYTES( framealloc, 300000 ) == SRALLOC_NULL );
+    sralloc_concurrent_frame_allocator_clear( framealloc );
+
+    // Small requests still fit when there's no room left for a whole sub-block
+    {
+        srallocator_t* smallalloc =
+          sralloc_create_concurrent_frame_allocator( "small", mallocalloc, 1000 );
+        lok( SRALLOC_BYTES( smallalloc, 2000 ) == SRALLOC_NULL );
+        void* pS1 = SRALLOC_BYTES( smallalloc, 100 );
+        void* pS2 = SRALLOC_BYTES( smallalloc, 100 );
+        lok( pS1 != SRALLOC_NULL && pS2 != SRALLOC_NULL && pS1 != pS2 );
+        SRALLOC_DEALLOC( smallalloc, pS2 );
+        SRALLOC_DEALLOC( smallalloc, pS1 );
+        sralloc_destroy_concurrent_frame_allocator( smallalloc );
+    }
+
+    for ( int frame = 0; frame < 4; ++frame ) {
+        unittest_thread_t threads[UNITTEST_NUM_THREADS];
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            threads[i] = unittest_thread_start( concurrent_frame_test_thread, framealloc );
+        }
+        for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+            lok( unittest_thread_join( threads[i] ) == 0 );
+        }
+
+        sralloc_concurrent_frame_allocator_collect_stats( framealloc );
+        lequal( sralloc_get_stats( framealloc ).num_allocations, 0 );
+        lequal( sralloc_get_stats( framealloc ).amount_allocated, 0 );
+        sralloc_concurrent_frame_allocator_clear( framealloc );
+    }
+
+    void* pB1 = SRALLOC_BYTES( framealloc, 100 );
+    sralloc_concurrent_frame_allocator_collect_stats( framealloc );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 1 );
+    SRALLOC_DEALLOC( framealloc, pB1 );
+    sralloc_destroy_concurrent_frame_allocator( framealloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+#define UNITTEST_RING_COUNT 20000
+
+typedef struct {
+    srallocator_t* allocator;
+    int*           slots[64];
+    srint_t        num_written;
+    srint_t        num_read;
+} unittest_ring_queue_t;
+
+static unittest_thread_result_t UNITTEST_THREAD_CALL
+ring_test_consumer( void* arg ) {
+    unittest_ring_queue_t* queue = (unittest_ring_queue_t*)arg;
+    int                    ok    = 1;
+    for ( srint_t i = 0; i < UNITTEST_RING_COUNT; ++i ) {
+        while ( SRALLOC_atomic_load( &queue->num_written ) <= i ) {
+            SRALLOC_thread_yield();
+        }
+
+        int* ptr = queue->slots[i % 64];
+        ok       = ok && ptr[0] == (int)i && ptr[i % 50] == (int)i;
+        SRALLOC_DEALLOC( queue->allocator, ptr );
+        SRALLOC_atomic_store( &queue->num_read, i + 1 );
+    }
+    return ok ? 0 : (unittest_thread_result_t)1;
+}
+
+void
+ring_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    {
+        // Blocks that don't fit before the end skip to the start
+        srallocator_t* ringalloc = sralloc_create_ring_allocator( "ring", mallocalloc, 1000, 0 );
+        int*           ptrs[4];
+        for ( int i = 0; i < 100; ++i ) {
+            ptrs[i % 4] = (int*)SRALLOC_BYTES( ringalloc, 200 );
+            lok( ptrs[i % 4] != SRALLOC_NULL );
+            ptrs[i % 4][49] = i;
+            if ( i >= 2 ) {
+                lequal( ptrs[( i - 2 ) % 4][49], i - 2 );
+                SRALLOC_DEALLOC( ringalloc, ptrs[( i - 2 ) % 4] );
+            }
+        }
+        lok( SRALLOC_BYTES( ringalloc, 800 ) == SRALLOC_NULL );
+        SRALLOC_DEALLOC( ringalloc, ptrs[98 % 4] );
+        SRALLOC_DEALLOC( ringalloc, ptrs[99 % 4] );
+        lequal( sralloc_get_stats( ringalloc ).num_allocations, 0 );
+        void* pA = SRALLOC_BYTES( ringalloc, 800 );
+        lok( pA != SRALLOC_NULL );
+        SRALLOC_DEALLOC( ringalloc, pA );
+
+        // An empty ring starts over, so blocks bigger than half of it keep fitting
+        for ( int i = 0; i < 4; ++i ) {
+            void* pB = SRALLOC_BYTES( ringalloc, 850 - ( i % 2 ) * 200 );
+            lok( pB == pA );
+            SRALLOC_DEALLOC( ringalloc, pB );
+        }
+        sralloc_destroy_ring_allocator( ringalloc );
+    }
+    {
+        // With the mirror a block can wrap around the end of the ring
+        srallocator_t* ringalloc = sralloc_create_ring_allocator(
+          "mirrored_ring", mallocalloc, SRALLOC_PAGE_SIZE, SRALLOC_RING_MIRRORED );
+        lok( ringalloc != SRALLOC_NULL );
+        char* pA = (char*)SRALLOC_BYTES( ringalloc, SRALLOC_PAGE_SIZE / 2 );
+        char* pB = (char*)SRALLOC_BYTES( ringalloc, SRALLOC_PAGE_SIZE / 4 );
+        SRALLOC_DEALLOC( ringalloc, pA );
+        char* pC = (char*)SRALLOC_BYTES( ringalloc, SRALLOC_PAGE_SIZE / 2 );
+        lok( pC > pB );
+        memset( pC, 7, SRALLOC_PAGE_SIZE / 2 );
+        lequal( *( pC - SRALLOC_PAGE_SIZE + SRALLOC_PAGE_SIZE / 2 - 1 ), 7 );
+        SRALLOC_DEALLOC( ringalloc, pB );
+        SRALLOC_DEALLOC( ringalloc, pC );
+        sralloc_destroy_ring_allocator( ringalloc );
+    }
+    {
+        // One thread allocates while another frees
+        unittest_ring_queue_t queue;
+        memset( &queue, 0, sizeof( queue ) );
+        queue.allocator = sralloc_create_ring_allocator(
+          "spsc_ring", mallocalloc, 4096, SRALLOC_RING_SPSC | SRALLOC_RING_MIRRORED );
+        unittest_thread_t consumer = unittest_thread_start( ring_test_consumer, &queue );
+        for ( srint_t i = 0; i < UNITTEST_RING_COUNT; ++i ) {
+            while ( i - SRALLOC_atomic_load( &queue.num_read ) >= 64 ) {
+                SRALLOC_thread_yield();
+            }
+
+            int* ptr = (int*)SRALLOC_BYTES( queue.allocator, sizeof( int ) * ( 1 + i % 50 ) );
+            while ( ptr == SRALLOC_NULL ) {
+                SRALLOC_thread_yield();
+                ptr = (int*)SRALLOC_BYTES( queue.allocator, sizeof( int ) * ( 1 + i % 50 ) );
+            }
+
+            for ( int j = 0; j < 1 + i % 50; ++j ) {
+                ptr[j] = (int)i;
+            }
+            queue.slots[i % 64] = ptr;
+            SRALLOC_atomic_store( &queue.num_written, i + 1 );
+        }
+        lequal( unittest_thread_join( consumer ), 0 );
+        lequal( sralloc_get_stats( queue.allocator ).num_allocations, 0 );
+        sralloc_destroy_ring_allocator( queue.allocator );
+    }
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+static void
+batch_allocator_tests( srallocator_t* allocator ) {
+    void* ptrs[100];
+    lequal( (int)sralloc_alloc_batch( allocator, 48, 16, 100, ptrs ), 100 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 100 );
+    for ( int i = 0; i < 100; ++i ) {
+        lequal( (int)( (sruintptr_t)ptrs[i] & 15 ), 0 );
+        memset( ptrs[i], i, 48 );
+    }
+    for ( int i = 0; i < 100; ++i ) {
+        lequal( *( (unsigned char*)ptrs[i] + 47 ), i );
+    }
+
+    // Blocks from a batch can be freed one by one and the other way around
+    SRALLOC_DEALLOC( allocator, ptrs[99] );
+    ptrs[99] = SRALLOC_BYTES( allocator, 48 );
+    sralloc_dealloc_batch( allocator, ptrs, 100 );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+    lequal( sralloc_get_stats( allocator ).amount_allocated, 0 );
+
+    lequal( (int)sralloc_alloc_batch( allocator, 0, 0, 4, ptrs ), 4 );
+    lok( ptrs[3] == SRALLOC_ZERO_SIZE_PTR );
+    lequal( sralloc_get_stats( allocator ).num_allocations, 0 );
+}
+
+void
+multi_frame_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* framealloc =
+      sralloc_create_multi_frame_allocator( "multi_frame", mallocalloc, 3, 20000 );
+    generic_allocator_tests( framealloc );
+
+    // An allocation lives through num_buffers - 1 advances
+    int* pA = SRALLOC_OBJECT( framealloc, int );
+    *pA     = 111;
+    sralloc_multi_frame_allocator_advance_frame( framealloc );
+    int* pB = SRALLOC_OBJECT( framealloc, int );
+    *pB     = 222;
+    lequal( sralloc_multi_frame_allocator_buffer_stats( framealloc, 1 ).num_allocations, 1 );
+    sralloc_multi_frame_allocator_advance_frame( framealloc );
+    lok( SRALLOC_BYTES( framealloc, 15000 ) != SRALLOC_NULL );
+    lok( SRALLOC_BYTES( framealloc, 15000 ) == SRALLOC_NULL );
+    lequal( *pA, 111 );
+    lequal( *pB, 222 );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 3 );
+
+    sralloc_frame_buffer_stats_t stats =
+      sralloc_multi_frame_allocator_buffer_stats( framealloc, 0 );
+    lequal( stats.num_allocations, 1 );
+    lok( stats.used >= 15000 );
+    lequal( stats.capacity, 20000 );
+
+    // The buffer pA was in comes around again, its high-water mark stays
+    sralloc_multi_frame_allocator_advance_frame( framealloc );
+    stats = sralloc_multi_frame_allocator_buffer_stats( framealloc, 0 );
+    lequal( stats.num_allocations, 0 );
+    lequal( stats.used, 0 );
+    lok( stats.high_water > 0 );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 2 );
+    int* pC = SRALLOC_OBJECT( framealloc, int );
+    lok( pC <= pA );
+    lequal( sralloc_multi_frame_allocator_buffer_stats( framealloc, 0 ).num_allocations, 1 );
+    SRALLOC_DEALLOC( framealloc, pC );
+    lequal( sralloc_get_stats( framealloc ).num_allocations, 2 );
+    sralloc_destroy_multi_frame_allocator( framealloc );
+
+    // The peak counts even when the newest block is freed before the advance
+    framealloc = sralloc_create_multi_frame_allocator( "multi_frame", mallocalloc, 2, 20000 );
+
+    void*   pD   = SRALLOC_BYTES( framealloc, 100 );
+    void*   pE   = SRALLOC_BYTES( framealloc, 1000 );
+    srint_t peak = sralloc_multi_frame_allocator_buffer_stats( framealloc, 0 ).used;
+    SRALLOC_DEALLOC( framealloc, pE );
+    lok( sralloc_multi_frame_allocator_buffer_stats( framealloc, 0 ).used < peak );
+    sralloc_multi_frame_allocator_advance_frame( framealloc );
+    lequal( sralloc_multi_frame_allocator_buffer_stats( framealloc, 1 ).high_water, peak );
+    SRALLOC_DEALLOC( framealloc, pD );
+    sralloc_destroy_multi_frame_allocator( framealloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+batch_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    batch_allocator_tests( mallocalloc );
+    {
+        srallocator_t* heapalloc = sralloc_create_heap_allocator( "heap" );
+        batch_allocator_tests( heapalloc );
+        void* ptrs[8];
+        lequal( (int)sralloc_alloc_batch( heapalloc, 20000, 64, 8, ptrs ), 8 );
+        lequal( (int)( (sruintptr_t)ptrs[7] & 63 ), 0 );
+        sralloc_dealloc_batch( heapalloc, ptrs, 8 );
+        lequal( sralloc_get_stats( heapalloc ).num_allocations, 0 );
+        sralloc_destroy_heap_allocator( heapalloc );
+    }
+    {
+        srallocator_t* proxyalloc = sralloc_create_proxy_allocator( "proxy", mallocalloc );
+        batch_allocator_tests( proxyalloc );
+        srallocator_t* mutexalloc =
+          sralloc_create_mutex_allocator( "mutex", proxyalloc, SRALLOC_LOCK_SPINLOCK );
+        batch_allocator_tests( mutexalloc );
+
+        // The whole batch is taken under one lock, reading the stats takes it too
+        sralloc_lock_stats_t lock_stats = sralloc_mutex_allocator_lock_stats( mutexalloc );
+        void*                ptrs[100];
+        sralloc_alloc_batch( mutexalloc, 32, 0, 100, ptrs );
+        sralloc_dealloc_batch( mutexalloc, ptrs, 100 );
+        lequal( (int)sralloc_mutex_allocator_lock_stats( mutexalloc ).num_acquisitions,
+                (int)lock_stats.num_acquisitions + 3 );
+        sralloc_destroy_mutex_allocator( mutexalloc );
+        sralloc_destroy_proxy_allocator( proxyalloc );
+    }
+    {
+        srallocator_t* stackalloc = sralloc_create_stack_allocator( "stack", mallocalloc, 20000 );
+        batch_allocator_tests( stackalloc );
+
+        // Only as many as fit are handed out
+        void* ptrs[100];
+        lequal( (int)sralloc_alloc_batch( stackalloc, 1000, 0, 100, ptrs ), 19 );
+        lequal( sralloc_get_stats( stackalloc ).num_allocations, 19 );
+        sralloc_dealloc_batch( stackalloc, ptrs, 19 );
+        lequal( sralloc_get_stats( stackalloc ).amount_allocated, 0 );
+
+        // Growing a block in place leaves the next one in the batch alone
+        lequal( (int)sralloc_alloc_batch( stackalloc, 100, 8, 2, ptrs ), 2 );
+        memset( ptrs[1], 2, 100 );
+        sralloc_stack_preamble_t neighbour = ( (sralloc_stack_preamble_t*)ptrs[1] )[-1];
+        int                      grown     = (int)( (char*)ptrs[1] - (char*)ptrs[0] );
+        while ( !sralloc_try_expand( stackalloc, ptrs[0], grown ) ) {
+            --grown;
+        }
+        lok( grown >= 108 );
+        memset( ptrs[0], 1, grown );
+        sralloc_stack_preamble_t* next = (sralloc_stack_preamble_t*)ptrs[1] - 1;
+        lok( memcmp( next, &neighbour, sizeof( neighbour ) ) == 0 );
+        lequal( ( (char*)ptrs[1] )[0], 2 );
+        sralloc_dealloc( stackalloc, ptrs[1] );
+        sralloc_dealloc( stackalloc, ptrs[0] );
+        lequal( sralloc_get_stats( stackalloc ).amount_allocated, 0 );
+        sralloc_destroy_stack_allocator( stackalloc );
+    }
+    {
+        srallocator_t* slotalloc = sralloc_create_slot_allocator( "slot", mallocalloc, 48, 120 );
+        batch_allocator_tests( slotalloc );
+        void* ptrs[200];
+        lequal( (int)sralloc_alloc_batch( slotalloc, 40, 0, 200, ptrs ), 120 );
+        sralloc_dealloc_batch( slotalloc, ptrs, 120 );
+        lequal( sralloc_get_stats( slotalloc ).num_allocations, 0 );
+        sralloc_destroy_slot_allocator( slotalloc );
+    }
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+sized_dealloc_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* proxyalloc  = sralloc_create_proxy_allocator( "proxy", mallocalloc );
+    srallocator_t* mutexalloc =
+      sralloc_create_mutex_allocator( "mutex", proxyalloc, SRALLOC_LOCK_MUTEX );
+    srallocator_t* stackalloc = sralloc_create_stack_allocator( "stack", mutexalloc, 20000 );
+    int            num_root_allocations = sralloc_get_stats( mallocalloc ).num_allocations;
+    int            root_allocated       = sralloc_get_stats( mallocalloc ).amount_allocated;
+    srallocator_t* allocators[]         = { mallocalloc, proxyalloc, mutexalloc, stackalloc };
+    int            aligns[]             = { 0, 4, 8, 16, 32, 64, 256 };
+    for ( int i_alloc = 0; i_alloc < 4; ++i_alloc ) {
+        srallocator_t* allocator       = allocators[i_alloc];
+        int            num_allocations  = sralloc_get_stats( allocator ).num_allocations;
+        int            amount_allocated = sralloc_get_stats( allocator ).amount_allocated;
+        void*          ptrs[7];
+        for ( int i = 0; i < 7; ++i ) {
+            ptrs[i] = SRALLOC_ALIGNED_BYTES( allocator, 100 + i, aligns[i] );
+            if ( aligns[i] > 0 ) {
+                lequal( (int)( (sruintptr_t)ptrs[i] & ( aligns[i] - 1 ) ), 0 );
+            }
+            memset( ptrs[i], i, 100 + i );
+        }
+        for ( int i = 6; i >= 0; --i ) {
+            lequal( *( (char*)ptrs[i] + 99 + i ), i );
+            SRALLOC_DEALLOC_SIZED( allocator, ptrs[i], 100 + i, aligns[i] );
+        }
+        lequal( sralloc_get_stats( allocator ).num_allocations, num_allocations );
+        lequal( sralloc_get_stats( allocator ).amount_allocated, amount_allocated );
+        sralloc_dealloc_sized( allocator, SRALLOC_NULL, 100, 0 );
+        sralloc_dealloc_sized( allocator, SRALLOC_ZERO_SIZE_PTR, 0, 0 );
+    }
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, num_root_allocations );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, root_allocated );
+
+    // Reallocating to zero frees through the preamble, without it there's no size to free with
+    void* shrunk = sralloc_alloc( stackalloc, 100 );
+#ifdef SRALLOC_DISABLE_PREAMBLE
+    lok( sralloc_realloc( stackalloc, shrunk, 0, 0 ) == SRALLOC_NULL );
+    sralloc_dealloc_sized( stackalloc, shrunk, 100, 0 );
+#else
+    lok( sralloc_realloc( stackalloc, shrunk, 0, 0 ) == SRALLOC_ZERO_SIZE_PTR );
+#endif
+    lequal( sralloc_get_stats( stackalloc ).num_allocations, 0 );
+
+    sralloc_destroy_stack_allocator( stackalloc );
+    sralloc_destroy_mutex_allocator( mutexalloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+realloc_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    {
+        // The topmost allocation grows in place, anything below it has to move
+        srallocator_t* stackalloc = sralloc_create_stack_allocator( "stack", mallocalloc, 20000 );
+        srallocator_t* proxyalloc = sralloc_create_proxy_allocator( "proxy", stackalloc );
+        int            allocs     = sralloc_get_stats( stackalloc ).num_allocations;
+        int            allocated  = sralloc_get_stats( stackalloc ).amount_allocated;
+        char*          pA         = (char*)SRALLOC_BYTES( stackalloc, 100 );
+        memset( pA, 1, 100 );
+        lok( sralloc_realloc( stackalloc, pA, 1000, 0 ) == pA );
+        lok( sralloc_try_expand( stackalloc, pA, 2000 ) );
+        lok( !sralloc_try_expand( stackalloc, pA, 20000 ) );
+        lequal( pA[99], 1 );
+        char* pB = (char*)SRALLOC_BYTES( stackalloc, 100 );
+        lok( !sralloc_try_expand( stackalloc, pA, 3000 ) );
+        lok( sralloc_try_expand( stackalloc, pA, 10 ) );
+        char* pA2 = (char*)sralloc_realloc( stackalloc, pA, 3000, 0 );
+        lok( pA2 > pB );
+        lequal( pA2[99], 1 );
+        lequal( sralloc_get_stats( stackalloc ).num_allocations, allocs + 2 );
+        SRALLOC_DEALLOC( stackalloc, pA2 );
+        SRALLOC_DEALLOC( stackalloc, pB );
+        lequal( sralloc_get_stats( stackalloc ).amount_allocated, allocated );
+
+        char* pC = (char*)SRALLOC_ALIGNED_BYTES( proxyalloc, 100, 64 );
+        lok( sralloc_try_expand( proxyalloc, pC, 5000 ) );
+        pC[4999] = 1;
+        lequal( sralloc_get_stats( stackalloc ).num_allocations, allocs + 1 );
+        SRALLOC_DEALLOC( proxyalloc, pC );
+        lequal( sralloc_get_stats( proxyalloc ).amount_allocated, 0 );
+        sralloc_destroy_proxy_allocator( proxyalloc );
+        sralloc_destroy_stack_allocator( stackalloc );
+    }
+    {
+        srallocator_t* mutexalloc =
+          sralloc_create_mutex_allocator( "mutex", mallocalloc, SRALLOC_LOCK_MUTEX );
+        srallocator_t* heapalloc     = sralloc_create_heap_allocator( "heap" );
+        srallocator_t* allocators[4] = { mallocalloc, mutexalloc, heapalloc, SRALLOC_NULL };
+        allocators[3] = sralloc_create_thread_cache_allocator( "tcache", heapalloc );
+        int allocations = sralloc_get_stats( mallocalloc ).num_allocations;
+        int allocated   = sralloc_get_stats( mallocalloc ).amount_allocated;
+        for ( int i_alloc = 0; i_alloc < 4; ++i_alloc ) {
+            srallocator_t* allocator = allocators[i_alloc];
+            int*           pA        = (int*)sralloc_realloc( allocator, SRALLOC_NULL, 40, 0 );
+            int*           pB        = (int*)SRALLOC_ALIGNED_BYTES( allocator, 40, 64 );
+            for ( int i = 0; i < 10; ++i ) {
+                pA[i] = i;
+                pB[i] = i;
+            }
+            for ( int size = 80; size < 40000; size *= 2 ) {
+                pA = (int*)sralloc_realloc( allocator, pA, size, 0 );
+                pB = (int*)sralloc_realloc( allocator, pB, size, 64 );
+                lequal( (int)( (sruintptr_t)pB & 63 ), 0 );
+                lequal( pA[9], 9 );
+                lequal( pB[9], 9 );
+            }
+            lok( sralloc_realloc( allocator, pA, 0, 0 ) == SRALLOC_ZERO_SIZE_PTR );
+            SRALLOC_DEALLOC( allocator, pB );
+        }
+        sralloc_thread_cache_allocator_flush( allocators[3] );
+        lequal( sralloc_get_stats( allocators[3] ).amount_allocated, 0 );
+        lequal( sralloc_get_stats( mallocalloc ).num_allocations, allocations );
+        lequal( sralloc_get_stats( mallocalloc ).amount_allocated, allocated );
+        lequal( sralloc_get_stats( mutexalloc ).amount_allocated, 0 );
+
+        // Heap blocks can be grown up to their size class
+        void* pC = SRALLOC_BYTES( heapalloc, 100 );
+        lok( sralloc_try_expand( heapalloc, pC, 112 ) );
+        lok( !sralloc_try_expand( heapalloc, pC, 113 ) );
+        SRALLOC_DEALLOC( heapalloc, pC );
+        sralloc_destroy_thread_cache_allocator( allocators[3] );
+        sralloc_destroy_heap_allocator( heapalloc );
+        sralloc_destroy_mutex_allocator( mutexalloc );
+    }
+    {
+        srallocator_t* slotalloc = sralloc_create_slot_allocator( "slot", mallocalloc, 48, 4 );
+        void*          pA        = SRALLOC_BYTES( slotalloc, 20 );
+        lok( sralloc_realloc( slotalloc, pA, 48, 0 ) == pA );
+        lok( sralloc_realloc( slotalloc, pA, 49, 0 ) == SRALLOC_NULL );
+        SRALLOC_DEALLOC( slotalloc, pA );
+        sralloc_destroy_slot_allocator( slotalloc );
+    }
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+static void*
+callback_test_allocate( void* user_data, srint_t size, srint_t align ) {
+    return sralloc_alloc_aligned( (srallocator_t*)user_data, size, align );
+}
+
+static void
+callback_test_deallocate( void* user_data, void* ptr, srint_t size, srint_t align ) {
+    sralloc_dealloc_sized( (srallocator_t*)user_data, ptr, size, align );
+}
+
+void
+callback_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* callbackalloc1 = sralloc_create_callback_allocator(
+      "callback1", SRALLOC_NULL, mallocalloc, callback_test_allocate, callback_test_deallocate );
+    srallocator_t* callbackalloc2 = sralloc_create_callback_allocator(
+      "callback2", mallocalloc, mallocalloc, callback_test_allocate, callback_test_deallocate );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 2 );
+    generic_allocator_tests( callbackalloc1 );
+    generic_allocator_tests( callbackalloc2 );
+    srallocator_t* proxyalloc = sralloc_create_proxy_allocator( "proxy", callbackalloc1 );
+    generic_allocator_tests( proxyalloc );
+#ifndef SRALLOC_DISABLE_PROXY
+    lequal( sralloc_get_stats( callbackalloc1 ).num_allocations, 2 );
+#endif
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    sralloc_destroy_callback_allocator( callbackalloc2 );
+    sralloc_destroy_callback_allocator( callbackalloc1 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+stats_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* proxyalloc1 = sralloc_create_proxy_allocator( "proxy1", mallocalloc );
+    srallocator_t* proxyalloc2 = sralloc_create_proxy_allocator( "proxy2", proxyalloc1 );
+    sralloc_stats_t total_before = sralloc_get_total_stats( mallocalloc );
+    void*           pA           = SRALLOC_BYTES( proxyalloc2, 100 );
+    void*           pB           = SRALLOC_BYTES( proxyalloc1, 100 );
+
+    // Every level counts the allocation that passed through it
+    sralloc_stats_t total = sralloc_get_total_stats( mallocalloc );
+#ifndef SRALLOC_DISABLE_PROXY
+    lequal( total.num_allocations, total_before.num_allocations + 5 );
+    lequal( total.amount_allocated,
+            sralloc_get_stats( mallocalloc ).amount_allocated +
+              sralloc_get_stats( proxyalloc1 ).amount_allocated +
+              sralloc_get_stats( proxyalloc2 ).amount_allocated );
+    lequal( sralloc_get_total_stats( proxyalloc2 ).num_allocations, 1 );
+#else
+    lequal( total.num_allocations, total_before.num_allocations + 2 );
+#endif
+    SRALLOC_DEALLOC( proxyalloc1, pB );
+    SRALLOC_DEALLOC( proxyalloc2, pA );
+#ifndef SRALLOC_DISABLE_PROXY
+    lequal( sralloc_get_total_stats( proxyalloc1 ).num_allocations, 1 );
+#endif
+
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    // Proxies aren't thread safe, but with sharded stats their counting is
+    srallocator_t* mutexalloc =
+      sralloc_create_mutex_allocator( "mutex", mallocalloc, SRALLOC_LOCK_MUTEX );
+    srallocator_t*    proxyalloc3 = sralloc_create_proxy_allocator( "proxy3", mutexalloc );
+    sralloc_stats_t   mutex_stats = sralloc_get_stats( mutexalloc );
+    unittest_thread_t threads[UNITTEST_NUM_THREADS];
+    for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+        threads[i] = unittest_thread_start( mutex_test_thread, proxyalloc3 );
+    }
+    void* pC = SRALLOC_BYTES( proxyalloc3, 100 );
+    for ( int i = 0; i < UNITTEST_NUM_THREADS; ++i ) {
+        unittest_thread_join( threads[i] );
+    }
+    lequal( sralloc_get_stats( proxyalloc3 ).num_allocations, 1 );
+    SRALLOC_DEALLOC( proxyalloc3, pC );
+    lequal( sralloc_get_stats( proxyalloc3 ).amount_allocated, 0 );
+    lequal( sralloc_get_stats( mutexalloc ).num_allocations, mutex_stats.num_allocations );
+    lequal( sralloc_get_stats( mutexalloc ).amount_allocated, mutex_stats.amount_allocated );
+    sralloc_destroy_proxy_allocator( proxyalloc3 );
+    sralloc_destroy_mutex_allocator( mutexalloc );
+#endif
+
+    sralloc_destroy_proxy_allocator( proxyalloc2 );
+    sralloc_destroy_proxy_allocator( proxyalloc1 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+report_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* proxyalloc  = sralloc_create_proxy_allocator( "proxy,\"a\"", mallocalloc );
+    srallocator_t* arenaalloc  = sralloc_create_arena_allocator( "arena", proxyalloc, 1024, 1 );
+    srallocator_t* outputalloc = sralloc_create_malloc_allocator( "output" );
+
+    void*           p     = SRALLOC_BYTES( arenaalloc, 100 );
+    sralloc_stats_t stats = sralloc_get_stats( arenaalloc );
+
+    // Sizing first, then a buffer that's too small, then one that fits
+    srchar_t buffer[4096];
+    srint_t  length = sralloc_report( mallocalloc, SRALLOC_REPORT_JSON, SRALLOC_NULL, 0 );
+    lok( length > 0 && length < (srint_t)sizeof( buffer ) );
+    lequal( (int)sralloc_report( mallocalloc, SRALLOC_REPORT_JSON, buffer, 8 ), (int)length );
+    lequal( (int)strlen( buffer ), 7 );
+    lequal( (int)sralloc_report( mallocalloc, SRALLOC_REPORT_JSON, buffer, length + 1 ),
+            (int)length );
+    lequal( (int)strlen( buffer ), (int)length );
+    lok( buffer[0] == '{' && buffer[length - 1] == '}' );
+    lok( strstr( buffer, "\"type\":\"malloc\"" ) != SRALLOC_NULL );
+    lok( strstr( buffer, "\"type\":\"arena\"" ) != SRALLOC_NULL );
+
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_USE_NAMES )
+    lok( strstr( buffer, "{\"name\":\"root\",\"type\":\"malloc\"," ) == buffer );
+#ifndef SRALLOC_DISABLE_PROXY
+    lok( strstr( buffer, "\"name\":\"proxy,\\\"a\\\"\"" ) != SRALLOC_NULL );
+#endif
+
+    // Peak stays after the memory is freed
+    char expected[128];
+    snprintf( expected,
+              sizeof( expected ),
+              "\"name\":\"arena\",\"type\":\"arena\",\"num_allocations\":1,"
+              "\"amount_allocated\":%lld,",
+              (long long)stats.amount_allocated );
+    lok( strstr( buffer, expected ) != SRALLOC_NULL );
+    SRALLOC_DEALLOC( arenaalloc, p );
+    sralloc_report( mallocalloc, SRALLOC_REPORT_JSON, buffer, sizeof( buffer ) );
+    long long overhead = sizeof( srallocator_t ) + sizeof( srallocator_arena_t );
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    overhead += SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE;
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    overhead += sizeof( struct sr__extended_stats );
+#endif
+    snprintf( expected,
+              sizeof( expected ),
+              "\"total_amount_allocated\":0,\"overhead\":%lld,\"peak\":%lld,\"children\":[]}",
+              overhead,
+              (long long)stats.amount_allocated );
+    lok( strstr( buffer, expected ) != SRALLOC_NULL );
+
+    // One row per allocator, names quoted where CSV needs it
+    sralloc_report( mallocalloc, SRALLOC_REPORT_CSV, buffer, sizeof( buffer ) );
+    int num_lines = 0;
+    for ( const srchar_t* c = buffer; *c != 0; ++c ) {
+        num_lines += *c == '\n';
+    }
+    lok( strstr( buffer, "\n0,-1,0,root,malloc," ) != SRALLOC_NULL );
+#ifndef SRALLOC_DISABLE_PROXY
+    lequal( num_lines, 4 );
+    lok( strstr( buffer, "\n1,0,1,\"proxy,\"\"a\"\"\",proxy," ) != SRALLOC_NULL );
+    lok( strstr( buffer, "\n2,1,2,arena,arena,0,0,0,0," ) != SRALLOC_NULL );
+#else
+    lequal( num_lines, 3 );
+    lok( strstr( buffer, "\n1,0,1,arena,arena,0,0,0,0," ) != SRALLOC_NULL );
+#endif
+#else
+    SRALLOC_UNUSED( stats );
+    SRALLOC_DEALLOC( arenaalloc, p );
+#endif
+
+    srint_t   alloc_length = 0;
+    srchar_t* report =
+      sralloc_report_alloc( arenaalloc, SRALLOC_REPORT_CSV, outputalloc, &alloc_length );
+    lok( report != SRALLOC_NULL );
+    lequal( (int)strlen( report ), (int)alloc_length );
+    lequal( (int)sralloc_get_stats( arenaalloc ).num_allocations, 0 );
+    sralloc_dealloc_sized( outputalloc, report, alloc_length + 1, 0 );
+
+    sralloc_destroy_malloc_allocator( outputalloc );
+    sralloc_destroy_arena_allocator( arenaalloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+extended_stats_test( void ) {
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* proxyalloc  = sralloc_create_proxy_allocator( "proxy", mallocalloc );
+    srallocator_t* stackalloc  = sralloc_create_stack_allocator( "stack", mallocalloc, 1024 );
+
+    void* ptrs[4];
+    void* p = SRALLOC_BYTES( proxyalloc, 100 );
+    void* q = SRALLOC_ALIGNED_BYTES( proxyalloc, 3, 64 );
+    lequal( (int)sralloc_alloc_batch( proxyalloc, 16, 0, 4, ptrs ), 4 );
+    sralloc_stats_t peak = sralloc_get_stats( proxyalloc );
+    sralloc_dealloc_batch( proxyalloc, ptrs, 4 );
+    SRALLOC_DEALLOC( proxyalloc, q );
+    lok( SRALLOC_BYTES( stackalloc, 2048 ) == SRALLOC_NULL );
+
+    sralloc_extended_stats_t stats =
+      sralloc_get_extended_stats( proxyalloc, SRALLOC_STATS_LIFETIME );
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    lequal( (int)stats.peak_num_allocations, 6 );
+    lequal( (int)stats.peak_amount_allocated, (int)peak.amount_allocated );
+    lequal( (int)stats.total_allocations, 6 );
+    lequal( (int)stats.total_amount_requested, 100 + 3 + 4 * 16 );
+    lequal( (int)stats.size_histogram[6], 1 );
+    lequal( (int)stats.size_histogram[4], 4 );
+    lequal( (int)stats.size_histogram[1], 1 );
+    lequal( (int)stats.padding, (int)peak.amount_allocated - ( 100 + 3 + 4 * 16 ) );
+    lequal( (int)stats.num_failed, 0 );
+    lequal( (int)sralloc_get_extended_stats( stackalloc, SRALLOC_STATS_LIFETIME ).num_failed, 1 );
+
+    // A new window keeps what's still allocated as its starting peak
+    sralloc_reset_stats_window( proxyalloc );
+    stats = sralloc_get_extended_stats( proxyalloc, SRALLOC_STATS_WINDOW );
+    lequal( (int)stats.peak_num_allocations, 1 );
+    lequal( (int)stats.total_allocations, 0 );
+    lequal( (int)stats.size_histogram[6], 0 );
+    SRALLOC_DEALLOC( proxyalloc, SRALLOC_BYTES( proxyalloc, 5000 ) );
+    stats = sralloc_get_extended_stats( proxyalloc, SRALLOC_STATS_WINDOW );
+    lequal( (int)stats.peak_num_allocations, 2 );
+    lequal( (int)stats.total_allocations, 1 );
+    lequal( (int)stats.size_histogram[12], 1 );
+    lequal( (int)sralloc_get_extended_stats( proxyalloc, SRALLOC_STATS_LIFETIME ).total_allocations,
+            7 );
+#else
+    lequal( (int)stats.total_allocations, 0 );
+    SRALLOC_UNUSED( peak );
+#endif
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    // Extended stats come from a pool, so a new allocator gets the block a destroyed one gave back
+    void* extended = (void*)stackalloc->extended_stats;
+    sralloc_destroy_stack_allocator( stackalloc );
+    stackalloc = sralloc_create_stack_allocator( "stack", mallocalloc, 1024 );
+    lok( (void*)stackalloc->extended_stats == extended );
+    lequal( (int)sralloc_get_extended_stats( stackalloc, SRALLOC_STATS_LIFETIME ).num_failed, 0 );
+#endif
+
+    SRALLOC_DEALLOC( proxyalloc, p );
+    sralloc_destroy_stack_allocator( stackalloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+typedef struct {
+    unsigned char data[8192];
+    srint_t       size;
+    int           num_writes;
+} trace_test_sink_t;
+
+static void
+trace_test_write( void* user_data, const void* data, srint_t size ) {
+    trace_test_sink_t* sink = (trace_test_sink_t*)user_data;
+    if ( sink->size + size <= (srint_t)sizeof( sink->data ) ) {
+        memcpy( sink->data + sink->size, data, size );
+    }
+    sink->size += size;
+    sink->num_writes++;
+}
+
+void
+trace_test( void ) {
+    static trace_test_sink_t sink;
+    srallocator_t*           mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t*           outputalloc = sralloc_create_malloc_allocator( "output" );
+    sralloc_trace_t* trace = sralloc_create_trace( outputalloc, 256, trace_test_write, &sink );
+    srallocator_t*   gamealloc  = sralloc_create_recording_allocator( "game", mallocalloc, trace );
+    srallocator_t*   audioalloc = sralloc_create_recording_allocator( "audio", mallocalloc, trace );
+
+    // Recording doesn't change what the parent does
+    sralloc_stats_t root_before = sralloc_get_stats( mallocalloc );
+    void*           p           = SRALLOC_BYTES( gamealloc, 100 );
+    void*           q           = SRALLOC_ALIGNED_BYTES( audioalloc, 48, 64 );
+    lequal( (int)( (sruintptr_t)q % 64 ), 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated - root_before.amount_allocated,
+            sralloc_get_stats( gamealloc ).amount_allocated +
+              sralloc_get_stats( audioalloc ).amount_allocated );
+    void* r        = sralloc_realloc( gamealloc, p, 200, 0 );
+    int   expanded = sralloc_try_expand( gamealloc, r, 300 );
+    SRALLOC_DEALLOC( audioalloc, q );
+    sralloc_dealloc_sized( gamealloc, r, expanded ? 300 : 200, 0 );
+    for ( int i = 0; i < 50; ++i ) {
+        SRALLOC_DEALLOC( audioalloc, SRALLOC_BYTES( audioalloc, 16 + i ) );
+    }
+    lequal( sralloc_get_stats( gamealloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( audioalloc ).amount_allocated, 0 );
+
+    // The buffer filled up a few times, the rest is written on destroy
+    lok( sink.num_writes > 1 );
+    sralloc_destroy_recording_allocator( audioalloc );
+    sralloc_destroy_recording_allocator( gamealloc );
+    sralloc_destroy_trace( trace );
+    lok( sink.size <= (srint_t)sizeof( sink.data ) );
+
+    sralloc_trace_reader_t reader = { sink.data, sink.size, 0, 0 };
+    sralloc_trace_event_t  event;
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_NAME && event.allocator_id == 0 );
+    lok( event.name_length == 4 && memcmp( event.name, "game", 4 ) == 0 );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_NAME && event.allocator_id == 1 );
+    lok( event.name_length == 5 && memcmp( event.name, "audio", 5 ) == 0 );
+
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_ALLOC && event.allocator_id == 0 );
+    lok( event.size == 100 && event.align == 0 && event.ptr == (sruintptr_t)p );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_ALLOC && event.allocator_id == 1 );
+    lok( event.size == 48 && event.align == 64 && event.ptr == (sruintptr_t)q );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_REALLOC && event.ptr == (sruintptr_t)p );
+    lok( event.size == 200 && event.new_ptr == (sruintptr_t)r );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_EXPAND && event.ptr == (sruintptr_t)r && event.size == 300 );
+    lequal( event.new_ptr != 0, expanded );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_FREE && event.allocator_id == 1 );
+    lok( event.ptr == (sruintptr_t)q );
+    lok( sralloc_trace_read( &reader, &event ) );
+    lok( event.op == SRALLOC_TRACE_FREE && event.allocator_id == 0 );
+    lok( event.ptr == (sruintptr_t)r );
+
+    int     num_events = 0;
+    int64_t last_time  = event.time_ns;
+    while ( sralloc_trace_read( &reader, &event ) ) {
+        lok( event.time_ns >= last_time );
+        last_time = event.time_ns;
+        ++num_events;
+    }
+    lequal( num_events, 100 );
+    lok( reader.offset == reader.size );
+
+    // A recording allocator below another one on the same trace records its own events first
+    static trace_test_sink_t nested_sink;
+    trace = sralloc_create_trace( outputalloc, 256, trace_test_write, &nested_sink );
+    srallocator_t* inneralloc = sralloc_create_recording_allocator( "inner", mallocalloc, trace );
+    srallocator_t* proxyalloc = sralloc_create_proxy_allocator( "proxy", inneralloc );
+    srallocator_t* outeralloc = sralloc_create_recording_allocator( "outer", proxyalloc, trace );
+    srint_t        inner_before = sralloc_get_stats( inneralloc ).num_allocations;
+    p                           = SRALLOC_BYTES( outeralloc, 100 );
+    lok( p != SRALLOC_NULL );
+    lequal( sralloc_get_stats( inneralloc ).num_allocations, inner_before + 1 );
+    SRALLOC_DEALLOC( outeralloc, p );
+    lequal( sralloc_get_stats( inneralloc ).num_allocations, inner_before );
+    sralloc_destroy_recording_allocator( outeralloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    sralloc_destroy_recording_allocator( inneralloc );
+    sralloc_destroy_trace( trace );
+
+    sralloc_trace_reader_t nested_reader = { nested_sink.data, nested_sink.size, 0, 0 };
+    sralloc_trace_op_t     last_op       = SRALLOC_TRACE_NAME;
+    int                    last_id       = -1;
+    int                    outer_allocs  = 0;
+    while ( sralloc_trace_read( &nested_reader, &event ) ) {
+        if ( event.op == SRALLOC_TRACE_ALLOC && event.allocator_id == 1 ) {
+            // Right after the block the proxy got for it
+            lok( event.ptr == (sruintptr_t)p );
+            lok( last_op == SRALLOC_TRACE_ALLOC && last_id == 0 );
+            ++outer_allocs;
+        }
+        last_op = event.op;
+        last_id = (int)event.allocator_id;
+    }
+    lequal( outer_allocs, 1 );
+
+    sralloc_destroy_malloc_allocator( outputalloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+replay_test( void ) {
+    // Recorders stacked on one trace, so the same blocks show up once for each of them
+    static trace_test_sink_t sink;
+    srallocator_t*           mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t*           outputalloc = sralloc_create_malloc_allocator( "output" );
+    sralloc_trace_t* trace = sralloc_create_trace( outputalloc, 256, trace_test_write, &sink );
+    srallocator_t*   inneralloc = sralloc_create_recording_allocator( "inner", mallocalloc, trace );
+    srallocator_t*   outeralloc = sralloc_create_recording_allocator( "outer", inneralloc, trace );
+    void*            ptrs[20];
+    for ( int i = 0; i < 20; ++i ) {
+        ptrs[i] = SRALLOC_BYTES( outeralloc, 16 * ( i + 1 ) );
+    }
+    ptrs[5] = sralloc_realloc( outeralloc, ptrs[5], 1000, 0 );
+    for ( int i = 19; i >= 0; --i ) {
+        SRALLOC_DEALLOC( outeralloc, ptrs[i] );
+    }
+    sralloc_destroy_recording_allocator( outeralloc );
+    sralloc_destroy_recording_allocator( inneralloc );
+    sralloc_destroy_trace( trace );
+    lok( sink.size <= (srint_t)sizeof( sink.data ) );
+
+    replay_summary_t summary;
+    replay_summarize( sink.data, sink.size, &summary );
+    lequal( (int)summary.num_allocators, 2 );
+    int64_t* latencies = (int64_t*)malloc( sizeof( int64_t ) * (size_t)summary.num_events );
+    for ( int kind = REPLAY_MALLOC; kind <= REPLAY_STACK; ++kind ) {
+        if ( kind == REPLAY_STACK && summary.unordered_frees > 0 ) {
+            continue;
+        }
+
+        replay_setup_t  setup;
+        replay_result_t result;
+        memset( &setup, 0, sizeof( setup ) );
+        setup.kind     = (replay_kind_t)kind;
+        setup.capacity = 1024 * 1024;
+        replay_run( &setup, sink.data, sink.size, latencies, &result );
+        lequal( (int)result.failed, 0 );
+        lok( result.ops > 40 );
+    }
+    free( latencies );
+
+    sralloc_destroy_malloc_allocator( outputalloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+static void*
+profiling_test_alloc( srallocator_t* allocator, srint_t size ) {
+    return SRALLOC_BYTES( allocator, size );
+}
+
+static long long
+profiling_test_inuse_bytes( srallocator_t* profiler, long long* alloc_bytes ) {
+    srchar_t  buffer[64];
+    long long inuse_count, inuse_bytes, alloc_count;
+    sralloc_profile_write( profiler, SRALLOC_PROFILE_PPROF, buffer, sizeof( buffer ) );
+    int num_read = sscanf( buffer,
+                           "heap profile: %lld: %lld [%lld: %lld] @ heap_v2/1",
+                           &inuse_count,
+                           &inuse_bytes,
+                           &alloc_count,
+                           alloc_bytes );
+    return num_read == 4 ? inuse_bytes : -1;
+}
+
+void
+profiling_test( void ) {
+    srallocator_t* mallocalloc  = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* storagealloc = sralloc_create_malloc_allocator( "storage" );
+
+    // Sampling every byte, every allocation is its own sample
+    srallocator_t* profiler =
+      sralloc_create_profiling_allocator( "profiler", mallocalloc, storagealloc, 1 );
+    void* small[10];
+    void* large[5];
+    for ( int i = 0; i < 10; ++i ) {
+        small[i] = profiling_test_alloc( profiler, 100 );
+    }
+    for ( int i = 0; i < 5; ++i ) {
+        large[i] = SRALLOC_BYTES( profiler, 1000 );
+    }
+
+    long long alloc_bytes = 0;
+    lequal( (int)profiling_test_inuse_bytes( profiler, &alloc_bytes ), 6000 );
+    lequal( (int)alloc_bytes, 6000 );
+    for ( int i = 0; i < 10; ++i ) {
+        SRALLOC_DEALLOC( profiler, small[i] );
+    }
+    large[0] = sralloc_realloc( profiler, large[0], 100000, 0 );
+    lequal( (int)profiling_test_inuse_bytes( profiler, &alloc_bytes ), 5000 );
+    lequal( (int)alloc_bytes, 6000 );
+
+    // One line per stack with something left, frames outermost first
+    srchar_t buffer[8192];
+    srint_t  length =
+      sralloc_profile_write( profiler, SRALLOC_PROFILE_FOLDED_INUSE, buffer, sizeof( buffer ) );
+    lok( length > 0 && length < (srint_t)sizeof( buffer ) );
+    lok( buffer[length - 1] == '\n' );
+    lok( strstr( buffer, " 5000\n" ) != SRALLOC_NULL );
+#ifdef __GLIBC__
+    lok( strncmp( buffer, "0x", 2 ) == 0 );
+    sralloc_profile_write( profiler, SRALLOC_PROFILE_FOLDED_ALLOC, buffer, sizeof( buffer ) );
+    lok( strstr( buffer, " 1000\n" ) != SRALLOC_NULL );
+    lok( strstr( buffer, " 5000\n" ) != SRALLOC_NULL );
+#endif
+
+    for ( int i = 0; i < 5; ++i ) {
+        SRALLOC_DEALLOC( profiler, large[i] );
+    }
+    lequal( (int)profiling_test_inuse_bytes( profiler, &alloc_bytes ), 0 );
+    sralloc_destroy_profiling_allocator( profiler );
+
+    // Sampled, the estimate is off by at most the bytes since the last sample
+    static void* ptrs[20000];
+    profiler = sralloc_create_profiling_allocator( "profiler", mallocalloc, storagealloc, 4096 );
+    for ( int i = 0; i < 20000; ++i ) {
+        ptrs[i] = SRALLOC_BYTES( profiler, 64 );
+    }
+    long long estimate = profiling_test_inuse_bytes( profiler, &alloc_bytes );
+    lok( estimate > 20000 * 64 - 65536 && estimate <= 20000 * 64 );
+    lequal( (int)alloc_bytes, (int)estimate );
+    for ( int i = 0; i < 20000; ++i ) {
+        SRALLOC_DEALLOC( profiler, ptrs[i] );
+    }
+    lequal( (int)profiling_test_inuse_bytes( profiler, &alloc_bytes ), 0 );
+    sralloc_destroy_profiling_allocator( profiler );
+
+    lequal( sralloc_get_stats( storagealloc ).num_allocations, 0 );
+    sralloc_destroy_malloc_allocator( storagealloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+void
+tracking_test( void ) {
+    srallocator_t* mallocalloc  = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* storagealloc = sralloc_create_malloc_allocator( "storage" );
+    srallocator_t* proxyalloc   = sralloc_create_proxy_allocator( "proxy", mallocalloc );
+    srallocator_t* stackalloc   = sralloc_create_stack_allocator( "stack", mallocalloc, 1024 );
+    srchar_t       buffer[1024];
+
+#ifdef SRALLOC_USE_TRACKING
+    lok( sralloc_enable_tracking( proxyalloc, storagealloc ) );
+    lok( sralloc_enable_tracking( stackalloc, storagealloc ) );
+
+    void* p = SRALLOC_BYTES( proxyalloc, 100 );
+    void* q[3];
+    for ( int i = 0; i < 3; ++i ) {
+        q[i] = SRALLOC_ALIGNED_BYTES( proxyalloc, 50, 16 );
+    }
+    void* r = sralloc_alloc( proxyalloc, 10 );
+    void* batch[4];
+    lequal( (int)sralloc_alloc_batch( proxyalloc, 8, 0, 4, batch ), 4 );
+
+    // Biggest call site first, the ones without a macro last
+    srint_t length = sralloc_tracking_report( proxyalloc, buffer, sizeof( buffer ) );
+    lequal( (int)length, (int)strlen( buffer ) );
+    lok( strstr( buffer, "has 9 allocations, 292 bytes live\n" ) != SRALLOC_NULL );
+    const srchar_t* aligned_site = strstr( buffer, "unittest.c:" );
+    lok( aligned_site != SRALLOC_NULL && strstr( aligned_site, "3 allocations, 150 bytes" ) ==
+                                           strstr( aligned_site, ": " ) + 2 );
+    lok( strstr( buffer, "1 allocation, 100 bytes, oldest #0" ) != SRALLOC_NULL );
+    lok( strstr( buffer, "align 16)" ) != SRALLOC_NULL );
+    lok( strstr( buffer, "unknown call site: 5 allocations, 42 bytes" ) != SRALLOC_NULL );
+    lok( strstr( buffer, "1 allocation, 100 bytes" ) < strstr( buffer, "unknown call site" ) );
+
+    // Moves keep the entry, frees drop it
+    p = sralloc_realloc( proxyalloc, p, 1000, 0 );
+    sralloc_dealloc_batch( proxyalloc, batch, 4 );
+    SRALLOC_DEALLOC( proxyalloc, r );
+    length = sralloc_tracking_report( proxyalloc, buffer, sizeof( buffer ) );
+    lok( strstr( buffer, "has 4 allocations, 1150 bytes live\n" ) != SRALLOC_NULL );
+    lok( strstr( buffer, "1 allocation, 1000 bytes, oldest #0" ) != SRALLOC_NULL );
+    lequal( (int)sralloc_tracking_report( proxyalloc, buffer, 16 ), (int)length );
+    lequal( (int)strlen( buffer ), 15 );
+
+    // Popping and clearing drop what the stack allocator handed out since
+    void* kept = SRALLOC_BYTES( stackalloc, 32 );
+    sralloc_stack_allocator_push_state( stackalloc );
+    SRALLOC_BYTES( stackalloc, 64 );
+    sralloc_tracking_report( stackalloc, buffer, sizeof( buffer ) );
+    lok( strstr( buffer, "has 2 allocations, 96 bytes live\n" ) != SRALLOC_NULL );
+    sralloc_stack_allocator_pop_state( stackalloc );
+    sralloc_tracking_report( stackalloc, buffer, sizeof( buffer ) );
+    lok( strstr( buffer, "has 1 allocation, 32 bytes live\n" ) != SRALLOC_NULL );
+    SRALLOC_UNUSED( kept );
+    sralloc_stack_allocator_clear( stackalloc );
+    lequal( (int)sralloc_tracking_report( stackalloc, buffer, sizeof( buffer ) ), 0 );
+
+    SRALLOC_DEALLOC( proxyalloc, p );
+    for ( int i = 0; i < 3; ++i ) {
+        SRALLOC_DEALLOC( proxyalloc, q[i] );
+    }
+
+    // Page aligned blocks spread over the table like any others
+    static void* pages[1000];
+    for ( int i = 0; i < 1000; ++i ) {
+        pages[i] = SRALLOC_ALIGNED_BYTES( proxyalloc, 16, 4096 );
+    }
+    sralloc_tracking_report( proxyalloc, buffer, sizeof( buffer ) );
+    lok( strstr( buffer, "has 1000 allocations, 16000 bytes live\n" ) != SRALLOC_NULL );
+    static char used[4096];
+    int         num_homes = 0;
+    for ( int i = 0; i < 1000; ++i ) {
+        srint_t home = sr__tracking_home( (sruintptr_t)i * 4096, 4095 );
+        num_homes += !used[home];
+        used[home] = 1;
+    }
+    lok( num_homes > 800 );
+    for ( int i = 0; i < 1000; ++i ) {
+        SRALLOC_DEALLOC( proxyalloc, pages[i] );
+    }
+#else
+    lok( !sralloc_enable_tracking( proxyalloc, storagealloc ) );
+#endif
+    lequal( (int)sralloc_tracking_report( proxyalloc, buffer, sizeof( buffer ) ), 0 );
+    lequal( (int)buffer[0], 0 );
+
+    sralloc_destroy_stack_allocator( stackalloc );
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    lequal( sralloc_get_stats( storagealloc ).num_allocations, 0 );
+    sralloc_destroy_malloc_allocator( storagealloc );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+
+#ifdef SRALLOC_64BIT_SIZES
+void
+large_sizes_test( void ) {
+    // Small blocks keep a 32 bit preamble
+    lequal( (int)sizeof( sralloc_malloc_preamble_t ), 8 );
+    lequal( (int)sizeof( sralloc_proxy_preamble_t ), 8 );
+
+    // None of these blocks are written to past their first page
+    srint_t        large_size  = (srint_t)3 * 1024 * 1024 * 1024;
+    srallocator_t* mallocalloc = sralloc_create_malloc_allocator( "root" );
+    srallocator_t* proxyalloc  = sralloc_create_proxy_allocator( "proxy", mallocalloc );
+    sr_result_t    pA          = sralloc_alloc_with_size( proxyalloc, large_size );
+    lok( pA.ptr != SRALLOC_NULL );
+    lok( pA.size == large_size );
+    lok( sralloc_get_stats( proxyalloc ).amount_allocated > large_size );
+    lok( sralloc_get_stats( mallocalloc ).amount_allocated > large_size );
+    SRALLOC_DEALLOC( proxyalloc, pA.ptr );
+    lok( sralloc_get_stats( proxyalloc ).amount_allocated == 0 );
+
+    srallocator_t* stackalloc = sralloc_create_stack_allocator( "stack", mallocalloc, large_size );
+    void*          pC         = SRALLOC_BYTES( stackalloc, large_size - 1024 * 1024 );
+    lok( pC != SRALLOC_NULL );
+    lok( sralloc_try_expand( stackalloc, pC, large_size - 1024 ) );
+    lok( sralloc_get_stats( stackalloc ).amount_allocated > large_size - 1024 );
+    void* pD = SRALLOC_BYTES( stackalloc, 100 );
+    lok( pD != SRALLOC_NULL );
+    SRALLOC_DEALLOC( stackalloc, pD );
+    SRALLOC_DEALLOC( stackalloc, pC );
+    lok( sralloc_get_stats( stackalloc ).amount_allocated == 0 );
+    sralloc_destroy_stack_allocator( stackalloc );
+
+    sralloc_destroy_proxy_allocator( proxyalloc );
+    lok( sralloc_get_stats( mallocalloc ).amount_allocated == 0 );
+    sralloc_destroy_malloc_allocator( mallocalloc );
+}
+#endif
+
+#ifdef __cplusplus
+void
+policy_test( void ) {
+    // Everything below the runtime adapter is resolved at compile time
+    sralloc::Malloc                                  root;
+    sralloc::Stack<sralloc::Malloc>                  stack( root, 64 * 1024 );
+    sralloc::Proxy<sralloc::Stack<sralloc::Malloc> > proxy( stack, "proxy" );
+    char*                                            pA = (char*)proxy.allocate( 100, 0 );
+    char*                                            pB = (char*)proxy.allocate( 100, 64 );
+    lok( pA != SRALLOC_NULL );
+    lequal( (int)( (sruintptr_t)pB & 63 ), 0 );
+    lequal( proxy.num_allocations(), 2 );
+    lequal( proxy.amount_allocated(), 200 );
+    proxy.deallocate( pB, 100, 64 );
+    lok( proxy.allocate( 100, 0 ) == pB );
+    lok( proxy.allocate( 1024 * 1024, 0 ) == SRALLOC_NULL );
+    proxy.deallocate( pB, 100, 0 );
+    lequal( stack.used(), (int)( pB - pA ) );
+    proxy.deallocate( pA, 100, 0 );
+    stack.clear();
+    lequal( stack.used(), 0 );
+
+    void* pC = root.allocate( 100, 256 );
+    lequal( (int)( (sruintptr_t)pC & 255 ), 0 );
+    root.deallocate( pC, 100, 256 );
+
+    {
+        sralloc::Runtime<sralloc::Proxy<sralloc::Stack<sralloc::Malloc> > > runtime( proxy,
+                                                                                     "runtime" );
+        generic_allocator_tests( runtime.get() );
+        lequal( sralloc_get_stats( runtime.get() ).num_allocations, 0 );
+        lequal( proxy.num_allocations(), 0 );
+    }
+
+    sralloc::Allocator mallocalloc = sralloc::Allocator::create_malloc_allocator( "root" );
+    sralloc::Dynamic                  dynamic( mallocalloc.get() );
+    sralloc::Stack<sralloc::Dynamic> dynamic_stack( dynamic, 1024 );
+    int*                              pD = sralloc::allocate_object<int>( dynamic_stack );
+    *pD                                  = 1;
+    lequal( sralloc_get_stats( mallocalloc.get() ).num_allocations, 1 );
+    sralloc::deallocate_object( dynamic_stack, pD );
+}
+#endif
+
 #ifndef NO_IGDEBUG
 void
 ig_debugheap_test( void ) {
@@ -221,8 +2067,8 @@ ig_debugheap_test( void ) {
     unittest_dealloc( igdbgalloc, pA1 );
     // unittest_dealloc( igdbgalloc, pA2 );
     sralloc_destroy_ig_debugheap_allocator( igdbgalloc );
-    lequal( mallocalloc->stats.num_allocations, 0 );
-    lequal( mallocalloc->stats.amount_allocated, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).num_allocations, 0 );
+    lequal( sralloc_get_stats( mallocalloc ).amount_allocated, 0 );
     sralloc_destroy_malloc_allocator( mallocalloc );
 }
 #endif
@@ -230,10 +2076,43 @@ ig_debugheap_test( void ) {
 int
 main( void ) {
 
+    lrun( "page_allocator", page_test );
+    lrun( "buddy_allocator", buddy_test );
+    lrun( "tlsf_allocator", tlsf_test );
+    lrun( "end_of_page_allocator", end_of_page_test );
+    lrun( "slot_allocator", slot_test );
+    lrun( "thread_cache_allocator", thread_cache_test );
+    lrun( "concurrent_frame_allocator", concurrent_frame_test );
+    lrun( "ring_allocator", ring_test );
+    lrun( "sized_dealloc", sized_dealloc_test );
+    lrun( "tracking", tracking_test );
+
+    // Without the preamble only the sized API can free from the allocators these use
+#ifndef SRALLOC_DISABLE_PREAMBLE
     lrun( "malloc_allocator", malloc_test );
+    lrun( "heap_allocator", heap_test );
+    lrun( "numa_allocator", numa_test );
     lrun( "stack_allocator", stack_test );
+    lrun( "arena_allocator", arena_test );
     lrun( "proxy_allocator", proxy_test );
-    lrun( "end_of_page_allocator", end_of_page_test );
+    lrun( "mutex_allocator", mutex_test );
+    lrun( "multi_frame_allocator", multi_frame_test );
+    lrun( "batch", batch_test );
+    lrun( "realloc", realloc_test );
+    lrun( "callback_allocator", callback_test );
+    lrun( "stats", stats_test );
+    lrun( "extended_stats", extended_stats_test );
+    lrun( "report", report_test );
+    lrun( "trace", trace_test );
+    lrun( "replay", replay_test );
+    lrun( "profiling_allocator", profiling_test );
+#endif
+#ifdef SRALLOC_64BIT_SIZES
+    lrun( "large_sizes", large_sizes_test );
+#endif
+#ifdef __cplusplus
+    lrun( "policy", policy_test );
+#endif
 
 #ifndef NO_IGDEBUG
     lrun( "ig_debugheap_allocator", ig_debugheap_test );
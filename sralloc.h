@@ -18,19 +18,34 @@
 #endif
 #endif // SRALLOC_ENABLE_WARNINGS
 
+// The implementation uses ftruncate, madvise and syscall, which strict ISO modes (-std=c99) hide.
+// Feature macros only count before the first system header, so when something is included
+// before the implementation, define _DEFAULT_SOURCE up front yourself.
+#if defined( SRALLOC_IMPLEMENTATION ) && !defined( _WIN32 ) && !defined( _DEFAULT_SOURCE )
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct srallocator srallocator_t;
 
-#ifndef SRALLOC_TYPES
+// Define SRALLOC_64BIT_SIZES (everywhere sralloc.h is included) for allocation sizes, capacities
+// and stats that go past 2 GiB. Types defined by SRALLOC_TYPES still get <stdint.h>, the API
+// uses int64_t for counters and trace fields whatever srint_t is.
 #include <stdint.h>
-typedef char         srchar_t;
+#ifndef SRALLOC_TYPES
+typedef char srchar_t;
+#ifdef SRALLOC_64BIT_SIZES
+typedef int64_t  srint_t;
+typedef uint64_t sruint_t;
+#else
 typedef int          srint_t;
 typedef unsigned int sruint_t;
-typedef short        srshort_t;
-typedef uintptr_t    sruintptr_t;
+#endif
+typedef short     srshort_t;
+typedef uintptr_t sruintptr_t;
 #endif
 
 typedef struct {
@@ -39,6 +54,11 @@ typedef struct {
     // srint_t offset;
 } sr_result_t;
 
+typedef struct {
+    srint_t num_allocations;
+    srint_t amount_allocated;
+} sralloc_stats_t;
+
 #if defined( SRALLOC_STATIC )
 #define SRALLOC_API static
 #else
@@ -53,16 +73,277 @@ SRALLOC_API sr_result_t sralloc_alloc_aligned_with_size( srallocator_t* allocato
                                                          srint_t        size,
                                                          srint_t        align );
 SRALLOC_API void        sralloc_dealloc( srallocator_t* allocator, void* ptr );
+
+// Frees ptr without reading its preamble, size and align must be what it was allocated with.
+// Required for the malloc, stack and proxy allocators when built with SRALLOC_DISABLE_PREAMBLE.
+SRALLOC_API void sralloc_dealloc_sized( srallocator_t* allocator,
+                                        void*          ptr,
+                                        srint_t        size,
+                                        srint_t        align );
 SRALLOC_API void*       sralloc_allocate( srallocator_t* allocator, srint_t size, srint_t align );
 
+// Batch API, for allocating or freeing many blocks of the same size in one call.
+// Returns how many pointers were written to out_ptrs, which is only less than count when the
+// allocator ran out. Every pointer passed to sralloc_dealloc_batch must be a live allocation,
+// null and zero size pointers are not filtered out.
+SRALLOC_API srint_t sralloc_alloc_batch( srallocator_t* allocator,
+                                         srint_t        size,
+                                         srint_t        align,
+                                         srint_t        count,
+                                         void**         out_ptrs );
+SRALLOC_API void    sralloc_dealloc_batch( srallocator_t* allocator, void** ptrs, srint_t count );
+
+// Resizing. align has to be the alignment ptr was allocated with. sralloc_realloc moves the
+// memory when it can't grow in place and returns null, leaving ptr untouched, when that fails too
+// or the allocator doesn't support resizing. A new_size of 0 frees ptr, except with
+// SRALLOC_DISABLE_PREAMBLE for allocators that need sralloc_dealloc_sized, where it returns null.
+// sralloc_try_expand never moves, it returns nonzero if ptr now holds new_size bytes.
+SRALLOC_API void* sralloc_realloc( srallocator_t* allocator,
+                                   void*          ptr,
+                                   srint_t        new_size,
+                                   srint_t        align );
+SRALLOC_API int   sralloc_try_expand( srallocator_t* allocator, void* ptr, srint_t new_size );
+
+// Stats of the allocator itself, and of it plus everything below it in the allocator tree.
+// With SRALLOC_ENABLE_SHARDED_STATS these sum the per-thread shards when called, so they're only
+// exact when no other thread is allocating from the allocators involved.
+SRALLOC_API sralloc_stats_t sralloc_get_stats( srallocator_t* allocator );
+SRALLOC_API sralloc_stats_t sralloc_get_total_stats( srallocator_t* allocator );
+
+// Extended stats, collected per allocator when built with SRALLOC_ENABLE_EXTENDED_STATS (and
+// zero otherwise). Sizes are what was asked for through the API, padding is what the allocator
+// charged its stats on top of that: preambles, alignment and rounding. Peaks follow the
+// allocator's own counters, so for the thread cache and concurrent frame allocators they only move
+// when the per-thread counts are folded in. Counters are updated atomically but padding is only
+// exact for allocators used by one thread at a time. Can't be combined with sharded stats.
+#define SRALLOC_STATS_HISTOGRAM_SIZE ( 8 * (int)sizeof( srint_t ) - 1 )
+
+typedef struct {
+    srint_t peak_num_allocations;
+    srint_t peak_amount_allocated;
+    int64_t total_allocations; // Successful allocations
+    int64_t total_amount_requested;
+    int64_t padding;
+    int64_t num_failed;
+    int64_t size_histogram[SRALLOC_STATS_HISTOGRAM_SIZE]; // [i] counts sizes from 2^i to 2^(i+1)-1
+} sralloc_extended_stats_t;
+
+// The window starts when the allocator is created and at every sralloc_reset_stats_window, for
+// example once per frame. Its peaks start over from the allocator's current stats.
+typedef enum {
+    SRALLOC_STATS_LIFETIME = 0,
+    SRALLOC_STATS_WINDOW,
+} sralloc_stats_window_t;
+
+SRALLOC_API sralloc_extended_stats_t sralloc_get_extended_stats( srallocator_t*         allocator,
+                                                                 sralloc_stats_window_t window );
+SRALLOC_API void                     sralloc_reset_stats_window( srallocator_t* allocator );
+
+// Allocation tracking, when built with SRALLOC_ENABLE_TRACKING (define it wherever sralloc.h is
+// included, the util macros below depend on it). An allocator that has had tracking enabled keeps
+// every live allocation made through the API in a hash table allocated from storage, which must
+// not be the allocator or part of its subtree: pointer, size, alignment, a sequence number and the
+// file and line of the SRALLOC_BYTES style macro or SRALLOC_AT_CALL_SITE that made it, if any.
+// When the allocator is destroyed with allocations left, the leak report goes to SRALLOC_log
+// (stderr by default) before the leak asserts fire. Clearing a frame, stack or arena allocator, or
+// popping its state, drops what it tracked. Enable it before anything is allocated, returns 0 if
+// tracking isn't built in or storage is out of memory.
+SRALLOC_API int sralloc_enable_tracking( srallocator_t* allocator, srallocator_t* storage );
+
+// The leak report for what allocator has live right now, grouped by call site with the most bytes
+// first, each with its oldest allocation. Written like sralloc_report, using temporary memory
+// from storage, and returns 0 when there's nothing to report.
+SRALLOC_API srint_t sralloc_tracking_report( srallocator_t* allocator,
+                                             srchar_t*      buffer,
+                                             srint_t        capacity );
+
+// Call site of the calling thread's next allocation through the API, cleared by it
+SRALLOC_API void sralloc_set_call_site( const char* file, int line );
+
+// Memory report of allocator and everything below it, as compact JSON or CSV. Every allocator
+// gets its name, type, own stats, the totals of its subtree, overhead and peak. Overhead is the
+// allocator's own bookkeeping: its struct and fixed state, children array and stats shards, not
+// the memory it maps or carves out of its parent later. Peak is the highest amount_allocated any
+// report has seen for it, or the tracked peak with SRALLOC_ENABLE_EXTENDED_STATS. JSON nests the
+// children, CSV has a row per allocator in depth first order with the id (row index) of its
+// parent. Writes at most capacity - 1 characters and a terminator, nothing is allocated, and
+// returns the length of the whole report so a buffer that was too small can be grown. Must not
+// run while allocators in the tree are created or destroyed.
+typedef enum {
+    SRALLOC_REPORT_JSON = 0,
+    SRALLOC_REPORT_CSV,
+} sralloc_report_format_t;
+
+SRALLOC_API srint_t sralloc_report( srallocator_t*          allocator,
+                                    sralloc_report_format_t format,
+                                    srchar_t*               buffer,
+                                    srint_t                 capacity );
+
+// Same, but allocated from output, which must not be part of the reported tree. Free it with
+// sralloc_dealloc_sized( output, report, length + 1, 0 ). Returns null if output is out of memory.
+SRALLOC_API srchar_t* sralloc_report_alloc( srallocator_t*          allocator,
+                                            sralloc_report_format_t format,
+                                            srallocator_t*          output,
+                                            srint_t*                out_length );
+
 // Malloc allocator (global allocator)
 SRALLOC_API srallocator_t* sralloc_create_malloc_allocator( const char* name );
 SRALLOC_API void           sralloc_destroy_malloc_allocator( srallocator_t* allocator );
 
+// Heap allocator (general purpose global allocator, gets its memory straight from the OS)
+// Size class segregated: blocks up to 8 KiB come from SRALLOC_HEAP_SPAN_SIZE spans with no
+// per-block preamble, bigger ones get their own mapping. Alignments of SRALLOC_HEAP_SPAN_SIZE
+// and up aren't supported and return null. Not thread safe on its own, put a mutex or thread
+// cache allocator in front of it for that.
+SRALLOC_API srallocator_t* sralloc_create_heap_allocator( const char* name );
+SRALLOC_API void           sralloc_destroy_heap_allocator( srallocator_t* allocator );
+
+// Page allocator (root allocator that maps every allocation straight from the OS)
+// Allocations are rounded up to whole pages and aligned to at least the page size, with no
+// header or padding. With huge_pages set, allocations of SRALLOC_HUGE_PAGE_SIZE and up first try
+// explicit huge pages (MAP_HUGETLB, large pages on Windows) and then ask for transparent huge
+// pages on a huge page aligned mapping (MADV_HUGEPAGE), otherwise they get normal pages.
+// huge_page_bytes is how much of what's mapped is backed by huge pages right now, for
+// transparent huge pages that's read from /proc/self/smaps so it isn't cheap. Not thread safe on
+// its own.
+typedef struct {
+    srint_t mapped;
+    srint_t huge_page_bytes;
+} sralloc_page_stats_t;
+
+SRALLOC_API srallocator_t*       sralloc_create_page_allocator( const char* name, int huge_pages );
+SRALLOC_API void                 sralloc_destroy_page_allocator( srallocator_t* allocator );
+SRALLOC_API sralloc_page_stats_t sralloc_page_allocator_stats( srallocator_t* allocator );
+
+// NUMA allocator (root allocator with a page allocator per NUMA node)
+// Each node's allocator binds its mappings to the node (mbind on linux), so an allocator tree
+// built on top of it for threads pinned to that node keeps their memory local, and its stats
+// are that node's. What's allocated from the NUMA allocator itself is bound to the calling
+// thread's node and counted in its own stats. Without NUMA support (or off linux) there is one
+// node and nothing is bound. Like the page allocator, not thread safe on its own.
+SRALLOC_API srallocator_t* sralloc_create_numa_allocator( const char* name, int huge_pages );
+SRALLOC_API void           sralloc_destroy_numa_allocator( srallocator_t* allocator );
+SRALLOC_API srint_t        sralloc_numa_allocator_num_nodes( srallocator_t* allocator );
+SRALLOC_API srallocator_t* sralloc_numa_allocator_node( srallocator_t* allocator, srint_t node );
+SRALLOC_API srallocator_t* sralloc_numa_allocator_local_node( srallocator_t* allocator );
+
 // Stack allocator (or stack frame allocator)
 SRALLOC_API      srallocator_t*
                  sralloc_create_stack_allocator( const char* name, srallocator_t* parent, srint_t capacity );
 SRALLOC_API void sralloc_destroy_stack_allocator( srallocator_t* allocator );
+SRALLOC_API void sralloc_stack_allocator_clear( srallocator_t* allocator );
+SRALLOC_API void sralloc_stack_allocator_push_state( srallocator_t* allocator );
+SRALLOC_API void sralloc_stack_allocator_pop_state( srallocator_t* allocator );
+
+// Virtual stack allocator (stack allocator that only commits what it has used)
+// Reserves capacity bytes of address space straight from the OS and commits them in
+// SRALLOC_STACK_COMMIT_SIZE steps as top advances, so blocks never move and memory use follows
+// the high-water mark instead of the capacity. Clear and pop_state decommit what lies past top,
+// except for the first keep_committed bytes. Destroyed with sralloc_destroy_stack_allocator.
+SRALLOC_API srallocator_t* sralloc_create_virtual_stack_allocator( const char*    name,
+                                                                   srallocator_t* parent,
+                                                                   srint_t        capacity,
+                                                                   srint_t        keep_committed );
+SRALLOC_API srint_t        sralloc_stack_allocator_committed( srallocator_t* allocator );
+
+// Arena allocator (stack allocator that grows by chaining blocks from the parent)
+// Bumps within the newest block and chains another one when it's full, block_size bytes and
+// growth_factor times bigger than the last one (1 keeps them the same size). Bigger allocations
+// get a block of their own. Clear keeps the largest block, gives the rest back and drops any
+// pushed states, pop_state gives back the blocks chained since the matching push_state.
+SRALLOC_API srallocator_t* sralloc_create_arena_allocator( const char*    name,
+                                                           srallocator_t* parent,
+                                                           srint_t        block_size,
+                                                           srint_t        growth_factor );
+SRALLOC_API void           sralloc_destroy_arena_allocator( srallocator_t* allocator );
+SRALLOC_API void           sralloc_arena_allocator_clear( srallocator_t* allocator );
+SRALLOC_API void           sralloc_arena_allocator_push_state( srallocator_t* allocator );
+SRALLOC_API void           sralloc_arena_allocator_pop_state( srallocator_t* allocator );
+
+// Concurrent frame allocator (stack allocator that many threads can allocate from at once)
+// The shared top only moves with an atomic add. Each thread grabs sub-blocks of
+// SRALLOC_FRAME_SUB_BLOCK_SIZE and bumps privately within them, so small allocations stay off the
+// shared cache line. Stats are kept per thread and summed into allocator->stats by
+// collect_stats. Clear and collect_stats must not run concurrently with allocations.
+SRALLOC_API srallocator_t* sralloc_create_concurrent_frame_allocator( const char*    name,
+                                                                      srallocator_t* parent,
+                                                                      srint_t        capacity );
+SRALLOC_API void sralloc_destroy_concurrent_frame_allocator( srallocator_t* allocator );
+SRALLOC_API void sralloc_concurrent_frame_allocator_clear( srallocator_t* allocator );
+SRALLOC_API void sralloc_concurrent_frame_allocator_collect_stats( srallocator_t* allocator );
+
+// Multi-buffered frame allocator (frame allocator for data that lives a few frames)
+// Bump allocates from one of num_buffers buffers of buffer_capacity bytes. advance_frame clears
+// the oldest buffer and makes it current, so an allocation stays valid through num_buffers - 1
+// calls to advance_frame without being copied or freed. Buffer stats are for the current buffer
+// at frames_ago 0, the previous one at 1 and so on. The high-water mark is the most the buffer
+// has had in use at once.
+typedef struct {
+    srint_t num_allocations;
+    srint_t amount_allocated;
+    srint_t used;
+    srint_t high_water;
+    srint_t capacity;
+} sralloc_frame_buffer_stats_t;
+
+SRALLOC_API srallocator_t* sralloc_create_multi_frame_allocator( const char*    name,
+                                                                 srallocator_t* parent,
+                                                                 srint_t        num_buffers,
+                                                                 srint_t        buffer_capacity );
+SRALLOC_API void           sralloc_destroy_multi_frame_allocator( srallocator_t* allocator );
+SRALLOC_API void sralloc_multi_frame_allocator_advance_frame( srallocator_t* allocator );
+SRALLOC_API sralloc_frame_buffer_stats_t
+sralloc_multi_frame_allocator_buffer_stats( srallocator_t* allocator, srint_t frames_ago );
+
+// Ring allocator (for streaming data that is freed in the order it was allocated)
+// Allocations are taken at the head of a capacity byte ring and frees move the tail past them,
+// so blocks have to be freed oldest first. Every block has a small header, preamble or not.
+// SRALLOC_RING_MIRRORED maps the ring twice back to back straight from the OS, so a block that
+// wraps around stays contiguous instead of skipping to the start; creation returns NULL when
+// that mapping isn't available. SRALLOC_RING_SPSC lets one thread allocate while another one
+// frees, without locks.
+typedef enum {
+    SRALLOC_RING_MIRRORED = 1,
+    SRALLOC_RING_SPSC     = 2,
+} sralloc_ring_flags_t;
+
+SRALLOC_API srallocator_t* sralloc_create_ring_allocator( const char*    name,
+                                                          srallocator_t* parent,
+                                                          srint_t        capacity,
+                                                          int            flags );
+SRALLOC_API void           sralloc_destroy_ring_allocator( srallocator_t* allocator );
+
+// Buddy allocator (for pools with blocks of all sizes coming and going)
+// Splits a capacity byte region from the parent into power-of-two blocks, down to
+// min_block_size, and merges freed blocks with their buddy again. Both sizes have to be powers of
+// two. Alloc and free are O(log n), with bitmaps tracking which blocks are split and free, and
+// there's no preamble. The size returned in sr_result_t is the whole rounded up block, which may
+// be used. Blocks are aligned to their size, up to SRALLOC_PAGE_SIZE. In the fragmentation
+// stats, free - largest_free_block is free memory that a single allocation can't get at.
+typedef struct {
+    srint_t capacity;
+    srint_t free;
+    srint_t largest_free_block;
+    srint_t num_free_blocks;
+} sralloc_buddy_stats_t;
+
+SRALLOC_API srallocator_t*        sralloc_create_buddy_allocator( const char*    name,
+                                                                  srallocator_t* parent,
+                                                                  srint_t        capacity,
+                                                                  srint_t        min_block_size );
+SRALLOC_API void                  sralloc_destroy_buddy_allocator( srallocator_t* allocator );
+SRALLOC_API sralloc_buddy_stats_t sralloc_buddy_allocator_stats( srallocator_t* allocator );
+
+// TLSF allocator (two-level segregated fit, general purpose with bounded latency)
+// Finds a good fit with two bitmap scans and merges freed blocks with their neighbours right away,
+// so alloc and free take the same time whatever the heap looks like. Memory comes in pools of
+// pool_size bytes from the parent, another pool is added when none has room (bigger if needed),
+// and pools are only given back on destroy. Size pool_size for the peak to keep the parent off
+// the hot path. Every block has a two pointer header.
+SRALLOC_API srallocator_t* sralloc_create_tlsf_allocator( const char*    name,
+                                                          srallocator_t* parent,
+                                                          srint_t        pool_size );
+SRALLOC_API void           sralloc_destroy_tlsf_allocator( srallocator_t* allocator );
 
 // Proxy allocator (for categorizing/structuring)
 SRALLOC_API srallocator_t* sralloc_create_proxy_allocator( const char*    name,
@@ -84,31 +365,183 @@ SRALLOC_API      srallocator_t*
 SRALLOC_API void sralloc_destroy_ig_debugheap_allocator( srallocator_t* allocator );
 #endif
 
+// Mutex allocator (for sharing any allocator between threads)
+// Serializes all calls into the parent with either a mutex or, for short critical sections, a
+// ticket spinlock. Creating and destroying child allocators is not synchronized.
+typedef enum {
+    SRALLOC_LOCK_MUTEX = 0,
+    SRALLOC_LOCK_SPINLOCK,
+} sralloc_lock_type_t;
+
+typedef struct {
+    int64_t num_acquisitions;
+    int64_t num_contended;
+    int64_t wait_time_ns;
+} sralloc_lock_stats_t;
+
+SRALLOC_API srallocator_t*       sralloc_create_mutex_allocator( const char*         name,
+                                                                 srallocator_t*      parent,
+                                                                 sralloc_lock_type_t lock_type );
+SRALLOC_API void                 sralloc_destroy_mutex_allocator( srallocator_t* allocator );
+SRALLOC_API sralloc_lock_stats_t sralloc_mutex_allocator_lock_stats( srallocator_t* allocator );
+
+// Thread cache allocator (for fast small allocations from many threads)
+// Keeps per-thread size class bins of freed blocks and refills/flushes them in batches from the
+// parent, which has to be thread safe (e.g. a mutex allocator). Blocks may be freed on any
+// thread. A thread's bins go back to the parent when it exits. Stats are folded into the
+// allocator at batch boundaries, on flush, at thread exit and on destroy. Destroy expects all
+// other threads to be done with the allocator.
+SRALLOC_API srallocator_t* sralloc_create_thread_cache_allocator( const char*    name,
+                                                                  srallocator_t* parent );
+SRALLOC_API void           sralloc_destroy_thread_cache_allocator( srallocator_t* allocator );
+SRALLOC_API void           sralloc_thread_cache_allocator_flush( srallocator_t* allocator );
+
 // Slot allocator (for things of same size)
-SRALLOC_API srallocator_t* sralloc_create_slot_allocator( srallocator_t* parent,
-                                                          const char*    name,
+// Fixed-size pool with an intrusive free list, no preamble and O(1) alloc/dealloc.
+// The growing variant chains another slab of slab_capacity slots from the parent when full.
+SRALLOC_API srallocator_t* sralloc_create_slot_allocator( const char*    name,
+                                                          srallocator_t* parent,
                                                           srint_t        slot_size,
                                                           srint_t        capacity );
+SRALLOC_API srallocator_t* sralloc_create_growing_slot_allocator( const char*    name,
+                                                                  srallocator_t* parent,
+                                                                  srint_t        slot_size,
+                                                                  srint_t        slab_capacity );
 SRALLOC_API void           sralloc_destroy_slot_allocator( srallocator_t* allocator );
 
+// Callback allocator (for plugging in allocators that live outside sralloc)
+// Forwards to the callbacks with user_data, passing the size and alignment back on deallocation.
+// Without a parent it's a root allocator, otherwise its own memory comes from the parent.
+typedef void* ( *sralloc_callback_allocate_t )( void* user_data, srint_t size, srint_t align );
+typedef void ( *sralloc_callback_deallocate_t )( void*   user_data,
+                                                 void*   ptr,
+                                                 srint_t size,
+                                                 srint_t align );
+
+SRALLOC_API      srallocator_t*
+                 sralloc_create_callback_allocator( const char*                   name,
+                                                    srallocator_t*                parent,
+                                                    void*                         user_data,
+                                                    sralloc_callback_allocate_t   allocate,
+                                                    sralloc_callback_deallocate_t deallocate );
+SRALLOC_API void sralloc_destroy_callback_allocator( srallocator_t* allocator );
+
+// Recording allocator (records the traffic going through it, for replaying it offline)
+// Forwards to the parent and appends a compact binary event for every allocation, free and
+// resize to the trace's buffer. The buffer is handed to write when it fills up, on
+// sralloc_trace_flush and when the trace is destroyed, so write usually appends it to a file.
+// Many recording allocators can share a trace, each gets an id and a name event. The buffer
+// comes from the allocator passed to sralloc_create_trace, which must not be part of the tree
+// being recorded. Calls are serialized on the trace's lock, which also makes the recording
+// allocators thread safe if their parents are only used through them.
+typedef struct sralloc_trace sralloc_trace_t;
+typedef void ( *sralloc_trace_write_t )( void* user_data, const void* data, srint_t size );
+
+SRALLOC_API sralloc_trace_t* sralloc_create_trace( srallocator_t*        allocator,
+                                                   srint_t               buffer_size,
+                                                   sralloc_trace_write_t write,
+                                                   void*                 user_data );
+SRALLOC_API void             sralloc_destroy_trace( sralloc_trace_t* trace );
+SRALLOC_API void             sralloc_trace_flush( sralloc_trace_t* trace );
+SRALLOC_API srallocator_t*   sralloc_create_recording_allocator( const char*      name,
+                                                                 srallocator_t*   parent,
+                                                                 sralloc_trace_t* trace );
+SRALLOC_API void             sralloc_destroy_recording_allocator( srallocator_t* allocator );
+
+// Reading a trace back. Set data and size of a zeroed reader to everything write was given, in
+// order, then sralloc_trace_read returns the events one by one and 0 at the end or on bad data.
+// Pointers are the addresses at recording time, they only identify allocations. A failed
+// allocation or resize has a null result. EXPAND is sralloc_try_expand, REALLOC may move.
+typedef enum {
+    SRALLOC_TRACE_NAME = 1,
+    SRALLOC_TRACE_ALLOC,
+    SRALLOC_TRACE_FREE,
+    SRALLOC_TRACE_REALLOC,
+    SRALLOC_TRACE_EXPAND,
+} sralloc_trace_op_t;
+
+typedef struct {
+    sralloc_trace_op_t op;
+    srint_t            allocator_id;
+    int64_t            time_ns; // Since the trace was created
+    uint64_t           ptr;     // ALLOC result, or the block that's freed or resized
+    uint64_t           new_ptr; // REALLOC and EXPAND result
+    srint_t            size;
+    srint_t            align;
+    const srchar_t*    name; // NAME of allocator_id, name_length chars without a terminator
+    srint_t            name_length;
+} sralloc_trace_event_t;
+
+typedef struct {
+    const unsigned char* data;
+    int64_t              size;
+    int64_t              offset;
+    int64_t              time_ns;
+} sralloc_trace_reader_t;
+
+SRALLOC_API int sralloc_trace_read( sralloc_trace_reader_t* reader, sralloc_trace_event_t* event );
+
+// Profiling allocator (sampling heap profiler, for finding the call sites behind the churn)
+// Forwards to the parent and samples on average one allocation per sample_bytes allocated, in a
+// Poisson process like tcmalloc's heap profiler, so big blocks are more likely to be picked. A
+// sampled allocation gets its call stack captured and stands for all the bytes since the previous
+// sample. Unsampled allocations only count down a per-thread counter, and frees only check a
+// counter for the pointer's hash bucket, so it's cheap enough to leave on. The profile's tables
+// come from storage, which must not be part of the profiled tree. Thread safe if the parent is.
+// It has no stats of its own, everything it forwards is counted by the parent.
+SRALLOC_API srallocator_t* sralloc_create_profiling_allocator( const char*    name,
+                                                               srallocator_t* parent,
+                                                               srallocator_t* storage,
+                                                               srint_t        sample_bytes );
+SRALLOC_API void           sralloc_destroy_profiling_allocator( srallocator_t* allocator );
+
+// Writes the profile, estimated from the samples, like sralloc_report: at most capacity - 1
+// characters and a terminator, returning the length of the whole profile. PPROF is the text heap
+// profile pprof reads (in use and allocated objects and bytes per stack, already scaled so the
+// sampling rate is written as 1), symbolize it with the binary or append /proc/self/maps after a
+// MAPPED_LIBRARIES: line. The FOLDED formats have a line per stack of its frames, outermost first
+// and separated by ';', and the bytes in use or allocated so far, as flamegraph.pl reads them.
+typedef enum {
+    SRALLOC_PROFILE_PPROF = 0,
+    SRALLOC_PROFILE_FOLDED_INUSE,
+    SRALLOC_PROFILE_FOLDED_ALLOC,
+} sralloc_profile_format_t;
+
+SRALLOC_API srint_t sralloc_profile_write( srallocator_t*           allocator,
+                                           sralloc_profile_format_t format,
+                                           srchar_t*                buffer,
+                                           srint_t                  capacity );
+
 // Util API. BYTES and DEALLOC only here for consistency.
 #ifndef SRALLOC_ALIGNOF
 #define SRALLOC_ALIGNOF alignof
 #endif
 
-#define SRALLOC_BYTES( allocator, size ) sralloc_alloc( allocator, size )
-#define SRALLOC_OBJECT( allocator, type ) ( (type*)sralloc_alloc( allocator, sizeof( type ) ) )
+// Records the call site for allocation tracking, call is an allocation through the API
+#ifdef SRALLOC_ENABLE_TRACKING
+#define SRALLOC_AT_CALL_SITE( call ) ( sralloc_set_call_site( __FILE__, __LINE__ ), call )
+#else
+#define SRALLOC_AT_CALL_SITE( call ) call
+#endif
+
+#define SRALLOC_BYTES( allocator, size ) SRALLOC_AT_CALL_SITE( sralloc_alloc( allocator, size ) )
+#define SRALLOC_OBJECT( allocator, type ) \
+    ( (type*)SRALLOC_AT_CALL_SITE( sralloc_alloc( allocator, sizeof( type ) ) ) )
 #define SRALLOC_ARRAY( allocator, type, length ) \
-    ( (type*)sralloc_alloc( allocator, sizeof( size ) * length ) );
+    ( (type*)SRALLOC_AT_CALL_SITE( sralloc_alloc( allocator, sizeof( type ) * ( length ) ) ) )
 
 #define SRALLOC_ALIGNED_BYTES( allocator, size, align ) \
-    sralloc_alloc_aligned( allocator, size, align )
-#define SRALLOC_ALIGNED_OBJECT( allocator, type ) \
-    ( (type*)sralloc_alloc_aligned( allocator, sizeof( type ), SRALLOC_ALIGNOF( type ) ) )
-#define SRALLOC_ALIGNED_ARRAY( allocator, type, length ) \
-    ( (type*)sralloc_alloc_aligned( allocator, sizeof( type ) * length ), SRALLOC_ALIGNOF( type ) );
+    SRALLOC_AT_CALL_SITE( sralloc_alloc_aligned( allocator, size, align ) )
+#define SRALLOC_ALIGNED_OBJECT( allocator, type )          \
+    ( (type*)SRALLOC_AT_CALL_SITE( sralloc_alloc_aligned( \
+      allocator, sizeof( type ), SRALLOC_ALIGNOF( type ) ) ) )
+#define SRALLOC_ALIGNED_ARRAY( allocator, type, length )   \
+    ( (type*)SRALLOC_AT_CALL_SITE( sralloc_alloc_aligned( \
+      allocator, sizeof( type ) * ( length ), SRALLOC_ALIGNOF( type ) ) ) )
 
 #define SRALLOC_DEALLOC( allocator, ptr ) sralloc_dealloc( allocator, ptr );
+#define SRALLOC_DEALLOC_SIZED( allocator, ptr, size, align ) \
+    sralloc_dealloc_sized( allocator, ptr, size, align );
 
 #ifdef __cplusplus
 }
@@ -123,6 +556,28 @@ SRALLOC_API void           sralloc_destroy_slot_allocator( srallocator_t* alloca
 #define SRALLOC_free free
 #endif
 
+#ifndef SRALLOC_realloc
+#include <stdlib.h>
+#define SRALLOC_realloc realloc
+#endif
+
+#ifndef SRALLOC_aligned_malloc
+#if defined( _WIN32 )
+#include <malloc.h>
+#define SRALLOC_aligned_malloc( size, align ) _aligned_malloc( size, align )
+#define SRALLOC_aligned_free _aligned_free
+#else
+#include <stdlib.h>
+#if !defined( __cplusplus )
+// Hidden by strict C99 but present in every POSIX libc
+int posix_memalign( void** memptr, size_t alignment, size_t size );
+#endif
+#define SR__USE_POSIX_MEMALIGN
+#define SRALLOC_aligned_malloc( size, align ) sr__posix_aligned_malloc( size, align )
+#define SRALLOC_aligned_free free
+#endif // _WIN32
+#endif // SRALLOC_aligned_malloc
+
 #ifndef SRALLOC_assert
 #include <assert.h>
 #define SRALLOC_assert assert
@@ -164,10 +619,32 @@ SRALLOC_API void           sralloc_destroy_slot_allocator( srallocator_t* alloca
 #define SRALLOC_USE_STATS
 #endif
 
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_ENABLE_EXTENDED_STATS )
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+#error "SRALLOC_ENABLE_EXTENDED_STATS can't be combined with SRALLOC_ENABLE_SHARDED_STATS"
+#endif
+#define SRALLOC_USE_EXTENDED_STATS
+#endif
+
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_ENABLE_TRACKING )
+#define SRALLOC_USE_TRACKING
+#endif
+
 #ifndef SRALLOC_DISABLE_NAMES
 #define SRALLOC_USE_NAMES
 #endif
 
+// Without the preamble, allocators that can rebuild the allocation from the size and alignment
+// passed to sralloc_dealloc_sized don't store one at all.
+#ifndef SRALLOC_DISABLE_PREAMBLE
+#define SRALLOC_USE_PREAMBLE
+#endif
+
+// Alignment every SRALLOC_malloc result is guaranteed to have
+#ifndef SRALLOC_MALLOC_ALIGN
+#define SRALLOC_MALLOC_ALIGN ( 2 * (srint_t)sizeof( void* ) )
+#endif
+
 // #ifndef SRALLOC_DISABLE_TYPES
 // #define SRALLOC_USE_TYPES
 // #endif
@@ -177,6 +654,16 @@ SRALLOC_API void           sralloc_destroy_slot_allocator( srallocator_t* alloca
 #define SRALLOC_PAGE_SIZE 0x1000
 #endif
 
+// Page allocator config, the size of a huge page (2 MiB on x64 and most arm64 systems)
+#ifndef SRALLOC_HUGE_PAGE_SIZE
+#define SRALLOC_HUGE_PAGE_SIZE 0x200000
+#endif
+
+// NUMA allocator config, threads on nodes past this allocate from node 0
+#ifndef SRALLOC_NUMA_MAX_NODES
+#define SRALLOC_NUMA_MAX_NODES 64
+#endif
+
 #ifndef SRALLOC_PROTECT_MEMORY
 #if defined( _WIN32 )
 #define WIN32_LEAN_AND_MEAN
@@ -190,7 +677,7 @@ typedef DWORD srmemflag_t;
 typedef int srmemflag_t;
 #define SRALLOC_MEMPROTECT_FLAG PROT_NONE
 #define SRALLOC_PROTECT_MEMORY( ptr, size, protection, old_protection ) \
-    SRALLOC_UNUSED( old_protection );                                   \
+    *( old_protection ) = PROT_READ | PROT_WRITE;                       \
     mprotect( ptr, size, protection );
 #else
 #define SRALLOC_PROTECT_MEMORY( ptr, size, protection, old_protection ) \
@@ -198,822 +685,7862 @@ typedef int srmemflag_t;
 #endif // _WIN32
 #endif // SRALLOC_PROTECT_MEMORY
 
-typedef struct {
-    int num_allocations;
-    int amount_allocated;
-} sralloc_stats_t;
+// Spins before a waiting thread yields its time slice, in case the lock holder got preempted
+#ifndef SRALLOC_SPIN_COUNT
+#define SRALLOC_SPIN_COUNT 64
+#endif
 
-typedef sr_result_t ( *sralloc_allocate_func )( srallocator_t* allocator,
-                                                srint_t        size,
-                                                srint_t        align );
-typedef void ( *sralloc_deallocate_func )( srallocator_t* allocator, void* ptr );
+// Heap allocator config. Spans must be a power of two, segments a multiple of the span size.
+#ifndef SRALLOC_HEAP_SPAN_SIZE
+#define SRALLOC_HEAP_SPAN_SIZE 0x10000
+#endif
 
-struct srallocator {
-#ifdef SRALLOC_USE_NAMES
-    const char* name; // TODO arrayify
+#ifndef SRALLOC_HEAP_SEGMENT_SIZE
+#define SRALLOC_HEAP_SEGMENT_SIZE 0x200000
 #endif
-    // #ifdef SRALLOC_USE_TYPES
-    //     char type[16];
-    // #endif
-    sralloc_allocate_func   allocate_func;
-    sralloc_deallocate_func deallocate_func;
-#ifdef SRALLOC_USE_STATS
-    srallocator_t*  parent;
-    srallocator_t** children;
-    srint_t         num_children;
-    srint_t         children_capacity;
-    sralloc_stats_t stats;
+
+// Empty spans the heap keeps ready for reuse, the pages of any more go back to the OS
+#ifndef SRALLOC_HEAP_MAX_FREE_SPANS
+#define SRALLOC_HEAP_MAX_FREE_SPANS 16
 #endif
-};
 
-// ██╗███╗   ██╗████████╗███████╗██████╗ ███╗   ██╗ █████╗ ██╗
-// ██║████╗  ██║╚══██╔══╝██╔════╝██╔══██╗████╗  ██║██╔══██╗██║
-// ██║██╔██╗ ██║   ██║   █████╗  ██████╔╝██╔██╗ ██║███████║██║
-// ██║██║╚██╗██║   ██║   ██╔══╝  ██╔══██╗██║╚██╗██║██╔══██║██║
-// ██║██║ ╚████║   ██║   ███████╗██║  ██║██║ ╚████║██║  ██║███████╗
-// ╚═╝╚═╝  ╚═══╝   ╚═╝   ╚══════╝╚═╝  ╚═╝╚═╝  ╚═══╝╚═╝  ╚═╝╚══════╝
+// Concurrent frame allocator config, bytes a thread takes from the shared top at a time
+#ifndef SRALLOC_FRAME_SUB_BLOCK_SIZE
+#define SRALLOC_FRAME_SUB_BLOCK_SIZE 4096
+#endif
 
-static void
-sr__add_child_allocator( srallocator_t* parent, srallocator_t* child ) {
-    SRALLOC_UNUSED( parent, child );
-#ifdef SRALLOC_USE_STATS
-    child->parent = parent;
-    if ( parent->children_capacity > parent->num_children ) {
-        parent->children[parent->num_children++] = child;
-        return;
-    }
+// Virtual stack allocator config, bytes committed at a time (a multiple of SRALLOC_PAGE_SIZE)
+#ifndef SRALLOC_STACK_COMMIT_SIZE
+#define SRALLOC_STACK_COMMIT_SIZE ( 64 * 1024 )
+#endif
 
-    parent->children_capacity = parent->children_capacity ? parent->children_capacity * 2 : 2;
+// Arena allocator config, blocks stop growing geometrically once they reach this size
+#ifndef SRALLOC_ARENA_MAX_BLOCK_SIZE
+#define SRALLOC_ARENA_MAX_BLOCK_SIZE ( 64 * 1024 * 1024 )
+#endif
 
-    void* new_children = SRALLOC_NULL;
-    if ( parent->parent != SRALLOC_NULL ) {
-        new_children = (srallocator_t*)sralloc_alloc(
-          parent->parent, sizeof( parent->children ) * parent->children_capacity );
-        SRALLOC_memcpy(
-          new_children, parent->children, parent->num_children * sizeof( parent->children ) );
-        sralloc_dealloc( parent->parent, parent->children );
-        parent->children                         = (srallocator_t**)new_children;
-        parent->children[parent->num_children++] = child;
-    }
-    else {
-        new_children = (srallocator_t*)sralloc_alloc(
-          parent, sizeof( parent->children ) * parent->children_capacity );
-        SRALLOC_memcpy(
-          new_children, parent->children, parent->num_children * sizeof( parent->children ) );
-        sralloc_dealloc( parent, parent->children );
-        parent->children                         = (srallocator_t**)new_children;
-        parent->children[parent->num_children++] = child;
-    }
-#endif // SRALLOC_USE_STATS
+// Thread cache allocator config, blocks moved between a thread's bin and the parent at a time
+#ifndef SRALLOC_TCACHE_BATCH
+#define SRALLOC_TCACHE_BATCH 32
+#endif
+
+// Slot allocator config
+#ifndef SRALLOC_SLOT_MAX_ALIGN
+#define SRALLOC_SLOT_MAX_ALIGN 64
+#endif
+
+// Threading primitives, used by the allocators that can be shared between threads
+#ifndef SRALLOC_ATOMICS
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#define SRALLOC_atomic_fetch_add( ptr, value )                                         \
+    ( sizeof( *( ptr ) ) == 8                                                          \
+        ? _InterlockedExchangeAdd64( (volatile __int64*)( ptr ), (__int64)( value ) ) \
+        : _InterlockedExchangeAdd( (volatile long*)( ptr ), (long)( value ) ) )
+#define SRALLOC_atomic_load( ptr )                                      \
+    ( sizeof( *( ptr ) ) == 8                                           \
+        ? _InterlockedOr64( (volatile __int64*)( ptr ), 0 )             \
+        : _InterlockedOr( (volatile long*)( ptr ), 0 ) )
+#define SRALLOC_atomic_store( ptr, value )                                                   \
+    ( sizeof( *( ptr ) ) == 8                                                                \
+        ? (void)_InterlockedExchange64( (volatile __int64*)( ptr ), (__int64)( value ) ) \
+        : (void)_InterlockedExchange( (volatile long*)( ptr ), (long)( value ) ) )
+#define SRALLOC_cpu_pause() _mm_pause()
+#else
+#define SRALLOC_atomic_fetch_add( ptr, value ) __atomic_fetch_add( ptr, value, __ATOMIC_ACQ_REL )
+#define SRALLOC_atomic_load( ptr ) __atomic_load_n( ptr, __ATOMIC_ACQUIRE )
+#define SRALLOC_atomic_store( ptr, value ) __atomic_store_n( ptr, value, __ATOMIC_RELEASE )
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define SRALLOC_cpu_pause() __builtin_ia32_pause()
+#elif defined( __aarch64__ ) || defined( __arm__ )
+#define SRALLOC_cpu_pause() __asm__ __volatile__( "yield" )
+#else
+#define SRALLOC_cpu_pause()
+#endif
+#endif
+#endif // SRALLOC_ATOMICS
+
+#ifndef SRALLOC_MUTEX
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+typedef SRWLOCK srmutex_t;
+#define SRALLOC_mutex_init( mutex ) InitializeSRWLock( mutex )
+#define SRALLOC_mutex_destroy( mutex ) SRALLOC_UNUSED( mutex )
+#define SRALLOC_mutex_trylock( mutex ) ( TryAcquireSRWLockExclusive( mutex ) != 0 )
+#define SRALLOC_mutex_lock( mutex ) AcquireSRWLockExclusive( mutex )
+#define SRALLOC_mutex_unlock( mutex ) ReleaseSRWLockExclusive( mutex )
+#define SRALLOC_thread_yield() SwitchToThread()
+#else
+#include <pthread.h>
+typedef pthread_mutex_t srmutex_t;
+#define SRALLOC_mutex_init( mutex ) pthread_mutex_init( mutex, SRALLOC_NULL )
+#define SRALLOC_mutex_destroy( mutex ) pthread_mutex_destroy( mutex )
+#define SRALLOC_mutex_trylock( mutex ) ( pthread_mutex_trylock( mutex ) == 0 )
+#define SRALLOC_mutex_lock( mutex ) pthread_mutex_lock( mutex )
+#define SRALLOC_mutex_unlock( mutex ) pthread_mutex_unlock( mutex )
+#include <sched.h>
+#define SRALLOC_thread_yield() sched_yield()
+#endif
+#endif // SRALLOC_MUTEX
+
+#ifndef SRALLOC_time_ns
+#if defined( _WIN32 )
+static int64_t
+sr__time_ns( void ) {
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+    return ( int64_t )( (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart );
+}
+#else
+#include <sys/time.h>
+#include <time.h>
+static int64_t
+sr__time_ns( void ) {
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    // Strict ISO modes hide clock_gettime unless a POSIX feature macro is set
+    struct timeval tv;
+    gettimeofday( &tv, SRALLOC_NULL );
+    return (int64_t)tv.tv_sec * 1000000000 + (int64_t)tv.tv_usec * 1000;
+#endif
 }
+#endif
+#define SRALLOC_time_ns sr__time_ns
+#endif // SRALLOC_time_ns
 
-static void
-sr__remove_child_allocator( srallocator_t* parent, srallocator_t* child ) {
-    SRALLOC_UNUSED( parent, child );
-#ifdef SRALLOC_USE_STATS
-    for ( srint_t i_child = 0; i_child < parent->num_children; ++i_child ) {
-        if ( parent->children[i_child] == child ) {
-            parent->children[i_child] = parent->children[--parent->num_children];
+// Call stack capture for the profiling allocator, fills frames with up to max_frames return
+// addresses, innermost first, and returns how many. Captures nothing where there's no default.
+#ifndef SRALLOC_backtrace
+#if defined( _WIN32 )
+#include <Windows.h>
+#define SRALLOC_backtrace( frames, max_frames ) \
+    (int)RtlCaptureStackBackTrace( 0, (DWORD)( max_frames ), frames, SRALLOC_NULL )
+#elif defined( __GLIBC__ ) || defined( __APPLE__ )
+#include <execinfo.h>
+#define SRALLOC_backtrace( frames, max_frames ) backtrace( frames, max_frames )
+#else
+#define SRALLOC_backtrace( frames, max_frames ) ( (void)( frames ), (void)( max_frames ), 0 )
+#endif
+#endif // SRALLOC_backtrace
 
-            if ( parent->num_children == 0 ) {
-                if ( parent->parent != SRALLOC_NULL ) {
-                    sralloc_dealloc( parent->parent, parent->children );
-                }
-                else {
-                    sralloc_dealloc( parent, parent->children );
-                }
+// Profiling allocator config
+#ifndef SRALLOC_PROFILE_MAX_FRAMES
+#define SRALLOC_PROFILE_MAX_FRAMES 32
+#endif
 
-                parent->children          = SRALLOC_NULL;
-                parent->children_capacity = 0;
-            }
+// Allocation tracking config, where leak reports go
+#ifdef SRALLOC_USE_TRACKING
+#include <stdlib.h> // qsort
+#ifndef SRALLOC_log
+#include <stdio.h>
+#define SRALLOC_log( message ) fputs( message, stderr )
+#endif
+#endif
 
-            return;
-        }
-    }
+#ifndef SRALLOC_THREAD_LOCAL
+#if defined( _MSC_VER )
+#define SRALLOC_THREAD_LOCAL __declspec( thread )
+#else
+#define SRALLOC_THREAD_LOCAL __thread
+#endif
+#endif
 
-    SRALLOC_assert( 0 );
-#endif // SRALLOC_USE_STATS
-}
+// Upper bound on threads at a time that get their own per-thread state (caches, stat shards etc),
+// an exited thread's slot goes to the next new thread.
+// Threads beyond it still work but take the shared slow path.
+#ifndef SRALLOC_MAX_THREADS
+#define SRALLOC_MAX_THREADS 128
+#endif
 
-static void
-sr__set_name( srallocator_t* allocator, const srchar_t* name ) {
-    SRALLOC_UNUSED( allocator, name );
-#ifdef SRALLOC_USE_NAMES
-    allocator->name = name;
+#define SR__CACHE_LINE_SIZE 64
+
+// Locks for library wide state, which can't wait for a create function to initialize them
+#if defined( _WIN32 )
+#include <Windows.h>
+typedef SRWLOCK sr__static_mutex_t;
+#define SR__STATIC_MUTEX_INIT SRWLOCK_INIT
+#define sr__static_mutex_lock( mutex ) AcquireSRWLockExclusive( mutex )
+#define sr__static_mutex_unlock( mutex ) ReleaseSRWLockExclusive( mutex )
+#else
+#include <pthread.h>
+typedef pthread_mutex_t sr__static_mutex_t;
+#define SR__STATIC_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define sr__static_mutex_lock( mutex ) pthread_mutex_lock( mutex )
+#define sr__static_mutex_unlock( mutex ) pthread_mutex_unlock( mutex )
 #endif
-}
 
-// static void
-// sr__set_type( srallocator_t* allocator, const srchar_t* name ) {
-//     SRALLOC_UNUSED( allocator, name );
-// #ifdef SRALLOC_USE_NAMES
-//     SRALLOC_memcpy( allocator->name, SRALLOC_strlen( name ), name );
-// #endif
-// }
+static sr__static_mutex_t           sr__thread_index_mutex = SR__STATIC_MUTEX_INIT;
+static srint_t                      sr__num_thread_indices;
+static srint_t                      sr__free_thread_indices[SRALLOC_MAX_THREADS];
+static srint_t                      sr__num_free_thread_indices;
+static SRALLOC_THREAD_LOCAL srint_t sr__thread_index_plus_one;
 
-static void*
-sr__ptr_to_aligned_ptr( void* ptr, srint_t align ) {
-    if ( align == 0 ) {
-        return ptr;
-    }
+static void sr__thread_cache_thread_exit( srint_t thread_index );
 
-    sruintptr_t offset      = ( ~(sruintptr_t)ptr + 1 ) & ( align - 1 );
-    void*       aligned_ptr = (srchar_t*)ptr + offset;
-    return aligned_ptr;
+// Runs when a thread that has an index exits: its thread caches are flushed and the index goes
+// back on the free list for the next new thread
+static void
+sr__thread_index_release( void* value ) {
+    srint_t thread_index = (srint_t)(sruintptr_t)value - 1;
+    sr__thread_cache_thread_exit( thread_index );
+    sr__thread_index_plus_one = 0;
+
+    sr__static_mutex_lock( &sr__thread_index_mutex );
+    sr__free_thread_indices[sr__num_free_thread_indices++] = thread_index;
+    sr__static_mutex_unlock( &sr__thread_index_mutex );
 }
 
-static srchar_t*
-sr__aligned_ptr_after_preamble( void* ptr, srint_t preamble_size, srint_t align ) {
-    srchar_t* after_preamble = (srchar_t*)ptr + preamble_size;
-    return sr__ptr_to_aligned_ptr( after_preamble, align );
-}
+#if defined( _WIN32 )
+static DWORD sr__thread_exit_key = FLS_OUT_OF_INDEXES;
 
-static srint_t
-sr__ptr_diff( void* ptr1, void* ptr2 ) {
-    return ( srint_t )( (srchar_t*)ptr1 - (srchar_t*)ptr2 );
+static void WINAPI
+sr__thread_exit( void* value ) {
+    if ( value != SRALLOC_NULL ) {
+        sr__thread_index_release( value );
+    }
 }
 
-//  █████╗ ██████╗ ██╗
-// ██╔══██╗██╔══██╗██║
-// ███████║██████╔╝██║
-// ██╔══██║██╔═══╝ ██║
-// ██║  ██║██║     ██║
-// ╚═╝  ╚═╝╚═╝     ╚═╝
-
-SRALLOC_API void*
-sralloc_alloc( srallocator_t* allocator, srint_t size ) {
-    if ( size == 0 ) {
-        return SRALLOC_ZERO_SIZE_PTR;
+// Call with sr__thread_index_mutex held
+static void
+sr__thread_on_exit( srint_t thread_index ) {
+    if ( sr__thread_exit_key == FLS_OUT_OF_INDEXES ) {
+        sr__thread_exit_key = FlsAlloc( sr__thread_exit );
     }
 
-    return allocator->allocate_func( allocator, size, 0 ).ptr;
+    FlsSetValue( sr__thread_exit_key, (void*)(sruintptr_t)( thread_index + 1 ) );
 }
+#else
+static pthread_key_t sr__thread_exit_key;
+static int           sr__thread_exit_key_created;
 
-SRALLOC_API sr_result_t
-            sralloc_alloc_with_size( srallocator_t* allocator, srint_t size ) {
-    if ( size == 0 ) {
-        sr_result_t res = { SRALLOC_ZERO_SIZE_PTR, 0 };
-        return res;
+// Call with sr__thread_index_mutex held
+static void
+sr__thread_on_exit( srint_t thread_index ) {
+    if ( !sr__thread_exit_key_created ) {
+        sr__thread_exit_key_created = pthread_key_create( &sr__thread_exit_key,
+                                                          sr__thread_index_release ) == 0;
     }
 
-    return allocator->allocate_func( allocator, size, 0 );
+    if ( sr__thread_exit_key_created ) {
+        pthread_setspecific( sr__thread_exit_key, (void*)(sruintptr_t)( thread_index + 1 ) );
+    }
 }
+#endif
 
-SRALLOC_API void*
-sralloc_alloc_aligned( srallocator_t* allocator, srint_t size, srint_t align ) {
-    if ( size == 0 ) {
-        return SRALLOC_ZERO_SIZE_PTR;
+// Small dense per-thread index, handed out on first use and given back when the thread exits
+static srint_t
+sr__thread_index( void ) {
+    if ( sr__thread_index_plus_one == 0 ) {
+        sr__static_mutex_lock( &sr__thread_index_mutex );
+        srint_t thread_index = sr__num_free_thread_indices > 0
+                                 ? sr__free_thread_indices[--sr__num_free_thread_indices]
+                                 : sr__num_thread_indices++;
+        if ( thread_index < SRALLOC_MAX_THREADS ) {
+            sr__thread_on_exit( thread_index );
+        }
+
+        sr__static_mutex_unlock( &sr__thread_index_mutex );
+        sr__thread_index_plus_one = thread_index + 1;
     }
 
-    return allocator->allocate_func( allocator, size, align ).ptr;
+    return sr__thread_index_plus_one - 1;
 }
 
-SRALLOC_API sr_result_t
-            sralloc_alloc_aligned_with_size( srallocator_t* allocator, srint_t size, srint_t align ) {
-    if ( size == 0 ) {
-        sr_result_t res = { SRALLOC_ZERO_SIZE_PTR, 0 };
-        return res;
-    }
+// OS virtual memory, for the allocators that get their memory straight from the OS
+#if defined( _WIN32 )
+static void*
+sr__os_map( sruintptr_t size ) {
+    return VirtualAlloc( SRALLOC_NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+}
 
-    return allocator->allocate_func( allocator, size, align );
+static void
+sr__os_unmap( void* ptr, sruintptr_t size ) {
+    SRALLOC_UNUSED( size );
+    VirtualFree( ptr, 0, MEM_RELEASE );
 }
 
-SRALLOC_API void
-sralloc_dealloc( srallocator_t* allocator, void* ptr ) {
-    if ( ptr == SRALLOC_ZERO_SIZE_PTR ) {
-        return;
-    }
+static void*
+sr__os_map_aligned( sruintptr_t size, sruintptr_t alignment ) {
+    // Windows can't release part of a mapping, so find an aligned hole and map into it
+    for ( int attempt = 0; attempt < 16; ++attempt ) {
+        srchar_t* ptr =
+          (srchar_t*)VirtualAlloc( SRALLOC_NULL, size + alignment, MEM_RESERVE, PAGE_NOACCESS );
+        if ( ptr == SRALLOC_NULL ) {
+            return SRALLOC_NULL;
+        }
 
-    if ( ptr == SRALLOC_NULL ) {
-        return;
+        VirtualFree( ptr, 0, MEM_RELEASE );
+        ptr = (srchar_t*)( ( (sruintptr_t)ptr + alignment - 1 ) & ~( alignment - 1 ) );
+        ptr = (srchar_t*)VirtualAlloc( ptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+        if ( ptr != SRALLOC_NULL ) {
+            return ptr;
+        }
     }
 
-    allocator->deallocate_func( allocator, ptr );
+    return SRALLOC_NULL;
 }
 
-// ███╗   ███╗ █████╗ ██╗     ██╗      ██████╗  ██████╗
-// ████╗ ████║██╔══██╗██║     ██║     ██╔═══██╗██╔════╝
-// ██╔████╔██║███████║██║     ██║     ██║   ██║██║
-// ██║╚██╔╝██║██╔══██║██║     ██║     ██║   ██║██║
-// ██║ ╚═╝ ██║██║  ██║███████╗███████╗╚██████╔╝╚██████╗
-// ╚═╝     ╚═╝╚═╝  ╚═╝╚══════╝╚══════╝ ╚═════╝  ╚═════╝
+// Address space only, pages are committed and decommitted in place and released with unmap
+static void*
+sr__os_reserve( sruintptr_t size ) {
+    return VirtualAlloc( SRALLOC_NULL, size, MEM_RESERVE, PAGE_NOACCESS );
+}
+
+static int
+sr__os_commit( void* ptr, sruintptr_t size ) {
+    return VirtualAlloc( ptr, size, MEM_COMMIT, PAGE_READWRITE ) != SRALLOC_NULL;
+}
+
+static void
+sr__os_decommit( void* ptr, sruintptr_t size ) {
+    VirtualFree( ptr, size, MEM_DECOMMIT );
+}
+
+// Large pages need the SeLockMemoryPrivilege, without it this fails and the caller falls back
+static void*
+sr__os_map_huge( sruintptr_t size ) {
+    return VirtualAlloc(
+      SRALLOC_NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE );
+}
+
+static int
+sr__os_advise_huge( void* ptr, sruintptr_t size ) {
+    SRALLOC_UNUSED( ptr, size );
+    return 0;
+}
+
+// Maps the same size bytes twice back to back, size a multiple of SR__MIRROR_GRANULARITY
+#define SR__MIRROR_GRANULARITY ( 64 * 1024 )
+static void*
+sr__os_map_mirrored( sruintptr_t size ) {
+    HANDLE mapping = CreateFileMappingA( INVALID_HANDLE_VALUE,
+                                         SRALLOC_NULL,
+                                         PAGE_READWRITE,
+                                         ( DWORD )( (uint64_t)size >> 32 ),
+                                         (DWORD)size,
+                                         SRALLOC_NULL );
+    if ( mapping == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    // Like sr__os_map_aligned, find a hole for both views and map into it
+    srchar_t* result = SRALLOC_NULL;
+    for ( int attempt = 0; attempt < 16 && result == SRALLOC_NULL; ++attempt ) {
+        srchar_t* ptr =
+          (srchar_t*)VirtualAlloc( SRALLOC_NULL, size * 2, MEM_RESERVE, PAGE_NOACCESS );
+        if ( ptr == SRALLOC_NULL ) {
+            break;
+        }
+
+        VirtualFree( ptr, 0, MEM_RELEASE );
+        void* view1 = MapViewOfFileEx( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, ptr );
+        void* view2 = MapViewOfFileEx( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, ptr + size );
+        if ( view1 == ptr && view2 == ptr + size ) {
+            result = ptr;
+        }
+        else {
+            if ( view1 != SRALLOC_NULL ) {
+                UnmapViewOfFile( view1 );
+            }
+
+            if ( view2 != SRALLOC_NULL ) {
+                UnmapViewOfFile( view2 );
+            }
+        }
+    }
+
+    // The views keep the mapping alive
+    CloseHandle( mapping );
+    return result;
+}
+
+static void
+sr__os_unmap_mirrored( void* ptr, sruintptr_t size ) {
+    UnmapViewOfFile( ptr );
+    UnmapViewOfFile( (srchar_t*)ptr + size );
+}
+#else
+#include <sys/mman.h>
+#if !defined( MAP_ANONYMOUS ) && defined( MAP_ANON )
+#define MAP_ANONYMOUS MAP_ANON
+#elif !defined( MAP_ANONYMOUS ) && defined( __linux__ )
+// Strict ISO modes (-std=c99) hide the non-POSIX parts of mman.h, these are the Linux values
+#define MAP_ANONYMOUS 0x20
+#endif
+#if !defined( MAP_NORESERVE ) && defined( __linux__ )
+#define MAP_NORESERVE 0x4000
+#elif !defined( MAP_NORESERVE )
+#define MAP_NORESERVE 0
+#endif
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined( __linux__ )
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+#include <sys/syscall.h>
+#endif
+
+static void*
+sr__os_map( sruintptr_t size ) {
+    void* ptr = mmap(
+      SRALLOC_NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    return ptr == MAP_FAILED ? SRALLOC_NULL : ptr;
+}
+
+static void
+sr__os_unmap( void* ptr, sruintptr_t size ) {
+    munmap( ptr, size );
+}
+
+static void*
+sr__os_map_aligned( sruintptr_t size, sruintptr_t alignment ) {
+    // Map enough to contain an aligned range and give back what's around it
+    srchar_t* ptr = (srchar_t*)sr__os_map( size + alignment );
+    if ( ptr == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    sruintptr_t head = ( ( ~(sruintptr_t)ptr + 1 ) & ( alignment - 1 ) );
+    srchar_t*   aligned_ptr = ptr + head;
+    if ( head > 0 ) {
+        munmap( ptr, head );
+    }
+
+    if ( alignment - head > 0 ) {
+        munmap( aligned_ptr + size, alignment - head );
+    }
+
+    return aligned_ptr;
+}
+
+// Address space only, pages are committed and decommitted in place and released with unmap
+static void*
+sr__os_reserve( sruintptr_t size ) {
+    void* ptr = mmap(
+      SRALLOC_NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    return ptr == MAP_FAILED ? SRALLOC_NULL : ptr;
+}
+
+static int
+sr__os_commit( void* ptr, sruintptr_t size ) {
+    return mprotect( ptr, size, PROT_READ | PROT_WRITE ) == 0;
+}
+
+// Mapping fresh inaccessible pages over the range hands the old ones back to the OS
+static void
+sr__os_decommit( void* ptr, sruintptr_t size ) {
+    mmap( ptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0 );
+}
+
+// Explicit huge pages, size a multiple of SRALLOC_HUGE_PAGE_SIZE. Returns null unless the system
+// has huge pages reserved for it.
+static void*
+sr__os_map_huge( sruintptr_t size ) {
+#if defined( __linux__ )
+    void* ptr = mmap( SRALLOC_NULL,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                      -1,
+                      0 );
+    return ptr == MAP_FAILED ? SRALLOC_NULL : ptr;
+#else
+    SRALLOC_UNUSED( size );
+    return SRALLOC_NULL;
+#endif
+}
+
+// Asks for transparent huge pages, returns nonzero if the hint was taken
+static int
+sr__os_advise_huge( void* ptr, sruintptr_t size ) {
+#if defined( __linux__ )
+    return madvise( ptr, size, MADV_HUGEPAGE ) == 0;
+#else
+    SRALLOC_UNUSED( ptr, size );
+    return 0;
+#endif
+}
+
+#if defined( __linux__ )
+static sruintptr_t
+sr__parse_number( const srchar_t** str, sruintptr_t base ) {
+    sruintptr_t number = 0;
+    for ( ;; ++*str ) {
+        srchar_t c = **str;
+        if ( c >= '0' && c <= '9' ) {
+            number = number * base + (sruintptr_t)( c - '0' );
+        }
+        else if ( base == 16 && c >= 'a' && c <= 'f' ) {
+            number = number * base + (sruintptr_t)( c - 'a' + 10 );
+        }
+        else {
+            return number;
+        }
+    }
+}
+
+typedef void ( *sr__huge_range_func )( void*       user_data,
+                                       sruintptr_t start,
+                                       sruintptr_t end,
+                                       sruintptr_t huge_bytes );
+
+// Calls func for every mapping in the process that has transparent huge pages in it
+static void
+sr__os_for_each_huge_range( sr__huge_range_func func, void* user_data ) {
+    int fd = open( "/proc/self/smaps", O_RDONLY );
+    if ( fd < 0 ) {
+        return;
+    }
+
+    // Only the start of each line matters, the rest is cut off
+    static const srchar_t anon_huge[] = "AnonHugePages:";
+    srchar_t              buffer[4096];
+    srchar_t              line[64];
+    srint_t               line_length = 0;
+    sruintptr_t           start       = 0;
+    sruintptr_t           end         = 0;
+    for ( ;; ) {
+        ssize_t num_read = read( fd, buffer, sizeof( buffer ) );
+        if ( num_read <= 0 ) {
+            break;
+        }
+
+        for ( ssize_t i = 0; i < num_read; ++i ) {
+            if ( buffer[i] != '\n' ) {
+                if ( line_length < (srint_t)sizeof( line ) - 1 ) {
+                    line[line_length++] = buffer[i];
+                }
+
+                continue;
+            }
+
+            line[line_length]   = 0;
+            line_length         = 0;
+            const srchar_t* str = line;
+            sruintptr_t     num = sr__parse_number( &str, 16 );
+            if ( str != line && *str == '-' ) {
+                ++str;
+                start = num;
+                end   = sr__parse_number( &str, 16 );
+                continue;
+            }
+
+            srint_t matched = 0;
+            while ( anon_huge[matched] != 0 && line[matched] == anon_huge[matched] ) {
+                ++matched;
+            }
+
+            if ( anon_huge[matched] == 0 ) {
+                str += matched;
+                while ( *str == ' ' ) {
+                    ++str;
+                }
+
+                sruintptr_t huge_bytes = sr__parse_number( &str, 10 ) * 1024;
+                if ( huge_bytes > 0 ) {
+                    func( user_data, start, end, huge_bytes );
+                }
+            }
+        }
+    }
+
+    close( fd );
+}
+#endif
+
+static srchar_t*
+sr__write_number( srchar_t* str, sruintptr_t number ) {
+    srchar_t  digits[24];
+    srchar_t* digit = digits;
+    do {
+        *digit++ = (srchar_t)( '0' + number % 10 );
+        number /= 10;
+    } while ( number > 0 );
+
+    while ( digit != digits ) {
+        *str++ = *--digit;
+    }
+
+    return str;
+}
+
+// Maps the same size bytes twice back to back, size a multiple of SR__MIRROR_GRANULARITY.
+// The pages belong to a shared memory object that is unlinked straight away, so only the two
+// mappings keep it around.
+#define SR__MIRROR_GRANULARITY SRALLOC_PAGE_SIZE
+static void*
+sr__os_map_mirrored( sruintptr_t size ) {
+    static srint_t sr__num_mirrors = 0;
+    int            fd              = -1;
+    for ( int attempt = 0; attempt < 16 && fd < 0; ++attempt ) {
+        srchar_t  name[64] = "/sralloc-";
+        srchar_t* name_end = sr__write_number( name + 9, (sruintptr_t)getpid() );
+        *name_end++        = '-';
+        name_end = sr__write_number( name_end, SRALLOC_atomic_fetch_add( &sr__num_mirrors, 1 ) );
+        *name_end = 0;
+        fd        = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0600 );
+        if ( fd >= 0 ) {
+            shm_unlink( name );
+        }
+    }
+
+    if ( fd < 0 ) {
+        return SRALLOC_NULL;
+    }
+
+    srchar_t* ptr = SRALLOC_NULL;
+    if ( ftruncate( fd, (off_t)size ) == 0 ) {
+        ptr = (srchar_t*)sr__os_reserve( size * 2 );
+    }
+
+    int prot = PROT_READ | PROT_WRITE;
+    if ( ptr != SRALLOC_NULL &&
+         ( mmap( ptr, size, prot, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED ||
+           mmap( ptr + size, size, prot, MAP_SHARED | MAP_FIXED, fd, 0 ) == MAP_FAILED ) ) {
+        munmap( ptr, size * 2 );
+        ptr = SRALLOC_NULL;
+    }
+
+    close( fd );
+    return ptr;
+}
+
+static void
+sr__os_unmap_mirrored( void* ptr, sruintptr_t size ) {
+    munmap( ptr, size * 2 );
+}
+#endif // _WIN32
+
+// NUMA nodes, linux only for now. Returns 0 when the system doesn't say, in which case nothing
+// should be bound.
+static srint_t
+sr__os_num_nodes( void ) {
+#if defined( __linux__ ) && defined( SYS_mbind )
+    int fd = open( "/sys/devices/system/node/possible", O_RDONLY );
+    if ( fd < 0 ) {
+        return 0;
+    }
+
+    srchar_t buffer[256];
+    ssize_t  num_read = read( fd, buffer, sizeof( buffer ) - 1 );
+    close( fd );
+    if ( num_read <= 0 ) {
+        return 0;
+    }
+
+    // A list like "0-3" or "0,2", the last number is the highest node
+    buffer[num_read] = 0;
+    srint_t highest  = 0;
+    for ( const srchar_t* str = buffer; *str != 0; ) {
+        if ( *str >= '0' && *str <= '9' ) {
+            highest = (srint_t)sr__parse_number( &str, 10 );
+        }
+        else {
+            ++str;
+        }
+    }
+
+    return highest < SRALLOC_NUMA_MAX_NODES ? highest + 1 : SRALLOC_NUMA_MAX_NODES;
+#else
+    return 0;
+#endif
+}
+
+static srint_t
+sr__os_current_node( void ) {
+#if defined( __linux__ ) && defined( SYS_getcpu )
+    unsigned int cpu;
+    unsigned int node;
+    if ( syscall( SYS_getcpu, &cpu, &node, SRALLOC_NULL ) == 0 ) {
+        return (srint_t)node;
+    }
+#endif
+    return 0;
+}
+
+// Has the pages of a fresh mapping come from node when they're first touched (MPOL_BIND)
+static int
+sr__os_bind_node( void* ptr, sruintptr_t size, srint_t node ) {
+#if defined( __linux__ ) && defined( SYS_mbind )
+#define SR__NODE_MASK_BITS ( 8 * sizeof( unsigned long ) )
+    unsigned long mask[( SRALLOC_NUMA_MAX_NODES + SR__NODE_MASK_BITS - 1 ) / SR__NODE_MASK_BITS];
+    SRALLOC_assert( node >= 0 && node < SRALLOC_NUMA_MAX_NODES );
+    SRALLOC_memset( mask, 0, sizeof( mask ) );
+    mask[node / SR__NODE_MASK_BITS] = 1ul << ( node % SR__NODE_MASK_BITS );
+
+    // 2 is MPOL_BIND, and the kernel reads one bit less of the mask than it's told to
+    long mode     = 2;
+    long max_node = (long)sizeof( mask ) * 8 + 1;
+    return syscall( SYS_mbind, ptr, size, mode, mask, max_node, 0l ) == 0;
+#else
+    SRALLOC_UNUSED( ptr, size, node );
+    return 0;
+#endif
+}
+
+typedef sr_result_t ( *sralloc_allocate_func )( srallocator_t* allocator,
+                                                srint_t        size,
+                                                srint_t        align );
+typedef void ( *sralloc_deallocate_func )( srallocator_t* allocator, void* ptr );
+typedef srint_t ( *sralloc_allocate_batch_func )( srallocator_t* allocator,
+                                                  srint_t        size,
+                                                  srint_t        align,
+                                                  srint_t        count,
+                                                  void**         out_ptrs );
+typedef void ( *sralloc_deallocate_batch_func )( srallocator_t* allocator,
+                                                 void**         ptrs,
+                                                 srint_t        count );
+typedef void ( *sralloc_deallocate_sized_func )( srallocator_t* allocator,
+                                                 void*          ptr,
+                                                 srint_t        size,
+                                                 srint_t        align );
+typedef sr_result_t ( *sralloc_reallocate_func )( srallocator_t* allocator,
+                                                  void*          ptr,
+                                                  srint_t        size,
+                                                  srint_t        align,
+                                                  int            may_move );
+
+struct srallocator {
+#ifdef SRALLOC_USE_NAMES
+    const char* name; // TODO arrayify
+#endif
+    // #ifdef SRALLOC_USE_TYPES
+    //     char type[16];
+    // #endif
+    sralloc_allocate_func   allocate_func;
+    sralloc_deallocate_func deallocate_func;
+
+    // Optional, sralloc_alloc_batch and sralloc_dealloc_batch loop when these are null
+    sralloc_allocate_batch_func   allocate_batch_func;
+    sralloc_deallocate_batch_func deallocate_batch_func;
+
+    // Optional, sralloc_dealloc_sized calls deallocate_func when this is null
+    sralloc_deallocate_sized_func deallocate_sized_func;
+
+    // Optional, returns a null ptr when the allocation can't be resized (in place)
+    sralloc_reallocate_func reallocate_func;
+#ifdef SRALLOC_USE_STATS
+    srallocator_t*  parent;
+    srallocator_t** children;
+    srint_t         num_children;
+    srint_t         children_capacity;
+    sralloc_stats_t stats;
+    srint_t         report_peak; // Highest amount_allocated seen by sralloc_report
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    srchar_t* stats_shards; // SRALLOC_MAX_THREADS cache lines, each starting with sralloc_stats_t
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    struct sr__extended_stats* extended_stats;
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    struct sr__tracking* tracking;
+#endif
+#endif
+};
+
+// ██╗███╗   ██╗████████╗███████╗██████╗ ███╗   ██╗ █████╗ ██╗
+// ██║████╗  ██║╚══██╔══╝██╔════╝██╔══██╗████╗  ██║██╔══██╗██║
+// ██║██╔██╗ ██║   ██║   █████╗  ██████╔╝██╔██╗ ██║███████║██║
+// ██║██║╚██╗██║   ██║   ██╔══╝  ██╔══██╗██║╚██╗██║██╔══██║██║
+// ██║██║ ╚████║   ██║   ███████╗██║  ██║██║ ╚████║██║  ██║███████╗
+// ╚═╝╚═╝  ╚═══╝   ╚═╝   ╚══════╝╚═╝  ╚═╝╚═╝  ╚═══╝╚═╝  ╚═╝╚══════╝
+
+static void
+sr__add_child_allocator( srallocator_t* parent, srallocator_t* child ) {
+    SRALLOC_UNUSED( parent, child );
+#ifdef SRALLOC_USE_STATS
+    child->parent = parent;
+    if ( parent->children_capacity > parent->num_children ) {
+        parent->children[parent->num_children++] = child;
+        return;
+    }
+
+    srint_t old_children_size = sizeof( parent->children ) * parent->children_capacity;
+    parent->children_capacity = parent->children_capacity ? parent->children_capacity * 2 : 2;
+
+    void* new_children = SRALLOC_NULL;
+    if ( parent->parent != SRALLOC_NULL ) {
+        new_children = (srallocator_t*)sralloc_alloc(
+          parent->parent, sizeof( parent->children ) * parent->children_capacity );
+        SRALLOC_memcpy(
+          new_children, parent->children, parent->num_children * sizeof( parent->children ) );
+        sralloc_dealloc_sized( parent->parent, parent->children, old_children_size, 0 );
+        parent->children                         = (srallocator_t**)new_children;
+        parent->children[parent->num_children++] = child;
+    }
+    else {
+        new_children = (srallocator_t*)sralloc_alloc(
+          parent, sizeof( parent->children ) * parent->children_capacity );
+        SRALLOC_memcpy(
+          new_children, parent->children, parent->num_children * sizeof( parent->children ) );
+        sralloc_dealloc_sized( parent, parent->children, old_children_size, 0 );
+        parent->children                         = (srallocator_t**)new_children;
+        parent->children[parent->num_children++] = child;
+    }
+#endif // SRALLOC_USE_STATS
+}
+
+static void
+sr__remove_child_allocator( srallocator_t* parent, srallocator_t* child ) {
+    SRALLOC_UNUSED( parent, child );
+#ifdef SRALLOC_USE_STATS
+    for ( srint_t i_child = 0; i_child < parent->num_children; ++i_child ) {
+        if ( parent->children[i_child] == child ) {
+            parent->children[i_child] = parent->children[--parent->num_children];
+
+            if ( parent->num_children == 0 ) {
+                srint_t children_size = sizeof( parent->children ) * parent->children_capacity;
+                if ( parent->parent != SRALLOC_NULL ) {
+                    sralloc_dealloc_sized( parent->parent, parent->children, children_size, 0 );
+                }
+                else {
+                    sralloc_dealloc_sized( parent, parent->children, children_size, 0 );
+                }
+
+                parent->children          = SRALLOC_NULL;
+                parent->children_capacity = 0;
+            }
+
+            return;
+        }
+    }
+
+    SRALLOC_assert( 0 );
+#endif // SRALLOC_USE_STATS
+}
+
+static void
+sr__set_name( srallocator_t* allocator, const srchar_t* name ) {
+    SRALLOC_UNUSED( allocator, name );
+#ifdef SRALLOC_USE_NAMES
+    allocator->name = name;
+#endif
+}
+
+// Text output into a caller's buffer, for the reports, profiles and leak reports
+typedef struct {
+    srchar_t* buffer;
+    srint_t   capacity;
+    srint_t   length; // Of the whole report, can be past capacity
+    srint_t   num_rows;
+} sr__report_writer_t;
+
+static void
+sr__report_write( sr__report_writer_t* writer, const srchar_t* str, srint_t length ) {
+    srint_t room = writer->capacity - 1 - writer->length;
+    if ( room > 0 ) {
+        SRALLOC_memcpy( writer->buffer + writer->length, str, length < room ? length : room );
+    }
+
+    writer->length += length;
+}
+
+static void
+sr__report_write_string( sr__report_writer_t* writer, const srchar_t* str ) {
+    srint_t length = 0;
+    while ( str[length] != 0 ) {
+        ++length;
+    }
+
+    sr__report_write( writer, str, length );
+}
+
+static void
+sr__report_write_number( sr__report_writer_t* writer, int64_t number ) {
+    srchar_t  digits[24];
+    srchar_t* digit     = digits + sizeof( digits );
+    uint64_t  magnitude = number < 0 ? 0 - (uint64_t)number : (uint64_t)number;
+    do {
+        *--digit = (srchar_t)( '0' + magnitude % 10 );
+        magnitude /= 10;
+    } while ( magnitude > 0 );
+
+    if ( number < 0 ) {
+        *--digit = '-';
+    }
+
+    sr__report_write( writer, digit, (srint_t)( digits + sizeof( digits ) - digit ) );
+}
+
+static void
+sr__report_write_hex( sr__report_writer_t* writer, uint64_t number ) {
+    srchar_t  digits[24];
+    srchar_t* digit = digits + sizeof( digits );
+    do {
+        *--digit = "0123456789abcdef"[number & 0xf];
+        number >>= 4;
+    } while ( number > 0 );
+
+    *--digit = 'x';
+    *--digit = '0';
+    sr__report_write( writer, digit, (srint_t)( digits + sizeof( digits ) - digit ) );
+}
+
+// Murmur3's 64 bit finalizer, for hashing pointers
+static uint64_t
+sr__hash64( uint64_t value ) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+#ifdef SRALLOC_USE_TRACKING
+typedef struct {
+    sruintptr_t     ptr; // 0 for an empty slot
+    srint_t         size;
+    srint_t         align;
+    int64_t         sequence;
+    const srchar_t* file; // Null when the call site isn't known
+    int             line;
+} sr__tracked_t;
+
+struct sr__tracking {
+    srallocator_t* storage;
+    srmutex_t      mutex;
+    int64_t        next_sequence;
+    sr__tracked_t* entries; // Open addressing on ptr, at most half full
+    srint_t        num_entries;
+    srint_t        capacity;
+};
+
+typedef struct {
+    const sr__tracked_t* oldest;
+    srint_t              num_allocations;
+    int64_t              amount;
+} sr__leak_site_t;
+
+// Set by sralloc_set_call_site and taken by the next allocation
+static SRALLOC_THREAD_LOCAL const srchar_t* sr__call_site_file;
+static SRALLOC_THREAD_LOCAL int             sr__call_site_line;
+
+// The whole address is hashed, page or larger aligned blocks would pile up in a few slots if
+// only some of the bits went in
+static srint_t
+sr__tracking_home( sruintptr_t ptr, srint_t mask ) {
+    return (srint_t)( sr__hash64( ptr >> 4 ) & mask );
+}
+
+static sr__tracked_t*
+sr__tracking_find( struct sr__tracking* tracking, const void* ptr ) {
+    if ( tracking->num_entries == 0 ) {
+        return SRALLOC_NULL;
+    }
+
+    srint_t mask = tracking->capacity - 1;
+    srint_t slot = sr__tracking_home( (sruintptr_t)ptr, mask );
+    for ( ; tracking->entries[slot].ptr != 0; slot = ( slot + 1 ) & mask ) {
+        if ( tracking->entries[slot].ptr == (sruintptr_t)ptr ) {
+            return &tracking->entries[slot];
+        }
+    }
+
+    return SRALLOC_NULL;
+}
+
+static int
+sr__tracking_grow( struct sr__tracking* tracking ) {
+    srint_t        capacity = tracking->capacity > 0 ? tracking->capacity * 2 : 1024;
+    srint_t        size     = capacity * (srint_t)sizeof( sr__tracked_t );
+    sr__tracked_t* entries  = (sr__tracked_t*)sralloc_alloc( tracking->storage, size );
+    if ( entries == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    SRALLOC_memset( entries, 0, size );
+    for ( srint_t i_entry = 0; i_entry < tracking->capacity; ++i_entry ) {
+        sr__tracked_t* entry = &tracking->entries[i_entry];
+        if ( entry->ptr == 0 ) {
+            continue;
+        }
+
+        srint_t slot = sr__tracking_home( entry->ptr, capacity - 1 );
+        while ( entries[slot].ptr != 0 ) {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+
+        entries[slot] = *entry;
+    }
+
+    if ( tracking->entries != SRALLOC_NULL ) {
+        sralloc_dealloc_sized( tracking->storage,
+                               tracking->entries,
+                               tracking->capacity * (srint_t)sizeof( sr__tracked_t ),
+                               0 );
+    }
+
+    tracking->entries  = entries;
+    tracking->capacity = capacity;
+    return 1;
+}
+
+// Shifts the entries after it back so lookups never need tombstones
+static void
+sr__tracking_remove_entry( struct sr__tracking* tracking, sr__tracked_t* entry ) {
+    srint_t mask = tracking->capacity - 1;
+    srint_t hole = (srint_t)( entry - tracking->entries );
+    for ( srint_t slot = ( hole + 1 ) & mask; tracking->entries[slot].ptr != 0;
+          slot         = ( slot + 1 ) & mask ) {
+        srint_t home = sr__tracking_home( tracking->entries[slot].ptr, mask );
+        if ( ( ( slot - home ) & mask ) >= ( ( slot - hole ) & mask ) ) {
+            tracking->entries[hole] = tracking->entries[slot];
+            hole                    = slot;
+        }
+    }
+
+    tracking->entries[hole].ptr = 0;
+    tracking->num_entries--;
+}
+
+// Call with the lock held. The entry is dropped if storage is out of memory.
+static void
+sr__tracking_insert( struct sr__tracking* tracking, const sr__tracked_t* tracked ) {
+    // Left behind if the block was freed without going through the API
+    sr__tracked_t* stale = sr__tracking_find( tracking, (void*)tracked->ptr );
+    if ( stale != SRALLOC_NULL ) {
+        *stale = *tracked;
+        return;
+    }
+
+    int full = ( tracking->num_entries + 1 ) * 2 > tracking->capacity;
+    if ( full && !sr__tracking_grow( tracking ) ) {
+        return;
+    }
+
+    srint_t mask = tracking->capacity - 1;
+    srint_t slot = sr__tracking_home( tracked->ptr, mask );
+    while ( tracking->entries[slot].ptr != 0 ) {
+        slot = ( slot + 1 ) & mask;
+    }
+
+    tracking->entries[slot] = *tracked;
+    tracking->num_entries++;
+}
+
+static void
+sr__tracking_add( srallocator_t*  allocator,
+                  void*           ptr,
+                  srint_t         size,
+                  srint_t         align,
+                  const srchar_t* file,
+                  int             line ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    sr__tracked_t        tracked;
+    tracked.ptr   = (sruintptr_t)ptr;
+    tracked.size  = size;
+    tracked.align = align;
+    tracked.file  = file;
+    tracked.line  = line;
+
+    SRALLOC_mutex_lock( &tracking->mutex );
+    tracked.sequence = tracking->next_sequence++;
+    sr__tracking_insert( tracking, &tracked );
+    SRALLOC_mutex_unlock( &tracking->mutex );
+}
+
+// Before ptr is freed, so it can't be handed out and tracked again first
+static void
+sr__tracking_remove( srallocator_t* allocator, void* ptr ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking == SRALLOC_NULL ) {
+        return;
+    }
+
+    SRALLOC_mutex_lock( &tracking->mutex );
+    sr__tracked_t* entry = sr__tracking_find( tracking, ptr );
+    if ( entry != SRALLOC_NULL ) {
+        sr__tracking_remove_entry( tracking, entry );
+    }
+
+    SRALLOC_mutex_unlock( &tracking->mutex );
+}
+
+// Call with the lock held, after ptr was resized to size and possibly moved to new_ptr. The entry
+// keeps its sequence number and call site.
+static void
+sr__tracking_move( struct sr__tracking* tracking, void* ptr, void* new_ptr, srint_t size ) {
+    sr__tracked_t* entry = sr__tracking_find( tracking, ptr );
+    if ( entry == SRALLOC_NULL ) {
+        return;
+    }
+
+    sr__tracked_t tracked = *entry;
+    tracked.ptr           = (sruintptr_t)new_ptr;
+    tracked.size          = size;
+    if ( new_ptr == ptr ) {
+        *entry = tracked;
+        return;
+    }
+
+    sr__tracking_remove_entry( tracking, entry );
+    sr__tracking_insert( tracking, &tracked );
+}
+
+static int64_t
+sr__tracking_sequence( srallocator_t* allocator ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    SRALLOC_mutex_lock( &tracking->mutex );
+    int64_t sequence = tracking->next_sequence;
+    SRALLOC_mutex_unlock( &tracking->mutex );
+    return sequence;
+}
+
+// For allocators that free in bulk: drops the entries of blocks in [begin, end) that were
+// allocated from sequence on. A null end has no bound.
+static void
+sr__tracking_forget( srallocator_t* allocator,
+                     const void*    begin,
+                     const void*    end,
+                     int64_t        sequence ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking == SRALLOC_NULL ) {
+        return;
+    }
+
+    SRALLOC_mutex_lock( &tracking->mutex );
+    srint_t i_slot = 0;
+    while ( i_slot < tracking->capacity && tracking->num_entries > 0 ) {
+        sr__tracked_t* entry = &tracking->entries[i_slot];
+        if ( entry->ptr != 0 && entry->ptr >= (sruintptr_t)begin &&
+             ( end == SRALLOC_NULL || entry->ptr < (sruintptr_t)end ) &&
+             entry->sequence >= sequence ) {
+            // The entry shifted back into the slot is looked at next
+            sr__tracking_remove_entry( tracking, entry );
+            continue;
+        }
+
+        ++i_slot;
+    }
+
+    SRALLOC_mutex_unlock( &tracking->mutex );
+}
+
+static int
+sr__tracking_compare_sites( const sr__tracked_t* a, const sr__tracked_t* b ) {
+    if ( a->file != b->file ) {
+        // Unknown call sites last
+        if ( a->file == SRALLOC_NULL || b->file == SRALLOC_NULL ) {
+            return a->file == SRALLOC_NULL ? 1 : -1;
+        }
+
+        const srchar_t* file_a = a->file;
+        const srchar_t* file_b = b->file;
+        while ( *file_a != 0 && *file_a == *file_b ) {
+            ++file_a;
+            ++file_b;
+        }
+
+        if ( *file_a != *file_b ) {
+            return (unsigned char)*file_a < (unsigned char)*file_b ? -1 : 1;
+        }
+    }
+
+    return ( a->line > b->line ) - ( a->line < b->line );
+}
+
+// By call site and then oldest first, so a site's allocations end up next to each other
+static int
+sr__tracking_compare_entries( const void* a, const void* b ) {
+    const sr__tracked_t* entry_a = (const sr__tracked_t*)a;
+    const sr__tracked_t* entry_b = (const sr__tracked_t*)b;
+    int                  order   = sr__tracking_compare_sites( entry_a, entry_b );
+    if ( order != 0 ) {
+        return order;
+    }
+
+    return ( entry_a->sequence > entry_b->sequence ) - ( entry_a->sequence < entry_b->sequence );
+}
+
+// Most bytes first
+static int
+sr__tracking_compare_leak_sites( const void* a, const void* b ) {
+    const sr__leak_site_t* site_a = (const sr__leak_site_t*)a;
+    const sr__leak_site_t* site_b = (const sr__leak_site_t*)b;
+    if ( site_a->amount != site_b->amount ) {
+        return site_a->amount > site_b->amount ? -1 : 1;
+    }
+
+    return ( site_a->oldest->sequence > site_b->oldest->sequence ) -
+           ( site_a->oldest->sequence < site_b->oldest->sequence );
+}
+
+static void
+sr__tracking_write_count( sr__report_writer_t* writer, int64_t num_allocations, int64_t amount ) {
+    sr__report_write_number( writer, num_allocations );
+    sr__report_write_string( writer, num_allocations == 1 ? " allocation, " : " allocations, " );
+    sr__report_write_number( writer, amount );
+    sr__report_write_string( writer, " bytes" );
+}
+
+// Call with the lock held and something tracked. The call sites are sorted in memory from
+// storage, without it only the totals are written.
+static void
+sr__tracking_write_report( srallocator_t* allocator, sr__report_writer_t* writer ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    srint_t              num_entries = tracking->num_entries;
+    int64_t              amount      = 0;
+    for ( srint_t i_slot = 0; i_slot < tracking->capacity; ++i_slot ) {
+        amount += tracking->entries[i_slot].ptr != 0 ? tracking->entries[i_slot].size : 0;
+    }
+
+#ifdef SRALLOC_USE_NAMES
+    sr__report_write_string( writer, "sralloc: \"" );
+    sr__report_write_string( writer, allocator->name );
+    sr__report_write_string( writer, "\" has " );
+#else
+    sr__report_write_string( writer, "sralloc: allocator has " );
+#endif
+    sr__tracking_write_count( writer, num_entries, amount );
+    sr__report_write_string( writer, " live\n" );
+
+    srint_t          entries_size = num_entries * (srint_t)sizeof( sr__tracked_t );
+    srint_t          sites_size   = num_entries * (srint_t)sizeof( sr__leak_site_t );
+    sr__tracked_t*   entries = (sr__tracked_t*)sralloc_alloc( tracking->storage, entries_size );
+    sr__leak_site_t* sites   = (sr__leak_site_t*)sralloc_alloc( tracking->storage, sites_size );
+    if ( entries == SRALLOC_NULL || sites == SRALLOC_NULL ) {
+        sr__report_write_string( writer, "  (out of memory for sorting the call sites)\n" );
+        sralloc_dealloc_sized( tracking->storage, entries, entries_size, 0 );
+        sralloc_dealloc_sized( tracking->storage, sites, sites_size, 0 );
+        return;
+    }
+
+    srint_t num_copied = 0;
+    for ( srint_t i_slot = 0; i_slot < tracking->capacity; ++i_slot ) {
+        if ( tracking->entries[i_slot].ptr != 0 ) {
+            entries[num_copied++] = tracking->entries[i_slot];
+        }
+    }
+
+    qsort( entries, num_entries, sizeof( sr__tracked_t ), sr__tracking_compare_entries );
+    srint_t num_sites = 0;
+    for ( srint_t i_entry = 0; i_entry < num_entries; ++i_entry ) {
+        if ( i_entry == 0 ||
+             sr__tracking_compare_sites( &entries[i_entry - 1], &entries[i_entry] ) != 0 ) {
+            sites[num_sites].oldest          = &entries[i_entry];
+            sites[num_sites].num_allocations = 0;
+            sites[num_sites].amount          = 0;
+            ++num_sites;
+        }
+
+        sites[num_sites - 1].num_allocations++;
+        sites[num_sites - 1].amount += entries[i_entry].size;
+    }
+
+    qsort( sites, num_sites, sizeof( sr__leak_site_t ), sr__tracking_compare_leak_sites );
+    for ( srint_t i_site = 0; i_site < num_sites; ++i_site ) {
+        const sr__tracked_t* oldest = sites[i_site].oldest;
+        if ( oldest->file != SRALLOC_NULL ) {
+            sr__report_write_string( writer, "  " );
+            sr__report_write_string( writer, oldest->file );
+            sr__report_write_string( writer, ":" );
+            sr__report_write_number( writer, oldest->line );
+            sr__report_write_string( writer, ": " );
+        }
+        else {
+            sr__report_write_string( writer, "  unknown call site: " );
+        }
+
+        sr__tracking_write_count( writer, sites[i_site].num_allocations, sites[i_site].amount );
+        sr__report_write_string( writer, ", oldest #" );
+        sr__report_write_number( writer, oldest->sequence );
+        sr__report_write_string( writer, " at " );
+        sr__report_write_hex( writer, oldest->ptr );
+        sr__report_write_string( writer, " (" );
+        sr__report_write_number( writer, oldest->size );
+        sr__report_write_string( writer, " bytes, align " );
+        sr__report_write_number( writer, oldest->align );
+        sr__report_write_string( writer, ")\n" );
+    }
+
+    sralloc_dealloc_sized( tracking->storage, entries, entries_size, 0 );
+    sralloc_dealloc_sized( tracking->storage, sites, sites_size, 0 );
+}
+
+// Logs the leak report if anything is left and gives the table back to storage
+static void
+sr__tracking_destroy( srallocator_t* allocator ) {
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking->num_entries > 0 ) {
+        sr__report_writer_t writer = { SRALLOC_NULL, 0, 0, 0 };
+        sr__tracking_write_report( allocator, &writer );
+
+        srint_t   capacity = writer.length + 1;
+        srchar_t* message  = (srchar_t*)sralloc_alloc( tracking->storage, capacity );
+        if ( message != SRALLOC_NULL ) {
+            sr__report_writer_t message_writer = { message, capacity, 0, 0 };
+            sr__tracking_write_report( allocator, &message_writer );
+            message[message_writer.length < capacity ? message_writer.length : capacity - 1] = 0;
+            SRALLOC_log( message );
+            sralloc_dealloc_sized( tracking->storage, message, capacity, 0 );
+        }
+    }
+
+    sralloc_dealloc_sized( tracking->storage,
+                           tracking->entries,
+                           tracking->capacity * (srint_t)sizeof( sr__tracked_t ),
+                           0 );
+    SRALLOC_mutex_destroy( &tracking->mutex );
+    sralloc_dealloc_sized( tracking->storage, tracking, sizeof( struct sr__tracking ), 0 );
+    allocator->tracking = SRALLOC_NULL;
+}
+#else
+#define sr__tracking_remove( allocator, ptr )
+#define sr__tracking_forget( allocator, begin, end, sequence )
+#endif // SRALLOC_USE_TRACKING
+
+// Zero size allocations aren't passed on, but still use up the call site
+static void
+sr__clear_call_site( void ) {
+#ifdef SRALLOC_USE_TRACKING
+    sr__call_site_file = SRALLOC_NULL;
+#endif
+}
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+// The window isn't counted separately, its totals are the lifetime ones minus a snapshot taken when
+// it started. Only the peaks need their own fields.
+struct sr__extended_stats {
+    sralloc_extended_stats_t lifetime;
+    sralloc_extended_stats_t window_start;
+    srint_t                  window_peak_num_allocations;
+    srint_t                  window_peak_amount_allocated;
+};
+#endif
+
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_ENABLE_SHARDED_STATS )
+#define SR__STATS_BLOCK_SIZE ( SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE )
+#elif defined( SRALLOC_USE_EXTENDED_STATS )
+#define SR__STATS_BLOCK_SIZE                                                          \
+    ( ( (srint_t)sizeof( struct sr__extended_stats ) + SR__CACHE_LINE_SIZE - 1 ) & \
+      ~( (srint_t)SR__CACHE_LINE_SIZE - 1 ) )
+#endif
+
+#ifdef SR__STATS_BLOCK_SIZE
+#define SR__STATS_POOL_CHUNK_BLOCKS 32
+
+// The shards or extended stats are the same size for every allocator, so they come from a library
+// wide pool instead of a mapping each, which would round the extended stats up to a whole page.
+// Chunks stay mapped until the program exits.
+static sr__static_mutex_t sr__stats_pool_mutex = SR__STATIC_MUTEX_INIT;
+static void**             sr__stats_pool_free;
+
+static srchar_t*
+sr__stats_block_alloc( void ) {
+    sr__static_mutex_lock( &sr__stats_pool_mutex );
+    if ( sr__stats_pool_free == SRALLOC_NULL ) {
+        srchar_t* chunk =
+          (srchar_t*)sr__os_map( SR__STATS_POOL_CHUNK_BLOCKS * SR__STATS_BLOCK_SIZE );
+        for ( srint_t i = 0; chunk != SRALLOC_NULL && i < SR__STATS_POOL_CHUNK_BLOCKS; ++i ) {
+            void** block        = (void**)( chunk + i * SR__STATS_BLOCK_SIZE );
+            *block              = (void*)sr__stats_pool_free;
+            sr__stats_pool_free = block;
+        }
+    }
+
+    void** block = sr__stats_pool_free;
+    if ( block != SRALLOC_NULL ) {
+        sr__stats_pool_free = (void**)*block;
+    }
+
+    sr__static_mutex_unlock( &sr__stats_pool_mutex );
+    if ( block != SRALLOC_NULL ) {
+        SRALLOC_memset( block, 0, SR__STATS_BLOCK_SIZE );
+    }
+
+    return (srchar_t*)block;
+}
+
+static void
+sr__stats_block_free( void* ptr ) {
+    void** block = (void**)ptr;
+    sr__static_mutex_lock( &sr__stats_pool_mutex );
+    *block              = (void*)sr__stats_pool_free;
+    sr__stats_pool_free = block;
+    sr__static_mutex_unlock( &sr__stats_pool_mutex );
+}
+#endif
+
+// With sharded stats every thread counts into its own cache line of the allocator, so the hot
+// path never shares a line with other threads. allocator->stats only holds what the threads
+// past SRALLOC_MAX_THREADS added atomically, and what's been folded in at destroy.
+static void
+sr__create_stats( srallocator_t* allocator ) {
+    SRALLOC_UNUSED( allocator );
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_ENABLE_SHARDED_STATS )
+    allocator->stats_shards = sr__stats_block_alloc();
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    allocator->extended_stats = (struct sr__extended_stats*)sr__stats_block_alloc();
+#endif
+}
+
+#ifdef SRALLOC_USE_STATS
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+static sralloc_stats_t*
+sr__stats_shard( srallocator_t* allocator, srint_t thread_index ) {
+    return (sralloc_stats_t*)( allocator->stats_shards + thread_index * SR__CACHE_LINE_SIZE );
+}
+#endif
+
+// The stats this thread's changes go to, for allocators that check what a call did to them
+static sralloc_stats_t*
+sr__thread_stats( srallocator_t* allocator ) {
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    srint_t thread_index = sr__thread_index();
+    if ( allocator->stats_shards != SRALLOC_NULL && thread_index < SRALLOC_MAX_THREADS ) {
+        return sr__stats_shard( allocator, thread_index );
+    }
+#endif
+    return &allocator->stats;
+}
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+// Called after allocator->stats grew, not thread safe so only from whoever just changed them
+static void
+sr__stats_track_peaks( srallocator_t* allocator,
+                       srint_t        num_allocations,
+                       srint_t        amount_allocated ) {
+    struct sr__extended_stats* extended = allocator->extended_stats;
+    if ( extended == SRALLOC_NULL ) {
+        return;
+    }
+
+    sralloc_stats_t stats;
+    stats.num_allocations  = SRALLOC_atomic_load( &allocator->stats.num_allocations );
+    stats.amount_allocated = SRALLOC_atomic_load( &allocator->stats.amount_allocated );
+
+    if ( amount_allocated > 0 ) {
+        if ( stats.amount_allocated > extended->lifetime.peak_amount_allocated ) {
+            extended->lifetime.peak_amount_allocated = stats.amount_allocated;
+        }
+        if ( stats.amount_allocated > extended->window_peak_amount_allocated ) {
+            extended->window_peak_amount_allocated = stats.amount_allocated;
+        }
+    }
+
+    if ( num_allocations > 0 ) {
+        if ( stats.num_allocations > extended->lifetime.peak_num_allocations ) {
+            extended->lifetime.peak_num_allocations = stats.num_allocations;
+        }
+        if ( stats.num_allocations > extended->window_peak_num_allocations ) {
+            extended->window_peak_num_allocations = stats.num_allocations;
+        }
+    }
+}
+#endif
+
+static void
+sr__stats_add( srallocator_t* allocator, srint_t num_allocations, srint_t amount_allocated ) {
+    sralloc_stats_t* stats = sr__thread_stats( allocator );
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    if ( stats == &allocator->stats ) {
+        SRALLOC_atomic_fetch_add( &stats->num_allocations, num_allocations );
+        SRALLOC_atomic_fetch_add( &stats->amount_allocated, amount_allocated );
+        return;
+    }
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    // The API reads the stats around every allocation, also for allocators other threads use
+    SRALLOC_atomic_fetch_add( &stats->num_allocations, num_allocations );
+    SRALLOC_atomic_fetch_add( &stats->amount_allocated, amount_allocated );
+    sr__stats_track_peaks( allocator, num_allocations, amount_allocated );
+#else
+    stats->num_allocations += num_allocations;
+    stats->amount_allocated += amount_allocated;
+#endif
+}
+
+static void
+sr__stats_reset( srallocator_t* allocator ) {
+    allocator->stats.num_allocations  = 0;
+    allocator->stats.amount_allocated = 0;
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    if ( allocator->stats_shards != SRALLOC_NULL ) {
+        SRALLOC_memset( allocator->stats_shards, 0, SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE );
+    }
+#endif
+}
+#endif // SRALLOC_USE_STATS
+
+// Folds the shards into allocator->stats for the leak asserts and gives them, the extended stats
+// and the tracking table back. Tracked leaks are reported first.
+static void
+sr__destroy_stats( srallocator_t* allocator ) {
+    SRALLOC_UNUSED( allocator );
+#ifdef SRALLOC_USE_TRACKING
+    if ( allocator->tracking != SRALLOC_NULL ) {
+        sr__tracking_destroy( allocator );
+    }
+#endif
+#if defined( SRALLOC_USE_STATS ) && defined( SRALLOC_ENABLE_SHARDED_STATS )
+    if ( allocator->stats_shards == SRALLOC_NULL ) {
+        return;
+    }
+
+    allocator->stats = sralloc_get_stats( allocator );
+    sr__stats_block_free( allocator->stats_shards );
+    allocator->stats_shards = SRALLOC_NULL;
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    if ( allocator->extended_stats != SRALLOC_NULL ) {
+        sr__stats_block_free( allocator->extended_stats );
+        allocator->extended_stats = SRALLOC_NULL;
+    }
+#endif
+}
+
+// static void
+// sr__set_type( srallocator_t* allocator, const srchar_t* name ) {
+//     SRALLOC_UNUSED( allocator, name );
+// #ifdef SRALLOC_USE_NAMES
+//     SRALLOC_memcpy( allocator->name, SRALLOC_strlen( name ), name );
+// #endif
+// }
+
+static void*
+sr__ptr_to_aligned_ptr( void* ptr, srint_t align ) {
+    if ( align == 0 ) {
+        return ptr;
+    }
+
+    sruintptr_t offset      = ( ~(sruintptr_t)ptr + 1 ) & ( align - 1 );
+    void*       aligned_ptr = (srchar_t*)ptr + offset;
+    return aligned_ptr;
+}
+
+#ifndef SRALLOC_USE_PREAMBLE
+// Allocators without a preamble only know how much to free through sralloc_dealloc_sized
+static void
+sr__deallocate_without_size( srallocator_t* allocator, void* ptr ) {
+    SRALLOC_UNUSED( allocator, ptr );
+    SRALLOC_assert( 0 );
+}
+#endif
+
+static srchar_t*
+sr__aligned_ptr_after_preamble( void* ptr, srint_t preamble_size, srint_t align ) {
+    srchar_t* after_preamble = (srchar_t*)ptr + preamble_size;
+    return (srchar_t*)sr__ptr_to_aligned_ptr( after_preamble, align );
+}
+
+static srint_t
+sr__ptr_diff( void* ptr1, void* ptr2 ) {
+    return ( srint_t )( (srchar_t*)ptr1 - (srchar_t*)ptr2 );
+}
+
+// Preambles keep their size and offset in 32 bits, also with SRALLOC_64BIT_SIZES. A block too
+// big for that stores its size in the srint_t right before the preamble, and only those blocks
+// make room for it, so small allocations keep their small preambles.
+#ifdef SRALLOC_64BIT_SIZES
+typedef int32_t sralloc_preamble_int_t;
+
+#define SR__PREAMBLE_LARGE_SIZE -1
+#define SR__PREAMBLE_MAX_SIZE 0x7fffffff
+
+// Header bytes needed on top of the preamble for a block of size plus the preamble
+static srint_t
+sr__preamble_extra( srint_t size ) {
+    return size > SR__PREAMBLE_MAX_SIZE - 64 ? (srint_t)sizeof( srint_t ) : 0;
+}
+
+static void
+sr__set_preamble_size( void* preamble, sralloc_preamble_int_t* size_field, srint_t size ) {
+    if ( size <= SR__PREAMBLE_MAX_SIZE ) {
+        *size_field = (sralloc_preamble_int_t)size;
+        return;
+    }
+
+    *size_field = SR__PREAMBLE_LARGE_SIZE;
+    SRALLOC_memcpy( (srchar_t*)preamble - sizeof( srint_t ), &size, sizeof( srint_t ) );
+}
+
+static srint_t
+sr__preamble_size( void* preamble, sralloc_preamble_int_t size_field ) {
+    if ( size_field != SR__PREAMBLE_LARGE_SIZE ) {
+        return size_field;
+    }
+
+    srint_t size;
+    SRALLOC_memcpy( &size, (srchar_t*)preamble - sizeof( srint_t ), sizeof( srint_t ) );
+    return size;
+}
+
+#ifdef SRALLOC_USE_PREAMBLE
+// Whether a block whose preamble is offset bytes in can be resized to size in place
+static int
+sr__preamble_fits( srint_t offset, srint_t size ) {
+    return size <= SR__PREAMBLE_MAX_SIZE || offset >= (srint_t)sizeof( srint_t );
+}
+#endif
+#else
+typedef srint_t sralloc_preamble_int_t;
+
+#define sr__preamble_extra( size ) 0
+#define sr__set_preamble_size( preamble, size_field, size ) ( *( size_field ) = ( size ) )
+#define sr__preamble_size( preamble, size_field ) ( size_field )
+#define sr__preamble_fits( offset, size ) 1
+#endif
+
+// Pointers converted at a time when a batch call is forwarded to a backing allocator
+#define SR__BATCH_CHUNK_SIZE 64
+
+// Size classes shared by the allocators that bin blocks by size: 16 byte steps up to 128, then
+// four classes per power of two.
+static srint_t
+sr__size_class( srint_t size ) {
+    if ( size <= 128 ) {
+        return size <= 16 ? 0 : ( size + 15 ) / 16 - 1;
+    }
+
+    srint_t group_size = 128;
+    srint_t size_class = 8;
+    while ( size > group_size * 2 ) {
+        group_size *= 2;
+        size_class += 4;
+    }
+
+    srint_t step = group_size / 4;
+    return size_class + ( size - group_size + step - 1 ) / step - 1;
+}
+
+// Index of the lowest and highest set bit, x must not be zero
+static srint_t
+sr__ffs32( uint32_t x ) {
+#if defined( _MSC_VER ) && !defined( __clang__ )
+    unsigned long index;
+    _BitScanForward( &index, x );
+    return (srint_t)index;
+#else
+    return __builtin_ctz( x );
+#endif
+}
+
+static srint_t
+sr__fls32( uint32_t x ) {
+#if defined( _MSC_VER ) && !defined( __clang__ )
+    unsigned long index;
+    _BitScanReverse( &index, x );
+    return (srint_t)index;
+#else
+    return 31 - __builtin_clz( x );
+#endif
+}
+
+static srint_t
+sr__fls64( uint64_t x ) {
+    uint32_t high = (uint32_t)( x >> 32 );
+    return high != 0 ? 32 + sr__fls32( high ) : sr__fls32( (uint32_t)x );
+}
+
+// Reallocation fallback for when an allocation can't grow in place
+static sr_result_t
+sr__reallocate_by_moving( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        old_size,
+                          srint_t        new_size,
+                          srint_t        align ) {
+    sr_result_t res = allocator->allocate_func( allocator, new_size, align );
+    if ( res.ptr != SRALLOC_NULL ) {
+        SRALLOC_memcpy( res.ptr, ptr, old_size < new_size ? old_size : new_size );
+        allocator->deallocate_func( allocator, ptr );
+    }
+
+    return res;
+}
+
+static srint_t
+sr__size_class_size( srint_t size_class ) {
+    if ( size_class < 8 ) {
+        return ( size_class + 1 ) * 16;
+    }
+
+    srint_t group_size = 128 << ( ( size_class - 8 ) / 4 );
+    return group_size + ( ( size_class - 8 ) % 4 + 1 ) * ( group_size / 4 );
+}
+
+//  █████╗ ██████╗ ██╗
+// ██╔══██╗██╔══██╗██║
+// ███████║██████╔╝██║
+// ██╔══██║██╔═══╝ ██║
+// ██║  ██║██║     ██║
+// ╚═╝  ╚═╝╚═╝     ╚═╝
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+// Counts a call that asked for count blocks of size and got allocated of them. amount_before is
+// allocator->stats.amount_allocated from before the call.
+static void
+sr__extended_stats_record( srallocator_t* allocator,
+                           srint_t        size,
+                           srint_t        count,
+                           srint_t        allocated,
+                           srint_t        amount_before ) {
+    if ( allocator->extended_stats == SRALLOC_NULL ) {
+        return;
+    }
+
+    sralloc_extended_stats_t* stats = &allocator->extended_stats->lifetime;
+    if ( allocated < count ) {
+        SRALLOC_atomic_fetch_add( &stats->num_failed, (int64_t)( count - allocated ) );
+    }
+
+    if ( allocated == 0 ) {
+        return;
+    }
+
+    int64_t requested = (int64_t)size * allocated;
+    int64_t amount    = SRALLOC_atomic_load( &allocator->stats.amount_allocated );
+    int64_t padding   = amount - amount_before - requested;
+    SRALLOC_atomic_fetch_add( &stats->total_allocations, (int64_t)allocated );
+    SRALLOC_atomic_fetch_add( &stats->total_amount_requested, requested );
+    SRALLOC_atomic_fetch_add( &stats->size_histogram[sr__fls64( (uint64_t)size )],
+                              (int64_t)allocated );
+    if ( padding > 0 ) {
+        SRALLOC_atomic_fetch_add( &stats->padding, padding );
+    }
+}
+#endif
+
+// Every allocation made through the API goes through here
+static sr_result_t
+sr__allocate( srallocator_t* allocator, srint_t size, srint_t align ) {
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    srint_t amount_before = SRALLOC_atomic_load( &allocator->stats.amount_allocated );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    // Still set for what allocate_func gets from its parents, that's made for the same call site
+    const srchar_t* file = sr__call_site_file;
+    int             line = sr__call_site_line;
+#endif
+    sr_result_t res = allocator->allocate_func( allocator, size, align );
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    sr__extended_stats_record( allocator, size, 1, res.ptr != SRALLOC_NULL, amount_before );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    sr__call_site_file = SRALLOC_NULL;
+    if ( allocator->tracking != SRALLOC_NULL && res.ptr != SRALLOC_NULL ) {
+        sr__tracking_add( allocator, res.ptr, size, align, file, line );
+    }
+#endif
+    return res;
+}
+
+// Every resize made through the API goes through here, allocator->reallocate_func must be set
+static sr_result_t
+sr__reallocate( srallocator_t* allocator, void* ptr, srint_t size, srint_t align, int may_move ) {
+#ifdef SRALLOC_USE_TRACKING
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking != SRALLOC_NULL ) {
+        // Locked throughout so the old block can't be handed out and tracked before it's moved
+        SRALLOC_mutex_lock( &tracking->mutex );
+        sr_result_t res = allocator->reallocate_func( allocator, ptr, size, align, may_move );
+        if ( res.ptr != SRALLOC_NULL ) {
+            sr__tracking_move( tracking, ptr, res.ptr, size );
+        }
+
+        SRALLOC_mutex_unlock( &tracking->mutex );
+        return res;
+    }
+#endif
+    return allocator->reallocate_func( allocator, ptr, size, align, may_move );
+}
+
+SRALLOC_API void*
+sralloc_alloc( srallocator_t* allocator, srint_t size ) {
+    if ( size == 0 ) {
+        sr__clear_call_site();
+        return SRALLOC_ZERO_SIZE_PTR;
+    }
+
+    return sr__allocate( allocator, size, 0 ).ptr;
+}
+
+SRALLOC_API sr_result_t
+            sralloc_alloc_with_size( srallocator_t* allocator, srint_t size ) {
+    if ( size == 0 ) {
+        sr_result_t res = { SRALLOC_ZERO_SIZE_PTR, 0 };
+        sr__clear_call_site();
+        return res;
+    }
+
+    return sr__allocate( allocator, size, 0 );
+}
+
+SRALLOC_API void*
+sralloc_alloc_aligned( srallocator_t* allocator, srint_t size, srint_t align ) {
+    if ( size == 0 ) {
+        sr__clear_call_site();
+        return SRALLOC_ZERO_SIZE_PTR;
+    }
+
+    return sr__allocate( allocator, size, align ).ptr;
+}
+
+SRALLOC_API sr_result_t
+            sralloc_alloc_aligned_with_size( srallocator_t* allocator, srint_t size, srint_t align ) {
+    if ( size == 0 ) {
+        sr_result_t res = { SRALLOC_ZERO_SIZE_PTR, 0 };
+        sr__clear_call_site();
+        return res;
+    }
+
+    return sr__allocate( allocator, size, align );
+}
+
+SRALLOC_API void
+sralloc_dealloc( srallocator_t* allocator, void* ptr ) {
+    if ( ptr == SRALLOC_ZERO_SIZE_PTR ) {
+        return;
+    }
+
+    if ( ptr == SRALLOC_NULL ) {
+        return;
+    }
+
+    sr__tracking_remove( allocator, ptr );
+    allocator->deallocate_func( allocator, ptr );
+}
+
+SRALLOC_API void
+sralloc_dealloc_sized( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    if ( ptr == SRALLOC_ZERO_SIZE_PTR || ptr == SRALLOC_NULL ) {
+        return;
+    }
+
+    sr__tracking_remove( allocator, ptr );
+    if ( allocator->deallocate_sized_func != SRALLOC_NULL ) {
+        allocator->deallocate_sized_func( allocator, ptr, size, align );
+        return;
+    }
+
+    allocator->deallocate_func( allocator, ptr );
+}
+
+SRALLOC_API void*
+sralloc_realloc( srallocator_t* allocator, void* ptr, srint_t new_size, srint_t align ) {
+    if ( ptr == SRALLOC_ZERO_SIZE_PTR || ptr == SRALLOC_NULL ) {
+        return sralloc_alloc_aligned( allocator, new_size, align );
+    }
+
+    if ( new_size == 0 ) {
+#ifndef SRALLOC_USE_PREAMBLE
+        // There's no size to free ptr with, it has to go through sralloc_dealloc_sized
+        if ( allocator->deallocate_func == sr__deallocate_without_size ) {
+            return SRALLOC_NULL;
+        }
+#endif
+        sr__tracking_remove( allocator, ptr );
+        allocator->deallocate_func( allocator, ptr );
+        return SRALLOC_ZERO_SIZE_PTR;
+    }
+
+    if ( allocator->reallocate_func == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    void* new_ptr = sr__reallocate( allocator, ptr, new_size, align, 1 ).ptr;
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    if ( new_ptr == SRALLOC_NULL ) {
+        sr__extended_stats_record( allocator, new_size, 1, 0, 0 );
+    }
+#endif
+    return new_ptr;
+}
+
+SRALLOC_API int
+sralloc_try_expand( srallocator_t* allocator, void* ptr, srint_t new_size ) {
+    if ( ptr == SRALLOC_ZERO_SIZE_PTR || ptr == SRALLOC_NULL || new_size == 0 ||
+         allocator->reallocate_func == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    return sr__reallocate( allocator, ptr, new_size, 0, 0 ).ptr != SRALLOC_NULL;
+}
+
+SRALLOC_API sralloc_stats_t
+sralloc_get_stats( srallocator_t* allocator ) {
+    sralloc_stats_t stats = { 0, 0 };
+    SRALLOC_UNUSED( allocator );
+#ifdef SRALLOC_USE_STATS
+    stats = allocator->stats;
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    if ( allocator->stats_shards != SRALLOC_NULL ) {
+        for ( srint_t i_shard = 0; i_shard < SRALLOC_MAX_THREADS; ++i_shard ) {
+            sralloc_stats_t* shard = sr__stats_shard( allocator, i_shard );
+            stats.num_allocations += shard->num_allocations;
+            stats.amount_allocated += shard->amount_allocated;
+        }
+    }
+#endif
+#endif
+    return stats;
+}
+
+SRALLOC_API sralloc_stats_t
+sralloc_get_total_stats( srallocator_t* allocator ) {
+    sralloc_stats_t stats = sralloc_get_stats( allocator );
+#ifdef SRALLOC_USE_STATS
+    for ( srint_t i_child = 0; i_child < allocator->num_children; ++i_child ) {
+        sralloc_stats_t child_stats = sralloc_get_total_stats( allocator->children[i_child] );
+        stats.num_allocations += child_stats.num_allocations;
+        stats.amount_allocated += child_stats.amount_allocated;
+    }
+#endif
+    return stats;
+}
+
+SRALLOC_API sralloc_extended_stats_t
+sralloc_get_extended_stats( srallocator_t* allocator, sralloc_stats_window_t window ) {
+    sralloc_extended_stats_t stats;
+    SRALLOC_memset( &stats, 0, sizeof( stats ) );
+    SRALLOC_UNUSED( allocator, window );
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    struct sr__extended_stats* extended = allocator->extended_stats;
+    if ( extended == SRALLOC_NULL ) {
+        return stats;
+    }
+
+    stats = extended->lifetime;
+    if ( window == SRALLOC_STATS_WINDOW ) {
+        const sralloc_extended_stats_t* start = &extended->window_start;
+        stats.peak_num_allocations            = extended->window_peak_num_allocations;
+        stats.peak_amount_allocated           = extended->window_peak_amount_allocated;
+        stats.total_allocations -= start->total_allocations;
+        stats.total_amount_requested -= start->total_amount_requested;
+        stats.padding -= start->padding;
+        stats.num_failed -= start->num_failed;
+        for ( int i_bucket = 0; i_bucket < SRALLOC_STATS_HISTOGRAM_SIZE; ++i_bucket ) {
+            stats.size_histogram[i_bucket] -= start->size_histogram[i_bucket];
+        }
+    }
+#endif
+    return stats;
+}
+
+SRALLOC_API void
+sralloc_reset_stats_window( srallocator_t* allocator ) {
+    SRALLOC_UNUSED( allocator );
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    struct sr__extended_stats* extended = allocator->extended_stats;
+    if ( extended == SRALLOC_NULL ) {
+        return;
+    }
+
+    extended->window_start                 = extended->lifetime;
+    extended->window_peak_num_allocations  = allocator->stats.num_allocations;
+    extended->window_peak_amount_allocated = allocator->stats.amount_allocated;
+#endif
+}
+
+SRALLOC_API int
+sralloc_enable_tracking( srallocator_t* allocator, srallocator_t* storage ) {
+    SRALLOC_UNUSED( allocator, storage );
+#ifdef SRALLOC_USE_TRACKING
+    if ( allocator->tracking != SRALLOC_NULL ) {
+        return 1;
+    }
+
+    struct sr__tracking* tracking =
+      (struct sr__tracking*)sralloc_alloc( storage, sizeof( struct sr__tracking ) );
+    if ( tracking == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    SRALLOC_memset( tracking, 0, sizeof( struct sr__tracking ) );
+    tracking->storage = storage;
+    if ( !sr__tracking_grow( tracking ) ) {
+        sralloc_dealloc_sized( storage, tracking, sizeof( struct sr__tracking ), 0 );
+        return 0;
+    }
+
+    SRALLOC_mutex_init( &tracking->mutex );
+    allocator->tracking = tracking;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+SRALLOC_API srint_t
+sralloc_tracking_report( srallocator_t* allocator, srchar_t* buffer, srint_t capacity ) {
+    sr__report_writer_t writer = { buffer, buffer != SRALLOC_NULL ? capacity : 0, 0, 0 };
+    SRALLOC_UNUSED( allocator );
+#ifdef SRALLOC_USE_TRACKING
+    struct sr__tracking* tracking = allocator->tracking;
+    if ( tracking != SRALLOC_NULL ) {
+        SRALLOC_mutex_lock( &tracking->mutex );
+        if ( tracking->num_entries > 0 ) {
+            sr__tracking_write_report( allocator, &writer );
+        }
+
+        SRALLOC_mutex_unlock( &tracking->mutex );
+    }
+#endif
+    if ( writer.capacity > 0 ) {
+        writer.buffer[writer.length < writer.capacity ? writer.length : writer.capacity - 1] = 0;
+    }
+
+    return writer.length;
+}
+
+SRALLOC_API void
+sralloc_set_call_site( const char* file, int line ) {
+    SRALLOC_UNUSED( file, line );
+#ifdef SRALLOC_USE_TRACKING
+    sr__call_site_file = file;
+    sr__call_site_line = line;
+#endif
+}
+
+SRALLOC_API srint_t
+sralloc_alloc_batch( srallocator_t* allocator,
+                     srint_t        size,
+                     srint_t        align,
+                     srint_t        count,
+                     void**         out_ptrs ) {
+    if ( size == 0 ) {
+        for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+            out_ptrs[i_ptr] = SRALLOC_ZERO_SIZE_PTR;
+        }
+
+        sr__clear_call_site();
+        return count;
+    }
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    srint_t amount_before = SRALLOC_atomic_load( &allocator->stats.amount_allocated );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    const srchar_t* file = sr__call_site_file;
+    int             line = sr__call_site_line;
+#endif
+    srint_t allocated = 0;
+    if ( allocator->allocate_batch_func != SRALLOC_NULL ) {
+        allocated = allocator->allocate_batch_func( allocator, size, align, count, out_ptrs );
+    }
+    else {
+        while ( allocated < count ) {
+            out_ptrs[allocated] = allocator->allocate_func( allocator, size, align ).ptr;
+            if ( out_ptrs[allocated] == SRALLOC_NULL ) {
+                break;
+            }
+
+            ++allocated;
+        }
+    }
+
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    sr__extended_stats_record( allocator, size, count, allocated, amount_before );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    sr__call_site_file = SRALLOC_NULL;
+    for ( srint_t i_ptr = 0; allocator->tracking != SRALLOC_NULL && i_ptr < allocated; ++i_ptr ) {
+        sr__tracking_add( allocator, out_ptrs[i_ptr], size, align, file, line );
+    }
+#endif
+    return allocated;
+}
+
+SRALLOC_API void
+sralloc_dealloc_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    if ( allocator->deallocate_batch_func != SRALLOC_NULL ) {
+#ifdef SRALLOC_USE_TRACKING
+        for ( srint_t i_ptr = 0; allocator->tracking != SRALLOC_NULL && i_ptr < count; ++i_ptr ) {
+            sr__tracking_remove( allocator, ptrs[i_ptr] );
+        }
+#endif
+        allocator->deallocate_batch_func( allocator, ptrs, count );
+        return;
+    }
+
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        sralloc_dealloc( allocator, ptrs[i_ptr] );
+    }
+}
+
+// ███╗   ███╗ █████╗ ██╗     ██╗      ██████╗  ██████╗
+// ████╗ ████║██╔══██╗██║     ██║     ██╔═══██╗██╔════╝
+// ██╔████╔██║███████║██║     ██║     ██║   ██║██║
+// ██║╚██╔╝██║██╔══██║██║     ██║     ██║   ██║██║
+// ██║ ╚═╝ ██║██║  ██║███████╗███████╗╚██████╔╝╚██████╗
+// ╚═╝     ╚═╝╚═╝  ╚═╝╚══════╝╚══════╝ ╚═════╝  ╚═════╝
+
+typedef struct {
+    sralloc_preamble_int_t offset;
+    sralloc_preamble_int_t size;
+} sralloc_malloc_preamble_t;
+
+#ifdef SRALLOC_USE_PREAMBLE
+static sr_result_t
+sralloc_malloc_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t preamble_size =
+      sizeof( sralloc_malloc_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size;
+    size += align;
+    size += preamble_size;
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size );
+#endif
+
+    srchar_t* unaligned_ptr = (srchar_t*)SRALLOC_malloc( size );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_malloc_deallocate( srallocator_t* allocator, void* ptr ) {
+    SRALLOC_UNUSED( allocator );
+    sralloc_malloc_preamble_t* preamble      = (sralloc_malloc_preamble_t*)ptr - 1;
+    srchar_t*                  unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -sr__preamble_size( preamble, preamble->size ) );
+#endif
+    SRALLOC_free( unaligned_ptr );
+}
+
+static void
+sralloc_malloc_deallocate_sized( srallocator_t* allocator,
+                                 void*          ptr,
+                                 srint_t        wanted_size,
+                                 srint_t        align ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t preamble_size =
+      sizeof( sralloc_malloc_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    // When malloc's own alignment covers align the preamble always lands at the same offset
+    srchar_t* unaligned_ptr = (srchar_t*)ptr - ( align > preamble_size ? align : preamble_size );
+    if ( align > SRALLOC_MALLOC_ALIGN ) {
+        sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
+        unaligned_ptr                       = (srchar_t*)preamble - preamble->offset;
+    }
+
+    SRALLOC_UNUSED( size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+    SRALLOC_free( unaligned_ptr );
+}
+
+// libc can't promise to grow in place, so only moving reallocations succeed
+static sr_result_t
+sralloc_malloc_reallocate( srallocator_t* allocator,
+                           void*          ptr,
+                           srint_t        wanted_size,
+                           srint_t        align,
+                           int            may_move ) {
+    sralloc_malloc_preamble_t* preamble      = (sralloc_malloc_preamble_t*)ptr - 1;
+    srint_t                    preamble_size = sizeof( sralloc_malloc_preamble_t );
+    srint_t                    header_size   = preamble->offset + preamble_size;
+    srint_t                    old_size      = sr__preamble_size( preamble, preamble->size );
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    // Past malloc's own alignment the block could come back misaligned, and a block that gets
+    // too big for its preamble needs a new one
+    srint_t size = wanted_size + align + preamble_size + sr__preamble_extra( wanted_size + align );
+    if ( align > SRALLOC_MALLOC_ALIGN || !sr__preamble_fits( preamble->offset, size ) ) {
+        return sr__reallocate_by_moving(
+          allocator, ptr, old_size - header_size, wanted_size, align );
+    }
+
+    srchar_t* unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    unaligned_ptr           = (srchar_t*)SRALLOC_realloc( unaligned_ptr, size );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    SRALLOC_UNUSED( old_size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 0, size - old_size );
+#endif
+
+    preamble = (sralloc_malloc_preamble_t*)( unaligned_ptr + header_size ) - 1;
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
+    sr_result_t res;
+    res.ptr  = unaligned_ptr + header_size;
+    res.size = wanted_size;
+    return res;
+}
+
+static srint_t
+sralloc_malloc_allocate_batch( srallocator_t* allocator,
+                               srint_t        wanted_size,
+                               srint_t        align,
+                               srint_t        count,
+                               void**         out_ptrs ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t preamble_size =
+      sizeof( sralloc_malloc_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size  = wanted_size + align + preamble_size;
+    srint_t i_ptr = 0;
+    for ( ; i_ptr < count; ++i_ptr ) {
+        srchar_t* unaligned_ptr = (srchar_t*)SRALLOC_malloc( size );
+        if ( unaligned_ptr == SRALLOC_NULL ) {
+            break;
+        }
+
+        srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+        sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
+        preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        out_ptrs[i_ptr] = ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, i_ptr, size * i_ptr );
+#endif
+    return i_ptr;
+}
+
+static void
+sralloc_malloc_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t amount_deallocated = 0;
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        sralloc_malloc_preamble_t* preamble      = (sralloc_malloc_preamble_t*)ptrs[i_ptr] - 1;
+        srchar_t*                  unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+        amount_deallocated += sr__preamble_size( preamble, preamble->size );
+        SRALLOC_free( unaligned_ptr );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -count, -amount_deallocated );
+#endif
+}
+#else
+#ifdef SR__USE_POSIX_MEMALIGN
+static void*
+sr__posix_aligned_malloc( size_t size, size_t align ) {
+    void* ptr = SRALLOC_NULL;
+    return posix_memalign( &ptr, align, size ) == 0 ? ptr : SRALLOC_NULL;
+}
+#endif
+
+static sr_result_t
+sralloc_malloc_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    SRALLOC_UNUSED( allocator );
+    void* ptr = align <= SRALLOC_MALLOC_ALIGN ? SRALLOC_malloc( wanted_size )
+                                              : SRALLOC_aligned_malloc( wanted_size, align );
+    if ( ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, wanted_size );
+#endif
+
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_malloc_deallocate_sized( srallocator_t* allocator,
+                                 void*          ptr,
+                                 srint_t        size,
+                                 srint_t        align ) {
+    SRALLOC_UNUSED( allocator, size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+    if ( align <= SRALLOC_MALLOC_ALIGN ) {
+        SRALLOC_free( ptr );
+    }
+    else {
+        SRALLOC_aligned_free( ptr );
+    }
+}
+#endif // SRALLOC_USE_PREAMBLE
+
+SRALLOC_API srallocator_t*
+            sralloc_create_malloc_allocator( const char* name ) {
+    srallocator_t* allocator = (srallocator_t*)SRALLOC_malloc( sizeof( srallocator_t ) );
+    SRALLOC_memset( allocator, 0, sizeof( srallocator_t ) );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    // sr__set_type( allocator, "malloc" );
+    allocator->allocate_func         = sralloc_malloc_allocate;
+    allocator->deallocate_sized_func = sralloc_malloc_deallocate_sized;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func       = sralloc_malloc_deallocate;
+    allocator->allocate_batch_func   = sralloc_malloc_allocate_batch;
+    allocator->deallocate_batch_func = sralloc_malloc_deallocate_batch;
+    allocator->reallocate_func       = sralloc_malloc_reallocate;
+#else
+    allocator->deallocate_func = sr__deallocate_without_size;
+#endif
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_malloc_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    SRALLOC_free( allocator );
+}
+
+// ██╗  ██╗███████╗ █████╗ ██████╗
+// ██║  ██║██╔════╝██╔══██╗██╔══██╗
+// ███████║█████╗  ███████║██████╔╝
+// ██╔══██║██╔══╝  ██╔══██║██╔═══╝
+// ██║  ██║███████╗██║  ██║██║
+// ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝╚═╝
+
+// Small blocks live in spans aligned to SRALLOC_HEAP_SPAN_SIZE, so the span header of any block
+// is found by masking its address and small blocks need no preamble. Spans are carved out of
+// segments mapped from the OS. Large blocks get a mapping of their own with the same header.
+#define SR__HEAP_NUM_CLASSES 32
+#define SR__HEAP_MAX_SMALL_SIZE 8192
+#define SR__HEAP_LARGE -1
+
+typedef struct sralloc_heap_span {
+    struct sralloc_heap_span* next; // In its size class's partial list, or the free span list
+    struct sralloc_heap_span* prev;
+    void*                     free_list;
+    srchar_t*                 bump; // First never-used block
+    srchar_t*                 end;
+    sruintptr_t               mapped_size; // Large spans only
+    srint_t                   size_class;
+    srint_t                   block_size;
+    srint_t                   num_used;
+} sralloc_heap_span_t;
+
+#define SR__HEAP_SPAN_HEADER_SIZE ( ( sizeof( sralloc_heap_span_t ) + 63 ) & ~(sruintptr_t)63 )
+
+typedef struct {
+    sralloc_heap_span_t* partial_spans[SR__HEAP_NUM_CLASSES]; // Spans with free blocks
+    sralloc_heap_span_t* free_spans;
+    sralloc_heap_span_t* released_spans; // Empty, only the page with the header is committed
+    srint_t              num_free_spans;
+    srchar_t*            segment_top; // Next never-used span in the newest segment
+    srchar_t*            segment_end;
+    void**               segments;
+    srint_t              num_segments;
+    srint_t              segments_capacity;
+} srallocator_heap_t;
+
+static sralloc_heap_span_t*
+sr__heap_span_of( void* ptr ) {
+    sruintptr_t span_mask = ~( (sruintptr_t)SRALLOC_HEAP_SPAN_SIZE - 1 );
+    return (sralloc_heap_span_t*)( (sruintptr_t)ptr & span_mask );
+}
+
+static int
+sr__heap_add_segment( srallocator_heap_t* heap ) {
+    if ( heap->num_segments == heap->segments_capacity ) {
+        srint_t capacity = heap->segments_capacity ? heap->segments_capacity * 2 : 64;
+        void**  segments = (void**)sr__os_map( capacity * sizeof( void* ) );
+        if ( segments == SRALLOC_NULL ) {
+            return 0;
+        }
+
+        if ( heap->segments != SRALLOC_NULL ) {
+            SRALLOC_memcpy( segments, heap->segments, heap->num_segments * sizeof( void* ) );
+            sr__os_unmap( heap->segments, heap->segments_capacity * sizeof( void* ) );
+        }
+
+        heap->segments          = segments;
+        heap->segments_capacity = capacity;
+    }
+
+    srchar_t* segment =
+      (srchar_t*)sr__os_map_aligned( SRALLOC_HEAP_SEGMENT_SIZE, SRALLOC_HEAP_SPAN_SIZE );
+    if ( segment == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    heap->segments[heap->num_segments++] = segment;
+    heap->segment_top                    = segment;
+    heap->segment_end                    = segment + SRALLOC_HEAP_SEGMENT_SIZE;
+    return 1;
+}
+
+static void
+sr__heap_unlink_span( srallocator_heap_t* heap, sralloc_heap_span_t* span ) {
+    if ( span->prev != SRALLOC_NULL ) {
+        span->prev->next = span->next;
+    }
+    else {
+        heap->partial_spans[span->size_class] = span->next;
+    }
+
+    if ( span->next != SRALLOC_NULL ) {
+        span->next->prev = span->prev;
+    }
+
+    span->next = SRALLOC_NULL;
+    span->prev = SRALLOC_NULL;
+}
+
+static void
+sr__heap_link_span( srallocator_heap_t* heap, sralloc_heap_span_t* span ) {
+    span->prev = SRALLOC_NULL;
+    span->next = heap->partial_spans[span->size_class];
+    if ( span->next != SRALLOC_NULL ) {
+        span->next->prev = span;
+    }
+
+    heap->partial_spans[span->size_class] = span;
+}
+
+static sralloc_heap_span_t*
+sr__heap_new_span( srallocator_heap_t* heap, srint_t size_class ) {
+    sralloc_heap_span_t* span = heap->free_spans;
+    if ( span != SRALLOC_NULL ) {
+        heap->free_spans = span->next;
+        heap->num_free_spans--;
+    }
+    else if ( heap->released_spans != SRALLOC_NULL &&
+              sr__os_commit( (srchar_t*)heap->released_spans + SRALLOC_PAGE_SIZE,
+                             SRALLOC_HEAP_SPAN_SIZE - SRALLOC_PAGE_SIZE ) ) {
+        span                 = heap->released_spans;
+        heap->released_spans = span->next;
+    }
+    else {
+        if ( heap->segment_top == heap->segment_end && !sr__heap_add_segment( heap ) ) {
+            return SRALLOC_NULL;
+        }
+
+        span = (sralloc_heap_span_t*)heap->segment_top;
+        heap->segment_top += SRALLOC_HEAP_SPAN_SIZE;
+    }
+
+    srint_t block_size = sr__size_class_size( size_class );
+    srint_t num_blocks = ( SRALLOC_HEAP_SPAN_SIZE - SR__HEAP_SPAN_HEADER_SIZE ) / block_size;
+    span->free_list    = SRALLOC_NULL;
+    span->bump         = (srchar_t*)span + SR__HEAP_SPAN_HEADER_SIZE;
+    span->end          = span->bump + num_blocks * block_size;
+    span->mapped_size  = 0;
+    span->size_class   = size_class;
+    span->block_size   = block_size;
+    span->num_used     = 0;
+    sr__heap_link_span( heap, span );
+    return span;
+}
+
+// The header has to be in the span ptr is in, which a span aligned ptr would start
+static sr_result_t
+sr__heap_allocate_large( srallocator_t* allocator, srint_t size, srint_t align ) {
+    SRALLOC_UNUSED( allocator );
+    if ( align >= SRALLOC_HEAP_SPAN_SIZE ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    sruintptr_t mapped_size = SR__HEAP_SPAN_HEADER_SIZE + size;
+    mapped_size = ( mapped_size + SRALLOC_PAGE_SIZE - 1 ) & ~( (sruintptr_t)SRALLOC_PAGE_SIZE - 1 );
+    sralloc_heap_span_t* span =
+      (sralloc_heap_span_t*)sr__os_map_aligned( mapped_size, SRALLOC_HEAP_SPAN_SIZE );
+    if ( span == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    span->mapped_size = mapped_size;
+    span->size_class  = SR__HEAP_LARGE;
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, (srint_t)mapped_size );
+#endif
+
+    srchar_t* block = (srchar_t*)span + SR__HEAP_SPAN_HEADER_SIZE;
+    srchar_t* ptr   = (srchar_t*)sr__ptr_to_aligned_ptr( block, align );
+
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = (srint_t)( mapped_size - SR__HEAP_SPAN_HEADER_SIZE ) - sr__ptr_diff( ptr, block );
+    return res;
+}
+
+static srchar_t*
+sr__heap_allocate_block( srallocator_heap_t* heap, srint_t size_class ) {
+    sralloc_heap_span_t* span = heap->partial_spans[size_class];
+    if ( span == SRALLOC_NULL ) {
+        span = sr__heap_new_span( heap, size_class );
+        if ( span == SRALLOC_NULL ) {
+            return SRALLOC_NULL;
+        }
+    }
+
+    srchar_t* block = (srchar_t*)span->free_list;
+    if ( block != SRALLOC_NULL ) {
+        span->free_list = *(void**)block;
+    }
+    else {
+        block = span->bump;
+        span->bump += span->block_size;
+    }
+
+    span->num_used++;
+    if ( span->free_list == SRALLOC_NULL && span->bump == span->end ) {
+        sr__heap_unlink_span( heap, span );
+    }
+
+    return block;
+}
+
+// Returns how much memory was given back, for the stats
+static srint_t
+sr__heap_deallocate_block( srallocator_heap_t* heap, void* ptr ) {
+    sralloc_heap_span_t* span = sr__heap_span_of( ptr );
+    if ( span->size_class == SR__HEAP_LARGE ) {
+        srint_t mapped_size = (srint_t)span->mapped_size;
+        sr__os_unmap( span, span->mapped_size );
+        return mapped_size;
+    }
+
+    // Aligned pointers may point into their block, find its start
+    srchar_t* first_block = (srchar_t*)span + SR__HEAP_SPAN_HEADER_SIZE;
+    srint_t   offset      = sr__ptr_diff( ptr, first_block );
+    srchar_t* block       = first_block + offset - offset % span->block_size;
+    int       was_full    = span->free_list == SRALLOC_NULL && span->bump == span->end;
+
+    SRALLOC_WRITE_DEALLOCATION_PATTERN( block, span->block_size );
+    *(void**)block  = span->free_list;
+    span->free_list = block;
+    span->num_used--;
+
+    if ( was_full ) {
+        sr__heap_link_span( heap, span );
+    }
+
+    // Keep the last span of each size class around so alloc/free at the edge doesn't thrash
+    if ( span->num_used == 0 && ( span->prev != SRALLOC_NULL || span->next != SRALLOC_NULL ) ) {
+        sr__heap_unlink_span( heap, span );
+        if ( heap->num_free_spans < SRALLOC_HEAP_MAX_FREE_SPANS ||
+             SRALLOC_HEAP_SPAN_SIZE <= SRALLOC_PAGE_SIZE ) {
+            span->next       = heap->free_spans;
+            heap->free_spans = span;
+            heap->num_free_spans++;
+        }
+        else {
+            sr__os_decommit( (srchar_t*)span + SRALLOC_PAGE_SIZE,
+                             SRALLOC_HEAP_SPAN_SIZE - SRALLOC_PAGE_SIZE );
+            span->next           = heap->released_spans;
+            heap->released_spans = span;
+        }
+    }
+
+    return span->block_size;
+}
+
+static sr_result_t
+sralloc_heap_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_heap_t* heap = (srallocator_heap_t*)( allocator + 1 );
+
+    // Blocks are always 16 byte aligned, anything stricter is found inside a bigger block
+    srint_t size = wanted_size;
+    if ( align > 16 ) {
+        size += align;
+    }
+    else {
+        align = 0;
+    }
+
+    if ( size > SR__HEAP_MAX_SMALL_SIZE ) {
+        return sr__heap_allocate_large( allocator, size, align );
+    }
+
+    srint_t   size_class = sr__size_class( size );
+    srchar_t* block      = sr__heap_allocate_block( heap, size_class );
+    if ( block == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    srint_t block_size = sr__size_class_size( size_class );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, block_size );
+#endif
+
+    srchar_t*   ptr = (srchar_t*)sr__ptr_to_aligned_ptr( block, align );
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = block_size - sr__ptr_diff( ptr, block );
+    return res;
+}
+
+static void
+sralloc_heap_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_heap_t* heap               = (srallocator_heap_t*)( allocator + 1 );
+    srint_t             amount_deallocated = sr__heap_deallocate_block( heap, ptr );
+    SRALLOC_UNUSED( amount_deallocated );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -amount_deallocated );
+#endif
+}
+
+static srint_t
+sralloc_heap_allocate_batch( srallocator_t* allocator,
+                             srint_t        wanted_size,
+                             srint_t        align,
+                             srint_t        count,
+                             void**         out_ptrs ) {
+    srint_t size = wanted_size + ( align > 16 ? align : 0 );
+    if ( size > SR__HEAP_MAX_SMALL_SIZE ) {
+        srint_t i_ptr = 0;
+        for ( ; i_ptr < count; ++i_ptr ) {
+            out_ptrs[i_ptr] = sralloc_heap_allocate( allocator, wanted_size, align ).ptr;
+            if ( out_ptrs[i_ptr] == SRALLOC_NULL ) {
+                break;
+            }
+        }
+
+        return i_ptr;
+    }
+
+    srallocator_heap_t* heap       = (srallocator_heap_t*)( allocator + 1 );
+    srint_t             size_class = sr__size_class( size );
+    srint_t             i_ptr      = 0;
+    for ( ; i_ptr < count; ++i_ptr ) {
+        srchar_t* block = sr__heap_allocate_block( heap, size_class );
+        if ( block == SRALLOC_NULL ) {
+            break;
+        }
+
+        out_ptrs[i_ptr] = sr__ptr_to_aligned_ptr( block, align > 16 ? align : 0 );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, i_ptr, sr__size_class_size( size_class ) * i_ptr );
+#endif
+    return i_ptr;
+}
+
+static void
+sralloc_heap_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    srallocator_heap_t* heap               = (srallocator_heap_t*)( allocator + 1 );
+    srint_t             amount_deallocated = 0;
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        amount_deallocated += sr__heap_deallocate_block( heap, ptrs[i_ptr] );
+    }
+
+    SRALLOC_UNUSED( amount_deallocated );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -count, -amount_deallocated );
+#endif
+}
+
+static sr_result_t
+sralloc_heap_reallocate( srallocator_t* allocator,
+                         void*          ptr,
+                         srint_t        wanted_size,
+                         srint_t        align,
+                         int            may_move ) {
+    // Whatever is left of the block after ptr can be used without moving
+    sralloc_heap_span_t* span        = sr__heap_span_of( ptr );
+    srchar_t*            first_block = (srchar_t*)span + SR__HEAP_SPAN_HEADER_SIZE;
+    srint_t              offset      = sr__ptr_diff( ptr, first_block );
+    srint_t              usable_size;
+    if ( span->size_class == SR__HEAP_LARGE ) {
+        usable_size = (srint_t)( span->mapped_size - SR__HEAP_SPAN_HEADER_SIZE ) - offset;
+    }
+    else {
+        usable_size = span->block_size - offset % span->block_size;
+    }
+
+    if ( wanted_size <= usable_size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = usable_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    return sr__reallocate_by_moving( allocator, ptr, usable_size, wanted_size, align );
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_heap_allocator( const char* name ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_heap_t );
+    srallocator_t* allocator      = (srallocator_t*)sr__os_map( allocator_size );
+    if ( allocator == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func         = sralloc_heap_allocate;
+    allocator->deallocate_func       = sralloc_heap_deallocate;
+    allocator->allocate_batch_func   = sralloc_heap_allocate_batch;
+    allocator->deallocate_batch_func = sralloc_heap_deallocate_batch;
+    allocator->reallocate_func       = sralloc_heap_reallocate;
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_heap_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srallocator_heap_t* heap = (srallocator_heap_t*)( allocator + 1 );
+    for ( srint_t i_segment = 0; i_segment < heap->num_segments; ++i_segment ) {
+        sr__os_unmap( heap->segments[i_segment], SRALLOC_HEAP_SEGMENT_SIZE );
+    }
+
+    if ( heap->segments != SRALLOC_NULL ) {
+        sr__os_unmap( heap->segments, heap->segments_capacity * sizeof( void* ) );
+    }
+
+    sr__os_unmap( allocator, sizeof( srallocator_t ) + sizeof( srallocator_heap_t ) );
+}
+
+// ██████╗  █████╗  ██████╗ ███████╗
+// ██╔══██╗██╔══██╗██╔════╝ ██╔════╝
+// ██████╔╝███████║██║  ███╗█████╗
+// ██╔═══╝ ██╔══██║██║   ██║██╔══╝
+// ██║     ██║  ██║╚██████╔╝███████╗
+// ╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚══════╝
+
+#define SR__PAGE_NORMAL 0
+#define SR__PAGE_HUGETLB 1 // Explicit huge pages, always backed by them
+#define SR__PAGE_ADVISED 2 // Transparent huge pages were asked for, the kernel decides
+
+typedef struct {
+    srchar_t* ptr;
+    srint_t   size; // Mapped bytes
+    srint_t   kind;
+} sralloc_page_span_t;
+
+// The mappings are kept in a side table so that no memory is spent on headers
+typedef struct {
+    sralloc_page_span_t* spans; // Open addressing, keyed by ptr
+    srint_t              spans_capacity;
+    srint_t              num_spans;
+    srint_t              mapped;
+    srint_t              hugetlb_mapped;
+    int                  huge_pages;
+    srint_t              node; // The NUMA node mappings are bound to, or -1
+} srallocator_page_t;
+
+// All of the page number is mixed in, huge page mappings have their low bits all zero
+static srint_t
+sr__page_home( srallocator_page_t* page_allocator, void* ptr ) {
+    uint64_t hash = sr__hash64( (sruintptr_t)ptr / SRALLOC_PAGE_SIZE );
+    return (srint_t)( hash & (uint64_t)( page_allocator->spans_capacity - 1 ) );
+}
+
+static sralloc_page_span_t*
+sr__page_find( srallocator_page_t* page_allocator, void* ptr ) {
+    srint_t mask = page_allocator->spans_capacity - 1;
+    for ( srint_t i = sr__page_home( page_allocator, ptr );; i = ( i + 1 ) & mask ) {
+        sralloc_page_span_t* span = &page_allocator->spans[i];
+        if ( span->ptr == ptr || span->ptr == SRALLOC_NULL ) {
+            return span;
+        }
+    }
+}
+
+static int
+sr__page_insert( srallocator_page_t* page_allocator, sralloc_page_span_t* new_span ) {
+    if ( ( page_allocator->num_spans + 1 ) * 2 > page_allocator->spans_capacity ) {
+        srint_t capacity = page_allocator->spans_capacity == 0 ? 256
+                                                               : page_allocator->spans_capacity * 2;
+        sralloc_page_span_t* spans =
+          (sralloc_page_span_t*)sr__os_map( capacity * sizeof( sralloc_page_span_t ) );
+        if ( spans == SRALLOC_NULL ) {
+            return 0;
+        }
+
+        sralloc_page_span_t* old_spans    = page_allocator->spans;
+        srint_t              old_capacity = page_allocator->spans_capacity;
+        page_allocator->spans             = spans;
+        page_allocator->spans_capacity    = capacity;
+        for ( srint_t i = 0; i < old_capacity; ++i ) {
+            if ( old_spans[i].ptr != SRALLOC_NULL ) {
+                *sr__page_find( page_allocator, old_spans[i].ptr ) = old_spans[i];
+            }
+        }
+
+        if ( old_spans != SRALLOC_NULL ) {
+            sr__os_unmap( old_spans, old_capacity * sizeof( sralloc_page_span_t ) );
+        }
+    }
+
+    *sr__page_find( page_allocator, new_span->ptr ) = *new_span;
+    ++page_allocator->num_spans;
+    return 1;
+}
+
+// Backward shift deletion, so lookups never need tombstones
+static void
+sr__page_remove( srallocator_page_t* page_allocator, sralloc_page_span_t* span ) {
+    srint_t mask = page_allocator->spans_capacity - 1;
+    srint_t hole = (srint_t)( span - page_allocator->spans );
+    for ( srint_t i = ( hole + 1 ) & mask; page_allocator->spans[i].ptr != SRALLOC_NULL;
+          i         = ( i + 1 ) & mask ) {
+        srint_t home = sr__page_home( page_allocator, page_allocator->spans[i].ptr );
+        if ( ( ( i - home ) & mask ) >= ( ( i - hole ) & mask ) ) {
+            page_allocator->spans[hole] = page_allocator->spans[i];
+            hole                        = i;
+        }
+    }
+
+    page_allocator->spans[hole].ptr = SRALLOC_NULL;
+    --page_allocator->num_spans;
+}
+
+static void
+sr__page_destroy_table( srallocator_page_t* page_allocator ) {
+    SRALLOC_assert( page_allocator->num_spans == 0 );
+    if ( page_allocator->spans != SRALLOC_NULL ) {
+        sr__os_unmap( page_allocator->spans,
+                      page_allocator->spans_capacity * sizeof( sralloc_page_span_t ) );
+    }
+}
+
+static sr_result_t
+sralloc_page_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_page_t* page_allocator = (srallocator_page_t*)( allocator + 1 );
+    sralloc_page_span_t span;
+    span.ptr  = SRALLOC_NULL;
+    span.size = ( wanted_size + SRALLOC_PAGE_SIZE - 1 ) & ~( (srint_t)SRALLOC_PAGE_SIZE - 1 );
+    span.kind = SR__PAGE_NORMAL;
+    if ( page_allocator->huge_pages && span.size >= SRALLOC_HUGE_PAGE_SIZE &&
+         align <= SRALLOC_HUGE_PAGE_SIZE ) {
+        srint_t huge_size =
+          ( span.size + SRALLOC_HUGE_PAGE_SIZE - 1 ) & ~( (srint_t)SRALLOC_HUGE_PAGE_SIZE - 1 );
+        span.ptr = (srchar_t*)sr__os_map_huge( (sruintptr_t)huge_size );
+        if ( span.ptr != SRALLOC_NULL ) {
+            span.size = huge_size;
+            span.kind = SR__PAGE_HUGETLB;
+        }
+        else {
+            // Only whole aligned huge pages can be transparent huge pages, the tail won't be
+            span.ptr = (srchar_t*)sr__os_map_aligned( (sruintptr_t)span.size,
+                                                      SRALLOC_HUGE_PAGE_SIZE );
+            if ( span.ptr != SRALLOC_NULL &&
+                 sr__os_advise_huge( span.ptr, (sruintptr_t)span.size ) ) {
+                span.kind = SR__PAGE_ADVISED;
+            }
+        }
+    }
+
+    if ( span.ptr == SRALLOC_NULL ) {
+        span.ptr = align > SRALLOC_PAGE_SIZE
+                     ? (srchar_t*)sr__os_map_aligned( (sruintptr_t)span.size, (sruintptr_t)align )
+                     : (srchar_t*)sr__os_map( (sruintptr_t)span.size );
+    }
+
+    if ( span.ptr != SRALLOC_NULL && page_allocator->node >= 0 ) {
+        sr__os_bind_node( span.ptr, (sruintptr_t)span.size, page_allocator->node );
+    }
+
+    if ( span.ptr == SRALLOC_NULL || !sr__page_insert( page_allocator, &span ) ) {
+        if ( span.ptr != SRALLOC_NULL ) {
+            sr__os_unmap( span.ptr, (sruintptr_t)span.size );
+        }
+
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    page_allocator->mapped += span.size;
+    if ( span.kind == SR__PAGE_HUGETLB ) {
+        page_allocator->hugetlb_mapped += span.size;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, span.size );
+#endif
+
+    sr_result_t res;
+    res.ptr  = span.ptr;
+    res.size = span.size;
+    return res;
+}
+
+static void
+sralloc_page_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_page_t*  page_allocator = (srallocator_page_t*)( allocator + 1 );
+    sralloc_page_span_t* span           = sr__page_find( page_allocator, ptr );
+    SRALLOC_assert( span->ptr == ptr );
+    srint_t size = span->size;
+    page_allocator->mapped -= size;
+    if ( span->kind == SR__PAGE_HUGETLB ) {
+        page_allocator->hugetlb_mapped -= size;
+    }
+
+    sr__page_remove( page_allocator, span );
+    sr__os_unmap( ptr, (sruintptr_t)size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+}
+
+static sr_result_t
+sralloc_page_reallocate( srallocator_t* allocator,
+                         void*          ptr,
+                         srint_t        wanted_size,
+                         srint_t        align,
+                         int            may_move ) {
+    srallocator_page_t* page_allocator = (srallocator_page_t*)( allocator + 1 );
+    srint_t             size           = sr__page_find( page_allocator, ptr )->size;
+    if ( wanted_size <= size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    return sr__reallocate_by_moving( allocator, ptr, size, wanted_size, align );
+}
+
+#if defined( __linux__ )
+typedef struct {
+    srallocator_page_t* page_allocator;
+    srint_t             huge_page_bytes;
+} sr__page_huge_count_t;
+
+// Huge pages in a mapping can't be told apart further, so the count is capped at how much of
+// the mapping the advised spans cover
+static void
+sr__page_count_huge_range( void* user_data, sruintptr_t start, sruintptr_t end, sruintptr_t huge ) {
+    sr__page_huge_count_t* count          = (sr__page_huge_count_t*)user_data;
+    srallocator_page_t*    page_allocator = count->page_allocator;
+    sruintptr_t            covered        = 0;
+    for ( srint_t i = 0; i < page_allocator->spans_capacity; ++i ) {
+        sralloc_page_span_t* span = &page_allocator->spans[i];
+        if ( span->ptr == SRALLOC_NULL || span->kind != SR__PAGE_ADVISED ) {
+            continue;
+        }
+
+        sruintptr_t span_start = (sruintptr_t)span->ptr;
+        sruintptr_t span_end   = span_start + (sruintptr_t)span->size;
+        if ( span_start < end && span_end > start ) {
+            sruintptr_t overlap_start = span_start > start ? span_start : start;
+            sruintptr_t overlap_end   = span_end < end ? span_end : end;
+            covered += overlap_end - overlap_start;
+        }
+    }
+
+    count->huge_page_bytes += (srint_t)( huge < covered ? huge : covered );
+}
+#endif
+
+SRALLOC_API sralloc_page_stats_t
+sralloc_page_allocator_stats( srallocator_t* allocator ) {
+    srallocator_page_t*  page_allocator = (srallocator_page_t*)( allocator + 1 );
+    sralloc_page_stats_t stats;
+    stats.mapped          = page_allocator->mapped;
+    stats.huge_page_bytes = page_allocator->hugetlb_mapped;
+#if defined( __linux__ )
+    sr__page_huge_count_t count;
+    count.page_allocator  = page_allocator;
+    count.huge_page_bytes = 0;
+    sr__os_for_each_huge_range( sr__page_count_huge_range, &count );
+    stats.huge_page_bytes += count.huge_page_bytes;
+#endif
+    return stats;
+}
+
+static srallocator_t*
+sr__create_page_allocator( const char* name, int huge_pages, srint_t node ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_page_t );
+    srallocator_t* allocator      = (srallocator_t*)sr__os_map( allocator_size );
+    if ( allocator == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func   = sralloc_page_allocate;
+    allocator->deallocate_func = sralloc_page_deallocate;
+    allocator->reallocate_func = sralloc_page_reallocate;
+
+    srallocator_page_t* page_allocator = (srallocator_page_t*)( allocator + 1 );
+    page_allocator->huge_pages         = huge_pages;
+    page_allocator->node               = node;
+    return allocator;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_page_allocator( const char* name, int huge_pages ) {
+    return sr__create_page_allocator( name, huge_pages, -1 );
+}
+
+SRALLOC_API void
+sralloc_destroy_page_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    sr__page_destroy_table( (srallocator_page_t*)( allocator + 1 ) );
+    sr__os_unmap( allocator, sizeof( srallocator_t ) + sizeof( srallocator_page_t ) );
+}
+
+// ███╗   ██╗██╗   ██╗███╗   ███╗ █████╗
+// ████╗  ██║██║   ██║████╗ ████║██╔══██╗
+// ██╔██╗ ██║██║   ██║██╔████╔██║███████║
+// ██║╚██╗██║██║   ██║██║╚██╔╝██║██╔══██║
+// ██║ ╚████║╚██████╔╝██║ ╚═╝ ██║██║  ██║
+// ╚═╝  ╚═══╝ ╚═════╝ ╚═╝     ╚═╝╚═╝  ╚═╝
+
+// The NUMA allocator is a page allocator itself, for what's allocated from it directly
+typedef struct {
+    srallocator_page_t pages;
+    srint_t            bind; // Whether the system has NUMA nodes to bind to
+    srint_t            num_nodes;
+    srallocator_t*     nodes[SRALLOC_NUMA_MAX_NODES]; // Page allocators, children of this one
+} srallocator_numa_t;
+
+static sr_result_t
+sralloc_numa_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    numa_allocator->pages.node         = -1;
+    if ( numa_allocator->bind ) {
+        srint_t node               = sr__os_current_node();
+        numa_allocator->pages.node = node < numa_allocator->num_nodes ? node : 0;
+    }
+
+    return sralloc_page_allocate( allocator, wanted_size, align );
+}
+
+SRALLOC_API srint_t
+sralloc_numa_allocator_num_nodes( srallocator_t* allocator ) {
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    return numa_allocator->num_nodes;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_numa_allocator_node( srallocator_t* allocator, srint_t node ) {
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    SRALLOC_assert( node >= 0 && node < numa_allocator->num_nodes );
+    return numa_allocator->nodes[node];
+}
+
+SRALLOC_API srallocator_t*
+sralloc_numa_allocator_local_node( srallocator_t* allocator ) {
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    srint_t             node           = sr__os_current_node();
+    return numa_allocator->nodes[node < numa_allocator->num_nodes ? node : 0];
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_numa_allocator( const char* name, int huge_pages ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_numa_t );
+    srallocator_t* allocator      = (srallocator_t*)sr__os_map( allocator_size );
+    if ( allocator == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func   = sralloc_numa_allocate;
+    allocator->deallocate_func = sralloc_page_deallocate;
+    allocator->reallocate_func = sralloc_page_reallocate;
+
+    // Without NUMA support there's one node and nothing is bound
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    srint_t             num_nodes      = sr__os_num_nodes();
+    numa_allocator->pages.huge_pages   = huge_pages;
+    numa_allocator->bind               = num_nodes > 0;
+    numa_allocator->num_nodes          = num_nodes > 0 ? num_nodes : 1;
+    for ( srint_t node = 0; node < numa_allocator->num_nodes; ++node ) {
+        numa_allocator->nodes[node] =
+          sr__create_page_allocator( "numa_node", huge_pages, num_nodes > 0 ? node : -1 );
+        SRALLOC_assert( numa_allocator->nodes[node] != SRALLOC_NULL );
+        sr__add_child_allocator( allocator, numa_allocator->nodes[node] );
+    }
+
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_numa_allocator( srallocator_t* allocator ) {
+    srallocator_numa_t* numa_allocator = (srallocator_numa_t*)( allocator + 1 );
+    for ( srint_t node = 0; node < numa_allocator->num_nodes; ++node ) {
+        sr__remove_child_allocator( allocator, numa_allocator->nodes[node] );
+        sralloc_destroy_page_allocator( numa_allocator->nodes[node] );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    sr__page_destroy_table( &numa_allocator->pages );
+    sr__os_unmap( allocator, sizeof( srallocator_t ) + sizeof( srallocator_numa_t ) );
+}
+
+// ███████╗████████╗ █████╗  ██████╗██╗  ██╗
+// ██╔════╝╚══██╔══╝██╔══██╗██╔════╝██║ ██╔╝
+// ███████╗   ██║   ███████║██║     █████╔╝
+// ╚════██║   ██║   ██╔══██║██║     ██╔═██╗
+// ███████║   ██║   ██║  ██║╚██████╗██║  ██╗
+// ╚══════╝   ╚═╝   ╚═╝  ╚═╝ ╚═════╝╚═╝  ╚═╝
+
+typedef struct {
+    sralloc_preamble_int_t offset;
+    sralloc_preamble_int_t size;
+} sralloc_stack_preamble_t;
+
+typedef struct {
+    void* top;
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t stats;
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    int64_t tracking_sequence; // Allocations from here on are dropped by the pop
+#endif
+} srallocator_stack_state_t;
+
+typedef struct {
+    void*                     top;
+    void*                     end;
+    srallocator_t*            backing_allocator;
+    srallocator_stack_state_t states[4];
+    srint_t                   num_states;
+    void*                     base;
+    void*                     committed_end;
+    srint_t                   keep_committed;
+    int                       is_virtual;
+} srallocator_stack_t;
+
+static srint_t
+sr__stack_commit_round( srint_t size ) {
+    // The commit size only has to be a multiple of the page size, not a power of two
+    srint_t commit_size = SRALLOC_STACK_COMMIT_SIZE;
+    return ( size + commit_size - 1 ) / commit_size * commit_size;
+}
+
+// Whether size bytes from ptr are usable, committing more of a virtual stack when they aren't yet
+static int
+sr__stack_commit( srallocator_stack_t* stack_allocator, void* ptr, srint_t size ) {
+    if ( size <= sr__ptr_diff( stack_allocator->committed_end, ptr ) ) {
+        return 1;
+    }
+
+    if ( !stack_allocator->is_virtual || size > sr__ptr_diff( stack_allocator->end, ptr ) ) {
+        return 0;
+    }
+
+    srint_t   used       = sr__ptr_diff( ptr, stack_allocator->base ) + size;
+    srchar_t* commit_end = (srchar_t*)stack_allocator->base + sr__stack_commit_round( used );
+    if ( commit_end > (srchar_t*)stack_allocator->end ) {
+        commit_end = (srchar_t*)stack_allocator->end;
+    }
+
+    srchar_t* committed_end = (srchar_t*)stack_allocator->committed_end;
+    if ( !sr__os_commit( committed_end, (sruintptr_t)( commit_end - committed_end ) ) ) {
+        return 0;
+    }
+
+    stack_allocator->committed_end = commit_end;
+    return 1;
+}
+
+// Gives back the committed pages past top, keeping at least keep_committed bytes
+static void
+sr__stack_decommit( srallocator_stack_t* stack_allocator ) {
+    if ( !stack_allocator->is_virtual ) {
+        return;
+    }
+
+    srint_t keep = sr__ptr_diff( stack_allocator->top, stack_allocator->base );
+    if ( keep < stack_allocator->keep_committed ) {
+        keep = stack_allocator->keep_committed;
+    }
+
+    srchar_t* keep_end      = (srchar_t*)stack_allocator->base + sr__stack_commit_round( keep );
+    srchar_t* committed_end = (srchar_t*)stack_allocator->committed_end;
+    if ( keep_end < committed_end ) {
+        sr__os_decommit( keep_end, (sruintptr_t)( committed_end - keep_end ) );
+        stack_allocator->committed_end = keep_end;
+    }
+}
+
+#ifdef SRALLOC_USE_PREAMBLE
+static sr_result_t
+sralloc_stack_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srint_t preamble_size =
+      sizeof( sralloc_stack_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size;
+    size += align;
+    size += preamble_size;
+
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    if ( !sr__stack_commit( stack_allocator, stack_allocator->top, size ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size );
+#endif
+
+    void*     unaligned_ptr = stack_allocator->top;
+    srchar_t* ptr           = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+    stack_allocator->top = ptr + size;
+    sr_result_t res;
+    res.ptr  = (void*)( ptr );
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_stack_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_stack_t*       stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    sralloc_malloc_preamble_t* preamble        = (sralloc_malloc_preamble_t*)ptr - 1;
+    srchar_t*                  unaligned_ptr   = (srchar_t*)preamble - preamble->offset;
+    stack_allocator->top                       = unaligned_ptr;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -sr__preamble_size( preamble, preamble->size ) );
+#endif
+}
+
+static sr_result_t
+sralloc_stack_reallocate( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        wanted_size,
+                          srint_t        align,
+                          int            may_move ) {
+    srallocator_stack_t*      stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    sralloc_stack_preamble_t* preamble        = (sralloc_stack_preamble_t*)ptr - 1;
+    srint_t header_size = preamble->offset + (srint_t)sizeof( sralloc_stack_preamble_t );
+    srint_t old_size    = sr__preamble_size( preamble, preamble->size );
+
+    // The topmost allocation grows and shrinks in place by moving top
+    srint_t size = header_size + wanted_size;
+    if ( (srchar_t*)ptr + old_size == stack_allocator->top &&
+         sr__preamble_fits( preamble->offset, size ) ) {
+        if ( !sr__stack_commit( stack_allocator, ptr, size ) ) {
+            sr_result_t res = { SRALLOC_NULL, 0 };
+            return res;
+        }
+
+#ifdef SRALLOC_USE_STATS
+        sr__stats_add( allocator, 0, size - old_size );
+#endif
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        stack_allocator->top = (srchar_t*)ptr + size;
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = wanted_size;
+        return res;
+    }
+
+    if ( wanted_size <= old_size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = old_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    // Anything below the top can't be handed back to the stack, so the old block is only
+    // dropped from the stats and its memory comes back when the stack unwinds past it.
+    sr_result_t res = sralloc_stack_allocate( allocator, wanted_size, align );
+    if ( res.ptr != SRALLOC_NULL ) {
+        SRALLOC_memcpy( res.ptr, ptr, old_size );
+#ifdef SRALLOC_USE_STATS
+        sr__stats_add( allocator, -1, -old_size );
+#endif
+    }
+
+    return res;
+}
+
+static srint_t
+sralloc_stack_allocate_batch( srallocator_t* allocator,
+                              srint_t        wanted_size,
+                              srint_t        align,
+                              srint_t        count,
+                              void**         out_ptrs ) {
+    srint_t preamble_size =
+      sizeof( sralloc_stack_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    // Each block is laid out like a single allocation, so the size in its preamble is what
+    // reallocate may grow into. stride is the most one block can take up.
+    srint_t stride = size + preamble_size + align;
+
+    // Hand out as many as fit
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    srint_t              space_left = sr__ptr_diff( stack_allocator->end, stack_allocator->top );
+    if ( stride * count > space_left ) {
+        count = space_left / stride;
+    }
+
+    if ( !sr__stack_commit( stack_allocator, stack_allocator->top, stride * count ) ) {
+        count = sr__ptr_diff( stack_allocator->committed_end, stack_allocator->top ) / stride;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, count, size * count );
+#endif
+
+    srchar_t* unaligned_ptr = (srchar_t*)stack_allocator->top;
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+        sralloc_stack_preamble_t* preamble = (sralloc_stack_preamble_t*)ptr - 1;
+        preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        out_ptrs[i_ptr] = ptr;
+        unaligned_ptr   = ptr + size;
+    }
+
+    stack_allocator->top = unaligned_ptr;
+    return count;
+}
+
+static void
+sralloc_stack_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    srallocator_stack_t* stack_allocator    = (srallocator_stack_t*)( allocator + 1 );
+    srchar_t*            lowest_ptr         = (srchar_t*)stack_allocator->top;
+    srint_t              amount_deallocated = 0;
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        sralloc_stack_preamble_t* preamble      = (sralloc_stack_preamble_t*)ptrs[i_ptr] - 1;
+        srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+        amount_deallocated += sr__preamble_size( preamble, preamble->size );
+        if ( unaligned_ptr < lowest_ptr ) {
+            lowest_ptr = unaligned_ptr;
+        }
+    }
+
+    stack_allocator->top = lowest_ptr;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -count, -amount_deallocated );
+#endif
+}
+#else
+static sr_result_t
+sralloc_stack_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    srchar_t*            ptr = (srchar_t*)sr__ptr_to_aligned_ptr( stack_allocator->top, align );
+    if ( !sr__stack_commit( stack_allocator, ptr, wanted_size ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, wanted_size );
+#endif
+
+    stack_allocator->top = ptr + wanted_size;
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+// The alignment padding before ptr is given back when the allocation before it is freed
+static void
+sralloc_stack_deallocate_sized( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    SRALLOC_UNUSED( size, align );
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    stack_allocator->top                 = ptr;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+}
+#endif // SRALLOC_USE_PREAMBLE
+
+SRALLOC_API void
+sralloc_stack_allocator_clear( srallocator_t* allocator ) {
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    stack_allocator->top                 = stack_allocator->base;
+    sr__stack_decommit( stack_allocator );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_reset( allocator );
+    sr__tracking_forget( allocator, SRALLOC_NULL, SRALLOC_NULL, 0 );
+#endif
+}
+
+SRALLOC_API void
+sralloc_stack_allocator_push_state( srallocator_t* allocator ) {
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    SRALLOC_assert(
+      stack_allocator->num_states <
+      ( srint_t )( sizeof( stack_allocator->states ) / sizeof( srallocator_stack_state_t ) ) );
+    srallocator_stack_state_t* state = &stack_allocator->states[stack_allocator->num_states++];
+    state->top                       = stack_allocator->top;
+#ifdef SRALLOC_USE_STATS
+    state->stats = sralloc_get_stats( allocator );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    state->tracking_sequence = sr__tracking_sequence( allocator );
+#endif
+}
+
+SRALLOC_API void
+sralloc_stack_allocator_pop_state( srallocator_t* allocator ) {
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    SRALLOC_assert( stack_allocator->num_states > 0 );
+    srallocator_stack_state_t* state = &stack_allocator->states[--stack_allocator->num_states];
+    stack_allocator->top             = state->top;
+    sr__stack_decommit( stack_allocator );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_reset( allocator );
+    allocator->stats = state->stats;
+    sr__tracking_forget( allocator, SRALLOC_NULL, SRALLOC_NULL, state->tracking_sequence );
+#endif
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_stack_allocator( const char* name, srallocator_t* parent, srint_t capacity ) {
+    srint_t header_size    = sizeof( srallocator_t ) + sizeof( srallocator_stack_t );
+    void*   memory         = sralloc_alloc( parent, header_size + capacity );
+    srallocator_t*       allocator       = (srallocator_t*)memory;
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+
+    // Only the header is cleared so that a large stack doesn't touch all of its pages up front
+    SRALLOC_memset( allocator, 0, header_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func = sralloc_stack_allocate;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func       = sralloc_stack_deallocate;
+    allocator->allocate_batch_func   = sralloc_stack_allocate_batch;
+    allocator->deallocate_batch_func = sralloc_stack_deallocate_batch;
+    allocator->reallocate_func       = sralloc_stack_reallocate;
+#else
+    allocator->deallocate_func       = sr__deallocate_without_size;
+    allocator->deallocate_sized_func = sralloc_stack_deallocate_sized;
+#endif
+    stack_allocator->base              = stack_allocator + 1;
+    stack_allocator->top               = stack_allocator->base;
+    stack_allocator->end               = ( (char*)stack_allocator->top ) + capacity;
+    stack_allocator->committed_end     = stack_allocator->end;
+    stack_allocator->num_states        = 0;
+    stack_allocator->backing_allocator = parent;
+    return allocator;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_virtual_stack_allocator( const char*    name,
+                                        srallocator_t* parent,
+                                        srint_t        capacity,
+                                        srint_t        keep_committed ) {
+    capacity   = sr__stack_commit_round( capacity );
+    void* base = sr__os_reserve( (sruintptr_t)capacity );
+    if ( base == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t* allocator = sralloc_create_stack_allocator( name, parent, 0 );
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    stack_allocator->base                = base;
+    stack_allocator->top                 = base;
+    stack_allocator->end                 = (srchar_t*)base + capacity;
+    stack_allocator->committed_end       = base;
+    stack_allocator->keep_committed      = keep_committed;
+    stack_allocator->is_virtual          = 1;
+    return allocator;
+}
+
+SRALLOC_API srint_t
+sralloc_stack_allocator_committed( srallocator_t* allocator ) {
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    return sr__ptr_diff( stack_allocator->committed_end, stack_allocator->base );
+}
+
+SRALLOC_API void
+sralloc_destroy_stack_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+    SRALLOC_assert( stack_allocator->num_states == 0 );
+    srint_t capacity = sr__ptr_diff( stack_allocator->end, stack_allocator->base );
+    if ( stack_allocator->is_virtual ) {
+        sr__os_unmap( stack_allocator->base, (sruintptr_t)capacity );
+        capacity = 0;
+    }
+
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_stack_t ) + capacity;
+    sralloc_dealloc_sized( stack_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
+
+//  █████╗ ██████╗ ███████╗███╗   ██╗ █████╗
+// ██╔══██╗██╔══██╗██╔════╝████╗  ██║██╔══██╗
+// ███████║██████╔╝█████╗  ██╔██╗ ██║███████║
+// ██╔══██║██╔══██╗██╔══╝  ██║╚██╗██║██╔══██║
+// ██║  ██║██║  ██║███████╗██║ ╚████║██║  ██║
+// ╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚═╝  ╚═══╝╚═╝  ╚═╝
+
+typedef struct sralloc_arena_block {
+    struct sralloc_arena_block* prev;
+    srint_t                     size; // Usable bytes after the header
+} sralloc_arena_block_t;
+
+typedef struct {
+    sralloc_arena_block_t* block;
+    srchar_t*              top;
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t stats;
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    int64_t tracking_sequence; // Allocations from here on are dropped by the pop
+#endif
+} srallocator_arena_state_t;
+
+typedef struct {
+    sralloc_arena_block_t*    block; // Newest block, the one allocations bump in
+    srchar_t*                 top;
+    srchar_t*                 end;
+    srallocator_t*            backing_allocator;
+    srint_t                   next_block_size;
+    srint_t                   growth_factor;
+    srallocator_arena_state_t states[4];
+    srint_t                   num_states;
+} srallocator_arena_t;
+
+// Chains a block with room for at least size bytes, bigger requests get a block of their own size
+static int
+sr__arena_add_block( srallocator_arena_t* arena_allocator, srint_t size ) {
+    srint_t block_size = arena_allocator->next_block_size;
+    if ( block_size < size ) {
+        block_size = size;
+    }
+
+    sralloc_arena_block_t* block = (sralloc_arena_block_t*)sralloc_alloc(
+      arena_allocator->backing_allocator, sizeof( sralloc_arena_block_t ) + block_size );
+    if ( block == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    block->prev                = arena_allocator->block;
+    block->size                = block_size;
+    arena_allocator->block     = block;
+    arena_allocator->top       = (srchar_t*)( block + 1 );
+    arena_allocator->end       = arena_allocator->top + block_size;
+    if ( block_size == arena_allocator->next_block_size &&
+         block_size <= SRALLOC_ARENA_MAX_BLOCK_SIZE / arena_allocator->growth_factor ) {
+        arena_allocator->next_block_size *= arena_allocator->growth_factor;
+    }
+
+    return 1;
+}
+
+static void
+sr__arena_free_block( srallocator_arena_t* arena_allocator, sralloc_arena_block_t* block ) {
+    sralloc_dealloc_sized( arena_allocator->backing_allocator,
+                           block,
+                           sizeof( sralloc_arena_block_t ) + block->size,
+                           0 );
+}
+
+#ifdef SRALLOC_USE_PREAMBLE
+static sr_result_t
+sralloc_arena_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srint_t preamble_size =
+      sizeof( sralloc_stack_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    if ( size > sr__ptr_diff( arena_allocator->end, arena_allocator->top ) &&
+         !sr__arena_add_block( arena_allocator, size ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size );
+#endif
+
+    srchar_t* unaligned_ptr = arena_allocator->top;
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_stack_preamble_t* preamble = (sralloc_stack_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+    arena_allocator->top = unaligned_ptr + size;
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+// Only the newest allocation gives its memory back, the rest waits for clear or pop_state
+static void
+sralloc_arena_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_arena_t*      arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    sralloc_stack_preamble_t* preamble        = (sralloc_stack_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr   = (srchar_t*)preamble - preamble->offset;
+    srint_t                   size            = sr__preamble_size( preamble, preamble->size );
+    if ( unaligned_ptr + size == arena_allocator->top ) {
+        arena_allocator->top = unaligned_ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+}
+
+static sr_result_t
+sralloc_arena_reallocate( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        wanted_size,
+                          srint_t        align,
+                          int            may_move ) {
+    srallocator_arena_t*      arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    sralloc_stack_preamble_t* preamble        = (sralloc_stack_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr   = (srchar_t*)preamble - preamble->offset;
+    srint_t header_size = preamble->offset + (srint_t)sizeof( sralloc_stack_preamble_t );
+    srint_t old_size    = sr__preamble_size( preamble, preamble->size );
+
+    // The newest allocation grows and shrinks in place while its block has room
+    srint_t size = header_size + wanted_size;
+    if ( unaligned_ptr + old_size == arena_allocator->top &&
+         size <= sr__ptr_diff( arena_allocator->end, unaligned_ptr ) &&
+         sr__preamble_fits( preamble->offset, size ) ) {
+#ifdef SRALLOC_USE_STATS
+        sr__stats_add( allocator, 0, size - old_size );
+#endif
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        arena_allocator->top = unaligned_ptr + size;
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = wanted_size;
+        return res;
+    }
+
+    if ( wanted_size <= old_size - header_size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = old_size - header_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    sr_result_t res = sralloc_arena_allocate( allocator, wanted_size, align );
+    if ( res.ptr != SRALLOC_NULL ) {
+        SRALLOC_memcpy( res.ptr, ptr, old_size - header_size );
+        sralloc_arena_deallocate( allocator, ptr );
+    }
+
+    return res;
+}
+#else
+static sr_result_t
+sralloc_arena_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    srchar_t*            ptr = (srchar_t*)sr__ptr_to_aligned_ptr( arena_allocator->top, align );
+    if ( wanted_size > sr__ptr_diff( arena_allocator->end, ptr ) ) {
+        if ( !sr__arena_add_block( arena_allocator, wanted_size + align ) ) {
+            sr_result_t res = { SRALLOC_NULL, 0 };
+            return res;
+        }
+
+        ptr = (srchar_t*)sr__ptr_to_aligned_ptr( arena_allocator->top, align );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, wanted_size );
+#endif
+
+    arena_allocator->top = ptr + wanted_size;
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_arena_deallocate_sized( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    SRALLOC_UNUSED( align );
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    if ( (srchar_t*)ptr + size == arena_allocator->top ) {
+        arena_allocator->top = (srchar_t*)ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+}
+#endif // SRALLOC_USE_PREAMBLE
+
+SRALLOC_API void
+sralloc_arena_allocator_clear( srallocator_t* allocator ) {
+    srallocator_arena_t*   arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    sralloc_arena_block_t* largest         = arena_allocator->block;
+    for ( sralloc_arena_block_t* block = arena_allocator->block; block != SRALLOC_NULL;
+          block                        = block->prev ) {
+        if ( block->size > largest->size ) {
+            largest = block;
+        }
+    }
+
+    sralloc_arena_block_t* block = arena_allocator->block;
+    while ( block != SRALLOC_NULL ) {
+        sralloc_arena_block_t* prev = block->prev;
+        if ( block != largest ) {
+            sr__arena_free_block( arena_allocator, block );
+        }
+
+        block = prev;
+    }
+
+    // Pushed states may point into the blocks that were just given back
+    arena_allocator->num_states = 0;
+    arena_allocator->block      = largest;
+    if ( largest != SRALLOC_NULL ) {
+        largest->prev        = SRALLOC_NULL;
+        arena_allocator->top = (srchar_t*)( largest + 1 );
+        arena_allocator->end = arena_allocator->top + largest->size;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_reset( allocator );
+    sr__tracking_forget( allocator, SRALLOC_NULL, SRALLOC_NULL, 0 );
+#endif
+}
+
+SRALLOC_API void
+sralloc_arena_allocator_push_state( srallocator_t* allocator ) {
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    SRALLOC_assert(
+      arena_allocator->num_states <
+      ( srint_t )( sizeof( arena_allocator->states ) / sizeof( srallocator_arena_state_t ) ) );
+    srallocator_arena_state_t* state = &arena_allocator->states[arena_allocator->num_states++];
+    state->block                     = arena_allocator->block;
+    state->top                       = arena_allocator->top;
+#ifdef SRALLOC_USE_STATS
+    state->stats = sralloc_get_stats( allocator );
+#endif
+#ifdef SRALLOC_USE_TRACKING
+    state->tracking_sequence = sr__tracking_sequence( allocator );
+#endif
+}
+
+// Blocks chained since the push are given back
+SRALLOC_API void
+sralloc_arena_allocator_pop_state( srallocator_t* allocator ) {
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    SRALLOC_assert( arena_allocator->num_states > 0 );
+    srallocator_arena_state_t* state = &arena_allocator->states[--arena_allocator->num_states];
+    while ( arena_allocator->block != state->block ) {
+        sralloc_arena_block_t* prev = arena_allocator->block->prev;
+        sr__arena_free_block( arena_allocator, arena_allocator->block );
+        arena_allocator->block = prev;
+    }
+
+    arena_allocator->top = state->top;
+    arena_allocator->end = SRALLOC_NULL;
+    if ( state->block != SRALLOC_NULL ) {
+        arena_allocator->end = (srchar_t*)( state->block + 1 ) + state->block->size;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_reset( allocator );
+    allocator->stats = state->stats;
+    sr__tracking_forget( allocator, SRALLOC_NULL, SRALLOC_NULL, state->tracking_sequence );
+#endif
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_arena_allocator( const char*    name,
+                                srallocator_t* parent,
+                                srint_t        block_size,
+                                srint_t        growth_factor ) {
+    SRALLOC_assert( block_size > 0 && growth_factor >= 1 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_arena_t );
+    void*   memory         = sralloc_alloc( parent, allocator_size );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*       allocator       = (srallocator_t*)memory;
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func = sralloc_arena_allocate;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func = sralloc_arena_deallocate;
+    allocator->reallocate_func = sralloc_arena_reallocate;
+#else
+    allocator->deallocate_func       = sr__deallocate_without_size;
+    allocator->deallocate_sized_func = sralloc_arena_deallocate_sized;
+#endif
+    arena_allocator->backing_allocator = parent;
+    arena_allocator->next_block_size   = block_size;
+    arena_allocator->growth_factor     = growth_factor;
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_arena_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_arena_t* arena_allocator = (srallocator_arena_t*)( allocator + 1 );
+    SRALLOC_assert( arena_allocator->num_states == 0 );
+    sralloc_arena_block_t* block = arena_allocator->block;
+    while ( block != SRALLOC_NULL ) {
+        sralloc_arena_block_t* prev = block->prev;
+        sr__arena_free_block( arena_allocator, block );
+        block = prev;
+    }
+
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_arena_t );
+    sralloc_dealloc_sized( arena_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
+
+//  ██████╗ ██████╗ ███╗   ██╗ ██████╗██╗   ██╗██████╗ ██████╗ ███████╗███╗   ██╗████████╗
+// ██╔════╝██╔═══██╗████╗  ██║██╔════╝██║   ██║██╔══██╗██╔══██╗██╔════╝████╗  ██║╚══██╔══╝
+// ██║     ██║   ██║██╔██╗ ██║██║     ██║   ██║██████╔╝██████╔╝█████╗  ██╔██╗ ██║   ██║
+// ██║     ██║   ██║██║╚██╗██║██║     ██║   ██║██╔══██╗██╔══██╗██╔══╝  ██║╚██╗██║   ██║
+// ╚██████╗╚██████╔╝██║ ╚████║╚██████╗╚██████╔╝██║  ██║██║  ██║███████╗██║ ╚████║   ██║
+//  ╚═════╝ ╚═════╝ ╚═╝  ╚═══╝ ╚═════╝ ╚═════╝ ╚═╝  ╚═╝╚═╝  ╚═╝╚══════╝╚═╝  ╚═══╝   ╚═╝
+
+typedef struct {
+    srchar_t* top; // The thread's current sub-block
+    srchar_t* end;
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t stats;
+#endif
+} sralloc_concurrent_frame_shard_t;
+
+typedef struct {
+    srchar_t*                         base;
+    sruintptr_t                       capacity;
+    srallocator_t*                    backing_allocator;
+    sralloc_concurrent_frame_shard_t* shards; // One cache line per thread
+    srchar_t                          padding_before[SR__CACHE_LINE_SIZE];
+    volatile sruintptr_t              top; // Offset from base, shared by all threads
+    srchar_t                          padding_after[SR__CACHE_LINE_SIZE];
+} srallocator_concurrent_frame_t;
+
+static sralloc_concurrent_frame_shard_t*
+sr__concurrent_frame_shard( srallocator_concurrent_frame_t* frame_allocator, srint_t index ) {
+    srchar_t* shard = (srchar_t*)frame_allocator->shards + index * SR__CACHE_LINE_SIZE;
+    return (sralloc_concurrent_frame_shard_t*)shard;
+}
+
+static srchar_t*
+sr__concurrent_frame_grab( srallocator_concurrent_frame_t* frame_allocator, srint_t size ) {
+    sruintptr_t offset = SRALLOC_atomic_fetch_add( &frame_allocator->top, (sruintptr_t)size );
+    if ( offset + size > frame_allocator->capacity ) {
+        // Hand the space back so a smaller request can still use what's left
+        SRALLOC_atomic_fetch_add( &frame_allocator->top, (sruintptr_t)0 - (sruintptr_t)size );
+        return SRALLOC_NULL;
+    }
+
+    return frame_allocator->base + offset;
+}
+
+static sr_result_t
+sralloc_concurrent_frame_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srint_t preamble_size =
+      sizeof( sralloc_stack_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size;
+    size += align;
+    size += preamble_size;
+
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+    sralloc_concurrent_frame_shard_t* shard        = SRALLOC_NULL;
+    srint_t                           thread_index = sr__thread_index();
+    if ( thread_index < SRALLOC_MAX_THREADS ) {
+        shard = sr__concurrent_frame_shard( frame_allocator, thread_index );
+    }
+
+    srchar_t* unaligned_ptr = SRALLOC_NULL;
+    if ( shard != SRALLOC_NULL && size <= sr__ptr_diff( shard->end, shard->top ) ) {
+        unaligned_ptr = shard->top;
+        shard->top += size;
+    }
+    else if ( shard != SRALLOC_NULL && size <= SRALLOC_FRAME_SUB_BLOCK_SIZE / 4 ) {
+        // Whatever is left of the old sub-block is wasted until the next clear
+        unaligned_ptr = sr__concurrent_frame_grab( frame_allocator, SRALLOC_FRAME_SUB_BLOCK_SIZE );
+        if ( unaligned_ptr != SRALLOC_NULL ) {
+            shard->top = unaligned_ptr + size;
+            shard->end = unaligned_ptr + SRALLOC_FRAME_SUB_BLOCK_SIZE;
+        }
+        else {
+            // No room for a whole sub-block, but there may be for this allocation
+            unaligned_ptr = sr__concurrent_frame_grab( frame_allocator, size );
+        }
+    }
+    else {
+        unaligned_ptr = sr__concurrent_frame_grab( frame_allocator, size );
+    }
+
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    if ( shard != SRALLOC_NULL ) {
+        shard->stats.amount_allocated += size;
+        shard->stats.num_allocations++;
+    }
+    else {
+        SRALLOC_atomic_fetch_add( &allocator->stats.amount_allocated, size );
+        SRALLOC_atomic_fetch_add( &allocator->stats.num_allocations, 1 );
+    }
+#endif
+
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_stack_preamble_t* preamble = (sralloc_stack_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_concurrent_frame_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+    sralloc_stack_preamble_t* preamble      = (sralloc_stack_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    srint_t                   size          = sr__preamble_size( preamble, preamble->size );
+    srint_t                   thread_index  = sr__thread_index();
+    if ( thread_index >= SRALLOC_MAX_THREADS ) {
+#ifdef SRALLOC_USE_STATS
+        SRALLOC_atomic_fetch_add( &allocator->stats.amount_allocated, -size );
+        SRALLOC_atomic_fetch_add( &allocator->stats.num_allocations, -1 );
+#endif
+        return;
+    }
+
+    // Memory only comes back on clear, except for the last allocation in this thread's sub-block
+    sralloc_concurrent_frame_shard_t* shard =
+      sr__concurrent_frame_shard( frame_allocator, thread_index );
+    if ( unaligned_ptr + size == shard->top ) {
+        shard->top = unaligned_ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    shard->stats.amount_allocated -= size;
+    shard->stats.num_allocations--;
+#endif
+}
+
+SRALLOC_API void
+sralloc_concurrent_frame_allocator_collect_stats( srallocator_t* allocator ) {
+    SRALLOC_UNUSED( allocator );
+#ifdef SRALLOC_USE_STATS
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+    for ( srint_t i_shard = 0; i_shard < SRALLOC_MAX_THREADS; ++i_shard ) {
+        sralloc_concurrent_frame_shard_t* shard =
+          sr__concurrent_frame_shard( frame_allocator, i_shard );
+        sr__stats_add( allocator, shard->stats.num_allocations, shard->stats.amount_allocated );
+        shard->stats.amount_allocated = 0;
+        shard->stats.num_allocations  = 0;
+    }
+#endif
+}
+
+SRALLOC_API void
+sralloc_concurrent_frame_allocator_clear( srallocator_t* allocator ) {
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+    SRALLOC_memset( frame_allocator->shards, 0, SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE );
+    SRALLOC_atomic_store( &frame_allocator->top, 0 );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_reset( allocator );
+    sr__tracking_forget( allocator, SRALLOC_NULL, SRALLOC_NULL, 0 );
+#endif
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_concurrent_frame_allocator( const char*    name,
+                                                       srallocator_t* parent,
+                                                       srint_t        capacity ) {
+    srint_t allocator_size =
+      sizeof( srallocator_t ) + sizeof( srallocator_concurrent_frame_t ) + capacity;
+    void* memory = sralloc_alloc_aligned( parent, allocator_size, SR__CACHE_LINE_SIZE );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    void* shards = sralloc_alloc_aligned(
+      parent, SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE, SR__CACHE_LINE_SIZE );
+    if ( shards == SRALLOC_NULL ) {
+        sralloc_dealloc_sized( parent, memory, allocator_size, SR__CACHE_LINE_SIZE );
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*                  allocator = (srallocator_t*)memory;
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+
+    SRALLOC_memset(
+      allocator, 0, sizeof( srallocator_t ) + sizeof( srallocator_concurrent_frame_t ) );
+    SRALLOC_memset( shards, 0, SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func           = sralloc_concurrent_frame_allocate;
+    allocator->deallocate_func         = sralloc_concurrent_frame_deallocate;
+    frame_allocator->base              = (srchar_t*)( frame_allocator + 1 );
+    frame_allocator->capacity          = capacity;
+    frame_allocator->backing_allocator = parent;
+    frame_allocator->shards            = (sralloc_concurrent_frame_shard_t*)shards;
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_concurrent_frame_allocator( srallocator_t* allocator ) {
+    sralloc_concurrent_frame_allocator_collect_stats( allocator );
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_concurrent_frame_t* frame_allocator =
+      (srallocator_concurrent_frame_t*)( allocator + 1 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_concurrent_frame_t ) +
+                             frame_allocator->capacity;
+    sralloc_dealloc_sized( frame_allocator->backing_allocator,
+                           frame_allocator->shards,
+                           SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE,
+                           SR__CACHE_LINE_SIZE );
+    sralloc_dealloc_sized(
+      frame_allocator->backing_allocator, allocator, allocator_size, SR__CACHE_LINE_SIZE );
+}
+
+// ███╗   ███╗██╗   ██╗██╗     ████████╗██╗███████╗██████╗  █████╗ ███╗   ███╗███████╗
+// ████╗ ████║██║   ██║██║     ╚══██╔══╝██║██╔════╝██╔══██╗██╔══██╗████╗ ████║██╔════╝
+// ██╔████╔██║██║   ██║██║        ██║   ██║█████╗  ██████╔╝███████║██╔████╔██║█████╗
+// ██║╚██╔╝██║██║   ██║██║        ██║   ██║██╔══╝  ██╔══██╗██╔══██║██║╚██╔╝██║██╔══╝
+// ██║ ╚═╝ ██║╚██████╔╝███████╗   ██║   ██║██║     ██║  ██║██║  ██║██║ ╚═╝ ██║███████╗
+// ╚═╝     ╚═╝ ╚═════╝ ╚══════╝   ╚═╝   ╚═╝╚═╝     ╚═╝  ╚═╝╚═╝  ╚═╝╚═╝     ╚═╝╚══════╝
+
+typedef struct {
+    srchar_t* base;
+    srchar_t* top;
+    srchar_t* end;
+    srint_t   num_allocations;
+    srint_t   amount_allocated;
+    srint_t   high_water;
+} sralloc_frame_buffer_t;
+
+typedef struct {
+    srallocator_t*          backing_allocator;
+    sralloc_frame_buffer_t* buffers;
+    srint_t                 num_buffers;
+    srint_t                 current;
+    srint_t                 buffer_capacity;
+} srallocator_multi_frame_t;
+
+static sralloc_frame_buffer_t*
+sr__multi_frame_buffer_of( srallocator_multi_frame_t* frame_allocator, void* ptr ) {
+    for ( srint_t i_buffer = 0; i_buffer < frame_allocator->num_buffers; ++i_buffer ) {
+        sralloc_frame_buffer_t* buffer = &frame_allocator->buffers[i_buffer];
+        if ( (srchar_t*)ptr >= buffer->base && (srchar_t*)ptr < buffer->end ) {
+            return buffer;
+        }
+    }
+
+    SRALLOC_assert( 0 );
+    return SRALLOC_NULL;
+}
+
+// Moves top up, the high-water mark has to follow every time since frees can move it back down
+static void
+sr__multi_frame_set_top( sralloc_frame_buffer_t* buffer, srchar_t* top ) {
+    buffer->top = top;
+    if ( sr__ptr_diff( top, buffer->base ) > buffer->high_water ) {
+        buffer->high_water = sr__ptr_diff( top, buffer->base );
+    }
+}
+
+// Only the newest allocation of the current frame gives its memory back, the rest waits for
+// its buffer to come around again
+static void
+sr__multi_frame_release( srallocator_t* allocator, void* unaligned_ptr, srint_t size ) {
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+    sralloc_frame_buffer_t* buffer = sr__multi_frame_buffer_of( frame_allocator, unaligned_ptr );
+    buffer->num_allocations--;
+    buffer->amount_allocated -= size;
+    if ( (srchar_t*)unaligned_ptr + size == buffer->top &&
+         buffer == &frame_allocator->buffers[frame_allocator->current] ) {
+        buffer->top = (srchar_t*)unaligned_ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+}
+
+#ifdef SRALLOC_USE_PREAMBLE
+static sr_result_t
+sralloc_multi_frame_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srint_t preamble_size =
+      sizeof( sralloc_stack_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+    sralloc_frame_buffer_t*    buffer = &frame_allocator->buffers[frame_allocator->current];
+    if ( size > sr__ptr_diff( buffer->end, buffer->top ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    buffer->num_allocations++;
+    buffer->amount_allocated += size;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size );
+#endif
+
+    srchar_t* unaligned_ptr = buffer->top;
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_stack_preamble_t* preamble = (sralloc_stack_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+    sr__multi_frame_set_top( buffer, unaligned_ptr + size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_multi_frame_deallocate( srallocator_t* allocator, void* ptr ) {
+    sralloc_stack_preamble_t* preamble      = (sralloc_stack_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    sr__multi_frame_release(
+      allocator, unaligned_ptr, sr__preamble_size( preamble, preamble->size ) );
+}
+#else
+static sr_result_t
+sralloc_multi_frame_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+    sralloc_frame_buffer_t*    buffer = &frame_allocator->buffers[frame_allocator->current];
+    srchar_t*                  ptr    = (srchar_t*)sr__ptr_to_aligned_ptr( buffer->top, align );
+    if ( wanted_size > sr__ptr_diff( buffer->end, ptr ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    buffer->num_allocations++;
+    buffer->amount_allocated += wanted_size;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, wanted_size );
+#endif
+
+    sr__multi_frame_set_top( buffer, ptr + wanted_size );
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_multi_frame_deallocate_sized( srallocator_t* allocator,
+                                      void*          ptr,
+                                      srint_t        size,
+                                      srint_t        align ) {
+    SRALLOC_UNUSED( align );
+    sr__multi_frame_release( allocator, ptr, size );
+}
+#endif // SRALLOC_USE_PREAMBLE
+
+SRALLOC_API void
+sralloc_multi_frame_allocator_advance_frame( srallocator_t* allocator ) {
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+    frame_allocator->current = ( frame_allocator->current + 1 ) % frame_allocator->num_buffers;
+
+    // Whatever is still allocated in the oldest buffer goes away with it
+    sralloc_frame_buffer_t* buffer = &frame_allocator->buffers[frame_allocator->current];
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -buffer->num_allocations, -buffer->amount_allocated );
+    sr__tracking_forget( allocator, buffer->base, buffer->top, 0 );
+#endif
+    buffer->top              = buffer->base;
+    buffer->num_allocations  = 0;
+    buffer->amount_allocated = 0;
+}
+
+SRALLOC_API sralloc_frame_buffer_stats_t
+sralloc_multi_frame_allocator_buffer_stats( srallocator_t* allocator, srint_t frames_ago ) {
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+    SRALLOC_assert( frames_ago >= 0 && frames_ago < frame_allocator->num_buffers );
+    srint_t i_buffer = ( frame_allocator->current + frame_allocator->num_buffers - frames_ago ) %
+                       frame_allocator->num_buffers;
+    sralloc_frame_buffer_t* buffer = &frame_allocator->buffers[i_buffer];
+
+    sralloc_frame_buffer_stats_t stats;
+    stats.num_allocations  = buffer->num_allocations;
+    stats.amount_allocated = buffer->amount_allocated;
+    stats.used             = sr__ptr_diff( buffer->top, buffer->base );
+    stats.high_water       = buffer->high_water;
+    stats.capacity         = frame_allocator->buffer_capacity;
+    return stats;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_multi_frame_allocator( const char*    name,
+                                      srallocator_t* parent,
+                                      srint_t        num_buffers,
+                                      srint_t        buffer_capacity ) {
+    SRALLOC_assert( num_buffers > 0 );
+    srint_t header_size = sizeof( srallocator_t ) + sizeof( srallocator_multi_frame_t ) +
+                          num_buffers * (srint_t)sizeof( sralloc_frame_buffer_t );
+    void* memory = sralloc_alloc( parent, header_size + num_buffers * buffer_capacity );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*             allocator       = (srallocator_t*)memory;
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, header_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func = sralloc_multi_frame_allocate;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func = sralloc_multi_frame_deallocate;
+#else
+    allocator->deallocate_func       = sr__deallocate_without_size;
+    allocator->deallocate_sized_func = sralloc_multi_frame_deallocate_sized;
+#endif
+    frame_allocator->backing_allocator = parent;
+    frame_allocator->buffers           = (sralloc_frame_buffer_t*)( frame_allocator + 1 );
+    frame_allocator->num_buffers       = num_buffers;
+    frame_allocator->buffer_capacity   = buffer_capacity;
+
+    srchar_t* buffer_memory = (srchar_t*)memory + header_size;
+    for ( srint_t i_buffer = 0; i_buffer < num_buffers; ++i_buffer ) {
+        sralloc_frame_buffer_t* buffer = &frame_allocator->buffers[i_buffer];
+        buffer->base                   = buffer_memory + i_buffer * buffer_capacity;
+        buffer->top                    = buffer->base;
+        buffer->end                    = buffer->base + buffer_capacity;
+    }
+
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_multi_frame_allocator( srallocator_t* allocator ) {
+    srallocator_multi_frame_t* frame_allocator = (srallocator_multi_frame_t*)( allocator + 1 );
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    // Buffers don't need to be empty, frame allocations are never expected to be freed one by one
+    srint_t allocator_size =
+      sizeof( srallocator_t ) + sizeof( srallocator_multi_frame_t ) +
+      frame_allocator->num_buffers *
+        ( (srint_t)sizeof( sralloc_frame_buffer_t ) + frame_allocator->buffer_capacity );
+    sralloc_dealloc_sized( frame_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
+
+// ██████╗ ██╗███╗   ██╗ ██████╗
+// ██╔══██╗██║████╗  ██║██╔════╝
+// ██████╔╝██║██╔██╗ ██║██║  ███╗
+// ██╔══██╗██║██║╚██╗██║██║   ██║
+// ██║  ██║██║██║ ╚████║╚██████╔╝
+// ╚═╝  ╚═╝╚═╝╚═╝  ╚═══╝ ╚═════╝
+
+typedef struct {
+    sruintptr_t end;  // Ring position right after the block, where freeing it moves the tail
+    srint_t     size; // Ring bytes the block takes, including what was skipped to fit it
+} sralloc_ring_header_t;
+
+// Head and tail are positions in [0, 2 * capacity), so a full ring can be told from an empty one.
+// They sit on separate cache lines since the producer and consumer threads each write one.
+typedef struct {
+    sruintptr_t    head;
+    srchar_t       head_padding[SR__CACHE_LINE_SIZE - sizeof( sruintptr_t )];
+    sruintptr_t    tail;
+    srchar_t       tail_padding[SR__CACHE_LINE_SIZE - sizeof( sruintptr_t )];
+    srchar_t*      base;
+    sruintptr_t    capacity;
+    int            flags;
+    srallocator_t* backing_allocator;
+} srallocator_ring_t;
+
+static void
+sr__ring_stats_add( srallocator_t* allocator, srint_t num, srint_t amount ) {
+    SRALLOC_UNUSED( allocator, num, amount );
+#ifdef SRALLOC_USE_STATS
+#ifndef SRALLOC_ENABLE_SHARDED_STATS
+    // The producer and consumer count into the same stats
+    srallocator_ring_t* ring_allocator = (srallocator_ring_t*)( allocator + 1 );
+    if ( ring_allocator->flags & SRALLOC_RING_SPSC ) {
+        SRALLOC_atomic_fetch_add( &allocator->stats.num_allocations, num );
+        SRALLOC_atomic_fetch_add( &allocator->stats.amount_allocated, amount );
+#ifdef SRALLOC_USE_EXTENDED_STATS
+        // Only the producer allocates, so it's the only one moving the peaks
+        sr__stats_track_peaks( allocator, num, amount );
+#endif
+        return;
+    }
+#endif
+    sr__stats_add( allocator, num, amount );
+#endif
+}
+
+static sr_result_t
+sralloc_ring_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_ring_t* ring_allocator = (srallocator_ring_t*)( allocator + 1 );
+    sruintptr_t         capacity       = ring_allocator->capacity;
+    sruintptr_t         head           = ring_allocator->head;
+    sruintptr_t         tail           = ( ring_allocator->flags & SRALLOC_RING_SPSC )
+                                           ? SRALLOC_atomic_load( &ring_allocator->tail )
+                                           : ring_allocator->tail;
+
+    // An empty ring starts over from the beginning, so a block doesn't need to skip the end.
+    // With SRALLOC_RING_SPSC the consumer owns the tail, so that ring keeps going around.
+    sruintptr_t used = ( head + 2 * capacity - tail ) % ( 2 * capacity );
+    if ( used == 0 && !( ring_allocator->flags & SRALLOC_RING_SPSC ) ) {
+        head                 = 0;
+        ring_allocator->tail = 0;
+    }
+
+    // Without the mirror a block that would run past the end skips to the start of the ring
+    sruintptr_t pos    = head % capacity;
+    sruintptr_t needed = sizeof( sralloc_ring_header_t ) + (sruintptr_t)( wanted_size + align );
+    sruintptr_t skipped = 0;
+    if ( !( ring_allocator->flags & SRALLOC_RING_MIRRORED ) && pos + needed > capacity ) {
+        skipped = capacity - pos;
+    }
+
+    if ( skipped + needed > capacity - used ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    srchar_t* start = ring_allocator->base + ( pos + skipped ) % capacity;
+    srchar_t* ptr =
+      sr__aligned_ptr_after_preamble( start, sizeof( sralloc_ring_header_t ), align );
+    sralloc_ring_header_t* header = (sralloc_ring_header_t*)ptr - 1;
+    header->size                  = (srint_t)( skipped + needed );
+    header->end                   = ( head + skipped + needed ) % ( 2 * capacity );
+    ring_allocator->head          = header->end;
+    sr__ring_stats_add( allocator, 1, header->size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_ring_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_ring_t*    ring_allocator = (srallocator_ring_t*)( allocator + 1 );
+    sralloc_ring_header_t* header         = (sralloc_ring_header_t*)ptr - 1;
+    sruintptr_t            capacity       = ring_allocator->capacity;
+    SRALLOC_assert( ( header->end + 2 * capacity - (sruintptr_t)header->size ) % ( 2 * capacity ) ==
+                    ring_allocator->tail );
+    sr__ring_stats_add( allocator, -1, -header->size );
+    if ( ring_allocator->flags & SRALLOC_RING_SPSC ) {
+        SRALLOC_atomic_store( &ring_allocator->tail, header->end );
+    }
+    else {
+        ring_allocator->tail = header->end;
+    }
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_ring_allocator( const char*    name,
+                               srallocator_t* parent,
+                               srint_t        capacity,
+                               int            flags ) {
+    SRALLOC_assert( capacity > 0 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_ring_t );
+    srchar_t* base         = SRALLOC_NULL;
+    if ( flags & SRALLOC_RING_MIRRORED ) {
+        capacity = ( capacity + SR__MIRROR_GRANULARITY - 1 ) &
+                   ~( (srint_t)SR__MIRROR_GRANULARITY - 1 );
+        base = (srchar_t*)sr__os_map_mirrored( (sruintptr_t)capacity );
+        if ( base == SRALLOC_NULL ) {
+            return SRALLOC_NULL;
+        }
+    }
+    else {
+        allocator_size += capacity;
+    }
+
+    void* memory = sralloc_alloc_aligned( parent, allocator_size, SR__CACHE_LINE_SIZE );
+    if ( memory == SRALLOC_NULL ) {
+        if ( base != SRALLOC_NULL ) {
+            sr__os_unmap_mirrored( base, (sruintptr_t)capacity );
+        }
+
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*      allocator      = (srallocator_t*)memory;
+    srallocator_ring_t* ring_allocator = (srallocator_ring_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, sizeof( srallocator_t ) + sizeof( srallocator_ring_t ) );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func   = sralloc_ring_allocate;
+    allocator->deallocate_func = sralloc_ring_deallocate;
+    ring_allocator->base     = base != SRALLOC_NULL ? base : (srchar_t*)( ring_allocator + 1 );
+    ring_allocator->capacity = (sruintptr_t)capacity;
+    ring_allocator->flags    = flags;
+    ring_allocator->backing_allocator = parent;
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_ring_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_ring_t* ring_allocator = (srallocator_ring_t*)( allocator + 1 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_ring_t );
+    if ( ring_allocator->flags & SRALLOC_RING_MIRRORED ) {
+        sr__os_unmap_mirrored( ring_allocator->base, ring_allocator->capacity );
+    }
+    else {
+        allocator_size += (srint_t)ring_allocator->capacity;
+    }
+
+    sralloc_dealloc_sized(
+      ring_allocator->backing_allocator, allocator, allocator_size, SR__CACHE_LINE_SIZE );
+}
+
+// ██████╗ ██╗   ██╗██████╗ ██████╗ ██╗   ██╗
+// ██╔══██╗██║   ██║██╔══██╗██╔══██╗╚██╗ ██╔╝
+// ██████╔╝██║   ██║██║  ██║██║  ██║ ╚████╔╝
+// ██╔══██╗██║   ██║██║  ██║██║  ██║  ╚██╔╝
+// ██████╔╝╚██████╔╝██████╔╝██████╔╝   ██║
+// ╚═════╝  ╚═════╝ ╚═════╝ ╚═════╝    ╚═╝
+
+#define SR__BUDDY_MAX_LEVELS 48
+
+// Free blocks are kept in doubly linked lists per level so a buddy can be unlinked when merging
+typedef struct sralloc_buddy_block {
+    struct sralloc_buddy_block* next;
+    struct sralloc_buddy_block* prev;
+} sralloc_buddy_block_t;
+
+// Level 0 is the whole region, each level below halves the block size. Nodes are numbered
+// breadth first, so the children of node n are 2n + 1 and 2n + 2.
+typedef struct {
+    srchar_t*              base;
+    srallocator_t*         backing_allocator;
+    srint_t                capacity;
+    srint_t                capacity_shift; // log2 of capacity
+    srint_t                max_level;      // The level of min_block_size blocks
+    srint_t                align;          // Alignment of base, the most a block can be aligned to
+    srint_t                free;
+    sralloc_buddy_block_t* free_lists[SR__BUDDY_MAX_LEVELS];
+    srint_t                num_free_blocks[SR__BUDDY_MAX_LEVELS];
+    unsigned char*         split_bits; // Per parent node, set while it's split into two blocks
+    unsigned char*         pair_bits;  // Per parent node, set when exactly one child is free
+} srallocator_buddy_t;
+
+static srint_t
+sr__buddy_bitmap_size( srint_t max_level ) {
+    return ( ( (srint_t)1 << max_level ) + 7 ) / 8;
+}
+
+// Returns the bit's new value
+static int
+sr__buddy_flip( unsigned char* bits, srint_t node ) {
+    bits[node >> 3] ^= (unsigned char)( 1 << ( node & 7 ) );
+    return ( bits[node >> 3] >> ( node & 7 ) ) & 1;
+}
+
+static srint_t
+sr__buddy_node( srallocator_buddy_t* buddy_allocator, void* block, srint_t level ) {
+    srint_t offset = sr__ptr_diff( block, buddy_allocator->base );
+    return ( (srint_t)1 << level ) - 1 + ( offset >> ( buddy_allocator->capacity_shift - level ) );
+}
+
+static void
+sr__buddy_push( srallocator_buddy_t* buddy_allocator, void* ptr, srint_t level ) {
+    sralloc_buddy_block_t* block = (sralloc_buddy_block_t*)ptr;
+    block->prev                  = SRALLOC_NULL;
+    block->next                  = buddy_allocator->free_lists[level];
+    if ( block->next != SRALLOC_NULL ) {
+        block->next->prev = block;
+    }
+
+    buddy_allocator->free_lists[level] = block;
+    ++buddy_allocator->num_free_blocks[level];
+}
+
+static void
+sr__buddy_unlink( srallocator_buddy_t* buddy_allocator, void* ptr, srint_t level ) {
+    sralloc_buddy_block_t* block = (sralloc_buddy_block_t*)ptr;
+    if ( block->prev != SRALLOC_NULL ) {
+        block->prev->next = block->next;
+    }
+    else {
+        buddy_allocator->free_lists[level] = block->next;
+    }
+
+    if ( block->next != SRALLOC_NULL ) {
+        block->next->prev = block->prev;
+    }
+
+    --buddy_allocator->num_free_blocks[level];
+}
+
+// Walks down the split nodes to the level of the block starting at ptr
+static srint_t
+sr__buddy_level_of( srallocator_buddy_t* buddy_allocator, void* ptr, srint_t* out_node ) {
+    srint_t offset = sr__ptr_diff( ptr, buddy_allocator->base );
+    SRALLOC_assert( offset >= 0 && offset < buddy_allocator->capacity );
+    srint_t level = 0;
+    srint_t node  = 0;
+    while ( level < buddy_allocator->max_level &&
+            ( ( buddy_allocator->split_bits[node >> 3] >> ( node & 7 ) ) & 1 ) ) {
+        ++level;
+        node = node * 2 + 1 + ( ( offset >> ( buddy_allocator->capacity_shift - level ) ) & 1 );
+    }
+
+    SRALLOC_assert( ( offset & ( ( buddy_allocator->capacity >> level ) - 1 ) ) == 0 );
+    *out_node = node;
+    return level;
+}
+
+static sr_result_t
+sralloc_buddy_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_buddy_t* buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+    srint_t              size            = wanted_size > align ? wanted_size : align;
+    srint_t              level           = buddy_allocator->max_level;
+    srint_t              block_size      = buddy_allocator->capacity >> level;
+    while ( block_size < size && level > 0 ) {
+        block_size <<= 1;
+        --level;
+    }
+
+    srint_t found = level;
+    while ( found >= 0 && buddy_allocator->free_lists[found] == SRALLOC_NULL ) {
+        --found;
+    }
+
+    if ( block_size < size || align > buddy_allocator->align || found < 0 ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    sralloc_buddy_block_t* block = buddy_allocator->free_lists[found];
+    srint_t                node  = sr__buddy_node( buddy_allocator, block, found );
+    sr__buddy_unlink( buddy_allocator, block, found );
+    if ( found > 0 ) {
+        sr__buddy_flip( buddy_allocator->pair_bits, ( node - 1 ) / 2 );
+    }
+
+    // Split down to the wanted level, the upper halves are left free
+    for ( ; found < level; ++found ) {
+        sr__buddy_flip( buddy_allocator->split_bits, node );
+        sr__buddy_flip( buddy_allocator->pair_bits, node );
+        srchar_t* upper_half = (srchar_t*)block + ( buddy_allocator->capacity >> ( found + 1 ) );
+        sr__buddy_push( buddy_allocator, upper_half, found + 1 );
+        node = node * 2 + 1;
+    }
+
+    buddy_allocator->free -= block_size;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, block_size );
+#endif
+
+    sr_result_t res;
+    res.ptr  = (void*)block;
+    res.size = block_size;
+    return res;
+}
+
+static void
+sralloc_buddy_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_buddy_t* buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+    srint_t              node;
+    srint_t              level      = sr__buddy_level_of( buddy_allocator, ptr, &node );
+    srint_t              block_size = buddy_allocator->capacity >> level;
+    buddy_allocator->free += block_size;
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -block_size );
+#endif
+
+    // Merge with the buddy for as long as it's free too, which is when the pair bit goes to zero
+    srchar_t* block = (srchar_t*)ptr;
+    while ( level > 0 && !sr__buddy_flip( buddy_allocator->pair_bits, ( node - 1 ) / 2 ) ) {
+        srint_t   is_left     = node & 1;
+        srchar_t* buddy_block = is_left ? block + block_size : block - block_size;
+        sr__buddy_unlink( buddy_allocator, buddy_block, level );
+        if ( !is_left ) {
+            block = buddy_block;
+        }
+
+        node = ( node - 1 ) / 2;
+        --level;
+        block_size <<= 1;
+        sr__buddy_flip( buddy_allocator->split_bits, node );
+    }
+
+    sr__buddy_push( buddy_allocator, block, level );
+}
+
+// Grows into the rest of the block, anything more moves
+static sr_result_t
+sralloc_buddy_reallocate( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        wanted_size,
+                          srint_t        align,
+                          int            may_move ) {
+    srallocator_buddy_t* buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+    srint_t              node;
+    srint_t              level      = sr__buddy_level_of( buddy_allocator, ptr, &node );
+    srint_t              block_size = buddy_allocator->capacity >> level;
+    if ( wanted_size <= block_size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = block_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    return sr__reallocate_by_moving( allocator, ptr, block_size, wanted_size, align );
+}
+
+SRALLOC_API sralloc_buddy_stats_t
+sralloc_buddy_allocator_stats( srallocator_t* allocator ) {
+    srallocator_buddy_t*  buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+    sralloc_buddy_stats_t stats           = { 0, 0, 0, 0 };
+    stats.capacity                        = buddy_allocator->capacity;
+    stats.free                            = buddy_allocator->free;
+    for ( srint_t level = buddy_allocator->max_level; level >= 0; --level ) {
+        stats.num_free_blocks += buddy_allocator->num_free_blocks[level];
+        if ( buddy_allocator->free_lists[level] != SRALLOC_NULL ) {
+            stats.largest_free_block = buddy_allocator->capacity >> level;
+        }
+    }
+
+    return stats;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_buddy_allocator( const char*    name,
+                                srallocator_t* parent,
+                                srint_t        capacity,
+                                srint_t        min_block_size ) {
+    SRALLOC_assert( capacity > 0 && ( capacity & ( capacity - 1 ) ) == 0 );
+    SRALLOC_assert( min_block_size >= (srint_t)sizeof( sralloc_buddy_block_t ) );
+    SRALLOC_assert( min_block_size <= capacity );
+    SRALLOC_assert( ( min_block_size & ( min_block_size - 1 ) ) == 0 );
+    srint_t max_level = 0;
+    while ( ( min_block_size << max_level ) < capacity ) {
+        ++max_level;
+    }
+
+    SRALLOC_assert( max_level < SR__BUDDY_MAX_LEVELS );
+    srint_t bitmap_size    = sr__buddy_bitmap_size( max_level );
+    srint_t allocator_size =
+      sizeof( srallocator_t ) + sizeof( srallocator_buddy_t ) + bitmap_size * 2;
+    void* memory = sralloc_alloc( parent, allocator_size );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srint_t   align = capacity < SRALLOC_PAGE_SIZE ? capacity : SRALLOC_PAGE_SIZE;
+    srchar_t* base  = (srchar_t*)sralloc_alloc_aligned( parent, capacity, align );
+    if ( base == SRALLOC_NULL ) {
+        sralloc_dealloc_sized( parent, memory, allocator_size, 0 );
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*       allocator       = (srallocator_t*)memory;
+    srallocator_buddy_t* buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func   = sralloc_buddy_allocate;
+    allocator->deallocate_func = sralloc_buddy_deallocate;
+    allocator->reallocate_func = sralloc_buddy_reallocate;
+
+    buddy_allocator->base              = base;
+    buddy_allocator->backing_allocator = parent;
+    buddy_allocator->capacity          = capacity;
+    buddy_allocator->max_level         = max_level;
+    buddy_allocator->align             = align;
+    buddy_allocator->free              = capacity;
+    buddy_allocator->split_bits        = (unsigned char*)( buddy_allocator + 1 );
+    buddy_allocator->pair_bits         = buddy_allocator->split_bits + bitmap_size;
+    while ( ( (srint_t)1 << buddy_allocator->capacity_shift ) < capacity ) {
+        ++buddy_allocator->capacity_shift;
+    }
+
+    sr__buddy_push( buddy_allocator, base, 0 );
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_buddy_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_buddy_t* buddy_allocator = (srallocator_buddy_t*)( allocator + 1 );
+    srallocator_t*       backing         = buddy_allocator->backing_allocator;
+    sralloc_dealloc_sized(
+      backing, buddy_allocator->base, buddy_allocator->capacity, buddy_allocator->align );
+
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_buddy_t ) +
+                             sr__buddy_bitmap_size( buddy_allocator->max_level ) * 2;
+    sralloc_dealloc_sized( backing, allocator, allocator_size, 0 );
+}
+
+// ████████╗██╗     ███████╗███████╗
+// ╚══██╔══╝██║     ██╔════╝██╔════╝
+//    ██║   ██║     ███████╗█████╗
+//    ██║   ██║     ╚════██║██╔══╝
+//    ██║   ███████╗███████║██║
+//    ╚═╝   ╚══════╝╚══════╝╚═╝
+
+// Block sizes are split into power-of-two first level ranges, each split into SR__TLSF_SL_COUNT
+// second level lists. Sizes below SR__TLSF_SMALL_SIZE all go in the first range, in steps of
+// SR__TLSF_ALIGN.
+#define SR__TLSF_SL_LOG2 5
+#define SR__TLSF_SL_COUNT ( 1 << SR__TLSF_SL_LOG2 )
+#define SR__TLSF_ALIGN ( 2 * (srint_t)sizeof( void* ) )
+#define SR__TLSF_ALIGN_LOG2 ( sizeof( void* ) == 8 ? 4 : 3 )
+#define SR__TLSF_SMALL_SIZE ( SR__TLSF_SL_COUNT * SR__TLSF_ALIGN )
+#define SR__TLSF_FL_SHIFT ( SR__TLSF_SL_LOG2 + SR__TLSF_ALIGN_LOG2 )
+#ifdef SRALLOC_64BIT_SIZES
+#define SR__TLSF_FL_COUNT 32
+#else
+#define SR__TLSF_FL_COUNT 24
+#endif
+
+// Flags in the low bits of the size
+#define SR__TLSF_FREE 1
+#define SR__TLSF_PREV_FREE 2
+
+// The header is the first two fields, the free list links are only there while the block is free
+typedef struct sralloc_tlsf_block {
+    struct sralloc_tlsf_block* prev_phys; // Only valid while the previous block is free
+    sruintptr_t                size;      // Bytes after the header, plus the flags
+    struct sralloc_tlsf_block* next_free;
+    struct sralloc_tlsf_block* prev_free;
+} sralloc_tlsf_block_t;
+
+#define SR__TLSF_HEADER_SIZE SR__TLSF_ALIGN
+
+// Each pool ends with a zero size block that is always in use, so merging stops there
+typedef struct sralloc_tlsf_pool {
+    struct sralloc_tlsf_pool* next;
+    sruintptr_t               size;
+} sralloc_tlsf_pool_t;
+
+typedef struct {
+    srallocator_t*        backing_allocator;
+    sralloc_tlsf_pool_t*  pools;
+    srint_t               pool_size;
+    uint32_t              fl_bitmap;
+    uint32_t              sl_bitmaps[SR__TLSF_FL_COUNT];
+    sralloc_tlsf_block_t* free_lists[SR__TLSF_FL_COUNT][SR__TLSF_SL_COUNT];
+} srallocator_tlsf_t;
+
+static srint_t
+sr__tlsf_size( sralloc_tlsf_block_t* block ) {
+    return (srint_t)( block->size & ~(sruintptr_t)( SR__TLSF_FREE | SR__TLSF_PREV_FREE ) );
+}
+
+static void
+sr__tlsf_set_size( sralloc_tlsf_block_t* block, srint_t size ) {
+    block->size = (sruintptr_t)size | ( block->size & ( SR__TLSF_FREE | SR__TLSF_PREV_FREE ) );
+}
+
+static sralloc_tlsf_block_t*
+sr__tlsf_next( sralloc_tlsf_block_t* block ) {
+    return (sralloc_tlsf_block_t*)( (srchar_t*)block + SR__TLSF_HEADER_SIZE +
+                                    sr__tlsf_size( block ) );
+}
+
+static void
+sr__tlsf_mapping( srint_t size, srint_t* fl, srint_t* sl ) {
+    if ( size < SR__TLSF_SMALL_SIZE ) {
+        *fl = 0;
+        *sl = size / SR__TLSF_ALIGN;
+        return;
+    }
+
+    srint_t log2 = sr__fls64( (uint64_t)size );
+    *sl          = ( size >> ( log2 - SR__TLSF_SL_LOG2 ) ) ^ SR__TLSF_SL_COUNT;
+    *fl          = log2 - SR__TLSF_FL_SHIFT + 1;
+}
+
+static void
+sr__tlsf_insert( srallocator_tlsf_t* tlsf_allocator, sralloc_tlsf_block_t* block ) {
+    srint_t fl, sl;
+    sr__tlsf_mapping( sr__tlsf_size( block ), &fl, &sl );
+    SRALLOC_assert( fl < SR__TLSF_FL_COUNT );
+    sralloc_tlsf_block_t* head = tlsf_allocator->free_lists[fl][sl];
+    block->next_free           = head;
+    block->prev_free           = SRALLOC_NULL;
+    if ( head != SRALLOC_NULL ) {
+        head->prev_free = block;
+    }
+
+    tlsf_allocator->free_lists[fl][sl] = block;
+    tlsf_allocator->fl_bitmap |= 1u << fl;
+    tlsf_allocator->sl_bitmaps[fl] |= 1u << sl;
+}
+
+static void
+sr__tlsf_remove( srallocator_tlsf_t* tlsf_allocator, sralloc_tlsf_block_t* block ) {
+    srint_t fl, sl;
+    sr__tlsf_mapping( sr__tlsf_size( block ), &fl, &sl );
+    if ( block->next_free != SRALLOC_NULL ) {
+        block->next_free->prev_free = block->prev_free;
+    }
+
+    if ( block->prev_free != SRALLOC_NULL ) {
+        block->prev_free->next_free = block->next_free;
+    }
+    else {
+        tlsf_allocator->free_lists[fl][sl] = block->next_free;
+        if ( block->next_free == SRALLOC_NULL ) {
+            tlsf_allocator->sl_bitmaps[fl] &= ~( 1u << sl );
+            if ( tlsf_allocator->sl_bitmaps[fl] == 0 ) {
+                tlsf_allocator->fl_bitmap &= ~( 1u << fl );
+            }
+        }
+    }
+}
+
+// Rounds size up to the next list boundary, any block in the list it maps to is big enough
+static srint_t
+sr__tlsf_round_up( srint_t size ) {
+    if ( size >= SR__TLSF_SMALL_SIZE ) {
+        size += ( (srint_t)1 << ( sr__fls64( (uint64_t)size ) - SR__TLSF_SL_LOG2 ) ) - 1;
+    }
+
+    return size;
+}
+
+// Takes a free block of at least size bytes off its list
+static sralloc_tlsf_block_t*
+sr__tlsf_locate( srallocator_tlsf_t* tlsf_allocator, srint_t size ) {
+    size = sr__tlsf_round_up( size );
+    srint_t fl, sl;
+    sr__tlsf_mapping( size, &fl, &sl );
+    if ( fl >= SR__TLSF_FL_COUNT ) {
+        return SRALLOC_NULL;
+    }
+
+    uint32_t sl_map = tlsf_allocator->sl_bitmaps[fl] & ( ~0u << sl );
+    if ( sl_map == 0 ) {
+        uint32_t fl_map = fl + 1 < 32 ? tlsf_allocator->fl_bitmap & ( ~0u << ( fl + 1 ) ) : 0;
+        if ( fl_map == 0 ) {
+            return SRALLOC_NULL;
+        }
+
+        fl     = sr__ffs32( fl_map );
+        sl_map = tlsf_allocator->sl_bitmaps[fl];
+    }
+
+    sl                          = sr__ffs32( sl_map );
+    sralloc_tlsf_block_t* block = tlsf_allocator->free_lists[fl][sl];
+    sr__tlsf_remove( tlsf_allocator, block );
+    return block;
+}
+
+// Merges block with its free neighbours and puts the result on its free list
+static void
+sr__tlsf_release( srallocator_tlsf_t* tlsf_allocator, sralloc_tlsf_block_t* block ) {
+    if ( block->size & SR__TLSF_PREV_FREE ) {
+        sralloc_tlsf_block_t* prev = block->prev_phys;
+        sr__tlsf_remove( tlsf_allocator, prev );
+        sr__tlsf_set_size(
+          prev, sr__tlsf_size( prev ) + SR__TLSF_HEADER_SIZE + sr__tlsf_size( block ) );
+        block = prev;
+    }
+
+    sralloc_tlsf_block_t* next = sr__tlsf_next( block );
+    if ( next->size & SR__TLSF_FREE ) {
+        sr__tlsf_remove( tlsf_allocator, next );
+        sr__tlsf_set_size(
+          block, sr__tlsf_size( block ) + SR__TLSF_HEADER_SIZE + sr__tlsf_size( next ) );
+        next = sr__tlsf_next( block );
+    }
+
+    block->size |= SR__TLSF_FREE;
+    next->size |= SR__TLSF_PREV_FREE;
+    next->prev_phys = block;
+    sr__tlsf_insert( tlsf_allocator, block );
+}
+
+// Gives the part of a used block past size back, if it's big enough to be a block of its own
+static void
+sr__tlsf_trim( srallocator_tlsf_t* tlsf_allocator, sralloc_tlsf_block_t* block, srint_t size ) {
+    srint_t rest_size = sr__tlsf_size( block ) - size - SR__TLSF_HEADER_SIZE;
+    if ( rest_size < SR__TLSF_ALIGN ) {
+        return;
+    }
+
+    sralloc_tlsf_block_t* rest =
+      (sralloc_tlsf_block_t*)( (srchar_t*)block + SR__TLSF_HEADER_SIZE + size );
+    rest->size = (sruintptr_t)rest_size;
+    sr__tlsf_set_size( block, size );
+    sr__tlsf_release( tlsf_allocator, rest );
+}
+
+// The pool's block has to be big enough for sr__tlsf_locate to find it for size
+static int
+sr__tlsf_add_pool( srallocator_tlsf_t* tlsf_allocator, srint_t size ) {
+    srint_t overhead  = (srint_t)sizeof( sralloc_tlsf_pool_t ) + SR__TLSF_HEADER_SIZE * 2;
+    srint_t pool_size = tlsf_allocator->pool_size;
+    size              = sr__tlsf_round_up( size );
+    if ( pool_size < size + overhead ) {
+        pool_size = ( size + overhead + SR__TLSF_ALIGN - 1 ) & ~( SR__TLSF_ALIGN - 1 );
+    }
+
+    sralloc_tlsf_pool_t* pool = (sralloc_tlsf_pool_t*)sralloc_alloc_aligned(
+      tlsf_allocator->backing_allocator, pool_size, SR__TLSF_ALIGN );
+    if ( pool == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    pool->next             = tlsf_allocator->pools;
+    pool->size             = (sruintptr_t)pool_size;
+    tlsf_allocator->pools  = pool;
+    sralloc_tlsf_block_t* block = (sralloc_tlsf_block_t*)( pool + 1 );
+    block->size                 = (sruintptr_t)( pool_size - overhead );
+    sralloc_tlsf_block_t* end   = sr__tlsf_next( block );
+    end->size                   = 0;
+    sr__tlsf_release( tlsf_allocator, block );
+    return 1;
+}
+
+static sr_result_t
+sralloc_tlsf_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_tlsf_t* tlsf_allocator = (srallocator_tlsf_t*)( allocator + 1 );
+    srint_t             size = ( wanted_size + SR__TLSF_ALIGN - 1 ) & ~( SR__TLSF_ALIGN - 1 );
+
+    // Over-aligned blocks are found with room to split off a free block in front of them
+    srint_t search_size = size;
+    if ( align > SR__TLSF_ALIGN ) {
+        search_size += align + SR__TLSF_HEADER_SIZE + SR__TLSF_ALIGN;
+    }
+
+    sralloc_tlsf_block_t* block = sr__tlsf_locate( tlsf_allocator, search_size );
+    if ( block == SRALLOC_NULL ) {
+        if ( !sr__tlsf_add_pool( tlsf_allocator, search_size ) ) {
+            sr_result_t res = { SRALLOC_NULL, 0 };
+            return res;
+        }
+
+        block = sr__tlsf_locate( tlsf_allocator, search_size );
+    }
+
+    if ( align > SR__TLSF_ALIGN ) {
+        srchar_t* ptr     = (srchar_t*)block + SR__TLSF_HEADER_SIZE;
+        srchar_t* aligned = (srchar_t*)sr__ptr_to_aligned_ptr( ptr, align );
+        srint_t   gap     = sr__ptr_diff( aligned, ptr );
+        if ( gap != 0 && gap < SR__TLSF_HEADER_SIZE + SR__TLSF_ALIGN ) {
+            aligned = (srchar_t*)sr__ptr_to_aligned_ptr(
+              ptr + SR__TLSF_HEADER_SIZE + SR__TLSF_ALIGN, align );
+            gap = sr__ptr_diff( aligned, ptr );
+        }
+
+        if ( gap != 0 ) {
+            sralloc_tlsf_block_t* leading = block;
+            block = (sralloc_tlsf_block_t*)( aligned - SR__TLSF_HEADER_SIZE );
+            block->size      = (sruintptr_t)( sr__tlsf_size( leading ) - gap ) | SR__TLSF_FREE;
+            block->prev_phys = leading;
+            block->size |= SR__TLSF_PREV_FREE;
+            sr__tlsf_set_size( leading, gap - SR__TLSF_HEADER_SIZE );
+            sr__tlsf_insert( tlsf_allocator, leading );
+            sr__tlsf_next( block )->prev_phys = block;
+        }
+    }
+
+    block->size &= ~(sruintptr_t)SR__TLSF_FREE;
+    sr__tlsf_next( block )->size &= ~(sruintptr_t)SR__TLSF_PREV_FREE;
+    sr__tlsf_trim( tlsf_allocator, block, size );
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, sr__tlsf_size( block ) + SR__TLSF_HEADER_SIZE );
+#endif
+
+    sr_result_t res;
+    res.ptr  = (srchar_t*)block + SR__TLSF_HEADER_SIZE;
+    res.size = sr__tlsf_size( block );
+    return res;
+}
+
+static void
+sralloc_tlsf_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_tlsf_t*   tlsf_allocator = (srallocator_tlsf_t*)( allocator + 1 );
+    sralloc_tlsf_block_t* block = (sralloc_tlsf_block_t*)( (srchar_t*)ptr - SR__TLSF_HEADER_SIZE );
+    SRALLOC_assert( ( block->size & SR__TLSF_FREE ) == 0 );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -( sr__tlsf_size( block ) + SR__TLSF_HEADER_SIZE ) );
+#endif
+    sr__tlsf_release( tlsf_allocator, block );
+}
+
+// Grows into the next block when it's free, shrinks by giving the tail back
+static sr_result_t
+sralloc_tlsf_reallocate( srallocator_t* allocator,
+                         void*          ptr,
+                         srint_t        wanted_size,
+                         srint_t        align,
+                         int            may_move ) {
+    srallocator_tlsf_t*   tlsf_allocator = (srallocator_tlsf_t*)( allocator + 1 );
+    sralloc_tlsf_block_t* block = (sralloc_tlsf_block_t*)( (srchar_t*)ptr - SR__TLSF_HEADER_SIZE );
+    sralloc_tlsf_block_t* next  = sr__tlsf_next( block );
+    srint_t               old_size = sr__tlsf_size( block );
+    srint_t               size = ( wanted_size + SR__TLSF_ALIGN - 1 ) & ~( SR__TLSF_ALIGN - 1 );
+    srint_t               available = old_size;
+    if ( next->size & SR__TLSF_FREE ) {
+        available += SR__TLSF_HEADER_SIZE + sr__tlsf_size( next );
+    }
+
+    if ( size > available ) {
+        if ( !may_move ) {
+            sr_result_t res = { SRALLOC_NULL, 0 };
+            return res;
+        }
+
+        return sr__reallocate_by_moving( allocator, ptr, old_size, wanted_size, align );
+    }
+
+    if ( size > old_size ) {
+        sr__tlsf_remove( tlsf_allocator, next );
+        sr__tlsf_set_size( block, available );
+        sr__tlsf_next( block )->size &= ~(sruintptr_t)SR__TLSF_PREV_FREE;
+    }
+
+    sr__tlsf_trim( tlsf_allocator, block, size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 0, sr__tlsf_size( block ) - old_size );
+#endif
+
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = sr__tlsf_size( block );
+    return res;
+}
+
+SRALLOC_API srallocator_t*
+sralloc_create_tlsf_allocator( const char* name, srallocator_t* parent, srint_t pool_size ) {
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_tlsf_t );
+    void*   memory         = sralloc_alloc( parent, allocator_size );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*      allocator      = (srallocator_t*)memory;
+    srallocator_tlsf_t* tlsf_allocator = (srallocator_tlsf_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    tlsf_allocator->backing_allocator = parent;
+    tlsf_allocator->pool_size         = pool_size;
+    if ( !sr__tlsf_add_pool( tlsf_allocator, 0 ) ) {
+        sralloc_dealloc_sized( parent, memory, allocator_size, 0 );
+        return SRALLOC_NULL;
+    }
+
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func   = sralloc_tlsf_allocate;
+    allocator->deallocate_func = sralloc_tlsf_deallocate;
+    allocator->reallocate_func = sralloc_tlsf_reallocate;
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_tlsf_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+#endif
+
+    srallocator_tlsf_t*  tlsf_allocator = (srallocator_tlsf_t*)( allocator + 1 );
+    srallocator_t*       backing        = tlsf_allocator->backing_allocator;
+    sralloc_tlsf_pool_t* pool           = tlsf_allocator->pools;
+    while ( pool != SRALLOC_NULL ) {
+        sralloc_tlsf_pool_t* next = pool->next;
+        sralloc_dealloc_sized( backing, pool, (srint_t)pool->size, SR__TLSF_ALIGN );
+        pool = next;
+    }
+
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_tlsf_t );
+    sralloc_dealloc_sized( backing, allocator, allocator_size, 0 );
+}
+
+// ██████╗ ██████╗  ██████╗ ██╗  ██╗██╗   ██╗
+// ██╔══██╗██╔══██╗██╔═══██╗╚██╗██╔╝╚██╗ ██╔╝
+// ██████╔╝██████╔╝██║   ██║ ╚███╔╝  ╚████╔╝
+// ██╔═══╝ ██╔══██╗██║   ██║ ██╔██╗   ╚██╔╝
+// ██║     ██║  ██║╚██████╔╝██╔╝ ██╗   ██║
+// ╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚═╝  ╚═╝   ╚═╝
+
+typedef struct {
+    srallocator_t* backing_allocator;
+} srallocator_proxy_t;
+
+typedef struct {
+    sralloc_preamble_int_t size;
+    sralloc_preamble_int_t offset;
+} sralloc_proxy_preamble_t;
+
+#ifdef SRALLOC_USE_PREAMBLE
+static sr_result_t
+sralloc_proxy_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t preamble_size =
+      sizeof( sralloc_proxy_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size;
+    size += align;
+    size += preamble_size;
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size );
+#endif
+
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    srchar_t*            unaligned_ptr =
+      (srchar_t*)sralloc_alloc( proxy_allocator->backing_allocator, size );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_proxy_preamble_t* preamble = (sralloc_proxy_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_proxy_deallocate( srallocator_t* allocator, void* ptr ) {
+    SRALLOC_UNUSED( allocator );
+    sralloc_proxy_preamble_t* preamble      = (sralloc_proxy_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    srint_t                   size          = sr__preamble_size( preamble, preamble->size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    sralloc_dealloc_sized( proxy_allocator->backing_allocator, unaligned_ptr, size, 0 );
+}
+
+// Grows in place when the backing allocator can, otherwise moves within the proxy so the
+// alignment of the new block is taken care of.
+static sr_result_t
+sralloc_proxy_reallocate( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        wanted_size,
+                          srint_t        align,
+                          int            may_move ) {
+    srallocator_proxy_t*      proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    srallocator_t*            backing         = proxy_allocator->backing_allocator;
+    sralloc_proxy_preamble_t* preamble        = (sralloc_proxy_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr   = (srchar_t*)preamble - preamble->offset;
+
+    srint_t header_size = preamble->offset + (srint_t)sizeof( sralloc_proxy_preamble_t );
+    srint_t old_size    = sr__preamble_size( preamble, preamble->size );
+    srint_t size        = header_size + wanted_size;
+    if ( backing->reallocate_func != SRALLOC_NULL && sr__preamble_fits( preamble->offset, size ) &&
+         sr__reallocate( backing, unaligned_ptr, size, 0, 0 ).ptr != SRALLOC_NULL ) {
+#ifdef SRALLOC_USE_STATS
+        sr__stats_add( allocator, 0, size - old_size );
+#endif
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = wanted_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    return sr__reallocate_by_moving( allocator, ptr, old_size - header_size, wanted_size, align );
+}
+
+static srint_t
+sralloc_proxy_allocate_batch( srallocator_t* allocator,
+                              srint_t        wanted_size,
+                              srint_t        align,
+                              srint_t        count,
+                              void**         out_ptrs ) {
+    srint_t preamble_size =
+      sizeof( sralloc_proxy_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    // The backing allocator writes its pointers straight into out_ptrs, we adjust them in place
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    srallocator_t*       backing         = proxy_allocator->backing_allocator;
+    srint_t              allocated = sralloc_alloc_batch( backing, size, 0, count, out_ptrs );
+    for ( srint_t i_ptr = 0; i_ptr < allocated; ++i_ptr ) {
+        srchar_t* unaligned_ptr = (srchar_t*)out_ptrs[i_ptr];
+        srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+        sralloc_proxy_preamble_t* preamble = (sralloc_proxy_preamble_t*)ptr - 1;
+        preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+        sr__set_preamble_size( preamble, &preamble->size, size );
+        out_ptrs[i_ptr] = ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, allocated, size * allocated );
+#endif
+    return allocated;
+}
+
+static void
+sralloc_proxy_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    srallocator_proxy_t* proxy_allocator    = (srallocator_proxy_t*)( allocator + 1 );
+    srint_t              amount_deallocated = 0;
+    void*                unaligned_ptrs[SR__BATCH_CHUNK_SIZE];
+    for ( srint_t i_chunk = 0; i_chunk < count; i_chunk += SR__BATCH_CHUNK_SIZE ) {
+        srint_t chunk_count = count - i_chunk;
+        if ( chunk_count > SR__BATCH_CHUNK_SIZE ) {
+            chunk_count = SR__BATCH_CHUNK_SIZE;
+        }
+
+        void** chunk_ptrs = ptrs + i_chunk;
+        for ( srint_t i_ptr = 0; i_ptr < chunk_count; ++i_ptr ) {
+            sralloc_proxy_preamble_t* preamble = (sralloc_proxy_preamble_t*)chunk_ptrs[i_ptr] - 1;
+            unaligned_ptrs[i_ptr]              = (srchar_t*)preamble - preamble->offset;
+            amount_deallocated += sr__preamble_size( preamble, preamble->size );
+        }
+
+        sralloc_dealloc_batch( proxy_allocator->backing_allocator, unaligned_ptrs, chunk_count );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -count, -amount_deallocated );
+#endif
+}
+#else
+// Alignment is left to the backing allocator, which is what lets the proxy go without a preamble
+static sr_result_t
+sralloc_proxy_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    sr_result_t          res =
+      sralloc_alloc_aligned_with_size( proxy_allocator->backing_allocator, wanted_size, align );
+    if ( res.ptr == SRALLOC_NULL ) {
+        return res;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, wanted_size );
+#endif
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_proxy_deallocate_sized( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    sralloc_dealloc_sized( proxy_allocator->backing_allocator, ptr, size, align );
+}
+#endif // SRALLOC_USE_PREAMBLE
+
+SRALLOC_API srallocator_t*
+            sralloc_create_proxy_allocator( const char* name, srallocator_t* parent ) {
+#ifdef SRALLOC_DISABLE_PROXY
+    return parent;
+#endif
+
+    srint_t              allocator_size  = sizeof( srallocator_t ) + sizeof( srallocator_proxy_t );
+    void*                memory          = sralloc_alloc( parent, allocator_size );
+    srallocator_t*       allocator       = (srallocator_t*)memory;
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func = sralloc_proxy_allocate;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func       = sralloc_proxy_deallocate;
+    allocator->allocate_batch_func   = sralloc_proxy_allocate_batch;
+    allocator->deallocate_batch_func = sralloc_proxy_deallocate_batch;
+    allocator->reallocate_func       = sralloc_proxy_reallocate;
+#else
+    allocator->deallocate_func       = sr__deallocate_without_size;
+    allocator->deallocate_sized_func = sralloc_proxy_deallocate_sized;
+#endif
+    proxy_allocator->backing_allocator = parent;
+
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_proxy_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_DISABLE_PROXY
+    return;
+#endif
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+    srint_t              allocator_size  = sizeof( srallocator_t ) + sizeof( srallocator_proxy_t );
+    sralloc_dealloc_sized( proxy_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
+
+// ███████╗███╗   ██╗██████╗          ██████╗ ███████╗   ██████╗  █████╗  ██████╗ ███████╗
+// ██╔════╝████╗  ██║██╔══██╗        ██╔═══██╗██╔════╝   ██╔══██╗██╔══██╗██╔════╝ ██╔════╝
+// █████╗  ██╔██╗ ██║██║  ██║        ██║   ██║█████╗     ██████╔╝███████║██║  ███╗█████╗
+// ██╔══╝  ██║╚██╗██║██║  ██║        ██║   ██║██╔══╝     ██╔═══╝ ██╔══██║██║   ██║██╔══╝
+// ███████╗██║ ╚████║██████╔╝███████╗╚██████╔╝██║███████╗██║     ██║  ██║╚██████╔╝███████╗
+// ╚══════╝╚═╝  ╚═══╝╚═════╝ ╚══════╝ ╚═════╝ ╚═╝╚══════╝╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚══════╝
+
+typedef struct {
+    srallocator_t* backing_allocator;
+} srallocator_end_of_page_t;
+
+typedef struct {
+    sralloc_preamble_int_t size;
+    sralloc_preamble_int_t offset;
+    srmemflag_t            initial_protection;
+    srchar_t*              page_ptr;
+} sralloc_end_of_page_preamble_t;
+
+static sr_result_t
+sralloc_end_of_page_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    SRALLOC_UNUSED( allocator );
+    srint_t preamble_size =
+      sizeof( sralloc_end_of_page_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size_to_allocate = wanted_size;
+    size_to_allocate += align;
+    size_to_allocate += preamble_size;
+    size_to_allocate += SRALLOC_PAGE_SIZE * 2;
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, size_to_allocate );
+#endif
+
+    srallocator_end_of_page_t* end_of_page_allocator =
+      (srallocator_end_of_page_t*)( allocator + 1 );
+    srchar_t* unaligned_ptr =
+      (srchar_t*)sralloc_alloc( end_of_page_allocator->backing_allocator, size_to_allocate );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    srchar_t* page_ptr = (srchar_t*)sr__ptr_to_aligned_ptr(
+      unaligned_ptr + wanted_size + align + preamble_size, SRALLOC_PAGE_SIZE );
+
+    srchar_t*                       ptr      = page_ptr - wanted_size - align;
+    sralloc_end_of_page_preamble_t* preamble = (sralloc_end_of_page_preamble_t*)ptr - 1;
+    preamble->offset   = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    preamble->page_ptr = page_ptr;
+    sr__set_preamble_size( preamble, &preamble->size, size_to_allocate );
+
+    // SRALLOC_assert( sr__ptr_to_aligned_ptr( ptr, align ) == ptr );
+    SRALLOC_PROTECT_MEMORY(
+      page_ptr, SRALLOC_PAGE_SIZE, SRALLOC_MEMPROTECT_FLAG, &preamble->initial_protection );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static void
+sralloc_end_of_page_deallocate( srallocator_t* allocator, void* ptr ) {
+    SRALLOC_UNUSED( allocator );
+    sralloc_end_of_page_preamble_t* preamble      = (sralloc_end_of_page_preamble_t*)ptr - 1;
+    srchar_t*                       unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    srint_t                         size = sr__preamble_size( preamble, preamble->size );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, -size );
+#endif
+    srchar_t*   page_ptr = preamble->page_ptr;
+    srmemflag_t current_protection;
+    SRALLOC_PROTECT_MEMORY(
+      page_ptr, SRALLOC_PAGE_SIZE, preamble->initial_protection, &current_protection );
+
+    srallocator_end_of_page_t* end_of_page_allocator =
+      (srallocator_end_of_page_t*)( allocator + 1 );
+    sralloc_dealloc_sized( end_of_page_allocator->backing_allocator, unaligned_ptr, size, 0 );
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_end_of_page_allocator( const char* name, srallocator_t* parent ) {
+#ifdef SRALLOC_DISABLE_end_of_page
+    return parent;
+#endif
+
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_end_of_page_t );
+    void*          memory         = sralloc_alloc( parent, allocator_size );
+    srallocator_t* allocator      = (srallocator_t*)memory;
+    srallocator_end_of_page_t* end_of_page_allocator =
+      (srallocator_end_of_page_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func                 = sralloc_end_of_page_allocate;
+    allocator->deallocate_func               = sralloc_end_of_page_deallocate;
+    end_of_page_allocator->backing_allocator = parent;
+
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_end_of_page_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srallocator_end_of_page_t* end_of_page_allocator =
+      (srallocator_end_of_page_t*)( allocator + 1 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_end_of_page_t );
+    sralloc_dealloc_sized( end_of_page_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
+
+    // ██╗ ██████╗         ██████╗ ███████╗██████╗ ██╗   ██╗ ██████╗ ██╗  ██╗███████╗ █████╗ ██████╗
+    // ██║██╔════╝         ██╔══██╗██╔════╝██╔══██╗██║   ██║██╔════╝ ██║ ██║██╔════╝██╔══██╗██╔══██╗
+    // ██║██║  ███╗        ██║  ██║█████╗  ██████╔╝██║   ██║██║  ███╗███████║█████╗ ███████║██████╔╝
+    // ██║██║   ██║        ██║  ██║██╔══╝  ██╔══██╗██║   ██║██║   ██║██╔══██║██╔══╝  ██╔══██║██╔═══╝
+    // ██║╚██████╔╝███████╗██████╔╝███████╗██████╔╝╚██████╔╝╚██████╔╝██║  ██║███████╗██║  ██║██║
+    // ╚═╝ ╚═════╝ ╚══════╝╚═════╝ ╚══════╝╚═════╝  ╚═════╝  ╚═════╝ ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝╚═╝
+
+#ifdef SRALLOC_ENABLE_IG_DEBUGHEAP
+
+typedef struct {
+    DebugHeap* debugheap;
+} srallocator_ig_debugheap_t;
+
+typedef struct {
+    srint_t     size;
+    srint_t     offset;
+    srmemflag_t initial_protection;
+    srchar_t*   page_ptr;
+} sralloc_ig_debugheap_preamble_t;
+
+static sr_result_t
+sralloc_ig_debugheap_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_ig_debugheap_t* ig_debugheap_allocator =
+      (srallocator_ig_debugheap_t*)( allocator + 1 );
+
+    void* ptr =
+      DebugHeapAllocate( ig_debugheap_allocator->debugheap, (size_t)wanted_size, (size_t)align );
+
+    srint_t actual_size = (srint_t)DebugHeapGetAllocSize( ig_debugheap_allocator->debugheap, ptr );
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, actual_size );
+#endif
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = actual_size;
+    return res;
+}
+
+static void
+sralloc_ig_debugheap_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_ig_debugheap_t* ig_debugheap_allocator =
+      (srallocator_ig_debugheap_t*)( allocator + 1 );
+
+#ifdef SRALLOC_USE_STATS
+    srint_t actual_size = (srint_t)DebugHeapGetAllocSize( ig_debugheap_allocator->debugheap, ptr );
+    sr__stats_add( allocator, -1, -actual_size );
+#endif
+
+    DebugHeapFree( ig_debugheap_allocator->debugheap, ptr );
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_ig_debugheap_allocator( const char*    name,
+                                                   srallocator_t* parent,
+                                                   sruint_t       capacity ) {
+    DebugHeap* debugheap = DebugHeapInit( (size_t)capacity );
+
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_ig_debugheap_t );
+    void*          memory    = DebugHeapAllocate( debugheap, allocator_size, 64u );
+    srallocator_t* allocator = (srallocator_t*)memory;
+    srallocator_ig_debugheap_t* ig_debugheap_allocator =
+      (srallocator_ig_debugheap_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func          = sralloc_ig_debugheap_allocate;
+    allocator->deallocate_func        = sralloc_ig_debugheap_deallocate;
+    ig_debugheap_allocator->debugheap = debugheap;
+
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_ig_debugheap_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srallocator_ig_debugheap_t* ig_debugheap_allocator =
+      (srallocator_ig_debugheap_t*)( allocator + 1 );
+
+    DebugHeap* debugheap = ig_debugheap_allocator->debugheap;
+    DebugHeapFree( ig_debugheap_allocator->debugheap, allocator );
+    DebugHeapDestroy( debugheap );
+}
+
+#endif //  SRALLOC_ENABLE_IG_DEBUGHEAP
+
+// ███╗   ███╗██╗   ██╗████████╗███████╗██╗  ██╗
+// ████╗ ████║██║   ██║╚══██╔══╝██╔════╝╚██╗██╔╝
+// ██╔████╔██║██║   ██║   ██║   █████╗   ╚███╔╝
+// ██║╚██╔╝██║██║   ██║   ██║   ██╔══╝   ██╔██╗
+// ██║ ╚═╝ ██║╚██████╔╝   ██║   ███████╗██╔╝ ██╗
+// ╚═╝     ╚═╝ ╚═════╝    ╚═╝   ╚══════╝╚═╝  ╚═╝
+
+typedef struct {
+    volatile sruint_t next_ticket;
+    volatile sruint_t now_serving;
+} srspinlock_t;
+
+typedef struct {
+    srallocator_t*       backing_allocator;
+    sralloc_lock_type_t  lock_type;
+    srmutex_t            mutex;
+    srspinlock_t         spinlock;
+    sralloc_lock_stats_t lock_stats;
+} srallocator_mutex_t;
+
+static void
+sr__mutex_allocator_lock( srallocator_mutex_t* mutex_allocator ) {
+    int     contended  = 0;
+    int64_t start_time = 0;
+    if ( mutex_allocator->lock_type == SRALLOC_LOCK_SPINLOCK ) {
+        srspinlock_t* spinlock = &mutex_allocator->spinlock;
+        sruint_t      ticket   = SRALLOC_atomic_fetch_add( &spinlock->next_ticket, 1 );
+        if ( SRALLOC_atomic_load( &spinlock->now_serving ) != ticket ) {
+            contended  = 1;
+            start_time = SRALLOC_time_ns();
+            for ( srint_t spins = 1; SRALLOC_atomic_load( &spinlock->now_serving ) != ticket;
+                  ++spins ) {
+                if ( spins % SRALLOC_SPIN_COUNT == 0 ) {
+                    SRALLOC_thread_yield();
+                }
+                else {
+                    SRALLOC_cpu_pause();
+                }
+            }
+        }
+    }
+    else if ( !SRALLOC_mutex_trylock( &mutex_allocator->mutex ) ) {
+        contended  = 1;
+        start_time = SRALLOC_time_ns();
+        SRALLOC_mutex_lock( &mutex_allocator->mutex );
+    }
+
+    // We own the lock from here on so the counters don't need to be atomic.
+    mutex_allocator->lock_stats.num_acquisitions++;
+    if ( contended ) {
+        mutex_allocator->lock_stats.num_contended++;
+        mutex_allocator->lock_stats.wait_time_ns += SRALLOC_time_ns() - start_time;
+    }
+}
+
+static void
+sr__mutex_allocator_unlock( srallocator_mutex_t* mutex_allocator ) {
+    if ( mutex_allocator->lock_type == SRALLOC_LOCK_SPINLOCK ) {
+        srspinlock_t* spinlock = &mutex_allocator->spinlock;
+        SRALLOC_atomic_store( &spinlock->now_serving, spinlock->now_serving + 1 );
+    }
+    else {
+        SRALLOC_mutex_unlock( &mutex_allocator->mutex );
+    }
+}
+
+static sr_result_t
+sralloc_mutex_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr__mutex_allocator_lock( mutex_allocator );
+
+    // No preamble: the backing allocator is only touched under the lock, so the change in its
+    // stats is exactly what this allocation cost.
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    sr_result_t res = sr__allocate( backing, wanted_size, align );
+#ifdef SRALLOC_USE_STATS
+    if ( res.ptr != SRALLOC_NULL ) {
+        sr__stats_add( allocator, 1, backing_stats->amount_allocated - amount_before );
+    }
+#endif
+
+    sr__mutex_allocator_unlock( mutex_allocator );
+    return res;
+}
+
+static void
+sralloc_mutex_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr__mutex_allocator_lock( mutex_allocator );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    sralloc_dealloc( backing, ptr );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, backing_stats->amount_allocated - amount_before );
+#endif
+    sr__mutex_allocator_unlock( mutex_allocator );
+}
+
+static srint_t
+sralloc_mutex_allocate_batch( srallocator_t* allocator,
+                              srint_t        wanted_size,
+                              srint_t        align,
+                              srint_t        count,
+                              void**         out_ptrs ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr__mutex_allocator_lock( mutex_allocator );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    srint_t allocated = sralloc_alloc_batch( backing, wanted_size, align, count, out_ptrs );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, allocated, backing_stats->amount_allocated - amount_before );
+#endif
+    sr__mutex_allocator_unlock( mutex_allocator );
+    return allocated;
+}
+
+static void
+sralloc_mutex_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr__mutex_allocator_lock( mutex_allocator );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    sralloc_dealloc_batch( backing, ptrs, count );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -count, backing_stats->amount_allocated - amount_before );
+#endif
+    sr__mutex_allocator_unlock( mutex_allocator );
+}
+
+static void
+sralloc_mutex_deallocate_sized( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr__mutex_allocator_lock( mutex_allocator );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    sralloc_dealloc_sized( backing, ptr, size, align );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, backing_stats->amount_allocated - amount_before );
+#endif
+    sr__mutex_allocator_unlock( mutex_allocator );
+}
+
+static sr_result_t
+sralloc_mutex_reallocate( srallocator_t* allocator,
+                          void*          ptr,
+                          srint_t        size,
+                          srint_t        align,
+                          int            may_move ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    srallocator_t*       backing         = mutex_allocator->backing_allocator;
+    sr_result_t          res             = { SRALLOC_NULL, 0 };
+    if ( backing->reallocate_func == SRALLOC_NULL ) {
+        return res;
+    }
+
+    sr__mutex_allocator_lock( mutex_allocator );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    res = sr__reallocate( backing, ptr, size, align, may_move );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 0, backing_stats->amount_allocated - amount_before );
+#endif
+    sr__mutex_allocator_unlock( mutex_allocator );
+    return res;
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_mutex_allocator( const char*         name,
+                                            srallocator_t*      parent,
+                                            sralloc_lock_type_t lock_type ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_mutex_t );
+    void*          memory         = sralloc_alloc_aligned( parent, allocator_size, 64 );
+    srallocator_t* allocator      = (srallocator_t*)memory;
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func           = sralloc_mutex_allocate;
+    allocator->deallocate_func         = sralloc_mutex_deallocate;
+    allocator->allocate_batch_func     = sralloc_mutex_allocate_batch;
+    allocator->deallocate_batch_func   = sralloc_mutex_deallocate_batch;
+    allocator->deallocate_sized_func   = sralloc_mutex_deallocate_sized;
+    allocator->reallocate_func         = sralloc_mutex_reallocate;
+    mutex_allocator->backing_allocator = parent;
+    mutex_allocator->lock_type         = lock_type;
+    SRALLOC_mutex_init( &mutex_allocator->mutex );
+    return allocator;
+}
+
+SRALLOC_API void
+sralloc_destroy_mutex_allocator( srallocator_t* allocator ) {
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    SRALLOC_mutex_destroy( &mutex_allocator->mutex );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_mutex_t );
+    sralloc_dealloc_sized( mutex_allocator->backing_allocator, allocator, allocator_size, 64 );
+}
+
+SRALLOC_API sralloc_lock_stats_t
+            sralloc_mutex_allocator_lock_stats( srallocator_t* allocator ) {
+    srallocator_mutex_t* mutex_allocator = (srallocator_mutex_t*)( allocator + 1 );
+    sr__mutex_allocator_lock( mutex_allocator );
+    sralloc_lock_stats_t lock_stats = mutex_allocator->lock_stats;
+    sr__mutex_allocator_unlock( mutex_allocator );
+    return lock_stats;
+}
+
+// ████████╗ ██████╗ █████╗  ██████╗██╗  ██╗███████╗
+// ╚══██╔══╝██╔════╝██╔══██╗██╔════╝██║  ██║██╔════╝
+//    ██║   ██║     ███████║██║     ███████║█████╗
+//    ██║   ██║     ██╔══██║██║     ██╔══██║██╔══╝
+//    ██║   ╚██████╗██║  ██║╚██████╗██║  ██║███████╗
+//    ╚═╝    ╚═════╝╚═╝  ╚═╝ ╚═════╝╚═╝  ╚═╝╚══════╝
+
+// Size classes up to 1024
+#define SR__TCACHE_NUM_CLASSES 20
+#define SR__TCACHE_MAX_SIZE 1024
+#define SR__TCACHE_HEADER_SIZE 16
+#define SR__TCACHE_UNCACHED -1
 
 typedef struct {
-    srint_t offset;
-    srint_t size;
-} sralloc_malloc_preamble_t;
+    sralloc_preamble_int_t size_class;
+    sralloc_preamble_int_t size;
+    sralloc_preamble_int_t offset;
+} sralloc_thread_cache_preamble_t;
+
+typedef struct {
+    void*   free_list;
+    srint_t count;
+} sralloc_thread_cache_bin_t;
+
+typedef struct {
+    sralloc_thread_cache_bin_t bins[SR__TCACHE_NUM_CLASSES];
+    sralloc_stats_t            stats; // Not yet folded into the allocator's stats
+} sralloc_thread_cache_t;
+
+typedef struct srallocator_thread_cache {
+    srallocator_t*                   backing_allocator;
+    sralloc_thread_cache_t*          caches[SRALLOC_MAX_THREADS];
+    struct srallocator_thread_cache* next; // In sr__thread_caches
+} srallocator_thread_cache_t;
+
+// Every thread cache allocator, so a thread's caches can be flushed when it exits
+static sr__static_mutex_t          sr__thread_caches_mutex = SR__STATIC_MUTEX_INIT;
+static srallocator_thread_cache_t* sr__thread_caches;
+
+static void
+sr__thread_cache_account( srallocator_t*          allocator,
+                          sralloc_thread_cache_t* cache,
+                          srint_t                 num_allocations,
+                          srint_t                 amount_allocated ) {
+    SRALLOC_UNUSED( allocator, cache, num_allocations, amount_allocated );
+#ifdef SRALLOC_USE_STATS
+    if ( cache != SRALLOC_NULL ) {
+        cache->stats.num_allocations += num_allocations;
+        cache->stats.amount_allocated += amount_allocated;
+    }
+    else {
+        SRALLOC_atomic_fetch_add( &allocator->stats.num_allocations, num_allocations );
+        SRALLOC_atomic_fetch_add( &allocator->stats.amount_allocated, amount_allocated );
+    }
+#endif
+}
+
+static void
+sr__thread_cache_fold_stats( srallocator_t* allocator, sralloc_thread_cache_t* cache ) {
+    SRALLOC_UNUSED( allocator, cache );
+#ifdef SRALLOC_USE_STATS
+    SRALLOC_atomic_fetch_add( &allocator->stats.num_allocations, cache->stats.num_allocations );
+    SRALLOC_atomic_fetch_add( &allocator->stats.amount_allocated, cache->stats.amount_allocated );
+    cache->stats.num_allocations  = 0;
+    cache->stats.amount_allocated = 0;
+#endif
+}
+
+static sralloc_thread_cache_t*
+sr__thread_cache_get( srallocator_thread_cache_t* tcache_allocator ) {
+    srint_t thread_index = sr__thread_index();
+    if ( thread_index >= SRALLOC_MAX_THREADS ) {
+        return SRALLOC_NULL;
+    }
+
+    sralloc_thread_cache_t* cache = tcache_allocator->caches[thread_index];
+    if ( cache == SRALLOC_NULL ) {
+        cache = (sralloc_thread_cache_t*)sralloc_alloc_aligned(
+          tcache_allocator->backing_allocator, sizeof( sralloc_thread_cache_t ), 64 );
+        if ( cache != SRALLOC_NULL ) {
+            SRALLOC_memset( cache, 0, sizeof( sralloc_thread_cache_t ) );
+            tcache_allocator->caches[thread_index] = cache;
+        }
+    }
+
+    return cache;
+}
+
+static void
+sr__thread_cache_release_block( srallocator_t* backing, void* ptr, srint_t block_size ) {
+    sralloc_dealloc_sized( backing, (srchar_t*)ptr - SR__TCACHE_HEADER_SIZE, block_size, 16 );
+}
+
+static void
+sr__thread_cache_flush_bin( srallocator_t*              allocator,
+                            srallocator_thread_cache_t* tcache_allocator,
+                            sralloc_thread_cache_t*     cache,
+                            sralloc_thread_cache_bin_t* bin,
+                            srint_t                     count ) {
+    srallocator_t* backing = tcache_allocator->backing_allocator;
+    void*          blocks[SRALLOC_TCACHE_BATCH];
+    while ( count > 0 && bin->free_list != SRALLOC_NULL ) {
+        srint_t num_blocks = 0;
+        while ( num_blocks < SRALLOC_TCACHE_BATCH && count > 0 && bin->free_list != SRALLOC_NULL ) {
+            void* ptr      = bin->free_list;
+            bin->free_list = *(void**)ptr;
+            bin->count--;
+            count--;
+            blocks[num_blocks++] = (srchar_t*)ptr - SR__TCACHE_HEADER_SIZE;
+        }
+
+#ifdef SRALLOC_USE_PREAMBLE
+        sralloc_dealloc_batch( backing, blocks, num_blocks );
+#else
+        srint_t block_size =
+          SR__TCACHE_HEADER_SIZE + sr__size_class_size( (srint_t)( bin - cache->bins ) );
+        for ( srint_t i_block = 0; i_block < num_blocks; ++i_block ) {
+            sralloc_dealloc_sized( backing, blocks[i_block], block_size, 16 );
+        }
+#endif
+    }
+
+    sr__thread_cache_fold_stats( allocator, cache );
+}
+
+static int
+sr__thread_cache_refill( srallocator_t*              allocator,
+                         srallocator_thread_cache_t* tcache_allocator,
+                         sralloc_thread_cache_t*     cache,
+                         srint_t                     size_class ) {
+    srallocator_t*              backing = tcache_allocator->backing_allocator;
+    sralloc_thread_cache_bin_t* bin     = &cache->bins[size_class];
+    srint_t block_size = SR__TCACHE_HEADER_SIZE + sr__size_class_size( size_class );
+    void*   blocks[SRALLOC_TCACHE_BATCH];
+    srint_t num_blocks =
+      sralloc_alloc_batch( backing, block_size, 16, SRALLOC_TCACHE_BATCH, blocks );
+    for ( srint_t i_block = 0; i_block < num_blocks; ++i_block ) {
+        srchar_t*                        block = (srchar_t*)blocks[i_block];
+        void*                            ptr   = block + SR__TCACHE_HEADER_SIZE;
+        sralloc_thread_cache_preamble_t* preamble = (sralloc_thread_cache_preamble_t*)ptr - 1;
+        preamble->size_class                      = (sralloc_preamble_int_t)size_class;
+        preamble->size                            = (sralloc_preamble_int_t)block_size;
+        preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, block );
+        *(void**)ptr     = bin->free_list;
+        bin->free_list   = ptr;
+        bin->count++;
+    }
+
+    sr__thread_cache_fold_stats( allocator, cache );
+    return bin->free_list != SRALLOC_NULL;
+}
+
+static sr_result_t
+sr__thread_cache_allocate_uncached( srallocator_t*          allocator,
+                                    sralloc_thread_cache_t* cache,
+                                    srint_t                 wanted_size,
+                                    srint_t                 align ) {
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+    srint_t preamble_size =
+      sizeof( sralloc_thread_cache_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t   size          = wanted_size + align + preamble_size;
+    srchar_t* unaligned_ptr = (srchar_t*)sralloc_alloc( tcache_allocator->backing_allocator, size );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    sr__thread_cache_account( allocator, cache, 1, size );
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_thread_cache_preamble_t* preamble = (sralloc_thread_cache_preamble_t*)ptr - 1;
+    preamble->size_class                      = SR__TCACHE_UNCACHED;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
+    sr_result_t res;
+    res.ptr  = (void*)ptr;
+    res.size = wanted_size;
+    return res;
+}
+
+static sr_result_t
+sralloc_thread_cache_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+    sralloc_thread_cache_t*     cache            = sr__thread_cache_get( tcache_allocator );
+    if ( cache == SRALLOC_NULL || wanted_size > SR__TCACHE_MAX_SIZE ||
+         align > SR__TCACHE_HEADER_SIZE ) {
+        return sr__thread_cache_allocate_uncached( allocator, cache, wanted_size, align );
+    }
+
+    srint_t                     size_class = sr__size_class( wanted_size );
+    sralloc_thread_cache_bin_t* bin        = &cache->bins[size_class];
+    if ( bin->free_list == SRALLOC_NULL &&
+         !sr__thread_cache_refill( allocator, tcache_allocator, cache, size_class ) ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    void* ptr      = bin->free_list;
+    bin->free_list = *(void**)ptr;
+    bin->count--;
+
+    srint_t class_size = sr__size_class_size( size_class );
+    sr__thread_cache_account( allocator, cache, 1, SR__TCACHE_HEADER_SIZE + class_size );
+
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = class_size;
+    return res;
+}
+
+static void
+sralloc_thread_cache_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+    sralloc_thread_cache_t*     cache            = sr__thread_cache_get( tcache_allocator );
+    sralloc_thread_cache_preamble_t* preamble    = (sralloc_thread_cache_preamble_t*)ptr - 1;
+    srint_t                          size_class  = preamble->size_class;
+    if ( size_class == SR__TCACHE_UNCACHED ) {
+        srchar_t* unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+        srint_t   size          = sr__preamble_size( preamble, preamble->size );
+        sr__thread_cache_account( allocator, cache, -1, -size );
+        sralloc_dealloc_sized( tcache_allocator->backing_allocator, unaligned_ptr, size, 0 );
+        return;
+    }
+
+    sr__thread_cache_account( allocator, cache, -1, -preamble->size );
+    SRALLOC_WRITE_DEALLOCATION_PATTERN( ptr, preamble->size - SR__TCACHE_HEADER_SIZE );
+    if ( cache == SRALLOC_NULL ) {
+        sr__thread_cache_release_block( tcache_allocator->backing_allocator, ptr, preamble->size );
+        return;
+    }
+
+    // Blocks freed on another thread than the one that allocated them simply end up in this
+    // thread's cache, the backing allocator is shared so any thread may hand them back.
+    sralloc_thread_cache_bin_t* bin = &cache->bins[size_class];
+    *(void**)ptr                    = bin->free_list;
+    bin->free_list                  = ptr;
+    if ( ++bin->count > SRALLOC_TCACHE_BATCH * 2 ) {
+        sr__thread_cache_flush_bin(
+          allocator, tcache_allocator, cache, bin, SRALLOC_TCACHE_BATCH );
+    }
+}
+
+static sr_result_t
+sralloc_thread_cache_reallocate( srallocator_t* allocator,
+                                 void*          ptr,
+                                 srint_t        wanted_size,
+                                 srint_t        align,
+                                 int            may_move ) {
+    sralloc_thread_cache_preamble_t* preamble = (sralloc_thread_cache_preamble_t*)ptr - 1;
+    srint_t usable_size = preamble->size - SR__TCACHE_HEADER_SIZE;
+    if ( preamble->size_class == SR__TCACHE_UNCACHED ) {
+        usable_size = sr__preamble_size( preamble, preamble->size ) - preamble->offset -
+                      (srint_t)sizeof( sralloc_thread_cache_preamble_t );
+    }
+
+    if ( wanted_size <= usable_size ) {
+        sr_result_t res;
+        res.ptr  = ptr;
+        res.size = usable_size;
+        return res;
+    }
+
+    if ( !may_move ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    return sr__reallocate_by_moving( allocator, ptr, usable_size, wanted_size, align );
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_thread_cache_allocator( const char* name, srallocator_t* parent ) {
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_thread_cache_t );
+    void*   memory         = sralloc_alloc_aligned( parent, allocator_size, 64 );
+    srallocator_t*              allocator        = (srallocator_t*)memory;
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+
+    SRALLOC_memset( allocator, 0, allocator_size );
+    sr__add_child_allocator( parent, allocator );
+    sr__set_name( allocator, name );
+    sr__create_stats( allocator );
+    allocator->allocate_func            = sralloc_thread_cache_allocate;
+    allocator->deallocate_func          = sralloc_thread_cache_deallocate;
+    allocator->reallocate_func          = sralloc_thread_cache_reallocate;
+    tcache_allocator->backing_allocator = parent;
+
+    sr__static_mutex_lock( &sr__thread_caches_mutex );
+    tcache_allocator->next = sr__thread_caches;
+    sr__thread_caches      = tcache_allocator;
+    sr__static_mutex_unlock( &sr__thread_caches_mutex );
+    return allocator;
+}
+
+static void
+sr__thread_cache_flush( srallocator_t*              allocator,
+                        srallocator_thread_cache_t* tcache_allocator,
+                        sralloc_thread_cache_t*     cache ) {
+    for ( srint_t i_bin = 0; i_bin < SR__TCACHE_NUM_CLASSES; ++i_bin ) {
+        sr__thread_cache_flush_bin(
+          allocator, tcache_allocator, cache, &cache->bins[i_bin], cache->bins[i_bin].count );
+    }
+}
+
+static void
+sr__thread_cache_thread_exit( srint_t thread_index ) {
+    sr__static_mutex_lock( &sr__thread_caches_mutex );
+    for ( srallocator_thread_cache_t* tcache_allocator = sr__thread_caches;
+          tcache_allocator != SRALLOC_NULL;
+          tcache_allocator = tcache_allocator->next ) {
+        sralloc_thread_cache_t* cache = tcache_allocator->caches[thread_index];
+        if ( cache != SRALLOC_NULL ) {
+            sr__thread_cache_flush( (srallocator_t*)tcache_allocator - 1, tcache_allocator, cache );
+        }
+    }
+
+    sr__static_mutex_unlock( &sr__thread_caches_mutex );
+}
+
+SRALLOC_API void
+sralloc_thread_cache_allocator_flush( srallocator_t* allocator ) {
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+    srint_t                     thread_index     = sr__thread_index();
+    if ( thread_index >= SRALLOC_MAX_THREADS ||
+         tcache_allocator->caches[thread_index] == SRALLOC_NULL ) {
+        return;
+    }
+
+    sr__thread_cache_flush( allocator, tcache_allocator, tcache_allocator->caches[thread_index] );
+}
+
+SRALLOC_API void
+sralloc_destroy_thread_cache_allocator( srallocator_t* allocator ) {
+    srallocator_thread_cache_t* tcache_allocator = (srallocator_thread_cache_t*)( allocator + 1 );
+    sr__static_mutex_lock( &sr__thread_caches_mutex );
+    srallocator_thread_cache_t** link = &sr__thread_caches;
+    while ( *link != tcache_allocator ) {
+        link = &( *link )->next;
+    }
+
+    *link = tcache_allocator->next;
+    sr__static_mutex_unlock( &sr__thread_caches_mutex );
+
+    for ( srint_t i_cache = 0; i_cache < SRALLOC_MAX_THREADS; ++i_cache ) {
+        sralloc_thread_cache_t* cache = tcache_allocator->caches[i_cache];
+        if ( cache == SRALLOC_NULL ) {
+            continue;
+        }
+
+        sr__thread_cache_flush( allocator, tcache_allocator, cache );
+        sralloc_dealloc_sized(
+          tcache_allocator->backing_allocator, cache, sizeof( sralloc_thread_cache_t ), 64 );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
+    SRALLOC_assert( allocator->num_children == 0 );
+    SRALLOC_assert( allocator->stats.num_allocations == 0 );
+    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
+#endif
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_thread_cache_t );
+    sralloc_dealloc_sized( tcache_allocator->backing_allocator, allocator, allocator_size, 64 );
+}
+
+// ███████╗██╗      ██████╗ ████████╗
+// ██╔════╝██║     ██╔═══██╗╚══██╔══╝
+// ███████╗██║     ██║   ██║   ██║
+// ╚════██║██║     ██║   ██║   ██║
+// ███████║███████╗╚██████╔╝   ██║
+// ╚══════╝╚══════╝ ╚═════╝    ╚═╝
+
+typedef struct sralloc_slot_slab {
+    struct sralloc_slot_slab* next;
+} sralloc_slot_slab_t;
+
+typedef struct {
+    void*                free_slot; // Each free slot stores a pointer to the next one
+    srchar_t*            top;       // First never-used slot in the newest slab
+    srchar_t*            end;
+    sralloc_slot_slab_t* slabs; // Extra slabs, the first one lives with the allocator
+    srallocator_t*       backing_allocator;
+    srint_t              slot_size;
+    srint_t              slot_align;
+    srint_t              capacity;
+    srint_t              growing;
+} srallocator_slot_t;
+
+static srint_t
+sr__slot_align( srint_t slot_size ) {
+    srint_t align = 1;
+    while ( ( slot_size & align ) == 0 && align < SRALLOC_SLOT_MAX_ALIGN ) {
+        align <<= 1;
+    }
+
+    return align;
+}
+
+static srint_t
+sr__slot_slab_size( srallocator_slot_t* slot_allocator ) {
+    return slot_allocator->slot_align + slot_allocator->slot_size * slot_allocator->capacity;
+}
+
+static int
+sr__slot_add_slab( srallocator_slot_t* slot_allocator ) {
+    srint_t slab_size = sizeof( sralloc_slot_slab_t ) + sr__slot_slab_size( slot_allocator );
+    sralloc_slot_slab_t* slab =
+      (sralloc_slot_slab_t*)sralloc_alloc( slot_allocator->backing_allocator, slab_size );
+    if ( slab == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    slab->next            = slot_allocator->slabs;
+    slot_allocator->slabs = slab;
+    slot_allocator->top =
+      (srchar_t*)sr__ptr_to_aligned_ptr( slab + 1, slot_allocator->slot_align );
+    slot_allocator->end =
+      slot_allocator->top + slot_allocator->slot_size * slot_allocator->capacity;
+    return 1;
+}
+
+static sr_result_t
+sralloc_slot_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    if ( wanted_size > slot_allocator->slot_size || align > slot_allocator->slot_align ) {
+        sr_result_t res = { SRALLOC_NULL, 0 };
+        return res;
+    }
+
+    void* ptr = slot_allocator->free_slot;
+    if ( ptr != SRALLOC_NULL ) {
+        slot_allocator->free_slot = *(void**)ptr;
+    }
+    else {
+        if ( slot_allocator->top == slot_allocator->end ) {
+            if ( !slot_allocator->growing || !sr__slot_add_slab( slot_allocator ) ) {
+                sr_result_t res = { SRALLOC_NULL, 0 };
+                return res;
+            }
+        }
+
+        ptr = slot_allocator->top;
+        slot_allocator->top += slot_allocator->slot_size;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 1, slot_allocator->slot_size );
+#endif
 
-static sr_result_t
-sralloc_malloc_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
-    SRALLOC_UNUSED( allocator );
-    srint_t preamble_size = sizeof( sralloc_malloc_preamble_t );
-    srint_t size          = wanted_size;
-    size += align;
-    size += preamble_size;
+    sr_result_t res;
+    res.ptr  = ptr;
+    res.size = slot_allocator->slot_size;
+    return res;
+}
 
+static void
+sralloc_slot_deallocate( srallocator_t* allocator, void* ptr ) {
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
 #ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated += size;
-    allocator->stats.num_allocations++;
+    sr__stats_add( allocator, -1, -slot_allocator->slot_size );
 #endif
+    SRALLOC_WRITE_DEALLOCATION_PATTERN( ptr, slot_allocator->slot_size );
+    *(void**)ptr              = slot_allocator->free_slot;
+    slot_allocator->free_slot = ptr;
+}
 
-    srchar_t* unaligned_ptr = SRALLOC_malloc( size );
-    if ( unaligned_ptr == SRALLOC_NULL ) {
-        sr_result_t res = { SRALLOC_NULL, 0 };
-        return res;
+// Slots never change size, so anything that fits stays where it is
+static sr_result_t
+sralloc_slot_reallocate( srallocator_t* allocator,
+                         void*          ptr,
+                         srint_t        wanted_size,
+                         srint_t        align,
+                         int            may_move ) {
+    SRALLOC_UNUSED( align, may_move );
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    sr_result_t         res            = { SRALLOC_NULL, 0 };
+    if ( wanted_size <= slot_allocator->slot_size ) {
+        res.ptr  = ptr;
+        res.size = slot_allocator->slot_size;
     }
 
-    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
-    sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
-    preamble->size                      = size;
-    preamble->offset                    = sr__ptr_diff( preamble, unaligned_ptr );
-
-    sr_result_t res;
-    res.ptr  = (void*)ptr;
-    res.size = wanted_size;
     return res;
 }
 
+static srint_t
+sralloc_slot_allocate_batch( srallocator_t* allocator,
+                             srint_t        wanted_size,
+                             srint_t        align,
+                             srint_t        count,
+                             void**         out_ptrs ) {
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    if ( wanted_size > slot_allocator->slot_size || align > slot_allocator->slot_align ) {
+        return 0;
+    }
+
+    srint_t i_ptr = 0;
+    for ( ; i_ptr < count; ++i_ptr ) {
+        void* ptr = slot_allocator->free_slot;
+        if ( ptr != SRALLOC_NULL ) {
+            slot_allocator->free_slot = *(void**)ptr;
+        }
+        else {
+            if ( slot_allocator->top == slot_allocator->end ) {
+                if ( !slot_allocator->growing || !sr__slot_add_slab( slot_allocator ) ) {
+                    break;
+                }
+            }
+
+            ptr = slot_allocator->top;
+            slot_allocator->top += slot_allocator->slot_size;
+        }
+
+        out_ptrs[i_ptr] = ptr;
+    }
+
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, i_ptr, slot_allocator->slot_size * i_ptr );
+#endif
+    return i_ptr;
+}
+
 static void
-sralloc_malloc_deallocate( srallocator_t* allocator, void* ptr ) {
-    SRALLOC_UNUSED( allocator );
-    sralloc_malloc_preamble_t* preamble      = (sralloc_malloc_preamble_t*)ptr - 1;
-    srchar_t*                  unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+sralloc_slot_deallocate_batch( srallocator_t* allocator, void** ptrs, srint_t count ) {
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    for ( srint_t i_ptr = 0; i_ptr < count; ++i_ptr ) {
+        SRALLOC_WRITE_DEALLOCATION_PATTERN( ptrs[i_ptr], slot_allocator->slot_size );
+        *(void**)ptrs[i_ptr]      = slot_allocator->free_slot;
+        slot_allocator->free_slot = ptrs[i_ptr];
+    }
+
 #ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated -= preamble->size;
-    allocator->stats.num_allocations--;
+    sr__stats_add( allocator, -count, -( slot_allocator->slot_size * count ) );
 #endif
-    SRALLOC_free( unaligned_ptr );
 }
 
-SRALLOC_API srallocator_t*
-            sralloc_create_malloc_allocator( const char* name ) {
-    srallocator_t* allocator = (srallocator_t*)SRALLOC_malloc( sizeof( srallocator_t ) );
+static srallocator_t*
+sr__create_slot_allocator( const char*    name,
+                           srallocator_t* parent,
+                           srint_t        slot_size,
+                           srint_t        capacity,
+                           srint_t        growing ) {
+    SRALLOC_assert( capacity > 0 );
+    if ( slot_size < (srint_t)sizeof( void* ) ) {
+        slot_size = sizeof( void* );
+    }
+
+    // Keep every slot able to hold the free list link
+    slot_size = ( slot_size + sizeof( void* ) - 1 ) & ~( (srint_t)sizeof( void* ) - 1 );
+
+    srallocator_slot_t slot_desc;
+    SRALLOC_memset( &slot_desc, 0, sizeof( slot_desc ) );
+    slot_desc.slot_size  = slot_size;
+    slot_desc.slot_align = sr__slot_align( slot_size );
+    slot_desc.capacity   = capacity;
+
+    srint_t allocator_size =
+      sizeof( srallocator_t ) + sizeof( srallocator_slot_t ) + sr__slot_slab_size( &slot_desc );
+    void* memory = sralloc_alloc( parent, allocator_size );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    srallocator_t*      allocator      = (srallocator_t*)memory;
+    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+
     SRALLOC_memset( allocator, 0, sizeof( srallocator_t ) );
+    sr__add_child_allocator( parent, allocator );
     sr__set_name( allocator, name );
-    // sr__set_type( allocator, "malloc" );
-    allocator->allocate_func   = sralloc_malloc_allocate;
-    allocator->deallocate_func = sralloc_malloc_deallocate;
+    sr__create_stats( allocator );
+    allocator->allocate_func          = sralloc_slot_allocate;
+    allocator->deallocate_func        = sralloc_slot_deallocate;
+    allocator->allocate_batch_func    = sralloc_slot_allocate_batch;
+    allocator->deallocate_batch_func  = sralloc_slot_deallocate_batch;
+    allocator->reallocate_func        = sralloc_slot_reallocate;
+    *slot_allocator                   = slot_desc;
+    slot_allocator->backing_allocator = parent;
+    slot_allocator->growing           = growing;
+    slot_allocator->top =
+      (srchar_t*)sr__ptr_to_aligned_ptr( slot_allocator + 1, slot_allocator->slot_align );
+    slot_allocator->end = slot_allocator->top + slot_size * capacity;
     return allocator;
 }
 
+SRALLOC_API srallocator_t*
+            sralloc_create_slot_allocator( const char*    name,
+                                           srallocator_t* parent,
+                                           srint_t        slot_size,
+                                           srint_t        capacity ) {
+    return sr__create_slot_allocator( name, parent, slot_size, capacity, 0 );
+}
+
+SRALLOC_API srallocator_t*
+            sralloc_create_growing_slot_allocator( const char*    name,
+                                                   srallocator_t* parent,
+                                                   srint_t        slot_size,
+                                                   srint_t        slab_capacity ) {
+    return sr__create_slot_allocator( name, parent, slot_size, slab_capacity, 1 );
+}
+
 SRALLOC_API void
-sralloc_destroy_malloc_allocator( srallocator_t* allocator ) {
+sralloc_destroy_slot_allocator( srallocator_t* allocator ) {
 #ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    sr__remove_child_allocator( allocator->parent, allocator );
     SRALLOC_assert( allocator->num_children == 0 );
     SRALLOC_assert( allocator->stats.num_allocations == 0 );
     SRALLOC_assert( allocator->stats.amount_allocated == 0 );
 #endif
-    SRALLOC_free( allocator );
-}
-
-// ███████╗████████╗ █████╗  ██████╗██╗  ██╗
-// ██╔════╝╚══██╔══╝██╔══██╗██╔════╝██║ ██╔╝
-// ███████╗   ██║   ███████║██║     █████╔╝
-// ╚════██║   ██║   ██╔══██║██║     ██╔═██╗
-// ███████║   ██║   ██║  ██║╚██████╗██║  ██╗
-// ╚══════╝   ╚═╝   ╚═╝  ╚═╝ ╚═════╝╚═╝  ╚═╝
+    srallocator_slot_t*  slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    sralloc_slot_slab_t* slab           = slot_allocator->slabs;
+    srint_t slab_size = sizeof( sralloc_slot_slab_t ) + sr__slot_slab_size( slot_allocator );
+    while ( slab != SRALLOC_NULL ) {
+        sralloc_slot_slab_t* next = slab->next;
+        sralloc_dealloc_sized( slot_allocator->backing_allocator, slab, slab_size, 0 );
+        slab = next;
+    }
 
-typedef struct {
-    srint_t offset;
-    srint_t size;
-} sralloc_stack_preamble_t;
+    srint_t allocator_size =
+      sizeof( srallocator_t ) + sizeof( srallocator_slot_t ) + sr__slot_slab_size( slot_allocator );
+    sralloc_dealloc_sized( slot_allocator->backing_allocator, allocator, allocator_size, 0 );
+}
 
-typedef struct {
-    void* top;
-#ifdef SRALLOC_USE_STATS
-    sralloc_stats_t stats;
-#endif
-} srallocator_stack_state_t;
+//  ██████╗ █████╗ ██╗     ██╗     ██████╗  █████╗  ██████╗██╗  ██╗
+// ██╔════╝██╔══██╗██║     ██║     ██╔══██╗██╔══██╗██╔════╝██║ ██╔╝
+// ██║     ███████║██║     ██║     ██████╔╝███████║██║     █████╔╝
+// ██║     ██╔══██║██║     ██║     ██╔══██╗██╔══██║██║     ██╔═██╗
+// ╚██████╗██║  ██║███████╗███████╗██████╔╝██║  ██║╚██████╗██║  ██╗
+//  ╚═════╝╚═╝  ╚═╝╚══════╝╚══════╝╚═════╝ ╚═╝  ╚═╝ ╚═════╝╚═╝  ╚═╝
 
 typedef struct {
-    void*                     top;
-    void*                     end;
-    srallocator_t*            backing_allocator;
-    srallocator_stack_state_t states[4];
-    srint_t                   num_states;
-} srallocator_stack_t;
+    srallocator_t*                backing_allocator;
+    void*                         user_data;
+    sralloc_callback_allocate_t   allocate;
+    sralloc_callback_deallocate_t deallocate;
+} srallocator_callback_t;
 
+#ifdef SRALLOC_USE_PREAMBLE
 static sr_result_t
-sralloc_stack_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
-    srint_t preamble_size = sizeof( sralloc_stack_preamble_t );
-    srint_t size          = wanted_size;
-    size += align;
-    size += preamble_size;
-
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    if ( size > sr__ptr_diff( stack_allocator->end, stack_allocator->top ) ) {
+sralloc_callback_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srint_t preamble_size =
+      sizeof( sralloc_proxy_preamble_t ) + sr__preamble_extra( wanted_size + align );
+    srint_t size = wanted_size + align + preamble_size;
+
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
+    srchar_t*               unaligned_ptr =
+      (srchar_t*)callback_allocator->allocate( callback_allocator->user_data, size, 0 );
+    if ( unaligned_ptr == SRALLOC_NULL ) {
         sr_result_t res = { SRALLOC_NULL, 0 };
         return res;
     }
 
 #ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated += size;
-    allocator->stats.num_allocations++;
+    sr__stats_add( allocator, 1, size );
 #endif
 
-    void*     unaligned_ptr = stack_allocator->top;
-    srchar_t* ptr           = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
-    sralloc_malloc_preamble_t* preamble = (sralloc_malloc_preamble_t*)ptr - 1;
-    preamble->size                      = size;
-    preamble->offset                    = sr__ptr_diff( preamble, unaligned_ptr );
-    stack_allocator->top                = ptr + size;
+    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
+    sralloc_proxy_preamble_t* preamble = (sralloc_proxy_preamble_t*)ptr - 1;
+    preamble->offset = (sralloc_preamble_int_t)sr__ptr_diff( preamble, unaligned_ptr );
+    sr__set_preamble_size( preamble, &preamble->size, size );
+
     sr_result_t res;
-    res.ptr  = (void*)( ptr );
+    res.ptr  = (void*)ptr;
     res.size = wanted_size;
     return res;
 }
 
 static void
-sralloc_stack_deallocate( srallocator_t* allocator, void* ptr ) {
-    srallocator_stack_t*       stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    sralloc_malloc_preamble_t* preamble        = (sralloc_malloc_preamble_t*)ptr - 1;
-    srchar_t*                  unaligned_ptr   = (srchar_t*)preamble - preamble->offset;
-    stack_allocator->top                       = unaligned_ptr;
-#ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated -= preamble->size;
-    allocator->stats.num_allocations--;
-#endif
-}
-
-SRALLOC_API void
-sralloc_stack_allocator_clear( srallocator_t* allocator ) {
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    stack_allocator->top                 = stack_allocator + 1;
+sralloc_callback_deallocate( srallocator_t* allocator, void* ptr ) {
+    sralloc_proxy_preamble_t* preamble      = (sralloc_proxy_preamble_t*)ptr - 1;
+    srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
+    srint_t                   size          = sr__preamble_size( preamble, preamble->size );
 #ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated = 0;
-    allocator->stats.num_allocations  = 0;
+    sr__stats_add( allocator, -1, -size );
 #endif
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
+    callback_allocator->deallocate( callback_allocator->user_data, unaligned_ptr, size, 0 );
 }
-
-SRALLOC_API void
-sralloc_stack_allocator_push_state( srallocator_t* allocator ) {
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    SRALLOC_assert(
-      stack_allocator->num_states <
-      ( srint_t )( sizeof( stack_allocator->states ) / sizeof( srallocator_stack_state_t ) ) );
-    srallocator_stack_state_t* state = &stack_allocator->states[stack_allocator->num_states++];
-    state->top                       = stack_allocator->top;
+#else
+static sr_result_t
+sralloc_callback_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
+    sr_result_t             res;
+    res.ptr  = callback_allocator->allocate( callback_allocator->user_data, wanted_size, align );
+    res.size = res.ptr != SRALLOC_NULL ? wanted_size : 0;
 #ifdef SRALLOC_USE_STATS
-    state->stats = allocator->stats;
+    if ( res.ptr != SRALLOC_NULL ) {
+        sr__stats_add( allocator, 1, wanted_size );
+    }
 #endif
+    return res;
 }
 
-SRALLOC_API void
-sralloc_stack_allocator_pop_state( srallocator_t* allocator ) {
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    SRALLOC_assert( stack_allocator->num_states > 0 );
-    srallocator_stack_state_t* state = &stack_allocator->states[--stack_allocator->num_states];
-    stack_allocator->top             = state->top;
+static void
+sralloc_callback_deallocate_sized( srallocator_t* allocator,
+                                   void*          ptr,
+                                   srint_t        size,
+                                   srint_t        align ) {
 #ifdef SRALLOC_USE_STATS
-    allocator->stats = state->stats;
+    sr__stats_add( allocator, -1, -size );
 #endif
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
+    callback_allocator->deallocate( callback_allocator->user_data, ptr, size, align );
 }
+#endif // SRALLOC_USE_PREAMBLE
 
 SRALLOC_API srallocator_t*
-            sralloc_create_stack_allocator( const char* name, srallocator_t* parent, srint_t capacity ) {
-    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_stack_t ) + capacity;
-    void*   memory         = sralloc_alloc( parent, allocator_size );
-    srallocator_t*       allocator       = (srallocator_t*)memory;
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
+            sralloc_create_callback_allocator( const char*                   name,
+                                               srallocator_t*                parent,
+                                               void*                         user_data,
+                                               sralloc_callback_allocate_t   allocate,
+                                               sralloc_callback_deallocate_t deallocate ) {
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_callback_t );
+    void*   memory         = parent != SRALLOC_NULL ? sralloc_alloc( parent, allocator_size )
+                                          : SRALLOC_malloc( allocator_size );
+    if ( memory == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
 
+    srallocator_t*          allocator          = (srallocator_t*)memory;
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
     SRALLOC_memset( allocator, 0, allocator_size );
-    sr__add_child_allocator( parent, allocator );
+    if ( parent != SRALLOC_NULL ) {
+        sr__add_child_allocator( parent, allocator );
+    }
+
     sr__set_name( allocator, name );
-    allocator->allocate_func           = sralloc_stack_allocate;
-    allocator->deallocate_func         = sralloc_stack_deallocate;
-    stack_allocator->top               = stack_allocator + 1;
-    stack_allocator->end               = ( (char*)stack_allocator->top ) + capacity;
-    stack_allocator->num_states        = 0;
-    stack_allocator->backing_allocator = parent;
+    sr__create_stats( allocator );
+    allocator->allocate_func = sralloc_callback_allocate;
+#ifdef SRALLOC_USE_PREAMBLE
+    allocator->deallocate_func = sralloc_callback_deallocate;
+#else
+    allocator->deallocate_func       = sr__deallocate_without_size;
+    allocator->deallocate_sized_func = sralloc_callback_deallocate_sized;
+#endif
+    callback_allocator->backing_allocator = parent;
+    callback_allocator->user_data         = user_data;
+    callback_allocator->allocate          = allocate;
+    callback_allocator->deallocate        = deallocate;
     return allocator;
 }
 
 SRALLOC_API void
-sralloc_destroy_stack_allocator( srallocator_t* allocator ) {
+sralloc_destroy_callback_allocator( srallocator_t* allocator ) {
+    srallocator_callback_t* callback_allocator = (srallocator_callback_t*)( allocator + 1 );
+    srallocator_t*          parent             = callback_allocator->backing_allocator;
 #ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
+    if ( parent != SRALLOC_NULL ) {
+        sr__remove_child_allocator( parent, allocator );
+    }
+
+    SRALLOC_assert( allocator->num_children == 0 );
     SRALLOC_assert( allocator->stats.num_allocations == 0 );
     SRALLOC_assert( allocator->stats.amount_allocated == 0 );
-    sr__remove_child_allocator( allocator->parent, allocator );
-    SRALLOC_assert( allocator->num_children == 0 );
 #endif
+    if ( parent == SRALLOC_NULL ) {
+        SRALLOC_free( allocator );
+        return;
+    }
 
-    srallocator_stack_t* stack_allocator = (srallocator_stack_t*)( allocator + 1 );
-    SRALLOC_UNUSED( stack_allocator );
-    SRALLOC_assert( stack_allocator->num_states == 0 );
-    sralloc_dealloc( stack_allocator->backing_allocator, allocator );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_callback_t );
+    sralloc_dealloc_sized( parent, allocator, allocator_size, 0 );
 }
 
-// ██████╗ ██████╗  ██████╗ ██╗  ██╗██╗   ██╗
-// ██╔══██╗██╔══██╗██╔═══██╗╚██╗██╔╝╚██╗ ██╔╝
-// ██████╔╝██████╔╝██║   ██║ ╚███╔╝  ╚████╔╝
-// ██╔═══╝ ██╔══██╗██║   ██║ ██╔██╗   ╚██╔╝
-// ██║     ██║  ██║╚██████╔╝██╔╝ ██╗   ██║
-// ╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚═╝  ╚═╝   ╚═╝
+// ████████╗██████╗  █████╗  ██████╗███████╗
+// ╚══██╔══╝██╔══██╗██╔══██╗██╔════╝██╔════╝
+//    ██║   ██████╔╝███████║██║     █████╗
+//    ██║   ██╔══██╗██╔══██║██║     ██╔══╝
+//    ██║   ██║  ██║██║  ██║╚██████╗███████╗
+//    ╚═╝   ╚═╝  ╚═╝╚═╝  ╚═╝ ╚═════╝╚══════╝
+
+// A trace starts with the magic, then every event is its op byte followed by varints: the
+// allocator id, ns since the previous event, and what the op needs (see sralloc_trace_read).
+#define SR__TRACE_MAGIC "srtrace1"
+#define SR__TRACE_MAGIC_SIZE 8
+#define SR__TRACE_MAX_NAME 64
+#define SR__TRACE_MAX_EVENT_SIZE ( 1 + 10 * 6 + SR__TRACE_MAX_NAME )
+
+struct sralloc_trace {
+    srallocator_t*        allocator;
+    sralloc_trace_write_t write;
+    void*                 user_data;
+    srmutex_t             mutex;
+    srint_t               owner; // Thread index + 1 of whoever holds mutex, 0 when nobody does
+    int64_t               last_time_ns;
+    srint_t               num_allocators;
+    srint_t               capacity;
+    srint_t               used;
+    unsigned char*        buffer;
+};
 
 typedef struct {
-    srallocator_t* backing_allocator;
-} srallocator_proxy_t;
+    srallocator_t*   backing_allocator;
+    sralloc_trace_t* trace;
+    srint_t          id;
+} srallocator_recording_t;
+
+static unsigned char*
+sr__trace_write_varint( unsigned char* out, uint64_t value ) {
+    while ( value >= 0x80 ) {
+        *out++ = (unsigned char)( ( value & 0x7f ) | 0x80 );
+        value >>= 7;
+    }
 
-typedef struct {
-    srint_t size;
-    srint_t offset;
-} sralloc_proxy_preamble_t;
+    *out++ = (unsigned char)value;
+    return out;
+}
+
+static void
+sr__trace_flush( sralloc_trace_t* trace ) {
+    if ( trace->used > 0 ) {
+        trace->write( trace->user_data, trace->buffer, trace->used );
+        trace->used = 0;
+    }
+}
+
+// The lock stays held across the call to the backing allocator so that events are written in
+// the order the backing allocator saw them. A recording allocator further down on the same trace
+// runs on the thread that already holds it and must not lock it again.
+static int
+sr__trace_lock( sralloc_trace_t* trace ) {
+    srint_t self = sr__thread_index() + 1;
+    if ( SRALLOC_atomic_load( &trace->owner ) == self ) {
+        return 0;
+    }
+
+    SRALLOC_mutex_lock( &trace->mutex );
+    SRALLOC_atomic_store( &trace->owner, self );
+    return 1;
+}
+
+static void
+sr__trace_unlock( sralloc_trace_t* trace, int locked ) {
+    if ( locked ) {
+        SRALLOC_atomic_store( &trace->owner, 0 );
+        SRALLOC_mutex_unlock( &trace->mutex );
+    }
+}
+
+// Call with the trace locked, and sr__trace_end_event once the op's fields are written
+static unsigned char*
+sr__trace_begin_event( sralloc_trace_t* trace, sralloc_trace_op_t op, srint_t allocator_id ) {
+    if ( trace->capacity - trace->used < SR__TRACE_MAX_EVENT_SIZE ) {
+        sr__trace_flush( trace );
+    }
+
+    int64_t now   = SRALLOC_time_ns();
+    int64_t delta = now > trace->last_time_ns ? now - trace->last_time_ns : 0;
+    trace->last_time_ns += delta;
+
+    unsigned char* event = trace->buffer + trace->used;
+    *event++             = (unsigned char)op;
+    event                = sr__trace_write_varint( event, (uint64_t)allocator_id );
+    return sr__trace_write_varint( event, (uint64_t)delta );
+}
+
+static void
+sr__trace_end_event( sralloc_trace_t* trace, unsigned char* event_end ) {
+    trace->used = (srint_t)( event_end - trace->buffer );
+}
 
 static sr_result_t
-sralloc_proxy_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
-    SRALLOC_UNUSED( allocator );
-    srint_t preamble_size = sizeof( sralloc_proxy_preamble_t );
-    srint_t size          = wanted_size;
-    size += align;
-    size += preamble_size;
+sralloc_recording_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_recording_t* recording_allocator = (srallocator_recording_t*)( allocator + 1 );
+    srallocator_t*           backing = recording_allocator->backing_allocator;
+    sralloc_trace_t*         trace   = recording_allocator->trace;
 
+    int locked = sr__trace_lock( trace );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    sr_result_t res = sr__allocate( backing, wanted_size, align );
 #ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated += size;
-    allocator->stats.num_allocations++;
+    if ( res.ptr != SRALLOC_NULL ) {
+        sr__stats_add( allocator, 1, backing_stats->amount_allocated - amount_before );
+    }
 #endif
 
-    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
-    srchar_t*            unaligned_ptr = SRALLOC_BYTES( proxy_allocator->backing_allocator, size );
-    if ( unaligned_ptr == SRALLOC_NULL ) {
-        sr_result_t res = { SRALLOC_NULL, 0 };
+    unsigned char* event =
+      sr__trace_begin_event( trace, SRALLOC_TRACE_ALLOC, recording_allocator->id );
+    event = sr__trace_write_varint( event, (uint64_t)wanted_size );
+    event = sr__trace_write_varint( event, (uint64_t)align );
+    event = sr__trace_write_varint( event, (uint64_t)(sruintptr_t)res.ptr );
+    sr__trace_end_event( trace, event );
+    sr__trace_unlock( trace, locked );
+    return res;
+}
+
+static void
+sr__recording_deallocate( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    srallocator_recording_t* recording_allocator = (srallocator_recording_t*)( allocator + 1 );
+    srallocator_t*           backing = recording_allocator->backing_allocator;
+    sralloc_trace_t*         trace   = recording_allocator->trace;
+
+    int locked = sr__trace_lock( trace );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    if ( size < 0 ) {
+        sralloc_dealloc( backing, ptr );
+    }
+    else {
+        sralloc_dealloc_sized( backing, ptr, size, align );
+    }
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, -1, backing_stats->amount_allocated - amount_before );
+#endif
+
+    unsigned char* event =
+      sr__trace_begin_event( trace, SRALLOC_TRACE_FREE, recording_allocator->id );
+    event = sr__trace_write_varint( event, (uint64_t)(sruintptr_t)ptr );
+    sr__trace_end_event( trace, event );
+    sr__trace_unlock( trace, locked );
+}
+
+static void
+sralloc_recording_deallocate( srallocator_t* allocator, void* ptr ) {
+    sr__recording_deallocate( allocator, ptr, -1, 0 );
+}
+
+static void
+sralloc_recording_deallocate_sized( srallocator_t* allocator,
+                                    void*          ptr,
+                                    srint_t        size,
+                                    srint_t        align ) {
+    sr__recording_deallocate( allocator, ptr, size, align );
+}
+
+static sr_result_t
+sralloc_recording_reallocate( srallocator_t* allocator,
+                              void*          ptr,
+                              srint_t        size,
+                              srint_t        align,
+                              int            may_move ) {
+    srallocator_recording_t* recording_allocator = (srallocator_recording_t*)( allocator + 1 );
+    srallocator_t*           backing = recording_allocator->backing_allocator;
+    sralloc_trace_t*         trace   = recording_allocator->trace;
+    sr_result_t              res     = { SRALLOC_NULL, 0 };
+    if ( backing->reallocate_func == SRALLOC_NULL ) {
         return res;
     }
 
-    srchar_t* ptr = sr__aligned_ptr_after_preamble( unaligned_ptr, preamble_size, align );
-    sralloc_proxy_preamble_t* preamble = (sralloc_proxy_preamble_t*)ptr - 1;
-    preamble->size                     = size;
-    preamble->offset                   = sr__ptr_diff( preamble, unaligned_ptr );
+    int locked = sr__trace_lock( trace );
+#ifdef SRALLOC_USE_STATS
+    sralloc_stats_t* backing_stats = sr__thread_stats( backing );
+    srint_t          amount_before = backing_stats->amount_allocated;
+#endif
+    res = sr__reallocate( backing, ptr, size, align, may_move );
+#ifdef SRALLOC_USE_STATS
+    sr__stats_add( allocator, 0, backing_stats->amount_allocated - amount_before );
+#endif
+
+    sralloc_trace_op_t op    = may_move ? SRALLOC_TRACE_REALLOC : SRALLOC_TRACE_EXPAND;
+    unsigned char*     event = sr__trace_begin_event( trace, op, recording_allocator->id );
+    event                    = sr__trace_write_varint( event, (uint64_t)(sruintptr_t)ptr );
+    event                    = sr__trace_write_varint( event, (uint64_t)size );
+    event                    = sr__trace_write_varint( event, (uint64_t)align );
+    event = sr__trace_write_varint( event, (uint64_t)(sruintptr_t)res.ptr );
+    sr__trace_end_event( trace, event );
+    sr__trace_unlock( trace, locked );
+    return res;
+}
+
+SRALLOC_API sralloc_trace_t*
+sralloc_create_trace( srallocator_t*        allocator,
+                      srint_t               buffer_size,
+                      sralloc_trace_write_t write,
+                      void*                 user_data ) {
+    SRALLOC_assert( buffer_size >= SR__TRACE_MAGIC_SIZE + SR__TRACE_MAX_EVENT_SIZE );
+    srint_t          trace_size = sizeof( sralloc_trace_t ) + buffer_size;
+    sralloc_trace_t* trace      = (sralloc_trace_t*)sralloc_alloc( allocator, trace_size );
+    if ( trace == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    SRALLOC_memset( trace, 0, sizeof( sralloc_trace_t ) );
+    trace->allocator    = allocator;
+    trace->write        = write;
+    trace->user_data    = user_data;
+    trace->last_time_ns = SRALLOC_time_ns();
+    trace->capacity     = buffer_size;
+    trace->used         = SR__TRACE_MAGIC_SIZE;
+    trace->buffer       = (unsigned char*)( trace + 1 );
+    SRALLOC_memcpy( trace->buffer, SR__TRACE_MAGIC, SR__TRACE_MAGIC_SIZE );
+    SRALLOC_mutex_init( &trace->mutex );
+    return trace;
+}
 
-    sr_result_t res;
-    res.ptr  = (void*)ptr;
-    res.size = wanted_size;
-    return res;
+SRALLOC_API void
+sralloc_destroy_trace( sralloc_trace_t* trace ) {
+    sr__trace_flush( trace );
+    SRALLOC_mutex_destroy( &trace->mutex );
+    srint_t trace_size = sizeof( sralloc_trace_t ) + trace->capacity;
+    sralloc_dealloc_sized( trace->allocator, trace, trace_size, 0 );
 }
 
-static void
-sralloc_proxy_deallocate( srallocator_t* allocator, void* ptr ) {
-    SRALLOC_UNUSED( allocator );
-    sralloc_proxy_preamble_t* preamble      = (sralloc_proxy_preamble_t*)ptr - 1;
-    srchar_t*                 unaligned_ptr = (srchar_t*)preamble - preamble->offset;
-#ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated -= preamble->size;
-    allocator->stats.num_allocations--;
-#endif
-    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
-    SRALLOC_DEALLOC( proxy_allocator->backing_allocator, unaligned_ptr );
+SRALLOC_API void
+sralloc_trace_flush( sralloc_trace_t* trace ) {
+    int locked = sr__trace_lock( trace );
+    sr__trace_flush( trace );
+    sr__trace_unlock( trace, locked );
 }
 
 SRALLOC_API srallocator_t*
-            sralloc_create_proxy_allocator( const char* name, srallocator_t* parent ) {
-#ifdef SRALLOC_DISABLE_PROXY
-    return parent;
-#endif
-
-    srint_t              allocator_size  = sizeof( srallocator_t ) + sizeof( srallocator_proxy_t );
-    void*                memory          = sralloc_alloc( parent, allocator_size );
-    srallocator_t*       allocator       = (srallocator_t*)memory;
-    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
+            sralloc_create_recording_allocator( const char*      name,
+                                                srallocator_t*   parent,
+                                                sralloc_trace_t* trace ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_recording_t );
+    srallocator_t* allocator      = (srallocator_t*)sralloc_alloc( parent, allocator_size );
+    srallocator_recording_t* recording_allocator = (srallocator_recording_t*)( allocator + 1 );
 
     SRALLOC_memset( allocator, 0, allocator_size );
     sr__add_child_allocator( parent, allocator );
     sr__set_name( allocator, name );
-    allocator->allocate_func           = sralloc_proxy_allocate;
-    allocator->deallocate_func         = sralloc_proxy_deallocate;
-    proxy_allocator->backing_allocator = parent;
+    sr__create_stats( allocator );
+    allocator->allocate_func               = sralloc_recording_allocate;
+    allocator->deallocate_func             = sralloc_recording_deallocate;
+    allocator->deallocate_sized_func       = sralloc_recording_deallocate_sized;
+    allocator->reallocate_func             = sralloc_recording_reallocate;
+    recording_allocator->backing_allocator = parent;
+    recording_allocator->trace             = trace;
+
+    // The name goes into the trace once, events only carry the id
+    srint_t name_length = 0;
+    while ( name != SRALLOC_NULL && name[name_length] != 0 &&
+            name_length < SR__TRACE_MAX_NAME ) {
+        ++name_length;
+    }
+
+    int locked              = sr__trace_lock( trace );
+    recording_allocator->id = trace->num_allocators++;
+    unsigned char* event =
+      sr__trace_begin_event( trace, SRALLOC_TRACE_NAME, recording_allocator->id );
+    event = sr__trace_write_varint( event, (uint64_t)name_length );
+    if ( name_length > 0 ) {
+        SRALLOC_memcpy( event, name, name_length );
+    }
 
+    sr__trace_end_event( trace, event + name_length );
+    sr__trace_unlock( trace, locked );
     return allocator;
 }
 
 SRALLOC_API void
-sralloc_destroy_proxy_allocator( srallocator_t* allocator ) {
-#ifdef SRALLOC_DISABLE_PROXY
-    return;
-#endif
+sralloc_destroy_recording_allocator( srallocator_t* allocator ) {
 #ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
     sr__remove_child_allocator( allocator->parent, allocator );
     SRALLOC_assert( allocator->num_children == 0 );
     SRALLOC_assert( allocator->stats.num_allocations == 0 );
     SRALLOC_assert( allocator->stats.amount_allocated == 0 );
 #endif
-    srallocator_proxy_t* proxy_allocator = (srallocator_proxy_t*)( allocator + 1 );
-    SRALLOC_DEALLOC( proxy_allocator->backing_allocator, allocator );
+    srallocator_recording_t* recording_allocator = (srallocator_recording_t*)( allocator + 1 );
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_recording_t );
+    sralloc_dealloc_sized( recording_allocator->backing_allocator, allocator, allocator_size, 0 );
 }
 
-// ███████╗███╗   ██╗██████╗          ██████╗ ███████╗   ██████╗  █████╗  ██████╗ ███████╗
-// ██╔════╝████╗  ██║██╔══██╗        ██╔═══██╗██╔════╝   ██╔══██╗██╔══██╗██╔════╝ ██╔════╝
-// █████╗  ██╔██╗ ██║██║  ██║        ██║   ██║█████╗     ██████╔╝███████║██║  ███╗█████╗
-// ██╔══╝  ██║╚██╗██║██║  ██║        ██║   ██║██╔══╝     ██╔═══╝ ██╔══██║██║   ██║██╔══╝
-// ███████╗██║ ╚████║██████╔╝███████╗╚██████╔╝██║███████╗██║     ██║  ██║╚██████╔╝███████╗
-// ╚══════╝╚═╝  ╚═══╝╚═════╝ ╚══════╝ ╚═════╝ ╚═╝╚══════╝╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚══════╝
+static int
+sr__trace_read_varint( sralloc_trace_reader_t* reader, uint64_t* value ) {
+    *value = 0;
+    for ( int shift = 0; shift < 64; shift += 7 ) {
+        if ( reader->offset >= reader->size ) {
+            return 0;
+        }
+
+        unsigned char byte = reader->data[reader->offset++];
+        *value |= (uint64_t)( byte & 0x7f ) << shift;
+        if ( ( byte & 0x80 ) == 0 ) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+SRALLOC_API int
+sralloc_trace_read( sralloc_trace_reader_t* reader, sralloc_trace_event_t* event ) {
+    if ( reader->offset == 0 ) {
+        for ( int i = 0; i < SR__TRACE_MAGIC_SIZE; ++i ) {
+            if ( i >= reader->size || reader->data[i] != (unsigned char)SR__TRACE_MAGIC[i] ) {
+                return 0;
+            }
+        }
+
+        reader->offset = SR__TRACE_MAGIC_SIZE;
+    }
+
+    if ( reader->offset >= reader->size ) {
+        return 0;
+    }
+
+    SRALLOC_memset( event, 0, sizeof( sralloc_trace_event_t ) );
+    event->op = (sralloc_trace_op_t)reader->data[reader->offset++];
+
+    uint64_t fields[4] = { 0, 0, 0, 0 };
+    if ( !sr__trace_read_varint( reader, &fields[0] ) ||
+         !sr__trace_read_varint( reader, &fields[1] ) ) {
+        return 0;
+    }
+
+    event->allocator_id = (srint_t)fields[0];
+    reader->time_ns += (int64_t)fields[1];
+    event->time_ns = reader->time_ns;
+
+    int num_fields = 4;
+    if ( event->op == SRALLOC_TRACE_NAME || event->op == SRALLOC_TRACE_FREE ) {
+        num_fields = 1;
+    }
+    else if ( event->op == SRALLOC_TRACE_ALLOC ) {
+        num_fields = 3;
+    }
+    else if ( event->op != SRALLOC_TRACE_REALLOC && event->op != SRALLOC_TRACE_EXPAND ) {
+        return 0;
+    }
+
+    for ( int i_field = 0; i_field < num_fields; ++i_field ) {
+        if ( !sr__trace_read_varint( reader, &fields[i_field] ) ) {
+            return 0;
+        }
+    }
+
+    if ( event->op == SRALLOC_TRACE_NAME ) {
+        if ( fields[0] > (uint64_t)( reader->size - reader->offset ) ) {
+            return 0;
+        }
 
+        event->name        = (const srchar_t*)reader->data + reader->offset;
+        event->name_length = (srint_t)fields[0];
+        reader->offset += event->name_length;
+    }
+    else if ( event->op == SRALLOC_TRACE_ALLOC ) {
+        event->size  = (srint_t)fields[0];
+        event->align = (srint_t)fields[1];
+        event->ptr   = fields[2];
+    }
+    else if ( event->op == SRALLOC_TRACE_FREE ) {
+        event->ptr = fields[0];
+    }
+    else {
+        event->ptr     = fields[0];
+        event->size    = (srint_t)fields[1];
+        event->align   = (srint_t)fields[2];
+        event->new_ptr = fields[3];
+    }
+
+    return 1;
+}
+
+// ██████╗ ██████╗  ██████╗ ███████╗██╗██╗     ███████╗
+// ██╔══██╗██╔══██╗██╔═══██╗██╔════╝██║██║     ██╔════╝
+// ██████╔╝██████╔╝██║   ██║█████╗  ██║██║     █████╗
+// ██╔═══╝ ██╔══██╗██║   ██║██╔══╝  ██║██║     ██╔══╝
+// ██║     ██║  ██║╚██████╔╝██║     ██║███████╗███████╗
+// ╚═╝     ╚═╝  ╚═╝ ╚═════╝ ╚═╝     ╚═╝╚══════╝╚══════╝
+
+// Frees check the pointer's bucket without the lock and only take it when there are live
+// samples in it.
+#define SR__PROFILE_FILTER_SIZE 4096
+
+// Each thread counts down in its own cache line, threads past SRALLOC_MAX_THREADS share one
+// under the lock. interval stays 0 until the thread's first allocation draws one.
 typedef struct {
-    srallocator_t* backing_allocator;
-} srallocator_end_of_page_t;
+    int64_t  bytes_until_sample;
+    int64_t  interval; // Bytes from the previous sample to the next
+    uint64_t random;
+} sr__profile_counter_t;
 
+// The bytes and counts are estimates of everything allocated from the stack, not just samples
 typedef struct {
-    srint_t     size;
-    srint_t     offset;
-    srmemflag_t initial_protection;
-    srchar_t*   page_ptr;
-} sralloc_end_of_page_preamble_t;
+    uint64_t hash;
+    srint_t  num_frames;
+    void*    frames[SRALLOC_PROFILE_MAX_FRAMES];
+    int64_t  inuse_count;
+    int64_t  inuse_bytes;
+    int64_t  alloc_count;
+    int64_t  alloc_bytes;
+} sr__profile_stack_t;
 
-static sr_result_t
-sralloc_end_of_page_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
-    SRALLOC_UNUSED( allocator );
-    srint_t preamble_size    = sizeof( sralloc_end_of_page_preamble_t );
-    srint_t size_to_allocate = wanted_size;
-    size_to_allocate += align;
-    size_to_allocate += preamble_size;
-    size_to_allocate += SRALLOC_PAGE_SIZE * 2;
+typedef struct {
+    sruintptr_t ptr; // 0 for an empty slot
+    int64_t     bytes;
+    int64_t     count;
+    srint_t     stack;
+} sr__profile_sample_t;
 
-#ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated += size_to_allocate;
-    allocator->stats.num_allocations++;
-#endif
+typedef struct {
+    srallocator_t*        backing_allocator;
+    srallocator_t*        storage;
+    int64_t               sample_bytes;
+    srmutex_t             mutex;
+    srchar_t*             counters; // SRALLOC_MAX_THREADS cache lines
+    sr__profile_counter_t shared_counter;
+    srint_t*              filter; // Live samples per pointer hash bucket
+    sr__profile_stack_t*  stacks;
+    srint_t               num_stacks;
+    srint_t               stacks_capacity;
+    srint_t*              stack_table; // Open addressing, index + 1 into stacks or 0
+    srint_t               stack_table_capacity;
+    sr__profile_sample_t* samples; // Open addressing on ptr
+    srint_t               num_samples;
+    srint_t               samples_capacity;
+} srallocator_profiling_t;
 
-    srallocator_end_of_page_t* end_of_page_allocator =
-      (srallocator_end_of_page_t*)( allocator + 1 );
-    srchar_t* unaligned_ptr =
-      SRALLOC_BYTES( end_of_page_allocator->backing_allocator, size_to_allocate );
-    if ( unaligned_ptr == SRALLOC_NULL ) {
-        sr_result_t res = { SRALLOC_NULL, 0 };
-        return res;
+static srint_t
+sr__profile_filter_index( const void* ptr ) {
+    return (srint_t)( sr__hash64( (sruintptr_t)ptr ) & ( SR__PROFILE_FILTER_SIZE - 1 ) );
+}
+
+// log2 to within about 0.005, enough for drawing intervals without pulling in libm
+static double
+sr__profile_log2( double x ) {
+    uint64_t bits;
+    SRALLOC_memcpy( &bits, &x, sizeof( bits ) );
+    int exponent = (int)( ( bits >> 52 ) & 0x7ff ) - 1023;
+    bits         = ( bits & ( ( (uint64_t)1 << 52 ) - 1 ) ) | ( (uint64_t)1023 << 52 );
+    double mantissa;
+    SRALLOC_memcpy( &mantissa, &bits, sizeof( mantissa ) );
+    return exponent + ( -0.34484843 * mantissa + 2.02466578 ) * mantissa - 1.67487759;
+}
+
+// Exponentially distributed with a mean of sample_bytes, so the samples are a Poisson process
+// over the allocated bytes
+static int64_t
+sr__profile_next_interval( srallocator_profiling_t* profiler, sr__profile_counter_t* counter ) {
+    counter->random ^= counter->random >> 12;
+    counter->random ^= counter->random << 25;
+    counter->random ^= counter->random >> 27;
+    uint64_t uniform  = ( ( counter->random * 0x2545f4914f6cdd1dull ) >> 38 ) + 1; // 1 to 2^26
+    double   interval = ( 26.0 - sr__profile_log2( (double)uniform ) ) * 0.6931471805599453 *
+                      (double)profiler->sample_bytes;
+    return interval < 1.0 ? 1 : (int64_t)interval;
+}
+
+// Called when the counter ran out. Returns the bytes since the previous sample, which the
+// allocation that ran it out stands for, or 0 on a thread's first allocation if the interval it
+// draws doesn't run out right away.
+static int64_t
+sr__profile_take_sample( srallocator_profiling_t* profiler,
+                         sr__profile_counter_t*   counter,
+                         srint_t                  size ) {
+    if ( counter->interval == 0 ) {
+        uint64_t seed = (uint64_t)(sruintptr_t)counter ^ (uint64_t)SRALLOC_time_ns();
+        counter->random             = sr__hash64( seed ) | 1;
+        counter->interval           = sr__profile_next_interval( profiler, counter );
+        counter->bytes_until_sample = counter->interval - size;
+        if ( counter->bytes_until_sample > 0 ) {
+            return 0;
+        }
     }
 
-    srchar_t* page_ptr = sr__ptr_to_aligned_ptr(
-      unaligned_ptr + wanted_size + align + preamble_size, SRALLOC_PAGE_SIZE );
+    int64_t bytes               = counter->interval - counter->bytes_until_sample;
+    counter->interval           = sr__profile_next_interval( profiler, counter );
+    counter->bytes_until_sample = counter->interval;
+    return bytes;
+}
 
-    srchar_t*                       ptr      = page_ptr - wanted_size - align;
-    sralloc_end_of_page_preamble_t* preamble = (sralloc_end_of_page_preamble_t*)ptr - 1;
-    preamble->size                           = size_to_allocate;
-    preamble->offset                         = sr__ptr_diff( preamble, unaligned_ptr );
-    preamble->page_ptr                       = page_ptr;
+static void*
+sr__profile_alloc_zeroed( srallocator_profiling_t* profiler, srint_t size ) {
+    void* ptr = sralloc_alloc( profiler->storage, size );
+    if ( ptr != SRALLOC_NULL ) {
+        SRALLOC_memset( ptr, 0, size );
+    }
 
-    // SRALLOC_assert( sr__ptr_to_aligned_ptr( ptr, align ) == ptr );
-    SRALLOC_PROTECT_MEMORY(
-      page_ptr, SRALLOC_PAGE_SIZE, SRALLOC_MEMPROTECT_FLAG, &preamble->initial_protection );
+    return ptr;
+}
 
-    sr_result_t res;
-    res.ptr  = (void*)ptr;
-    res.size = wanted_size;
-    return res;
+static int
+sr__profile_grow_stack_table( srallocator_profiling_t* profiler ) {
+    srint_t old_capacity = profiler->stack_table_capacity;
+    srint_t capacity     = old_capacity > 0 ? old_capacity * 2 : 64;
+    srint_t* table =
+      (srint_t*)sr__profile_alloc_zeroed( profiler, capacity * (srint_t)sizeof( srint_t ) );
+    if ( table == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    for ( srint_t i_stack = 0; i_stack < profiler->num_stacks; ++i_stack ) {
+        srint_t slot = (srint_t)( profiler->stacks[i_stack].hash & ( capacity - 1 ) );
+        while ( table[slot] != 0 ) {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+
+        table[slot] = i_stack + 1;
+    }
+
+    sralloc_dealloc_sized( profiler->storage,
+                           profiler->stack_table,
+                           profiler->stack_table_capacity * (srint_t)sizeof( srint_t ),
+                           0 );
+    profiler->stack_table          = table;
+    profiler->stack_table_capacity = capacity;
+    return 1;
 }
 
-static void
-sralloc_end_of_page_deallocate( srallocator_t* allocator, void* ptr ) {
-    SRALLOC_UNUSED( allocator );
-    sralloc_end_of_page_preamble_t* preamble      = (sralloc_end_of_page_preamble_t*)ptr - 1;
-    srchar_t*                       unaligned_ptr = (srchar_t*)preamble - preamble->offset;
-#ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated -= preamble->size;
-    allocator->stats.num_allocations--;
-#endif
-    srchar_t*   page_ptr = preamble->page_ptr;
-    srmemflag_t current_protection;
-    SRALLOC_PROTECT_MEMORY(
-      page_ptr, SRALLOC_PAGE_SIZE, preamble->initial_protection, &current_protection );
+// Returns the stack's index, adding it if it's new, or -1 when storage is out of memory
+static srint_t
+sr__profile_find_stack( srallocator_profiling_t* profiler, void** frames, srint_t num_frames ) {
+    uint64_t hash = (uint64_t)num_frames;
+    for ( srint_t i_frame = 0; i_frame < num_frames; ++i_frame ) {
+        hash = sr__hash64( hash ^ (uint64_t)(sruintptr_t)frames[i_frame] );
+    }
 
-    srallocator_end_of_page_t* end_of_page_allocator =
-      (srallocator_end_of_page_t*)( allocator + 1 );
-    SRALLOC_DEALLOC( end_of_page_allocator->backing_allocator, unaligned_ptr );
+    if ( ( profiler->num_stacks + 1 ) * 2 > profiler->stack_table_capacity &&
+         !sr__profile_grow_stack_table( profiler ) ) {
+        return -1;
+    }
+
+    srint_t mask = profiler->stack_table_capacity - 1;
+    srint_t slot = (srint_t)( hash & mask );
+    for ( ; profiler->stack_table[slot] != 0; slot = ( slot + 1 ) & mask ) {
+        srint_t              index = profiler->stack_table[slot] - 1;
+        sr__profile_stack_t* stack = &profiler->stacks[index];
+        int                  same  = stack->hash == hash && stack->num_frames == num_frames;
+        for ( srint_t i_frame = 0; same && i_frame < num_frames; ++i_frame ) {
+            same = stack->frames[i_frame] == frames[i_frame];
+        }
+
+        if ( same ) {
+            return index;
+        }
+    }
+
+    if ( profiler->num_stacks == profiler->stacks_capacity ) {
+        srint_t old_capacity = profiler->stacks_capacity;
+        srint_t capacity     = old_capacity > 0 ? old_capacity * 2 : 32;
+        srint_t old_size     = old_capacity * (srint_t)sizeof( sr__profile_stack_t );
+        sr__profile_stack_t* stacks = (sr__profile_stack_t*)sr__profile_alloc_zeroed(
+          profiler, capacity * (srint_t)sizeof( sr__profile_stack_t ) );
+        if ( stacks == SRALLOC_NULL ) {
+            return -1;
+        }
+
+        if ( old_size > 0 ) {
+            SRALLOC_memcpy( stacks, profiler->stacks, old_size );
+        }
+
+        sralloc_dealloc_sized( profiler->storage, profiler->stacks, old_size, 0 );
+        profiler->stacks          = stacks;
+        profiler->stacks_capacity = capacity;
+    }
+
+    sr__profile_stack_t* stack = &profiler->stacks[profiler->num_stacks];
+    stack->hash                = hash;
+    stack->num_frames          = num_frames;
+    for ( srint_t i_frame = 0; i_frame < num_frames; ++i_frame ) {
+        stack->frames[i_frame] = frames[i_frame];
+    }
+
+    profiler->stack_table[slot] = profiler->num_stacks + 1;
+    return profiler->num_stacks++;
 }
 
-SRALLOC_API srallocator_t*
-            sralloc_create_end_of_page_allocator( const char* name, srallocator_t* parent ) {
-#ifdef SRALLOC_DISABLE_end_of_page
-    return parent;
-#endif
+static sr__profile_sample_t*
+sr__profile_find_sample( srallocator_profiling_t* profiler, const void* ptr ) {
+    if ( profiler->samples_capacity == 0 ) {
+        return SRALLOC_NULL;
+    }
 
-    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_end_of_page_t );
-    void*          memory         = sralloc_alloc( parent, allocator_size );
-    srallocator_t* allocator      = (srallocator_t*)memory;
-    srallocator_end_of_page_t* end_of_page_allocator =
-      (srallocator_end_of_page_t*)( allocator + 1 );
+    srint_t mask = profiler->samples_capacity - 1;
+    srint_t slot = (srint_t)( sr__hash64( (sruintptr_t)ptr ) & mask );
+    for ( ; profiler->samples[slot].ptr != 0; slot = ( slot + 1 ) & mask ) {
+        if ( profiler->samples[slot].ptr == (sruintptr_t)ptr ) {
+            return &profiler->samples[slot];
+        }
+    }
 
-    SRALLOC_memset( allocator, 0, allocator_size );
-    sr__add_child_allocator( parent, allocator );
-    sr__set_name( allocator, name );
-    allocator->allocate_func                 = sralloc_end_of_page_allocate;
-    allocator->deallocate_func               = sralloc_end_of_page_deallocate;
-    end_of_page_allocator->backing_allocator = parent;
+    return SRALLOC_NULL;
+}
 
-    return allocator;
+static int
+sr__profile_grow_samples( srallocator_profiling_t* profiler ) {
+    srint_t capacity = profiler->samples_capacity > 0 ? profiler->samples_capacity * 2 : 256;
+    srint_t size     = capacity * (srint_t)sizeof( sr__profile_sample_t );
+    sr__profile_sample_t* samples =
+      (sr__profile_sample_t*)sr__profile_alloc_zeroed( profiler, size );
+    if ( samples == SRALLOC_NULL ) {
+        return 0;
+    }
+
+    for ( srint_t i_sample = 0; i_sample < profiler->samples_capacity; ++i_sample ) {
+        sr__profile_sample_t* sample = &profiler->samples[i_sample];
+        if ( sample->ptr == 0 ) {
+            continue;
+        }
+
+        srint_t slot = (srint_t)( sr__hash64( sample->ptr ) & ( capacity - 1 ) );
+        while ( samples[slot].ptr != 0 ) {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+
+        samples[slot] = *sample;
+    }
+
+    sralloc_dealloc_sized( profiler->storage,
+                           profiler->samples,
+                           profiler->samples_capacity * (srint_t)sizeof( sr__profile_sample_t ),
+                           0 );
+    profiler->samples          = samples;
+    profiler->samples_capacity = capacity;
+    return 1;
 }
 
-SRALLOC_API void
-sralloc_destroy_end_of_page_allocator( srallocator_t* allocator ) {
-#ifdef SRALLOC_USE_STATS
-    sr__remove_child_allocator( allocator->parent, allocator );
-    SRALLOC_assert( allocator->num_children == 0 );
-    SRALLOC_assert( allocator->stats.num_allocations == 0 );
-    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
-#endif
-    srallocator_end_of_page_t* end_of_page_allocator =
-      (srallocator_end_of_page_t*)( allocator + 1 );
-    SRALLOC_DEALLOC( end_of_page_allocator->backing_allocator, allocator );
+// Takes the sample out of the stack's in use numbers and the table, shifting the entries after it
+// back so lookups never need tombstones
+static void
+sr__profile_forget_sample( srallocator_profiling_t* profiler, sr__profile_sample_t* sample ) {
+    sr__profile_stack_t* stack = &profiler->stacks[sample->stack];
+    stack->inuse_count -= sample->count;
+    stack->inuse_bytes -= sample->bytes;
+    SRALLOC_atomic_fetch_add( &profiler->filter[sr__profile_filter_index( (void*)sample->ptr )],
+                              -1 );
+
+    srint_t mask = profiler->samples_capacity - 1;
+    srint_t hole = (srint_t)( sample - profiler->samples );
+    for ( srint_t slot = ( hole + 1 ) & mask; profiler->samples[slot].ptr != 0;
+          slot         = ( slot + 1 ) & mask ) {
+        srint_t home = (srint_t)( sr__hash64( profiler->samples[slot].ptr ) & mask );
+        if ( ( ( slot - home ) & mask ) >= ( ( slot - hole ) & mask ) ) {
+            profiler->samples[hole] = profiler->samples[slot];
+            hole                    = slot;
+        }
+    }
+
+    profiler->samples[hole].ptr = 0;
+    profiler->num_samples--;
 }
 
-    // ██╗ ██████╗         ██████╗ ███████╗██████╗ ██╗   ██╗ ██████╗ ██╗  ██╗███████╗ █████╗ ██████╗
-    // ██║██╔════╝         ██╔══██╗██╔════╝██╔══██╗██║   ██║██╔════╝ ██║ ██║██╔════╝██╔══██╗██╔══██╗
-    // ██║██║  ███╗        ██║  ██║█████╗  ██████╔╝██║   ██║██║  ███╗███████║█████╗ ███████║██████╔╝
-    // ██║██║   ██║        ██║  ██║██╔══╝  ██╔══██╗██║   ██║██║   ██║██╔══██║██╔══╝  ██╔══██║██╔═══╝
-    // ██║╚██████╔╝███████╗██████╔╝███████╗██████╔╝╚██████╔╝╚██████╔╝██║  ██║███████╗██║  ██║██║
-    // ╚═╝ ╚═════╝ ╚══════╝╚═════╝ ╚══════╝╚═════╝  ╚═════╝  ╚═════╝ ╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝╚═╝
+// Call with the lock held. Drops the sample if storage is out of memory.
+static void
+sr__profile_add_sample( srallocator_profiling_t* profiler,
+                        void*                    ptr,
+                        int64_t                  bytes,
+                        int64_t                  count,
+                        srint_t                  stack_index ) {
+    // Left behind if the block was freed without going through the profiler
+    sr__profile_sample_t* stale = sr__profile_find_sample( profiler, ptr );
+    if ( stale != SRALLOC_NULL ) {
+        sr__profile_forget_sample( profiler, stale );
+    }
 
-#ifdef SRALLOC_ENABLE_IG_DEBUGHEAP
+    if ( ( profiler->num_samples + 1 ) * 2 > profiler->samples_capacity &&
+         !sr__profile_grow_samples( profiler ) ) {
+        return;
+    }
 
-typedef struct {
-    DebugHeap* debugheap;
-} srallocator_ig_debugheap_t;
+    srint_t mask = profiler->samples_capacity - 1;
+    srint_t slot = (srint_t)( sr__hash64( (sruintptr_t)ptr ) & mask );
+    while ( profiler->samples[slot].ptr != 0 ) {
+        slot = ( slot + 1 ) & mask;
+    }
 
-typedef struct {
-    srint_t     size;
-    srint_t     offset;
-    srmemflag_t initial_protection;
-    srchar_t*   page_ptr;
-} sralloc_ig_debugheap_preamble_t;
+    sr__profile_sample_t* sample = &profiler->samples[slot];
+    sample->ptr                  = (sruintptr_t)ptr;
+    sample->bytes                = bytes;
+    sample->count                = count;
+    sample->stack                = stack_index;
+    profiler->num_samples++;
+    profiler->stacks[stack_index].inuse_count += count;
+    profiler->stacks[stack_index].inuse_bytes += bytes;
+    SRALLOC_atomic_fetch_add( &profiler->filter[sr__profile_filter_index( ptr )], 1 );
+}
+
+static void
+sr__profile_record( srallocator_profiling_t* profiler,
+                    void*                    ptr,
+                    srint_t                  size,
+                    int64_t                  bytes,
+                    void**                   frames,
+                    srint_t                  num_frames ) {
+    int64_t count = bytes > size ? bytes / size : 1;
+
+    SRALLOC_mutex_lock( &profiler->mutex );
+    srint_t stack_index = sr__profile_find_stack( profiler, frames, num_frames );
+    if ( stack_index >= 0 ) {
+        profiler->stacks[stack_index].alloc_count += count;
+        profiler->stacks[stack_index].alloc_bytes += bytes;
+        sr__profile_add_sample( profiler, ptr, bytes, count, stack_index );
+    }
+
+    SRALLOC_mutex_unlock( &profiler->mutex );
+}
 
 static sr_result_t
-sralloc_ig_debugheap_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
-    srallocator_ig_debugheap_t* ig_debugheap_allocator =
-      (srallocator_ig_debugheap_t*)( allocator + 1 );
+sralloc_profiling_allocate( srallocator_t* allocator, srint_t wanted_size, srint_t align ) {
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
+    sr_result_t res = sr__allocate( profiler->backing_allocator, wanted_size, align );
+    if ( res.ptr == SRALLOC_NULL ) {
+        return res;
+    }
 
-    void* ptr =
-      DebugHeapAllocate( ig_debugheap_allocator->debugheap, (size_t)wanted_size, (size_t)align );
+    int64_t bytes        = 0;
+    srint_t thread_index = sr__thread_index();
+    if ( thread_index < SRALLOC_MAX_THREADS ) {
+        sr__profile_counter_t* counter =
+          (sr__profile_counter_t*)( profiler->counters + thread_index * SR__CACHE_LINE_SIZE );
+        counter->bytes_until_sample -= wanted_size;
+        if ( counter->bytes_until_sample > 0 ) {
+            return res;
+        }
 
-    srint_t actual_size = (srint_t)DebugHeapGetAllocSize( ig_debugheap_allocator->debugheap, ptr );
+        bytes = sr__profile_take_sample( profiler, counter, wanted_size );
+    }
+    else {
+        SRALLOC_mutex_lock( &profiler->mutex );
+        profiler->shared_counter.bytes_until_sample -= wanted_size;
+        if ( profiler->shared_counter.bytes_until_sample <= 0 ) {
+            bytes = sr__profile_take_sample( profiler, &profiler->shared_counter, wanted_size );
+        }
 
-#ifdef SRALLOC_USE_STATS
-    allocator->stats.amount_allocated += actual_size;
-    allocator->stats.num_allocations += 1;
-#endif
+        SRALLOC_mutex_unlock( &profiler->mutex );
+    }
+
+    // The stack is captured here, which is only ever called through a function pointer, so that
+    // exactly one frame (this one) belongs to the profiler and is dropped. Unless they were
+    // inlined, sralloc_alloc and sr__allocate are still above the caller's frame.
+    if ( bytes > 0 ) {
+        void*   frames[SRALLOC_PROFILE_MAX_FRAMES + 1];
+        srint_t num_frames = (srint_t)SRALLOC_backtrace( frames, SRALLOC_PROFILE_MAX_FRAMES + 1 );
+        num_frames         = num_frames > 1 ? num_frames - 1 : 0;
+        sr__profile_record( profiler, res.ptr, wanted_size, bytes, frames + 1, num_frames );
+    }
+
+    return res;
+}
+
+static void
+sr__profiling_deallocate( srallocator_t* allocator, void* ptr, srint_t size, srint_t align ) {
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
+    srallocator_t*           backing  = profiler->backing_allocator;
+
+    // The sample goes before the block can be handed out, and sampled, again
+    if ( SRALLOC_atomic_load( &profiler->filter[sr__profile_filter_index( ptr )] ) != 0 ) {
+        SRALLOC_mutex_lock( &profiler->mutex );
+        sr__profile_sample_t* sample = sr__profile_find_sample( profiler, ptr );
+        if ( sample != SRALLOC_NULL ) {
+            sr__profile_forget_sample( profiler, sample );
+        }
+
+        SRALLOC_mutex_unlock( &profiler->mutex );
+    }
+
+    if ( size < 0 ) {
+        sralloc_dealloc( backing, ptr );
+    }
+    else {
+        sralloc_dealloc_sized( backing, ptr, size, align );
+    }
+}
 
-    sr_result_t res;
-    res.ptr  = (void*)ptr;
-    res.size = actual_size;
-    return res;
+static void
+sralloc_profiling_deallocate( srallocator_t* allocator, void* ptr ) {
+    sr__profiling_deallocate( allocator, ptr, -1, 0 );
 }
 
 static void
-sralloc_ig_debugheap_deallocate( srallocator_t* allocator, void* ptr ) {
-    srallocator_ig_debugheap_t* ig_debugheap_allocator =
-      (srallocator_ig_debugheap_t*)( allocator + 1 );
+sralloc_profiling_deallocate_sized( srallocator_t* allocator,
+                                    void*          ptr,
+                                    srint_t        size,
+                                    srint_t        align ) {
+    sr__profiling_deallocate( allocator, ptr, size, align );
+}
 
-#ifdef SRALLOC_USE_STATS
-    srint_t actual_size = (srint_t)DebugHeapGetAllocSize( ig_debugheap_allocator->debugheap, ptr );
-    allocator->stats.amount_allocated -= actual_size;
-    allocator->stats.num_allocations -= 1;
-#endif
+// Resizes aren't sampled, but a sampled block that moves takes its sample with it
+static sr_result_t
+sralloc_profiling_reallocate( srallocator_t* allocator,
+                              void*          ptr,
+                              srint_t        size,
+                              srint_t        align,
+                              int            may_move ) {
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
+    srallocator_t*           backing  = profiler->backing_allocator;
+    sr_result_t              res      = { SRALLOC_NULL, 0 };
+    if ( backing->reallocate_func == SRALLOC_NULL ) {
+        return res;
+    }
 
-    DebugHeapFree( ig_debugheap_allocator->debugheap, ptr );
+    if ( SRALLOC_atomic_load( &profiler->filter[sr__profile_filter_index( ptr )] ) == 0 ) {
+        return sr__reallocate( backing, ptr, size, align, may_move );
+    }
+
+    // Locked throughout so the old address can't be sampled again before the sample moves
+    SRALLOC_mutex_lock( &profiler->mutex );
+    res = sr__reallocate( backing, ptr, size, align, may_move );
+    sr__profile_sample_t* sample = sr__profile_find_sample( profiler, ptr );
+    if ( res.ptr != SRALLOC_NULL && res.ptr != ptr && sample != SRALLOC_NULL ) {
+        sr__profile_sample_t moved = *sample;
+        sr__profile_forget_sample( profiler, sample );
+        sr__profile_add_sample( profiler, res.ptr, moved.bytes, moved.count, moved.stack );
+    }
+
+    SRALLOC_mutex_unlock( &profiler->mutex );
+    return res;
 }
 
 SRALLOC_API srallocator_t*
-            sralloc_create_ig_debugheap_allocator( const char*    name,
-                                                   srallocator_t* parent,
-                                                   sruint_t       capacity ) {
-    DebugHeap* debugheap = DebugHeapInit( (size_t)capacity );
-
-    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_ig_debugheap_t );
-    void*          memory    = DebugHeapAllocate( debugheap, allocator_size, 64u );
-    srallocator_t* allocator = (srallocator_t*)memory;
-    srallocator_ig_debugheap_t* ig_debugheap_allocator =
-      (srallocator_ig_debugheap_t*)( allocator + 1 );
+            sralloc_create_profiling_allocator( const char*    name,
+                                                srallocator_t* parent,
+                                                srallocator_t* storage,
+                                                srint_t        sample_bytes ) {
+    srint_t        allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_profiling_t );
+    srallocator_t* allocator      = (srallocator_t*)sralloc_alloc( parent, allocator_size );
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
 
     SRALLOC_memset( allocator, 0, allocator_size );
     sr__add_child_allocator( parent, allocator );
     sr__set_name( allocator, name );
-    allocator->allocate_func          = sralloc_ig_debugheap_allocate;
-    allocator->deallocate_func        = sralloc_ig_debugheap_deallocate;
-    ig_debugheap_allocator->debugheap = debugheap;
-
+    sr__create_stats( allocator );
+    allocator->allocate_func         = sralloc_profiling_allocate;
+    allocator->deallocate_func       = sralloc_profiling_deallocate;
+    allocator->deallocate_sized_func = sralloc_profiling_deallocate_sized;
+    allocator->reallocate_func       = sralloc_profiling_reallocate;
+    profiler->backing_allocator      = parent;
+    profiler->storage                = storage;
+    profiler->sample_bytes           = sample_bytes > 1 ? sample_bytes : 1;
+    profiler->counters = (srchar_t*)sr__os_map( SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE );
+    profiler->filter   = (srint_t*)sr__profile_alloc_zeroed(
+      profiler, SR__PROFILE_FILTER_SIZE * (srint_t)sizeof( srint_t ) );
+    SRALLOC_assert( profiler->counters != SRALLOC_NULL && profiler->filter != SRALLOC_NULL );
+    SRALLOC_mutex_init( &profiler->mutex );
     return allocator;
 }
 
 SRALLOC_API void
-sralloc_destroy_ig_debugheap_allocator( srallocator_t* allocator ) {
+sralloc_destroy_profiling_allocator( srallocator_t* allocator ) {
 #ifdef SRALLOC_USE_STATS
+    sr__destroy_stats( allocator );
     sr__remove_child_allocator( allocator->parent, allocator );
     SRALLOC_assert( allocator->num_children == 0 );
     SRALLOC_assert( allocator->stats.num_allocations == 0 );
     SRALLOC_assert( allocator->stats.amount_allocated == 0 );
 #endif
-    srallocator_ig_debugheap_t* ig_debugheap_allocator =
-      (srallocator_ig_debugheap_t*)( allocator + 1 );
-
-    DebugHeap* debugheap = ig_debugheap_allocator->debugheap;
-    DebugHeapFree( ig_debugheap_allocator->debugheap, allocator );
-    DebugHeapDestroy( debugheap );
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
+    srallocator_t*           storage  = profiler->storage;
+    sralloc_dealloc_sized( storage,
+                           profiler->samples,
+                           profiler->samples_capacity * (srint_t)sizeof( sr__profile_sample_t ),
+                           0 );
+    sralloc_dealloc_sized( storage,
+                           profiler->stack_table,
+                           profiler->stack_table_capacity * (srint_t)sizeof( srint_t ),
+                           0 );
+    sralloc_dealloc_sized( storage,
+                           profiler->stacks,
+                           profiler->stacks_capacity * (srint_t)sizeof( sr__profile_stack_t ),
+                           0 );
+    sralloc_dealloc_sized(
+      storage, profiler->filter, SR__PROFILE_FILTER_SIZE * (srint_t)sizeof( srint_t ), 0 );
+    sr__os_unmap( profiler->counters, SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE );
+    SRALLOC_mutex_destroy( &profiler->mutex );
+
+    srint_t allocator_size = sizeof( srallocator_t ) + sizeof( srallocator_profiling_t );
+    sralloc_dealloc_sized( profiler->backing_allocator, allocator, allocator_size, 0 );
 }
 
-#endif //  SRALLOC_ENABLE_IG_DEBUGHEAP
+SRALLOC_API srint_t
+sralloc_profile_write( srallocator_t*           allocator,
+                       sralloc_profile_format_t format,
+                       srchar_t*                buffer,
+                       srint_t                  capacity ) {
+    srallocator_profiling_t* profiler = (srallocator_profiling_t*)( allocator + 1 );
+    sr__report_writer_t      writer   = { buffer, buffer != SRALLOC_NULL ? capacity : 0, 0, 0 };
+    SRALLOC_mutex_lock( &profiler->mutex );
+    if ( format == SRALLOC_PROFILE_PPROF ) {
+        sr__profile_stack_t total;
+        SRALLOC_memset( &total, 0, sizeof( total ) );
+        for ( srint_t i_stack = 0; i_stack < profiler->num_stacks; ++i_stack ) {
+            total.inuse_count += profiler->stacks[i_stack].inuse_count;
+            total.inuse_bytes += profiler->stacks[i_stack].inuse_bytes;
+            total.alloc_count += profiler->stacks[i_stack].alloc_count;
+            total.alloc_bytes += profiler->stacks[i_stack].alloc_bytes;
+        }
 
-/*
+        sr__report_write_string( &writer, "heap profile: " );
+        for ( srint_t i_stack = -1; i_stack < profiler->num_stacks; ++i_stack ) {
+            sr__profile_stack_t* stack = i_stack < 0 ? &total : &profiler->stacks[i_stack];
+            sr__report_write_number( &writer, stack->inuse_count );
+            sr__report_write_string( &writer, ": " );
+            sr__report_write_number( &writer, stack->inuse_bytes );
+            sr__report_write_string( &writer, " [" );
+            sr__report_write_number( &writer, stack->alloc_count );
+            sr__report_write_string( &writer, ": " );
+            sr__report_write_number( &writer, stack->alloc_bytes );
+            sr__report_write_string( &writer, i_stack < 0 ? "] @ heap_v2/1" : "] @" );
+            for ( srint_t i_frame = 0; i_stack >= 0 && i_frame < stack->num_frames; ++i_frame ) {
+                sr__report_write_string( &writer, " " );
+                sr__report_write_hex( &writer, (sruintptr_t)stack->frames[i_frame] );
+            }
 
-// ███████╗██╗      ██████╗ ████████╗
-// ██╔════╝██║     ██╔═══██╗╚══██╔══╝
-// ███████╗██║     ██║   ██║   ██║
-// ╚════██║██║     ██║   ██║   ██║
-// ███████║███████╗╚██████╔╝   ██║
-// ╚══════╝╚══════╝ ╚═════╝    ╚═╝
+            sr__report_write_string( &writer, "\n" );
+        }
+    }
+    else {
+        for ( srint_t i_stack = 0; i_stack < profiler->num_stacks; ++i_stack ) {
+            sr__profile_stack_t* stack = &profiler->stacks[i_stack];
+            int64_t              bytes =
+              format == SRALLOC_PROFILE_FOLDED_INUSE ? stack->inuse_bytes : stack->alloc_bytes;
+            if ( bytes == 0 ) {
+                continue;
+            }
+
+            if ( stack->num_frames == 0 ) {
+                sr__report_write_string( &writer, "[unknown]" );
+            }
+
+            for ( srint_t i_frame = stack->num_frames - 1; i_frame >= 0; --i_frame ) {
+                sr__report_write_hex( &writer, (sruintptr_t)stack->frames[i_frame] );
+                sr__report_write_string( &writer, i_frame > 0 ? ";" : "" );
+            }
+
+            sr__report_write_string( &writer, " " );
+            sr__report_write_number( &writer, bytes );
+            sr__report_write_string( &writer, "\n" );
+        }
+    }
+
+    SRALLOC_mutex_unlock( &profiler->mutex );
+    if ( writer.capacity > 0 ) {
+        writer.buffer[writer.length < writer.capacity ? writer.length : writer.capacity - 1] = 0;
+    }
+
+    return writer.length;
+}
+
+// ██████╗ ███████╗██████╗  ██████╗ ██████╗ ████████╗
+// ██╔══██╗██╔════╝██╔══██╗██╔═══██╗██╔══██╗╚══██╔══╝
+// ██████╔╝█████╗  ██████╔╝██║   ██║██████╔╝   ██║
+// ██╔══██╗██╔══╝  ██╔═══╝ ██║   ██║██╔══██╗   ██║
+// ██║  ██║███████╗██║     ╚██████╔╝██║  ██║   ██║
+// ╚═╝  ╚═╝╚══════╝╚═╝      ╚═════╝ ╚═╝  ╚═╝   ╚═╝
 
+// Allocators don't store their type, it's looked up from the allocate function they were
+// created with.
 typedef struct {
+    sralloc_allocate_func allocate_func;
+    const srchar_t*       type;
+    srint_t               state_size;
+} sr__report_type_t;
+
+static const sr__report_type_t sr__report_types[] = {
+    { sralloc_malloc_allocate, "malloc", 0 },
+    { sralloc_heap_allocate, "heap", sizeof( srallocator_heap_t ) },
+    { sralloc_page_allocate, "page", sizeof( srallocator_page_t ) },
+    { sralloc_numa_allocate, "numa", sizeof( srallocator_numa_t ) },
+    { sralloc_stack_allocate, "stack", sizeof( srallocator_stack_t ) },
+    { sralloc_arena_allocate, "arena", sizeof( srallocator_arena_t ) },
+    { sralloc_concurrent_frame_allocate,
+      "concurrent_frame",
+      sizeof( srallocator_concurrent_frame_t ) },
+    { sralloc_multi_frame_allocate, "multi_frame", sizeof( srallocator_multi_frame_t ) },
+    { sralloc_ring_allocate, "ring", sizeof( srallocator_ring_t ) },
+    { sralloc_buddy_allocate, "buddy", sizeof( srallocator_buddy_t ) },
+    { sralloc_tlsf_allocate, "tlsf", sizeof( srallocator_tlsf_t ) },
+    { sralloc_proxy_allocate, "proxy", sizeof( srallocator_proxy_t ) },
+    { sralloc_end_of_page_allocate, "end_of_page", sizeof( srallocator_end_of_page_t ) },
+#ifdef SRALLOC_ENABLE_IG_DEBUGHEAP
+    { sralloc_ig_debugheap_allocate, "ig_debugheap", sizeof( srallocator_ig_debugheap_t ) },
+#endif
+    { sralloc_mutex_allocate, "mutex", sizeof( srallocator_mutex_t ) },
+    { sralloc_thread_cache_allocate, "thread_cache", sizeof( srallocator_thread_cache_t ) },
+    { sralloc_slot_allocate, "slot", sizeof( srallocator_slot_t ) },
+    { sralloc_callback_allocate, "callback", sizeof( srallocator_callback_t ) },
+    { sralloc_recording_allocate, "recording", sizeof( srallocator_recording_t ) },
+    { sralloc_profiling_allocate, "profiling", sizeof( srallocator_profiling_t ) },
+};
 
-} srallocator_slot_t;
+// Names are quoted and escaped, for JSON always and for CSV only when they need it
+static void
+sr__report_write_name( sr__report_writer_t*    writer,
+                       sralloc_report_format_t format,
+                       const srchar_t*         name ) {
+    int quote = format == SRALLOC_REPORT_JSON;
+    for ( const srchar_t* c = name; *c != 0 && !quote; ++c ) {
+        quote = *c == ',' || *c == '"' || *c == '\n' || *c == '\r';
+    }
 
-void*
-sralloc_slot_allocate( srallocator_t* allocator, srint_t size ) {
-    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
-    srshort_t           slot           = slot_allocator->free_slot;
-    if ( slot_allocator->free_slot != 0 ) {
-        srshort_t next_slot_offset = slot * slot_allocator->slot_size;
-        char*     next_free_slot   = (char*)slot_allocator->slots + next_slot_offset;
-        slot_allocator->free_slot  = *(srshort_t*)next_free_slot;
+    if ( quote ) {
+        sr__report_write( writer, "\"", 1 );
     }
-    else {
-        SRALLOC_assert( slot_allocator->num_slots < slot_allocator->capacity );
-        slot = slot_allocator->num_slots++;
+
+    for ( const srchar_t* c = name; *c != 0; ++c ) {
+        if ( format == SRALLOC_REPORT_CSV ) {
+            sr__report_write( writer, c, 1 );
+            if ( *c == '"' ) {
+                sr__report_write( writer, c, 1 );
+            }
+        }
+        else if ( *c == '"' || *c == '\\' ) {
+            sr__report_write( writer, "\\", 1 );
+            sr__report_write( writer, c, 1 );
+        }
+        else if ( (unsigned char)*c < 0x20 ) {
+            srchar_t escaped[6] = { '\\', 'u', '0', '0', '0', '0' };
+            escaped[4]          = "0123456789abcdef"[( *c >> 4 ) & 0xf];
+            escaped[5]          = "0123456789abcdef"[*c & 0xf];
+            sr__report_write( writer, escaped, 6 );
+        }
+        else {
+            sr__report_write( writer, c, 1 );
+        }
     }
 
-    allocator->stats.amount_allocated += size;
-    allocator->stats.num_allocations++;
+    if ( quote ) {
+        sr__report_write( writer, "\"", 1 );
+    }
+}
 
-    srshort_t slot_offset = slot * slot_allocator->slot_size;
-    char*     slot        = (char*)slot_allocator->slots + next_slot_offset;
-    void*     ptr         = (void*)slot;
-    return ptr;
+static void
+sr__report_write_field( sr__report_writer_t*    writer,
+                        sralloc_report_format_t format,
+                        const srchar_t*         key,
+                        srint_t                 value ) {
+    if ( format == SRALLOC_REPORT_JSON ) {
+        sr__report_write( writer, ",\"", 2 );
+        sr__report_write_string( writer, key );
+        sr__report_write( writer, "\":", 2 );
+    }
+    else {
+        sr__report_write( writer, ",", 1 );
+    }
+
+    sr__report_write_number( writer, value );
 }
 
-void
-sralloc_slot_deallocate( srallocator_t* allocator, void* ptr ) {
-    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
-    srint_t*            slot_ptr       = (srint_t*)ptr;
-    if ( slot_allocator->free_slot == 0 ) {
-        slot_allocator->free_slot = (slot_ptr - slot_allocator->slots;
+static void
+sr__report_node( sr__report_writer_t*    writer,
+                 sralloc_report_format_t format,
+                 srallocator_t*          allocator,
+                 srint_t                 parent_id,
+                 srint_t                 depth ) {
+    const srchar_t* type     = "unknown";
+    srint_t         overhead = sizeof( srallocator_t );
+    srint_t num_types = (srint_t)( sizeof( sr__report_types ) / sizeof( sr__report_types[0] ) );
+    for ( srint_t i_type = 0; i_type < num_types; ++i_type ) {
+        if ( sr__report_types[i_type].allocate_func == allocator->allocate_func ) {
+            type = sr__report_types[i_type].type;
+            overhead += sr__report_types[i_type].state_size;
+            break;
+        }
     }
 
-    slot_ptr--;
-    allocator->stats.amount_allocated -= *slot_ptr;
-    allocator->stats.num_allocations--;
-    return free( slot_ptr );
+    const srchar_t* name = "";
+#ifdef SRALLOC_USE_NAMES
+    if ( allocator->name != SRALLOC_NULL ) {
+        name = allocator->name;
+    }
+#endif
+
+    sralloc_stats_t stats       = sralloc_get_stats( allocator );
+    sralloc_stats_t total_stats = sralloc_get_total_stats( allocator );
+    srint_t         peak        = stats.amount_allocated;
+#ifdef SRALLOC_USE_STATS
+    overhead += allocator->children_capacity * (srint_t)sizeof( srallocator_t* );
+#ifdef SRALLOC_ENABLE_SHARDED_STATS
+    if ( allocator->stats_shards != SRALLOC_NULL ) {
+        overhead += SRALLOC_MAX_THREADS * SR__CACHE_LINE_SIZE;
+    }
+#endif
+#ifdef SRALLOC_USE_EXTENDED_STATS
+    if ( allocator->extended_stats != SRALLOC_NULL ) {
+        overhead += (srint_t)sizeof( struct sr__extended_stats );
+        if ( allocator->extended_stats->lifetime.peak_amount_allocated > peak ) {
+            peak = allocator->extended_stats->lifetime.peak_amount_allocated;
+        }
+    }
+#endif
+    if ( allocator->report_peak > peak ) {
+        peak = allocator->report_peak;
+    }
+
+    allocator->report_peak = peak;
+#endif
+
+    srint_t id = writer->num_rows++;
+    if ( format == SRALLOC_REPORT_JSON ) {
+        sr__report_write_string( writer, "{\"name\":" );
+        sr__report_write_name( writer, format, name );
+        sr__report_write_string( writer, ",\"type\":\"" );
+        sr__report_write_string( writer, type );
+        sr__report_write( writer, "\"", 1 );
+    }
+    else {
+        sr__report_write_number( writer, id );
+        sr__report_write_field( writer, format, "parent", parent_id );
+        sr__report_write_field( writer, format, "depth", depth );
+        sr__report_write( writer, ",", 1 );
+        sr__report_write_name( writer, format, name );
+        sr__report_write( writer, ",", 1 );
+        sr__report_write_string( writer, type );
+    }
+
+    sr__report_write_field( writer, format, "num_allocations", stats.num_allocations );
+    sr__report_write_field( writer, format, "amount_allocated", stats.amount_allocated );
+    sr__report_write_field(
+      writer, format, "total_num_allocations", total_stats.num_allocations );
+    sr__report_write_field(
+      writer, format, "total_amount_allocated", total_stats.amount_allocated );
+    sr__report_write_field( writer, format, "overhead", overhead );
+    sr__report_write_field( writer, format, "peak", peak );
+    if ( format == SRALLOC_REPORT_CSV ) {
+        sr__report_write( writer, "\n", 1 );
+    }
+    else {
+        sr__report_write_string( writer, ",\"children\":[" );
+    }
+
+#ifdef SRALLOC_USE_STATS
+    for ( srint_t i_child = 0; i_child < allocator->num_children; ++i_child ) {
+        if ( format == SRALLOC_REPORT_JSON && i_child > 0 ) {
+            sr__report_write( writer, ",", 1 );
+        }
+
+        sr__report_node( writer, format, allocator->children[i_child], id, depth + 1 );
+    }
+#endif
+
+    if ( format == SRALLOC_REPORT_JSON ) {
+        sr__report_write( writer, "]}", 2 );
+    }
 }
 
-SRALLOC_API srallocator_t*
-            sralloc_create_slot_allocator( srallocator_t* parent,
-                                           const char*    name,
-                                           srint_t        slot_size,
-                                           srint_t        capacity ) {
+SRALLOC_API srint_t
+sralloc_report( srallocator_t*          allocator,
+                sralloc_report_format_t format,
+                srchar_t*               buffer,
+                srint_t                 capacity ) {
+    sr__report_writer_t writer = { buffer, buffer != SRALLOC_NULL ? capacity : 0, 0, 0 };
+    if ( format == SRALLOC_REPORT_CSV ) {
+        sr__report_write_string( &writer,
+                                 "id,parent,depth,name,type,num_allocations,amount_allocated,"
+                                 "total_num_allocations,total_amount_allocated,overhead,peak\n" );
+    }
 
-    srint_t allocator_size =
-      sizeof( srallocator_t ) + sizeof( srallocator_slot_t ) + slot_size * capacity;
-    srallocator_t*      allocator      = parent->allocate( parent, allocator_size );
-    srallocator_slot_t* slot_allocator = (srallocator_slot_t*)( allocator + 1 );
+    sr__report_node( &writer, format, allocator, -1, 0 );
+    if ( writer.capacity > 0 ) {
+        writer.buffer[writer.length < writer.capacity ? writer.length : writer.capacity - 1] = 0;
+    }
 
-    SRALLOC_memset( allocator, 0, sizeof( srallocator_t ) );
-    allocator->name           = name;
-    allocator->parent         = parent;
-    allocator->allocate       = sralloc_slot_allocate;
-    allocator->deallocate     = sralloc_slot_deallocate;
-    slot_allocator->num_slots = 0;
-    slot_allocator->capacity  = capacity;
-    slot_allocator->slot_size = slot_size;
-    slot_allocator->slots     = (void*)slot_allocator + 1;
-    return allocator;
-};
+    return writer.length;
+}
 
-SRALLOC_API void
-sralloc_destroy_slot_allocator( srallocator_t* allocator ) {
-    SRALLOC_assert( allocator->num_children == 0 );
-    SRALLOC_assert( allocator->stats.num_allocations == 0 );
-    SRALLOC_assert( allocator->stats.amount_allocated == 0 );
-    allocator->parent->deallocate( allocator->parent, allocator );
+SRALLOC_API srchar_t*
+sralloc_report_alloc( srallocator_t*          allocator,
+                      sralloc_report_format_t format,
+                      srallocator_t*          output,
+                      srint_t*                out_length ) {
+#ifdef SRALLOC_USE_STATS
+    for ( srallocator_t* ancestor = output; ancestor != SRALLOC_NULL;
+          ancestor                = ancestor->parent ) {
+        SRALLOC_assert( ancestor != allocator );
+    }
+#endif
+
+    srint_t   length = sralloc_report( allocator, format, SRALLOC_NULL, 0 );
+    srchar_t* report = (srchar_t*)sralloc_alloc( output, length + 1 );
+    if ( report == SRALLOC_NULL ) {
+        return SRALLOC_NULL;
+    }
+
+    // Another thread can change the numbers in between, the report is cut to the first length
+    srint_t written = sralloc_report( allocator, format, report, length + 1 );
+    *out_length     = written < length ? written : length;
+    return report;
 }
-END OF SLOT
-*/
+
 #endif // SRALLOC_IMPLEMENTATION
 
 #if defined( __cplusplus ) && !defined( SRALLOC_NO_CLASSES )
 
+#ifndef SRALLOC_malloc
+#include <stdlib.h>
+#define SRALLOC_malloc malloc
+#define SRALLOC_free free
+#endif
+
+#ifndef SRALLOC_MALLOC_ALIGN
+#define SRALLOC_MALLOC_ALIGN ( 2 * (srint_t)sizeof( void* ) )
+#endif
+
 namespace sralloc {
 class Allocator {
   public:
     // clang-format off
     static Allocator create_malloc_allocator( const char* name )
-                    { return Allocator( sralloc_create_malloc_allocator( name ) ); }
+                    { return Allocator( sralloc_create_malloc_allocator( name ), AllocatorMalloc ); }
     static Allocator create_stack_allocator( const char* name, srallocator_t* parent, srint_t capacity )
-                    { return Allocator( sralloc_create_stack_allocator( name, parent, capacity ) ); }
+                    { return Allocator( sralloc_create_stack_allocator( name, parent, capacity ),
+                                        AllocatorStack ); }
 
     void*       allocate( srint_t size )
                     { return sralloc_alloc( _allocator, size ); }
 
     sr_result_t allocate_with_size( srint_t size )
-                    { sralloc_alloc_with_size( _allocator, size ); }
+                    { return sralloc_alloc_with_size( _allocator, size ); }
 
     void*       allocate_aligned( srint_t size, srint_t align )
-                    { sralloc_alloc_aligned( _allocator, size ); }
+                    { return sralloc_alloc_aligned( _allocator, size, align ); }
 
     sr_result_t allocate_aligned_with_size( srint_t size, srint_t align )
-                    { sralloc_alloc_aligned_with_size( _allocator, size ); }
+                    { return sralloc_alloc_aligned_with_size( _allocator, size, align ); }
 
     template <typename T>
     T*          allocate()
@@ -1025,10 +8552,22 @@ class Allocator {
 
     void        deallocate( void* ptr )
                     { sralloc_dealloc( _allocator, ptr ); }
+
+    srallocator_t* get() const
+                    { return _allocator; }
     // clang-format on
 
+    Allocator( Allocator&& other )
+    : _allocator( other._allocator )
+    , _type( other._type ) {
+        other._allocator = nullptr;
+        other._type      = AllocatorInvalid;
+    }
+
     ~Allocator() {
         switch ( _type ) {
+        case AllocatorInvalid:
+            break;
         case AllocatorMalloc:
             sralloc_destroy_malloc_allocator( _allocator );
             break;
@@ -1039,22 +8578,233 @@ class Allocator {
     }
 
   private:
-    Allocator( srallocator_t* allocator )
-    : _allocator( allocator ) {}
-
-    Allocator( const Allocator& ) = delete;
-    void operator=( const Allocator& ) = delete;
-
     enum AllocatorType {
         AllocatorInvalid = 0,
         AllocatorMalloc,
         AllocatorStack,
     };
 
+    Allocator( srallocator_t* allocator, AllocatorType type )
+    : _allocator( allocator )
+    , _type( type ) {}
+
+    Allocator( const Allocator& ) = delete;
+    void operator=( const Allocator& ) = delete;
+
     srallocator_t* _allocator;
     AllocatorType  _type;
 };
 
+// Static dispatch policies
+// Composed at compile time, e.g. Proxy<Stack<Malloc>>, so a whole chain inlines into the call
+// site instead of going through allocate_func. Each policy has
+//   void* allocate( srint_t size, srint_t align );
+//   void  deallocate( void* ptr, srint_t size, srint_t align );
+// where align 0 means no particular alignment, and memory is freed with the size and alignment
+// it was allocated with. No preambles are written. Runtime<Policy> turns a chain back into an
+// srallocator_t*, Dynamic goes the other way.
+
+// Malloc policy (stateless root)
+class Malloc {
+  public:
+    void* allocate( srint_t size, srint_t align ) {
+        if ( align <= SRALLOC_MALLOC_ALIGN ) {
+            return SRALLOC_malloc( (size_t)size );
+        }
+
+        // Over-aligned, the original pointer goes in the padding right before the aligned one
+        srchar_t* unaligned_ptr = static_cast<srchar_t*>( SRALLOC_malloc( (size_t)( size + align ) ) );
+        if ( unaligned_ptr == nullptr ) {
+            return nullptr;
+        }
+
+        sruintptr_t address = ( (sruintptr_t)unaligned_ptr + align ) & ~(sruintptr_t)( align - 1 );
+        void**      ptr     = reinterpret_cast<void**>( address );
+        ptr[-1]             = unaligned_ptr;
+        return ptr;
+    }
+
+    void deallocate( void* ptr, srint_t size, srint_t align ) {
+        (void)size;
+        if ( ptr == nullptr ) {
+            return;
+        }
+
+        SRALLOC_free( align <= SRALLOC_MALLOC_ALIGN ? ptr : static_cast<void**>( ptr )[-1] );
+    }
+};
+
+// Stack policy, a bump allocator over one block from the backing policy
+// Deallocating the most recent allocation rewinds the top, anything else waits for clear().
+template <typename Backing>
+class Stack {
+  public:
+    Stack( Backing& backing, srint_t capacity )
+    : _backing( backing )
+    , _capacity( capacity ) {
+        _begin = static_cast<srchar_t*>( backing.allocate( capacity, 0 ) );
+        _top   = _begin;
+        _end   = _begin != nullptr ? _begin + capacity : _begin;
+    }
+
+    ~Stack() {
+        _backing.deallocate( _begin, _capacity, 0 );
+    }
+
+    void* allocate( srint_t size, srint_t align ) {
+        sruintptr_t address = (sruintptr_t)_top;
+        if ( align > 0 ) {
+            address = ( address + align - 1 ) & ~(sruintptr_t)( align - 1 );
+        }
+
+        if ( address + size > (sruintptr_t)_end ) {
+            return nullptr;
+        }
+
+        _top = reinterpret_cast<srchar_t*>( address + size );
+        return reinterpret_cast<void*>( address );
+    }
+
+    void deallocate( void* ptr, srint_t size, srint_t align ) {
+        (void)align;
+        if ( static_cast<srchar_t*>( ptr ) + size == _top ) {
+            _top = static_cast<srchar_t*>( ptr );
+        }
+    }
+
+    void clear() {
+        _top = _begin;
+    }
+
+    srint_t used() const {
+        return (srint_t)( _top - _begin );
+    }
+
+  private:
+    Stack( const Stack& ) = delete;
+    void operator=( const Stack& ) = delete;
+
+    Backing&  _backing;
+    srint_t   _capacity;
+    srchar_t* _begin;
+    srchar_t* _top;
+    srchar_t* _end;
+};
+
+// Proxy policy, counts what passes through it on the way to the backing policy
+template <typename Backing>
+class Proxy {
+  public:
+    Proxy( Backing& backing, const char* name )
+    : _backing( backing )
+    , _name( name )
+    , _num_allocations( 0 )
+    , _amount_allocated( 0 ) {}
+
+    void* allocate( srint_t size, srint_t align ) {
+        void* ptr = _backing.allocate( size, align );
+        if ( ptr != nullptr ) {
+            _num_allocations++;
+            _amount_allocated += size;
+        }
+
+        return ptr;
+    }
+
+    void deallocate( void* ptr, srint_t size, srint_t align ) {
+        if ( ptr == nullptr ) {
+            return;
+        }
+
+        _num_allocations--;
+        _amount_allocated -= size;
+        _backing.deallocate( ptr, size, align );
+    }
+
+    const char* name() const {
+        return _name;
+    }
+
+    srint_t num_allocations() const {
+        return _num_allocations;
+    }
+
+    srint_t amount_allocated() const {
+        return _amount_allocated;
+    }
+
+  private:
+    Proxy( const Proxy& ) = delete;
+    void operator=( const Proxy& ) = delete;
+
+    Backing&    _backing;
+    const char* _name;
+    srint_t     _num_allocations;
+    srint_t     _amount_allocated;
+};
+
+// Dynamic policy, puts a runtime srallocator_t* at the bottom of a static chain
+class Dynamic {
+  public:
+    explicit Dynamic( srallocator_t* allocator )
+    : _allocator( allocator ) {}
+
+    void* allocate( srint_t size, srint_t align ) {
+        return sralloc_alloc_aligned( _allocator, size, align );
+    }
+
+    void deallocate( void* ptr, srint_t size, srint_t align ) {
+        sralloc_dealloc_sized( _allocator, ptr, size, align );
+    }
+
+  private:
+    srallocator_t* _allocator;
+};
+
+// Type erases a policy into an srallocator_t* for code that takes one, e.g. as the parent of the
+// C allocators. Calls through it go through function pointers again.
+template <typename Policy>
+class Runtime {
+  public:
+    Runtime( Policy& policy, const char* name, srallocator_t* parent = nullptr )
+    : _allocator( sralloc_create_callback_allocator(
+        name, parent, &policy, &Runtime::allocate_callback, &Runtime::deallocate_callback ) ) {}
+
+    ~Runtime() {
+        sralloc_destroy_callback_allocator( _allocator );
+    }
+
+    srallocator_t* get() const {
+        return _allocator;
+    }
+
+  private:
+    Runtime( const Runtime& ) = delete;
+    void operator=( const Runtime& ) = delete;
+
+    static void* allocate_callback( void* user_data, srint_t size, srint_t align ) {
+        return static_cast<Policy*>( user_data )->allocate( size, align );
+    }
+
+    static void deallocate_callback( void* user_data, void* ptr, srint_t size, srint_t align ) {
+        static_cast<Policy*>( user_data )->deallocate( ptr, size, align );
+    }
+
+    srallocator_t* _allocator;
+};
+
+template <typename T, typename Policy>
+T*
+allocate_object( Policy& policy ) {
+    return static_cast<T*>( policy.allocate( sizeof( T ), alignof( T ) ) );
+}
+
+template <typename T, typename Policy>
+void
+deallocate_object( Policy& policy, T* ptr ) {
+    policy.deallocate( ptr, sizeof( T ), alignof( T ) );
+}
+
 } // namespace sralloc
 #endif //__cplusplus && SRALLOC_NO_CLASSES
 